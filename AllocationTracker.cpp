@@ -0,0 +1,72 @@
+#include "AllocationTracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> frameAllocations(0);
+static std::atomic<size_t> frameBytes(0);
+static std::atomic<size_t> totalAllocations(0);
+
+bool AllocationTracker::isEnabled() {
+#ifdef MP_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AllocationTracker::beginFrame() {
+    frameAllocations.store(0, std::memory_order_relaxed);
+    frameBytes.store(0, std::memory_order_relaxed);
+}
+
+size_t AllocationTracker::getFrameAllocations() {
+    return frameAllocations.load(std::memory_order_relaxed);
+}
+
+size_t AllocationTracker::getFrameBytes() {
+    return frameBytes.load(std::memory_order_relaxed);
+}
+
+size_t AllocationTracker::getTotalAllocations() {
+    return totalAllocations.load(std::memory_order_relaxed);
+}
+
+void AllocationTracker::recordAllocation(size_t bytes) {
+    frameAllocations.fetch_add(1, std::memory_order_relaxed);
+    frameBytes.fetch_add(bytes, std::memory_order_relaxed);
+    totalAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifdef MP_TRACK_ALLOCATIONS
+// Replacements for the global allocation functions. The nothrow forms call
+// these by default; over-aligned allocations keep the library versions and
+// are not counted.
+void* operator new(std::size_t bytes) {
+    AllocationTracker::recordAllocation(bytes);
+    void* p = std::malloc(bytes == 0 ? 1 : bytes);
+    if(p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t bytes) {
+    return ::operator new(bytes);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
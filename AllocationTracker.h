@@ -0,0 +1,24 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <cstddef>
+
+// Counts heap allocations made through global operator new.
+// The counting operator new is only compiled in when MP_TRACK_ALLOCATIONS is
+// defined (cmake -DMP_TRACK_ALLOCATIONS=ON), otherwise every count stays zero
+// and isEnabled() returns false.
+class AllocationTracker {
+public:
+    static bool isEnabled();
+
+    // starts a new per-frame count
+    static void beginFrame();
+    static size_t getFrameAllocations();
+    static size_t getFrameBytes();
+    static size_t getTotalAllocations();
+
+    // called by the replacement operator new
+    static void recordAllocation(size_t bytes);
+};
+
+#endif // ALLOCATION_TRACKER_H
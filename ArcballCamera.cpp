@@ -6,7 +6,8 @@ ArcballCamera::ArcballCamera()
     : _target(0.0f, 0.0f, 0.0f),
       _radius(10.0f),
       _theta(0.0f),
-      _phi(glm::radians(45.0f))
+      _phi(glm::radians(45.0f)),
+      _distanceLimit(MAX_RADIUS)
 {
     updatePosition();
 }
@@ -41,6 +42,14 @@ void ArcballCamera::zoom(float deltaRadius) {
     updatePosition();
 }
 
+void ArcballCamera::setOrientation(float theta, float phi, float radius) {
+    _theta = theta;
+    _phi = std::clamp(phi, glm::radians(1.0f), glm::radians(179.0f));
+    _radius = std::clamp(radius, MIN_RADIUS, MAX_RADIUS);
+
+    updatePosition();
+}
+
 void ArcballCamera::zoomIn(float deltaRadius) {
     zoom(-deltaRadius);
 }
@@ -49,9 +58,21 @@ void ArcballCamera::zoomOut(float deltaRadius) {
     zoom(deltaRadius);
 }
 
+void ArcballCamera::setDistanceLimit(float maxDistance) {
+    _distanceLimit = maxDistance;
+    updatePosition();
+}
+
+glm::vec3 ArcballCamera::getDesiredPosition() const {
+    return glm::vec3(_target.x + _radius * sin(_phi) * sin(_theta),
+                     _target.y + _radius * cos(_phi),
+                     _target.z + _radius * sin(_phi) * cos(_theta));
+}
+
 // Updates the camera's position based on current parameters
 void ArcballCamera::updatePosition() {
-    _position.x = _target.x + _radius * sin(_phi) * sin(_theta);
-    _position.y = _target.y + _radius * cos(_phi);
-    _position.z = _target.z + _radius * sin(_phi) * cos(_theta);
+    float distance = std::min(_radius, _distanceLimit);
+    _position.x = _target.x + distance * sin(_phi) * sin(_theta);
+    _position.y = _target.y + distance * cos(_phi);
+    _position.z = _target.z + distance * sin(_phi) * cos(_theta);
 }
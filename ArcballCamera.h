@@ -18,9 +18,17 @@ public:
     void zoomIn(float deltaRadius = 0.5f);   // Zoom in by decreasing radius
     void zoomOut(float deltaRadius = 0.5f);  // Zoom out by increasing radius
 
+    void setOrientation(float theta, float phi, float radius); // Place the eye directly
+    // keeps the eye this close to the target while the radius is further, see CameraCollision
+    void setDistanceLimit(float maxDistance);
+
     float getTheta() const { return _theta; }
     float getPhi() const { return _phi; }
+    float getRadius() const { return _radius; }
     glm::vec3 getPosition() const { return _position; }
+    // where the eye would be without the distance limit
+    glm::vec3 getDesiredPosition() const;
+    glm::vec3 getTarget() const { return _target; }
 
 private:
     glm::vec3 _target;
@@ -31,6 +39,9 @@ private:
 
     const float MIN_RADIUS = 2.0f;
     const float MAX_RADIUS = 50.0f;
+
+    // declared after MAX_RADIUS, which it starts out as
+    float _distanceLimit;
 };
 
 #endif // ARCBALLCAMERA_H
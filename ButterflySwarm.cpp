@@ -0,0 +1,133 @@
+#include "ButterflySwarm.h"
+
+#include "PrimitiveMeshes.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+
+// The wing Lucid draws with CSCI441::drawSolidCone(0.05f, 0.2f, 16, 4)
+static constexpr auto WING_MESH = PrimitiveMeshGenerator::makeCone<16, 4>(0.05, 0.2);
+static constexpr GLuint NUM_WINGS = 4;
+
+// Lucid::_drawUpperWing and _drawLowerWing below its model matrix, for one wing angle
+static glm::mat4 getWingMatrix(GLuint wing, float wingAngle) {
+    const float HALF_PI = glm::half_pi<float>();
+    bool isLeftWing = (wing % 2 == 0);
+    bool isUpperWing = (wing < 2);
+
+    glm::mat4 modelMtx(1.0f);
+    if (isUpperWing) {
+        modelMtx = glm::scale(modelMtx, glm::vec3(0.5f, 1.5f, 1.5f));
+        modelMtx = glm::rotate(modelMtx, (isLeftWing ? -1.0f : 1.0f) * HALF_PI, glm::vec3(1.0f, 0.0f, 0.0f));
+        modelMtx = glm::rotate(modelMtx, wingAngle, glm::vec3(0.0f, 0.0f, 1.0f));
+    } else {
+        modelMtx = glm::scale(modelMtx, glm::vec3(0.5f, 1.0f, 0.8f));
+        modelMtx = glm::rotate(modelMtx, (isLeftWing ? -1.0f : 1.0f) * HALF_PI, glm::vec3(1.0f, 0.0f, 0.0f));
+        modelMtx = glm::translate(modelMtx, glm::vec3(0.0f, 0.0f, (isLeftWing ? -0.1f : 0.1f)));
+        modelMtx = glm::rotate(modelMtx, -wingAngle, glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+    return modelMtx;
+}
+
+void ButterflySwarm::create(GpuResourceRegistry& registry, GLuint maxInstances) {
+    release();
+
+    const GLuint VERTICES_PER_WING = static_cast<GLuint>(WING_MESH.vertices.size());
+    _numVertices = NUM_WINGS * VERTICES_PER_WING;
+    _maxInstances = maxInstances;
+
+    // Lucid::drawLucid places the wings with translate(position + 0.85 up) * rotZ(90) * rotX(heading + 90).
+    // rotZ(90) * rotX(heading) is rotY(heading) * rotZ(90), so everything but the
+    // translation and the heading turn about Y bakes into the texture
+    glm::mat4 bodyMtx = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.85f, 0.0f));
+    bodyMtx = glm::rotate(bodyMtx, glm::half_pi<float>(), glm::vec3(0.0f, 0.0f, 1.0f));
+    bodyMtx = glm::rotate(bodyMtx, glm::half_pi<float>(), glm::vec3(1.0f, 0.0f, 0.0f));
+
+    std::vector<glm::vec4> texels(static_cast<size_t>(_numVertices) * NUM_FRAMES * 2);
+    for (GLuint frame = 0; frame < NUM_FRAMES; ++frame) {
+        float wingAngle = glm::two_pi<float>() * frame / NUM_FRAMES;
+        for (GLuint wing = 0; wing < NUM_WINGS; ++wing) {
+            glm::mat4 modelMtx = bodyMtx * getWingMatrix(wing, wingAngle);
+            glm::mat3 normalMtx = glm::transpose(glm::inverse(glm::mat3(modelMtx)));
+            for (GLuint i = 0; i < VERTICES_PER_WING; ++i) {
+                const PrimitiveVertex& vertex = WING_MESH.vertices[i];
+                glm::vec3 position(vertex.position[0], vertex.position[1], vertex.position[2]);
+                glm::vec3 normal(vertex.normal[0], vertex.normal[1], vertex.normal[2]);
+                size_t column = wing * VERTICES_PER_WING + i;
+                texels[frame * _numVertices + column] = modelMtx * glm::vec4(position, 1.0f);
+                texels[(NUM_FRAMES + frame) * _numVertices + column] = glm::vec4(glm::normalize(normalMtx * normal), 0.0f);
+            }
+        }
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // read with texelFetch, the shader blends between frames itself
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, _numVertices, NUM_FRAMES * 2, 0, GL_RGBA, GL_FLOAT, texels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    _animationTexture = registry.adopt(GpuResourceType::TEXTURE, texture, texels.size() * sizeof(glm::vec4), "butterfly animation texture");
+
+    // the only per-vertex attribute left is the wing color, upper wings lighter than lower ones
+    std::vector<glm::vec3> colors(_numVertices);
+    std::vector<GLushort> indices;
+    indices.reserve(NUM_WINGS * WING_MESH.indices.size());
+    for (GLuint wing = 0; wing < NUM_WINGS; ++wing) {
+        glm::vec3 color = (wing < 2 ? glm::vec3(1.0f, 0.8f, 1.0f) : glm::vec3(1.0f, 0.5f, 1.0f));
+        for (GLuint i = 0; i < VERTICES_PER_WING; ++i) colors[wing * VERTICES_PER_WING + i] = color;
+        for (uint16_t index : WING_MESH.indices) indices.push_back(static_cast<GLushort>(wing * VERTICES_PER_WING + index));
+    }
+    _numIndices = static_cast<GLsizei>(indices.size());
+
+    _vao = registry.createVertexArray("butterfly swarm VAO");
+    _colorVBO = registry.createBuffer(GL_ARRAY_BUFFER, colors.size() * sizeof(glm::vec3), colors.data(), GL_STATIC_DRAW, "butterfly swarm color VBO");
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+
+    _instanceVBO = registry.createBuffer(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(maxInstances) * sizeof(Instance), nullptr, GL_STREAM_DRAW, "butterfly swarm instance VBO");
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, positionHeading));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, phase));
+    glVertexAttribDivisor(2, 1);
+
+    _ibo = registry.createBuffer(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW, "butterfly swarm IBO");
+    glBindVertexArray(0);
+
+    fprintf( stdout, "[INFO]: butterfly animation baked, %u vertices x %u frames\n", _numVertices, NUM_FRAMES );
+}
+
+void ButterflySwarm::release() {
+    _vao.reset();
+    _colorVBO.reset();
+    _instanceVBO.reset();
+    _ibo.reset();
+    _animationTexture.reset();
+    _numInstances = 0;
+}
+
+void ButterflySwarm::setInstances(const std::vector<Instance>& instances) {
+    _numInstances = static_cast<GLuint>(std::min<size_t>(instances.size(), _maxInstances));
+    if (_numInstances == 0) return;
+
+    // orphan the previous contents so the upload does not wait on the last draw
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceVBO.get());
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_maxInstances) * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(_numInstances) * sizeof(Instance), instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ButterflySwarm::draw() const {
+    if (_numInstances == 0) return;
+    glBindVertexArray(_vao.get());
+    glDrawElementsInstanced(GL_TRIANGLES, _numIndices, GL_UNSIGNED_SHORT, (void*)0, static_cast<GLsizei>(_numInstances));
+    glBindVertexArray(0);
+}
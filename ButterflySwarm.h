@@ -0,0 +1,56 @@
+#ifndef BUTTERFLY_SWARM_H
+#define BUTTERFLY_SWARM_H
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "GpuResourceRegistry.h"
+
+// Draws any number of Lucid butterflies in a single instanced call.
+// The four wing cones of Lucid::drawLucid are baked, for every step of the
+// flap, into a vertex animation texture: row f holds the position of every
+// vertex at frame f, row NUM_FRAMES + f its normal, both in the butterfly's
+// own space. The vertex shader fetches the two frames around an instance's
+// phase by gl_VertexID and blends them, then places the result with the
+// instance's position and heading, so an instance is only five floats.
+class ButterflySwarm {
+public:
+    // per-instance attributes of shaders/butterfly_swarm.vs.glsl
+    struct Instance {
+        // xyz as Lucid::getPosition, w as Lucid::getHeading
+        glm::vec4 positionHeading;
+        // point in the flap cycle, 0 to 1
+        GLfloat phase;
+    };
+
+    // Lucid::move advances the wings by pi / 20, one cycle is 40 of its steps
+    static constexpr GLuint NUM_FRAMES = 40;
+
+    void create(GpuResourceRegistry& registry, GLuint maxInstances);
+    void release();
+
+    // streams the placements for the following draws, at most maxInstances of them
+    void setInstances(const std::vector<Instance>& instances);
+
+    // bind the swarm program and the animation texture first
+    void draw() const;
+
+    GLuint getAnimationTexture() const { return _animationTexture.get(); }
+    GLuint getNumVertices() const { return _numVertices; }
+    GLuint getNumInstances() const { return _numInstances; }
+
+private:
+    GpuHandle _vao;
+    GpuHandle _colorVBO;
+    GpuHandle _instanceVBO;
+    GpuHandle _ibo;
+    GpuHandle _animationTexture;
+    GLuint _numVertices = 0;
+    GLsizei _numIndices = 0;
+    GLuint _maxInstances = 0;
+    GLuint _numInstances = 0;
+};
+
+#endif // BUTTERFLY_SWARM_H
@@ -0,0 +1,22 @@
+#include "CameraCollision.h"
+
+#include <algorithm>
+
+float CameraCollision::update(const SceneQuery& sceneQuery, glm::vec3 pivot, glm::vec3 desiredEye) {
+    const float desiredDistance = glm::length(desiredEye - pivot);
+
+    float allowedDistance = desiredDistance;
+    SceneQuery::Hit hit;
+    if(sceneQuery.sphereCast(pivot, desiredEye, PROBE_RADIUS, hit, SCENERY_TYPES) && hit.distance > 0.0f) {
+        allowedDistance = std::max(hit.distance, std::min(MIN_DISTANCE, desiredDistance));
+    }
+
+    if(_distance < 0.0f || allowedDistance < _distance) {
+        _distance = allowedDistance;
+    } else {
+        _distance += (allowedDistance - _distance) * EASE_OUT_RATE;
+    }
+    // zooming in needs no easing either
+    _distance = std::min(_distance, desiredDistance);
+    return _distance;
+}
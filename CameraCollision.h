@@ -0,0 +1,36 @@
+#ifndef CAMERA_COLLISION_H
+#define CAMERA_COLLISION_H
+
+#include <glm/glm.hpp>
+
+#include "SceneQuery.h"
+
+// Keeps a camera's eye out of the static scenery. Every tick a small sphere
+// is cast from the point the camera orbits or rides on, its pivot, toward
+// where the eye wants to be, and the eye stops where the sphere first
+// touches a trunk, leaves, lamp or building box. It comes in at once, so it
+// is never inside anything, and eases back out once the way is clear, so a
+// post sliding past does not make it jump in and out.
+// A pivot that is already inside a box leaves the eye where it wants to be.
+class CameraCollision {
+public:
+    // covers the corners of the 0.1 near plane with room to spare
+    static constexpr float PROBE_RADIUS = 0.2f;
+    // fraction of the way back out the eye covers per tick
+    static constexpr float EASE_OUT_RATE = 0.1f;
+    // the eye never comes closer, a view matrix needs some distance to look along
+    static constexpr float MIN_DISTANCE = 0.5f;
+    static constexpr unsigned int SCENERY_TYPES = SceneQuery::typeBit(SceneQuery::ObjectType::TREE) |
+                                                  SceneQuery::typeBit(SceneQuery::ObjectType::LAMP) |
+                                                  SceneQuery::typeBit(SceneQuery::ObjectType::BUILDING);
+
+    // returns how far from the pivot, toward the desired eye, the eye may be this tick
+    float update(const SceneQuery& sceneQuery, glm::vec3 pivot, glm::vec3 desiredEye);
+    // the next update() places the eye without easing, for when the camera was not in use
+    void reset() { _distance = -1.0f; }
+
+private:
+    float _distance = -1.0f;
+};
+
+#endif // CAMERA_COLLISION_H
@@ -0,0 +1,106 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265f
+#endif
+
+void CameraPath::addKey(const CameraKey& key) {
+    // keys are expected in time order, keep them that way
+    _keys.push_back(key);
+    for(size_t i = _keys.size() - 1; i > 0 && _keys[i].time < _keys[i - 1].time; --i) {
+        std::swap(_keys[i], _keys[i - 1]);
+    }
+}
+
+float CameraPath::getDuration() const {
+    return _keys.empty() ? 0.0f : _keys.back().time;
+}
+
+CameraKey CameraPath::sample(float time) const {
+    if(_keys.empty()) return CameraKey{0.0f, glm::vec3(0.0f), 0.0f, 0.0f, 10.0f};
+    if(time <= _keys.front().time) return _keys.front();
+    if(time >= _keys.back().time) return _keys.back();
+
+    // find the segment containing time and linearly blend the two keys
+    size_t next = 1;
+    while(_keys[next].time < time) ++next;
+    const CameraKey& a = _keys[next - 1];
+    const CameraKey& b = _keys[next];
+
+    float t = (time - a.time) / (b.time - a.time);
+    CameraKey key;
+    key.time = time;
+    key.position = a.position + (b.position - a.position) * t;
+    key.theta = a.theta + (b.theta - a.theta) * t;
+    key.phi = a.phi + (b.phi - a.phi) * t;
+    key.radius = a.radius + (b.radius - a.radius) * t;
+    return key;
+}
+
+CameraPath CameraPath::arcballOrbit(float worldSize) {
+    // sweep the target corner to corner while orbiting twice, zooming out then back in
+    CameraPath path;
+    const float EDGE = worldSize * 0.8f;
+    path.addKey({ 0.0f, glm::vec3(-EDGE, 0.0f, -EDGE), 0.0f,               glm::radians(60.0f), 10.0f});
+    path.addKey({ 5.0f, glm::vec3(-EDGE * 0.5f, 0.0f, 0.0f), (float)M_PI,  glm::radians(80.0f),  5.0f});
+    path.addKey({10.0f, glm::vec3(0.0f, 0.0f, 0.0f), 2.0f * (float)M_PI,   glm::radians(30.0f), 40.0f});
+    path.addKey({15.0f, glm::vec3(EDGE * 0.5f, 0.0f, 0.0f), 3.0f * (float)M_PI, glm::radians(85.0f),  3.0f});
+    path.addKey({20.0f, glm::vec3(EDGE, 0.0f, EDGE), 4.0f * (float)M_PI,   glm::radians(60.0f), 10.0f});
+    return path;
+}
+
+CameraPath CameraPath::freeCamFlyover(float worldSize) {
+    // circle the island high up looking inward, then dive down and skim through the trees
+    CameraPath path;
+    const int NUM_ORBIT_KEYS = 8;
+    const float ORBIT_RADIUS = worldSize * 1.1f;
+    for(int i = 0; i <= NUM_ORBIT_KEYS; ++i) {
+        float angle = 2.0f * (float)M_PI * i / NUM_ORBIT_KEYS;
+        glm::vec3 eye(ORBIT_RADIUS * cos(angle), 40.0f, ORBIT_RADIUS * sin(angle));
+        // theta chosen so the free cam faces the center of the world
+        float theta = atan2(-eye.x, eye.z);
+        if(i > 0) {
+            while(theta < path._keys.back().theta - (float)M_PI) theta += 2.0f * (float)M_PI;
+            while(theta > path._keys.back().theta + (float)M_PI) theta -= 2.0f * (float)M_PI;
+        }
+        path.addKey({1.5f * i, eye, theta, (float)M_PI / 2.8f, 0.0f});
+    }
+    float lastTime = path.getDuration();
+    path.addKey({lastTime + 3.0f, glm::vec3(worldSize * 0.9f, 3.0f, 0.0f), path._keys.back().theta, (float)M_PI / 2.0f, 0.0f});
+    path.addKey({lastTime + 9.0f, glm::vec3(-worldSize * 0.9f, 3.0f, 0.0f), path._keys.back().theta, (float)M_PI / 2.0f, 0.0f});
+    return path;
+}
+
+CameraPath CameraPath::firstPersonWalk(float worldSize) {
+    // walk a square loop at ground level, turning at each corner
+    CameraPath path;
+    const float EDGE = worldSize * 0.7f;
+    const glm::vec3 CORNERS[5] = {
+        glm::vec3(-EDGE, 0.0f, -EDGE),
+        glm::vec3( EDGE, 0.0f, -EDGE),
+        glm::vec3( EDGE, 0.0f,  EDGE),
+        glm::vec3(-EDGE, 0.0f,  EDGE),
+        glm::vec3(-EDGE, 0.0f, -EDGE)
+    };
+    const float SIDE_TIME = 5.0f;
+    const float TURN_TIME = 0.5f;
+    float time = 0.0f;
+    for(int i = 0; i < 4; ++i) {
+        glm::vec3 dir = CORNERS[i + 1] - CORNERS[i];
+        // FPCamera looks along (sin(heading), 0, cos(heading))
+        float heading = atan2(dir.x, dir.z);
+        if(i > 0) {
+            // keep the heading continuous so interpolation turns the short way
+            while(heading < path._keys.back().theta - (float)M_PI) heading += 2.0f * (float)M_PI;
+            while(heading > path._keys.back().theta + (float)M_PI) heading -= 2.0f * (float)M_PI;
+            time += TURN_TIME;
+        }
+        path.addKey({time, CORNERS[i], heading, 0.0f, 0.0f});
+        time += SIDE_TIME;
+        path.addKey({time, CORNERS[i + 1], heading, 0.0f, 0.0f});
+    }
+    return path;
+}
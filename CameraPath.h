@@ -0,0 +1,38 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// A single keyframe along a scripted camera path.
+// Each camera interprets the fields it needs:
+//   Arcball     - position is the target, theta/phi/radius place the eye
+//   FreeCam     - position is the eye, theta/phi give the look direction
+//   First person - position is the hero position, theta is the hero heading
+struct CameraKey {
+    float time;
+    glm::vec3 position;
+    float theta;
+    float phi;
+    float radius;
+};
+
+class CameraPath {
+public:
+    CameraPath() = default;
+
+    void addKey(const CameraKey& key);
+    CameraKey sample(float time) const;
+    float getDuration() const;
+    bool isEmpty() const { return _keys.empty(); }
+
+    // Predefined paths used by the flythrough benchmark
+    static CameraPath arcballOrbit(float worldSize);
+    static CameraPath freeCamFlyover(float worldSize);
+    static CameraPath firstPersonWalk(float worldSize);
+
+private:
+    std::vector<CameraKey> _keys;
+};
+
+#endif // CAMERA_PATH_H
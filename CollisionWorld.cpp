@@ -0,0 +1,232 @@
+#include "CollisionWorld.h"
+
+#include <algorithm>
+#include <cmath>
+
+CollisionWorld::CollisionWorld(float worldSize, float cellSize)
+    : _worldSize(worldSize),
+      _cellSize(cellSize),
+      _queryStamp(0),
+      _stats{0, 0, 0}
+{
+    _gridSize = std::max(1, static_cast<int>(std::ceil(2.0f * worldSize / cellSize)));
+    _cells.resize(static_cast<size_t>(_gridSize) * _gridSize);
+}
+
+void CollisionWorld::clear() {
+    _staticCircles.clear();
+    _staticStamps.clear();
+    for(auto& cell : _cells) cell.clear();
+    _bodies.clear();
+    _axes[0].clear();
+    _axes[1].clear();
+}
+
+void CollisionWorld::_cellRange(glm::vec2 boundsMin, glm::vec2 boundsMax, glm::ivec2& cellMin, glm::ivec2& cellMax) const {
+    // anything outside the world lands in the border cells
+    auto toCell = [this](float value) {
+        int cell = static_cast<int>(std::floor((value + _worldSize) / _cellSize));
+        return std::min(std::max(cell, 0), _gridSize - 1);
+    };
+    cellMin = glm::ivec2(toCell(boundsMin.x), toCell(boundsMin.y));
+    cellMax = glm::ivec2(toCell(boundsMax.x), toCell(boundsMax.y));
+}
+
+void CollisionWorld::addStaticCircle(glm::vec2 center, float radius) {
+    unsigned int index = static_cast<unsigned int>(_staticCircles.size());
+    _staticCircles.push_back({center, radius});
+    _staticStamps.push_back(0);
+
+    glm::ivec2 cellMin, cellMax;
+    _cellRange(center - radius, center + radius, cellMin, cellMax);
+    for(int y = cellMin.y; y <= cellMax.y; ++y) {
+        for(int x = cellMin.x; x <= cellMax.x; ++x) {
+            _cells[static_cast<size_t>(y) * _gridSize + x].push_back(index);
+        }
+    }
+}
+
+CollisionWorld::BodyId CollisionWorld::addBody(glm::vec2 position, float radius) {
+    BodyId id = static_cast<BodyId>(_bodies.size());
+    Body body{};
+    body.position = position;
+    body.radius = radius;
+    body.boundsMin = position - radius;
+    body.boundsMax = position + radius;
+    _bodies.push_back(body);
+
+    // append both endpoints at the end of each axis and let them sink into place,
+    // every body they pass gets its pair updated on the way
+    for(int axis = 0; axis < 2; ++axis) {
+        std::vector<Endpoint>& endpoints = _axes[axis];
+        _bodies[id].endpoints[axis][0] = endpoints.size();
+        endpoints.push_back({_bodies[id].boundsMin[axis], id, true});
+        _bodies[id].endpoints[axis][1] = endpoints.size();
+        endpoints.push_back({_bodies[id].boundsMax[axis], id, false});
+        _bubble(axis, _bodies[id].endpoints[axis][0]);
+        _bubble(axis, _bodies[id].endpoints[axis][1]);
+    }
+    return id;
+}
+
+void CollisionWorld::setBodyPosition(BodyId body, glm::vec2 position) {
+    _bodies[body].position = position;
+    _setBounds(body, position - _bodies[body].radius, position + _bodies[body].radius);
+}
+
+void CollisionWorld::_setBounds(BodyId id, glm::vec2 boundsMin, glm::vec2 boundsMax) {
+    Body& body = _bodies[id];
+    body.boundsMin = boundsMin;
+    body.boundsMax = boundsMax;
+    for(int axis = 0; axis < 2; ++axis) {
+        _axes[axis][body.endpoints[axis][0]].value = boundsMin[axis];
+        _axes[axis][body.endpoints[axis][1]].value = boundsMax[axis];
+        // grow outward first so min never crosses its own max
+        _bubble(axis, body.endpoints[axis][1]);
+        _bubble(axis, body.endpoints[axis][0]);
+    }
+}
+
+void CollisionWorld::_bubble(int axis, size_t index) {
+    std::vector<Endpoint>& endpoints = _axes[axis];
+    while(index > 0 && endpoints[index - 1].value > endpoints[index].value) {
+        _swap(axis, index - 1, index);
+        --index;
+    }
+    while(index + 1 < endpoints.size() && endpoints[index + 1].value < endpoints[index].value) {
+        _swap(axis, index, index + 1);
+        ++index;
+    }
+}
+
+void CollisionWorld::_swap(int axis, size_t left, size_t right) {
+    std::vector<Endpoint>& endpoints = _axes[axis];
+    const Endpoint& a = endpoints[left];
+    const Endpoint& b = endpoints[right];
+    // overlap can only start or stop where a min passes a max of another body
+    if(a.body != b.body && a.isMin != b.isMin) {
+        _updatePair(a.body, b.body);
+    }
+
+    std::swap(endpoints[left], endpoints[right]);
+    _bodies[endpoints[left].body].endpoints[axis][endpoints[left].isMin ? 0 : 1] = left;
+    _bodies[endpoints[right].body].endpoints[axis][endpoints[right].isMin ? 0 : 1] = right;
+    _stats.endpointSwaps++;
+}
+
+void CollisionWorld::_updatePair(BodyId a, BodyId b) {
+    // bounds are already final when endpoints move, so test both axes directly
+    const Body& bodyA = _bodies[a];
+    const Body& bodyB = _bodies[b];
+    bool overlapping = bodyA.boundsMin.x < bodyB.boundsMax.x && bodyB.boundsMin.x < bodyA.boundsMax.x &&
+                       bodyA.boundsMin.y < bodyB.boundsMax.y && bodyB.boundsMin.y < bodyA.boundsMax.y;
+
+    std::vector<BodyId>& partnersA = _bodies[a].partners;
+    std::vector<BodyId>& partnersB = _bodies[b].partners;
+    auto found = std::find(partnersA.begin(), partnersA.end(), b);
+    if(overlapping && found == partnersA.end()) {
+        partnersA.push_back(b);
+        partnersB.push_back(a);
+    } else if(!overlapping && found != partnersA.end()) {
+        partnersA.erase(found);
+        partnersB.erase(std::find(partnersB.begin(), partnersB.end(), a));
+    }
+}
+
+void CollisionWorld::_gatherCandidates(BodyId id, glm::vec2 boundsMin, glm::vec2 boundsMax) {
+    _candidates.clear();
+
+    _queryStamp++;
+    glm::ivec2 cellMin, cellMax;
+    _cellRange(boundsMin, boundsMax, cellMin, cellMax);
+    for(int y = cellMin.y; y <= cellMax.y; ++y) {
+        for(int x = cellMin.x; x <= cellMax.x; ++x) {
+            for(unsigned int index : _cells[static_cast<size_t>(y) * _gridSize + x]) {
+                if(_staticStamps[index] == _queryStamp) continue;
+                _staticStamps[index] = _queryStamp;
+                _candidates.push_back(_staticCircles[index]);
+            }
+        }
+    }
+
+    // other bodies are treated as standing still while this one moves
+    for(BodyId partner : _bodies[id].partners) {
+        _candidates.push_back({_bodies[partner].position, _bodies[partner].radius});
+    }
+}
+
+bool CollisionWorld::_sweepCircle(glm::vec2 start, glm::vec2 motion, float radius, const Circle& obstacle, float& hitTime, glm::vec2& hitNormal) {
+    // solve |start + t * motion - center| = radius + obstacle.radius for the first t in [0, 1]
+    float contactDistance = radius + obstacle.radius;
+    glm::vec2 offset = start - obstacle.center;
+    float a = glm::dot(motion, motion);
+    float b = glm::dot(offset, motion);
+    float c = glm::dot(offset, offset) - contactDistance * contactDistance;
+
+    if(c < 0.0f) {
+        // already overlapping, only block motion that digs further in
+        if(b >= 0.0f) return false;
+        float length = glm::length(offset);
+        hitTime = 0.0f;
+        hitNormal = length > 0.0f ? offset / length : glm::vec2(-motion / std::sqrt(a));
+        return true;
+    }
+    if(b >= 0.0f || a <= 0.0f) return false;
+
+    float discriminant = b * b - a * c;
+    if(discriminant < 0.0f) return false;
+
+    float t = (-b - std::sqrt(discriminant)) / a;
+    if(t > 1.0f) return false;
+
+    hitTime = std::max(t, 0.0f);
+    hitNormal = glm::normalize(offset + motion * hitTime);
+    return true;
+}
+
+glm::vec2 CollisionWorld::moveBody(BodyId id, glm::vec2 target) {
+    Body& body = _bodies[id];
+    glm::vec2 position = body.position;
+    glm::vec2 motion = target - position;
+    float reach = body.radius + glm::length(motion);
+
+    // fatten the bounds over everything the slide can reach this step so the
+    // broadphase pairs cover the whole sweep, not just the end position
+    _setBounds(id, position - reach, position + reach);
+    _gatherCandidates(id, position - reach, position + reach);
+
+    for(int iteration = 0; iteration < MAX_SLIDE_ITERATIONS; ++iteration) {
+        float motionLength = glm::length(motion);
+        if(motionLength <= SKIN_WIDTH) break;
+
+        float hitTime = 1.0f;
+        glm::vec2 hitNormal(0.0f);
+        bool hit = false;
+        for(const Circle& obstacle : _candidates) {
+            float t;
+            glm::vec2 normal;
+            _stats.candidatesTested++;
+            if(_sweepCircle(position, motion, _bodies[id].radius, obstacle, t, normal) && t < hitTime) {
+                hitTime = t;
+                hitNormal = normal;
+                hit = true;
+            }
+        }
+
+        if(!hit) {
+            position += motion;
+            break;
+        }
+        _stats.hits++;
+
+        // stop just short of contact, then slide the rest along the contact tangent
+        float travel = std::max(hitTime * motionLength - SKIN_WIDTH, 0.0f);
+        position += motion * (travel / motionLength);
+        glm::vec2 remaining = motion * (1.0f - hitTime);
+        motion = remaining - hitNormal * glm::dot(remaining, hitNormal);
+    }
+
+    _bodies[id].position = position;
+    _setBounds(id, position - _bodies[id].radius, position + _bodies[id].radius);
+    return position;
+}
@@ -0,0 +1,95 @@
+#ifndef COLLISION_WORLD_H
+#define COLLISION_WORLD_H
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// Collision on the ground plane, every shape is a circle in XZ.
+// Static obstacles (trunks, posts, buildings) live in a uniform grid.
+// Moving bodies are kept in an incremental sweep-and-prune on both axes:
+// endpoint lists stay sorted by insertion sort between moves, so a body only
+// pays for the neighbours it actually passes and the overlapping pairs are
+// updated as endpoints swap.
+// Moves are swept against everything the broadphase reports and slide along
+// whatever they hit instead of stopping, so fast bodies cannot tunnel.
+class CollisionWorld {
+public:
+    typedef int BodyId;
+
+    struct Stats {
+        unsigned int endpointSwaps;
+        unsigned int candidatesTested;
+        unsigned int hits;
+    };
+
+    CollisionWorld(float worldSize, float cellSize = 4.0f);
+
+    // removes all static obstacles and bodies
+    void clear();
+
+    void addStaticCircle(glm::vec2 center, float radius);
+
+    BodyId addBody(glm::vec2 position, float radius);
+    // teleports the body without sweeping
+    void setBodyPosition(BodyId body, glm::vec2 position);
+    glm::vec2 getBodyPosition(BodyId body) const { return _bodies[body].position; }
+    size_t getNumBodies() const { return _bodies.size(); }
+
+    // sweeps the body toward target and returns where it ended up
+    glm::vec2 moveBody(BodyId body, glm::vec2 target);
+
+    const Stats& getStats() const { return _stats; }
+    void resetStats() { _stats = {0, 0, 0}; }
+
+    static constexpr int MAX_SLIDE_ITERATIONS = 4;
+    // gap left between surfaces after a hit so the next sweep does not start in contact
+    static constexpr float SKIN_WIDTH = 1e-3f;
+
+private:
+    struct Circle {
+        glm::vec2 center;
+        float radius;
+    };
+
+    struct Endpoint {
+        float value;
+        BodyId body;
+        bool isMin;
+    };
+
+    struct Body {
+        glm::vec2 position;
+        float radius;
+        glm::vec2 boundsMin;
+        glm::vec2 boundsMax;
+        // index of the min and max endpoint on each axis
+        size_t endpoints[2][2];
+        std::vector<BodyId> partners;
+    };
+
+    float _worldSize;
+    float _cellSize;
+    int _gridSize;
+    std::vector<Circle> _staticCircles;
+    std::vector<std::vector<unsigned int>> _cells;
+    // stamp per static circle so one query never tests it twice
+    std::vector<unsigned int> _staticStamps;
+    unsigned int _queryStamp;
+
+    std::vector<Body> _bodies;
+    std::vector<Endpoint> _axes[2];
+
+    std::vector<Circle> _candidates;
+    Stats _stats;
+
+    void _cellRange(glm::vec2 boundsMin, glm::vec2 boundsMax, glm::ivec2& cellMin, glm::ivec2& cellMax) const;
+    void _setBounds(BodyId body, glm::vec2 boundsMin, glm::vec2 boundsMax);
+    void _bubble(int axis, size_t index);
+    void _swap(int axis, size_t left, size_t right);
+    void _updatePair(BodyId a, BodyId b);
+    void _gatherCandidates(BodyId body, glm::vec2 boundsMin, glm::vec2 boundsMax);
+
+    static bool _sweepCircle(glm::vec2 start, glm::vec2 motion, float radius, const Circle& obstacle, float& hitTime, glm::vec2& hitNormal);
+};
+
+#endif // COLLISION_WORLD_H
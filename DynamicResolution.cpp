@@ -0,0 +1,176 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+DynamicResolution::DynamicResolution()
+    : _targetMs(0.0),
+      _scaleLimit(MAX_SCALE),
+      _scale(MAX_SCALE),
+      _fullResolutionMs(0.0),
+      _hasEstimate(false),
+      _windowWidth(0),
+      _windowHeight(0),
+      _renderWidth(0),
+      _renderHeight(0),
+      _hdr(false),
+      _framebuffer(0),
+      _targetWidth(0),
+      _targetHeight(0),
+      _pGpuTimer(nullptr),
+      _pendingHead(0),
+      _numPendingScales(0)
+{}
+
+DynamicResolution::~DynamicResolution() {
+    release();
+}
+
+void DynamicResolution::setScaleLimit(float scale) {
+    _scaleLimit = std::min(std::max(scale, MIN_SCALE), MAX_SCALE);
+    _scale = std::min(_scale, _scaleLimit);
+}
+
+void DynamicResolution::setHDR(bool hdr) {
+    if(hdr == _hdr) return;
+    _hdr = hdr;
+    // a zero size makes the next beginScene() allocate the target in the new format
+    _targetWidth = 0;
+    _targetHeight = 0;
+}
+
+void DynamicResolution::beginScene(GpuResourceRegistry& registry, RenderStateCache& renderStateCache, GLint windowWidth, GLint windowHeight) {
+    if(_pGpuTimer == nullptr) _pGpuTimer = new GpuTimer(TIMER_QUERIES);
+
+    _updateScale();
+
+    // the target only grows, shrinking the window just renders into a corner of it
+    if(windowWidth > _targetWidth || windowHeight > _targetHeight) {
+        _allocateTarget(registry, renderStateCache, std::max(windowWidth, _targetWidth), std::max(windowHeight, _targetHeight));
+    }
+
+    _windowWidth = windowWidth;
+    _windowHeight = windowHeight;
+    _renderWidth = std::max(1, static_cast<GLint>(std::lround(windowWidth * _scale)));
+    _renderHeight = std::max(1, static_cast<GLint>(std::lround(windowHeight * _scale)));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    glViewport(0, 0, _renderWidth, _renderHeight);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    _pGpuTimer->begin();
+    if(_numPendingScales == MAX_PENDING_SCALES) {
+        _pendingHead = (_pendingHead + 1) % MAX_PENDING_SCALES;
+        _numPendingScales--;
+    }
+    _pendingScales[(_pendingHead + _numPendingScales) % MAX_PENDING_SCALES] = _scale;
+    _numPendingScales++;
+}
+
+void DynamicResolution::endScene() {
+    _pGpuTimer->end();
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, _renderWidth, _renderHeight,
+                      0, 0, _windowWidth, _windowHeight,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, _windowWidth, _windowHeight);
+}
+
+void DynamicResolution::endSceneInTarget() {
+    _pGpuTimer->end();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, _windowWidth, _windowHeight);
+}
+
+void DynamicResolution::release() {
+    if(_framebuffer != 0) {
+        glDeleteFramebuffers(1, &_framebuffer);
+        _framebuffer = 0;
+    }
+    _colorTexture.reset();
+    _depthTexture.reset();
+    _targetWidth = 0;
+    _targetHeight = 0;
+
+    delete _pGpuTimer;
+    _pGpuTimer = nullptr;
+    _pendingHead = 0;
+    _numPendingScales = 0;
+}
+
+void DynamicResolution::_allocateTarget(GpuResourceRegistry& registry, RenderStateCache& renderStateCache, GLint width, GLint height) {
+    if(_framebuffer == 0) glGenFramebuffers(1, &_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+
+    size_t bytes = static_cast<size_t>(width) * height * 4;
+
+    GLuint colorTexture;
+    glGenTextures(1, &colorTexture);
+    // through the cache, so it does not skip the next bind on this unit
+    renderStateCache.bindTexture(ALLOCATION_TEXTURE_UNIT, GL_TEXTURE_2D, colorTexture);
+    if(_hdr) {
+        // floats without alpha in the same four bytes, nothing reads the scene's alpha
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, width, height, 0, GL_RGB, GL_FLOAT, nullptr);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // post-processing taps past the edge must not wrap around
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    _colorTexture = registry.adopt(GpuResourceType::TEXTURE, colorTexture, bytes, (_hdr ? "dynamic resolution HDR color" : "dynamic resolution color"));
+
+    GLuint depthTexture;
+    glGenTextures(1, &depthTexture);
+    renderStateCache.bindTexture(ALLOCATION_TEXTURE_UNIT, GL_TEXTURE_2D, depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    _depthTexture = registry.adopt(GpuResourceType::TEXTURE, depthTexture, bytes, "dynamic resolution depth");
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if(status != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf( stderr, "[ERROR]: dynamic resolution target is incomplete (0x%x)\n", status );
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    _targetWidth = width;
+    _targetHeight = height;
+    fprintf( stdout, "[INFO]: dynamic resolution %starget allocated at %dx%d\n", (_hdr ? "HDR " : ""), width, height );
+}
+
+void DynamicResolution::_updateScale() {
+    // results come back a few frames late and in order, each one carries the scale it was rendered at
+    double elapsedMs;
+    while(_numPendingScales > 0 && _pGpuTimer->popResult(elapsedMs)) {
+        float measuredScale = _pendingScales[_pendingHead];
+        _pendingHead = (_pendingHead + 1) % MAX_PENDING_SCALES;
+        _numPendingScales--;
+
+        // fill cost goes with the pixel count, so normalize the sample to full resolution
+        double fullMs = elapsedMs / (measuredScale * measuredScale);
+        if(_hasEstimate) {
+            _fullResolutionMs += SMOOTHING * (fullMs - _fullResolutionMs);
+        } else {
+            _fullResolutionMs = fullMs;
+            _hasEstimate = true;
+        }
+    }
+    if(_targetMs <= 0.0) {
+        _scale = _scaleLimit;
+        return;
+    }
+    if(!_hasEstimate || _fullResolutionMs <= 0.0) return;
+
+    float desired = static_cast<float>(std::sqrt(HEADROOM * _targetMs / _fullResolutionMs));
+    desired = std::min(std::max(desired, MIN_SCALE), _scaleLimit);
+    _scale += std::min(std::max(desired - _scale, -MAX_STEP), MAX_STEP);
+}
@@ -0,0 +1,99 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <glad/gl.h>
+
+#include "GpuResourceRegistry.h"
+#include "GpuTimer.h"
+#include "RenderStateCache.h"
+
+// Renders the 3D scene into an offscreen target at a fraction of the window
+// resolution and bilinearly upscales it to the default framebuffer. The
+// fraction is picked every frame from the GPU time of the scene so the frame
+// holds a target budget; fill bound scenes trade sharpness for frame rate.
+// Without a budget the scene renders at the scale limit.
+class DynamicResolution {
+public:
+    DynamicResolution();
+    ~DynamicResolution();
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    // 0 turns the budget off
+    void setTargetFrameTime(double targetMs) { _targetMs = targetMs; }
+    double getTargetFrameTime() const { return _targetMs; }
+    // highest scale picked, clamped to MIN_SCALE to MAX_SCALE
+    void setScaleLimit(float scale);
+    float getScaleLimit() const { return _scaleLimit; }
+
+    // binds the offscreen target (reallocated when the window grows), sets the
+    // viewport to the scaled size, clears it and starts timing the scene
+    void beginScene(GpuResourceRegistry& registry, RenderStateCache& renderStateCache, GLint windowWidth, GLint windowHeight);
+    // stops timing, upscales into the default framebuffer and leaves it bound
+    // with a full window viewport
+    void endScene();
+    // stops timing and binds the default framebuffer with a full window viewport,
+    // the scene stays in the lower left render size of getColorTexture()
+    void endSceneInTarget();
+    // deletes the target and the timer queries, call before the context goes away
+    void release();
+
+    // an HDR target keeps colors above 1 for post-processing, the next beginScene() reallocates it
+    void setHDR(bool hdr);
+    bool isHDR() const { return _hdr; }
+
+    float getScale() const { return _scale; }
+    GLint getRenderWidth() const { return _renderWidth; }
+    GLint getRenderHeight() const { return _renderHeight; }
+    GLuint getColorTexture() const { return _colorTexture.get(); }
+    GLint getTargetWidth() const { return _targetWidth; }
+    GLint getTargetHeight() const { return _targetHeight; }
+
+    static constexpr float MIN_SCALE = 0.5f;
+    static constexpr float MAX_SCALE = 1.0f;
+
+private:
+    // aim a little under the budget so noise does not push frames over it
+    static constexpr double HEADROOM = 0.9;
+    // weight of a new sample in the smoothed full resolution cost
+    static constexpr double SMOOTHING = 0.2;
+    // largest change of the scale per frame, keeps the image from pumping
+    static constexpr float MAX_STEP = 0.05f;
+    // queries the scene timer keeps in flight
+    static constexpr GLuint TIMER_QUERIES = 4;
+    // in flight plus read back but not yet popped, so the ring never overflows
+    static constexpr GLuint MAX_PENDING_SCALES = 2 * TIMER_QUERIES;
+    // unit the target's textures are bound to while they are set up
+    static constexpr GLuint ALLOCATION_TEXTURE_UNIT = 0;
+
+    double _targetMs;
+    float _scaleLimit;
+    float _scale;
+    // GPU milliseconds the scene would take at full resolution
+    double _fullResolutionMs;
+    bool _hasEstimate;
+
+    GLint _windowWidth;
+    GLint _windowHeight;
+    GLint _renderWidth;
+    GLint _renderHeight;
+
+    bool _hdr;
+    GLuint _framebuffer;
+    GLint _targetWidth;
+    GLint _targetHeight;
+    GpuHandle _colorTexture;
+    GpuHandle _depthTexture;
+
+    GpuTimer* _pGpuTimer;
+    // scale each timed frame was rendered at, matched to results in order; a
+    // fixed ring so steady frames do not allocate
+    float _pendingScales[MAX_PENDING_SCALES];
+    GLuint _pendingHead;    // oldest scale
+    GLuint _numPendingScales;
+
+    void _allocateTarget(GpuResourceRegistry& registry, RenderStateCache& renderStateCache, GLint width, GLint height);
+    void _updateScale();
+};
+
+#endif // DYNAMIC_RESOLUTION_H
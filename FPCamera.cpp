@@ -1,14 +1,22 @@
 // FPSCamera.cpp
 #include "FPCamera.h"
 
+#include <algorithm>
+
 FPCamera::FPCamera(float heightOffset)
-    : _position(0.0f), _heading(0.0f), _heightOffset(heightOffset) {}
+    : _position(0.0f), _heroPosition(0.0f), _heading(0.0f), _heightOffset(heightOffset), _heightLimit(heightOffset) {}
 
 void FPCamera::updatePositionAndOrientation(const glm::vec3& heroPosition, float heroHeading) {
-    _position = heroPosition + glm::vec3(0.0f, _heightOffset, 0.0f);
+    _heroPosition = heroPosition;
+    _position = heroPosition + glm::vec3(0.0f, std::min(_heightOffset, _heightLimit), 0.0f);
     _heading = heroHeading;
 }
 
+void FPCamera::setHeightLimit(float maxHeightOffset) {
+    _heightLimit = maxHeightOffset;
+    _position = _heroPosition + glm::vec3(0.0f, std::min(_heightOffset, _heightLimit), 0.0f);
+}
+
 glm::vec3 FPCamera::getPosition() const {
     return _position;
 }
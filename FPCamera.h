@@ -11,11 +11,18 @@ public:
     void updatePositionAndOrientation(const glm::vec3& heroPosition, float heroHeading);
     glm::mat4 getViewMatrix() const;
     glm::vec3 getPosition() const;
+    glm::vec3 getHeroPosition() const { return _heroPosition; }
+    // where the eye would be without the height limit
+    glm::vec3 getDesiredPosition() const { return _heroPosition + glm::vec3(0.0f, _heightOffset, 0.0f); }
+    // keeps the eye this far above the hero at most, see CameraCollision
+    void setHeightLimit(float maxHeightOffset);
 
 private:
     glm::vec3 _position;
+    glm::vec3 _heroPosition;
     float _heading;
     float _heightOffset;
+    float _heightLimit;
 };
 
 #endif // FP_CAMERA_H
@@ -0,0 +1,370 @@
+#include "Flock.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLOCK_SSE
+#endif
+
+#ifdef FLOCK_SSE
+static inline float horizontalSum(__m128 v) {
+    __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+#endif
+
+Flock::Flock(unsigned int numThreads) :
+        _hashWidth(0),
+        _hashHeight(0),
+        _obstaclesDirty(true),
+        _obstacleGridWidth(0),
+        _generation(0),
+        _busyWorkers(0),
+        _quit(false),
+        _nextChunk(0) {
+    setNumThreads(numThreads);
+}
+
+Flock::~Flock() {
+    _stopWorkers();
+}
+
+void Flock::setNumThreads(unsigned int numThreads) {
+    _stopWorkers();
+    _quit = false;
+    for (unsigned int i = 1; i < numThreads; ++i) {
+        _workers.emplace_back(&Flock::_workerLoop, this, _generation);
+    }
+}
+
+void Flock::_stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    _wake.notify_all();
+    for (std::thread& worker : _workers) worker.join();
+    _workers.clear();
+}
+
+void Flock::_workerLoop(uint64_t seenGeneration) {
+    // started before any update it has to take part in
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&] { return _quit || _generation != seenGeneration; });
+            if (_quit) return;
+            seenGeneration = _generation;
+        }
+        _steerChunks();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_busyWorkers == 0) _done.notify_one();
+        }
+    }
+}
+
+void Flock::clear() {
+    _positionX.clear(); _positionY.clear(); _positionZ.clear();
+    _velocityX.clear(); _velocityY.clear(); _velocityZ.clear();
+    _ids.clear();
+}
+
+void Flock::addAgent(glm::vec3 position, glm::vec3 velocity) {
+    _ids.push_back(static_cast<uint32_t>(_positionX.size()));
+    _positionX.push_back(position.x);
+    _positionY.push_back(position.y);
+    _positionZ.push_back(position.z);
+    _velocityX.push_back(velocity.x);
+    _velocityY.push_back(velocity.y);
+    _velocityZ.push_back(velocity.z);
+}
+
+void Flock::addObstacle(glm::vec2 center, float radius) {
+    _obstacles.push_back(glm::vec3(center.x, center.y, radius));
+    _obstaclesDirty = true;
+}
+
+void Flock::clearObstacles() {
+    _obstacles.clear();
+    _obstaclesDirty = true;
+}
+
+uint32_t Flock::_bucket(int x, int y, int z) const {
+    return ((static_cast<uint32_t>(z) & (_hashWidth - 1)) * _hashHeight + (static_cast<uint32_t>(y) & (_hashHeight - 1))) * _hashWidth
+           + (static_cast<uint32_t>(x) & (_hashWidth - 1));
+}
+
+glm::ivec3 Flock::_cell(float x, float y, float z) const {
+    // shifted so the wrap falls on the edge of the bounds rather than through the middle
+    float inverseCellSize = 1.0f / _parameters.neighborRadius;
+    return glm::ivec3(static_cast<int>(std::floor((x + _parameters.boundsHalfSize) * inverseCellSize)),
+                      static_cast<int>(std::floor(y * inverseCellSize)),
+                      static_cast<int>(std::floor((z + _parameters.boundsHalfSize) * inverseCellSize)));
+}
+
+void Flock::_resizeHash() {
+    // the bounds plus a cell either side, and never fewer than four so a row of three cells never wraps onto itself
+    uint32_t width = 4, height = 4;
+    while (width < 2.0f * _parameters.boundsHalfSize / _parameters.neighborRadius + 2.0f) width *= 2;
+    while (height < _parameters.maxHeight / _parameters.neighborRadius + 2.0f) height *= 2;
+    _hashWidth = width;
+    _hashHeight = height;
+    _bucketStart.resize(static_cast<size_t>(width) * width * height + 1);
+    _bucketCursor.resize(static_cast<size_t>(width) * width * height);
+}
+
+void Flock::_buildObstacleGrid() {
+    _obstaclesDirty = false;
+    _resizeHash();
+    float extent = _parameters.boundsHalfSize + _parameters.obstacleMargin;
+    _obstacleGridWidth = std::max(1, static_cast<int>(std::ceil(2.0f * extent / OBSTACLE_CELL_SIZE)));
+    size_t numCells = static_cast<size_t>(_obstacleGridWidth) * _obstacleGridWidth;
+
+    // every obstacle goes in each cell its reach overlaps, counted then scattered
+    auto forEachCell = [&](const glm::vec3& obstacle, auto visit) {
+        float reach = obstacle.z + _parameters.obstacleMargin;
+        int minX = std::max(0, static_cast<int>((obstacle.x - reach + extent) / OBSTACLE_CELL_SIZE));
+        int maxX = std::min(_obstacleGridWidth - 1, static_cast<int>((obstacle.x + reach + extent) / OBSTACLE_CELL_SIZE));
+        int minZ = std::max(0, static_cast<int>((obstacle.y - reach + extent) / OBSTACLE_CELL_SIZE));
+        int maxZ = std::min(_obstacleGridWidth - 1, static_cast<int>((obstacle.y + reach + extent) / OBSTACLE_CELL_SIZE));
+        for (int z = minZ; z <= maxZ; ++z) {
+            for (int x = minX; x <= maxX; ++x) visit(static_cast<size_t>(z) * _obstacleGridWidth + x);
+        }
+    };
+
+    _obstacleCellStart.assign(numCells + 1, 0);
+    for (const glm::vec3& obstacle : _obstacles) {
+        forEachCell(obstacle, [&](size_t cell) { _obstacleCellStart[cell + 1]++; });
+    }
+    for (size_t cell = 0; cell < numCells; ++cell) _obstacleCellStart[cell + 1] += _obstacleCellStart[cell];
+    _obstacleIndices.resize(_obstacleCellStart[numCells]);
+    std::vector<uint32_t> cursor(_obstacleCellStart.begin(), _obstacleCellStart.end() - 1);
+    for (size_t i = 0; i < _obstacles.size(); ++i) {
+        forEachCell(_obstacles[i], [&](size_t cell) { _obstacleIndices[cursor[cell]++] = static_cast<uint32_t>(i); });
+    }
+}
+
+void Flock::_sortIntoBuckets() {
+    const size_t numAgents = _positionX.size();
+
+    const uint32_t numBuckets = static_cast<uint32_t>(_bucketCursor.size());
+    // padded so the four wide loads past the last agent stay in bounds
+    if (_sortedIds.size() != numAgents + 3) {
+        for (std::vector<float>* sorted : { &_sortedPositionX, &_sortedPositionY, &_sortedPositionZ, &_sortedVelocityX, &_sortedVelocityY, &_sortedVelocityZ }) {
+            sorted->assign(numAgents + 3, 0.0f);
+        }
+        _sortedIds.assign(numAgents + 3, 0);
+        _bucketOf.resize(numAgents);
+    }
+
+    std::fill(_bucketStart.begin(), _bucketStart.end(), 0);
+    for (size_t i = 0; i < numAgents; ++i) {
+        glm::ivec3 cell = _cell(_positionX[i], _positionY[i], _positionZ[i]);
+        _bucketOf[i] = _bucket(cell.x, cell.y, cell.z);
+        _bucketStart[_bucketOf[i] + 1]++;
+    }
+    for (uint32_t bucket = 0; bucket < numBuckets; ++bucket) {
+        _bucketStart[bucket + 1] += _bucketStart[bucket];
+        _bucketCursor[bucket] = _bucketStart[bucket];
+    }
+    for (size_t i = 0; i < numAgents; ++i) {
+        uint32_t slot = _bucketCursor[_bucketOf[i]]++;
+        _sortedPositionX[slot] = _positionX[i];
+        _sortedPositionY[slot] = _positionY[i];
+        _sortedPositionZ[slot] = _positionZ[i];
+        _sortedVelocityX[slot] = _velocityX[i];
+        _sortedVelocityY[slot] = _velocityY[i];
+        _sortedVelocityZ[slot] = _velocityZ[i];
+        _sortedIds[slot] = _ids[i];
+    }
+}
+
+void Flock::update() {
+    if (_positionX.empty()) return;
+    if (_obstaclesDirty) _buildObstacleGrid();
+    _sortIntoBuckets();
+
+    if (_workers.empty()) {
+        _nextChunk = 0;
+        _steerChunks();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _nextChunk = 0;
+        _busyWorkers = static_cast<unsigned int>(_workers.size());
+        _generation++;
+    }
+    _wake.notify_all();
+    _steerChunks();
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [&] { return _busyWorkers == 0; });
+}
+
+void Flock::_steerChunks() {
+    const size_t numAgents = _positionX.size();
+    for (;;) {
+        size_t begin = _nextChunk.fetch_add(1) * CHUNK_SIZE;
+        if (begin >= numAgents) return;
+        _steerRange(begin, std::min(begin + CHUNK_SIZE, numAgents));
+    }
+}
+
+void Flock::_steerRange(size_t begin, size_t end) {
+    const Parameters& p = _parameters;
+    const float neighborRadiusSq = p.neighborRadius * p.neighborRadius;
+    const float separationRadiusSq = p.separationRadius * p.separationRadius;
+    const float extent = p.boundsHalfSize + p.obstacleMargin;
+
+    for (size_t i = begin; i < end; ++i) {
+        const float px = _sortedPositionX[i], py = _sortedPositionY[i], pz = _sortedPositionZ[i];
+        float vx = _sortedVelocityX[i], vy = _sortedVelocityY[i], vz = _sortedVelocityZ[i];
+
+        float count = 0.0f;
+        float sumPx = 0.0f, sumPy = 0.0f, sumPz = 0.0f;
+        float sumVx = 0.0f, sumVy = 0.0f, sumVz = 0.0f;
+        float sepX = 0.0f, sepY = 0.0f, sepZ = 0.0f;
+#ifdef FLOCK_SSE
+        const __m128 positionX = _mm_set1_ps(px), positionY = _mm_set1_ps(py), positionZ = _mm_set1_ps(pz);
+        const __m128 radiusSq = _mm_set1_ps(neighborRadiusSq), separationSq = _mm_set1_ps(separationRadiusSq);
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+        const __m128i laneOffsets = _mm_set_epi32(3, 2, 1, 0);
+        // summed across all 27 cells, reduced to scalars once
+        __m128 count4 = zero;
+        __m128 sumPx4 = zero, sumPy4 = zero, sumPz4 = zero;
+        __m128 sumVx4 = zero, sumVy4 = zero, sumVz4 = zero;
+        __m128 sepX4 = zero, sepY4 = zero, sepZ4 = zero;
+#endif
+
+        // the 27 cells around the agent as nine rows of three along x, each a run of sorted slots
+        uint32_t runFirst[27], runLast[27];
+        int numRuns = 0;
+        glm::ivec3 cell = _cell(px, py, pz);
+        uint32_t column = static_cast<uint32_t>(cell.x) & (_hashWidth - 1);
+        for (int dz = -1; dz <= 1; ++dz) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                uint32_t row = _bucket(0, cell.y + dy, cell.z + dz);
+                if (column > 0 && column < _hashWidth - 1) {
+                    runFirst[numRuns] = _bucketStart[row + column - 1];
+                    runLast[numRuns++] = _bucketStart[row + column + 2];
+                } else {
+                    // the row wraps around, three separate runs
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        uint32_t bucket = row + (static_cast<uint32_t>(cell.x + dx) & (_hashWidth - 1));
+                        runFirst[numRuns] = _bucketStart[bucket];
+                        runLast[numRuns++] = _bucketStart[bucket + 1];
+                    }
+                }
+            }
+        }
+
+        for (int run = 0; run < numRuns; ++run) {
+            const uint32_t last = runLast[run];
+            uint32_t j = runFirst[run];
+#ifdef FLOCK_SSE
+            const __m128i lastSlot = _mm_set1_epi32(static_cast<int>(last));
+            for (; j < last; j += 4) {
+                // lanes past the run belong to other cells, or are padding
+                __m128i slots = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(j)), laneOffsets);
+                __m128 inRun = _mm_castsi128_ps(_mm_cmplt_epi32(slots, lastSlot));
+
+                __m128 otherX = _mm_loadu_ps(&_sortedPositionX[j]);
+                __m128 otherY = _mm_loadu_ps(&_sortedPositionY[j]);
+                __m128 otherZ = _mm_loadu_ps(&_sortedPositionZ[j]);
+                __m128 offsetX = _mm_sub_ps(otherX, positionX);
+                __m128 offsetY = _mm_sub_ps(otherY, positionY);
+                __m128 offsetZ = _mm_sub_ps(otherZ, positionZ);
+                __m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(offsetX, offsetX), _mm_mul_ps(offsetY, offsetY)), _mm_mul_ps(offsetZ, offsetZ));
+
+                // a zero distance is the agent itself
+                __m128 isNeighbor = _mm_and_ps(inRun, _mm_and_ps(_mm_cmplt_ps(distanceSq, radiusSq), _mm_cmpgt_ps(distanceSq, zero)));
+                count4 = _mm_add_ps(count4, _mm_and_ps(isNeighbor, one));
+                sumPx4 = _mm_add_ps(sumPx4, _mm_and_ps(isNeighbor, otherX));
+                sumPy4 = _mm_add_ps(sumPy4, _mm_and_ps(isNeighbor, otherY));
+                sumPz4 = _mm_add_ps(sumPz4, _mm_and_ps(isNeighbor, otherZ));
+                sumVx4 = _mm_add_ps(sumVx4, _mm_and_ps(isNeighbor, _mm_loadu_ps(&_sortedVelocityX[j])));
+                sumVy4 = _mm_add_ps(sumVy4, _mm_and_ps(isNeighbor, _mm_loadu_ps(&_sortedVelocityY[j])));
+                sumVz4 = _mm_add_ps(sumVz4, _mm_and_ps(isNeighbor, _mm_loadu_ps(&_sortedVelocityZ[j])));
+
+                // pushed away from close neighbours by offset / distance^2, the masked lanes may divide by zero
+                __m128 isClose = _mm_and_ps(isNeighbor, _mm_cmplt_ps(distanceSq, separationSq));
+                __m128 inverseDistanceSq = _mm_div_ps(one, distanceSq);
+                sepX4 = _mm_add_ps(sepX4, _mm_and_ps(isClose, _mm_mul_ps(offsetX, inverseDistanceSq)));
+                sepY4 = _mm_add_ps(sepY4, _mm_and_ps(isClose, _mm_mul_ps(offsetY, inverseDistanceSq)));
+                sepZ4 = _mm_add_ps(sepZ4, _mm_and_ps(isClose, _mm_mul_ps(offsetZ, inverseDistanceSq)));
+            }
+#endif
+            // everything without SSE
+            for (; j < last; ++j) {
+                float offsetX = _sortedPositionX[j] - px;
+                float offsetY = _sortedPositionY[j] - py;
+                float offsetZ = _sortedPositionZ[j] - pz;
+                float distanceSq = offsetX * offsetX + offsetY * offsetY + offsetZ * offsetZ;
+                if (distanceSq >= neighborRadiusSq || distanceSq <= 0.0f) continue;
+                count += 1.0f;
+                sumPx += _sortedPositionX[j]; sumPy += _sortedPositionY[j]; sumPz += _sortedPositionZ[j];
+                sumVx += _sortedVelocityX[j]; sumVy += _sortedVelocityY[j]; sumVz += _sortedVelocityZ[j];
+                if (distanceSq < separationRadiusSq) {
+                    sepX += offsetX / distanceSq; sepY += offsetY / distanceSq; sepZ += offsetZ / distanceSq;
+                }
+            }
+        }
+
+#ifdef FLOCK_SSE
+        count += horizontalSum(count4);
+        sumPx += horizontalSum(sumPx4); sumPy += horizontalSum(sumPy4); sumPz += horizontalSum(sumPz4);
+        sumVx += horizontalSum(sumVx4); sumVy += horizontalSum(sumVy4); sumVz += horizontalSum(sumVz4);
+        sepX += horizontalSum(sepX4); sepY += horizontalSum(sepY4); sepZ += horizontalSum(sepZ4);
+#endif
+        if (count > 0.0f) {
+            float inverseCount = 1.0f / count;
+            vx += (sumVx * inverseCount - vx) * p.alignmentWeight + (sumPx * inverseCount - px) * p.cohesionWeight - sepX * p.separationWeight;
+            vy += (sumVy * inverseCount - vy) * p.alignmentWeight + (sumPy * inverseCount - py) * p.cohesionWeight - sepY * p.separationWeight;
+            vz += (sumVz * inverseCount - vz) * p.alignmentWeight + (sumPz * inverseCount - pz) * p.cohesionWeight - sepZ * p.separationWeight;
+        }
+
+        // steer out of the margin around trunks and posts, harder the deeper in
+        if (!_obstacleCellStart.empty()) {
+            int obstacleCellX = std::min(_obstacleGridWidth - 1, std::max(0, static_cast<int>((px + extent) / OBSTACLE_CELL_SIZE)));
+            int obstacleCellZ = std::min(_obstacleGridWidth - 1, std::max(0, static_cast<int>((pz + extent) / OBSTACLE_CELL_SIZE)));
+            size_t obstacleCell = static_cast<size_t>(obstacleCellZ) * _obstacleGridWidth + obstacleCellX;
+            for (uint32_t k = _obstacleCellStart[obstacleCell]; k < _obstacleCellStart[obstacleCell + 1]; ++k) {
+                const glm::vec3& obstacle = _obstacles[_obstacleIndices[k]];
+                float awayX = px - obstacle.x, awayZ = pz - obstacle.y;
+                float distance = std::sqrt(awayX * awayX + awayZ * awayZ);
+                if (distance >= obstacle.z + p.obstacleMargin || distance < 1e-4f) continue;
+                float depth = std::min(2.0f, 1.0f - (distance - obstacle.z) / p.obstacleMargin);
+                vx += awayX / distance * depth * p.obstacleWeight;
+                vz += awayZ / distance * depth * p.obstacleWeight;
+            }
+        }
+
+        // back towards the box
+        if (px > p.boundsHalfSize) vx -= p.boundsWeight; else if (px < -p.boundsHalfSize) vx += p.boundsWeight;
+        if (pz > p.boundsHalfSize) vz -= p.boundsWeight; else if (pz < -p.boundsHalfSize) vz += p.boundsWeight;
+        if (py > p.maxHeight) vy -= p.boundsWeight; else if (py < p.minHeight) vy += p.boundsWeight;
+
+        float speed = std::sqrt(vx * vx + vy * vy + vz * vz);
+        if (speed > p.maxSpeed) {
+            float scale = p.maxSpeed / speed;
+            vx *= scale; vy *= scale; vz *= scale;
+        } else if (speed < p.minSpeed) {
+            if (speed > 0.0f) {
+                float scale = p.minSpeed / speed;
+                vx *= scale; vy *= scale; vz *= scale;
+            } else {
+                vx = p.minSpeed;
+            }
+        }
+
+        // each slot only writes itself, the sorted copy is the only thing read
+        _positionX[i] = px + vx; _positionY[i] = py + vy; _positionZ[i] = pz + vz;
+        _velocityX[i] = vx; _velocityY[i] = vy; _velocityZ[i] = vz;
+        _ids[i] = _sortedIds[i];
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef FLOCK_H
+#define FLOCK_H
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Boids: separation, alignment and cohesion among agents within a neighbour
+// radius, plus avoidance of vertical cylinders (trees, lamp posts) and a soft
+// box the flock is kept in. Units are per simulation tick.
+//
+// Agents are stored as structure of arrays. Every tick they are counting
+// sorted into a spatial hash of neighbour radius sized cells, so the agents of
+// a cell sit next to each other and an agent only scans the 27 cells around
+// it, four candidates at a time with SSE. The hash wraps cell coordinates onto
+// a power of two grid sized to the bounds: agents that stray outside alias
+// onto cells inside and get filtered by distance, and cells next to each
+// other along x are next to each other in memory, so each row of three cells
+// is one contiguous run and agents handled one after another share their
+// neighbours in cache. The sort leaves the agents in cell order; getId() says
+// which agent added first each slot holds.
+// Steering only reads the sorted copy and writes each agent's own slot, so it
+// splits across worker threads and gives the same result for any thread count.
+class Flock {
+public:
+    struct Parameters {
+        float neighborRadius = 2.0f;
+        float separationRadius = 0.6f;
+        float separationWeight = 0.004f;
+        float alignmentWeight = 0.05f;
+        float cohesionWeight = 0.002f;
+        float minSpeed = 0.04f;
+        float maxSpeed = 0.12f;
+        // kept from obstacle surfaces, pushed away harder the closer they get
+        float obstacleMargin = 1.0f;
+        float obstacleWeight = 0.03f;
+        // soft box: +-boundsHalfSize on x and z, minHeight to maxHeight on y
+        float boundsHalfSize = 50.0f;
+        float minHeight = 1.0f;
+        float maxHeight = 6.0f;
+        float boundsWeight = 0.01f;
+    };
+
+    explicit Flock(unsigned int numThreads = 1);
+    ~Flock();
+    Flock(const Flock&) = delete;
+    Flock& operator=(const Flock&) = delete;
+
+    void setParameters(const Parameters& parameters) { _parameters = parameters; _obstaclesDirty = true; }
+    const Parameters& getParameters() const { return _parameters; }
+
+    // 1 runs on the calling thread only, more adds workers that steer alongside it
+    void setNumThreads(unsigned int numThreads);
+    unsigned int getNumThreads() const { return static_cast<unsigned int>(_workers.size()) + 1; }
+
+    void clear();
+    void addAgent(glm::vec3 position, glm::vec3 velocity);
+    // infinitely tall cylinder standing on the ground plane
+    void addObstacle(glm::vec2 center, float radius);
+    void clearObstacles();
+
+    void update();
+
+    size_t getNumAgents() const { return _positionX.size(); }
+    glm::vec3 getPosition(size_t slot) const { return glm::vec3(_positionX[slot], _positionY[slot], _positionZ[slot]); }
+    glm::vec3 getVelocity(size_t slot) const { return glm::vec3(_velocityX[slot], _velocityY[slot], _velocityZ[slot]); }
+    uint32_t getId(size_t slot) const { return _ids[slot]; }
+
+private:
+    static constexpr size_t CHUNK_SIZE = 1024;
+    static constexpr float OBSTACLE_CELL_SIZE = 4.0f;
+
+    Parameters _parameters;
+
+    std::vector<float> _positionX, _positionY, _positionZ;
+    std::vector<float> _velocityX, _velocityY, _velocityZ;
+    std::vector<uint32_t> _ids;
+
+    // the same, sorted by hash bucket, padded to a multiple of four
+    std::vector<float> _sortedPositionX, _sortedPositionY, _sortedPositionZ;
+    std::vector<float> _sortedVelocityX, _sortedVelocityY, _sortedVelocityZ;
+    std::vector<uint32_t> _sortedIds;
+
+    // spatial hash, bucket b holds sorted slots _bucketStart[b] to _bucketStart[b + 1]
+    uint32_t _hashWidth;  // buckets along x and z, a power of two
+    uint32_t _hashHeight; // buckets along y, a power of two
+    std::vector<uint32_t> _bucketOf;
+    std::vector<uint32_t> _bucketStart;
+    std::vector<uint32_t> _bucketCursor;
+
+    // obstacles binned on a coarse 2D grid over the bounds
+    std::vector<glm::vec3> _obstacles; // x, z, radius
+    bool _obstaclesDirty;
+    int _obstacleGridWidth;
+    std::vector<uint32_t> _obstacleCellStart;
+    std::vector<uint32_t> _obstacleIndices;
+
+    // worker pool, woken once per update for the steering pass
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    uint64_t _generation;
+    unsigned int _busyWorkers;
+    bool _quit;
+    std::atomic<size_t> _nextChunk;
+
+    void _stopWorkers();
+    void _workerLoop(uint64_t seenGeneration);
+
+    uint32_t _bucket(int x, int y, int z) const;
+    glm::ivec3 _cell(float x, float y, float z) const;
+    void _resizeHash();
+    void _sortIntoBuckets();
+    void _buildObstacleGrid();
+    void _steerChunks();
+    void _steerRange(size_t begin, size_t end);
+};
+
+#endif // FLOCK_H
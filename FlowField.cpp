@@ -0,0 +1,267 @@
+#include "FlowField.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <thread>
+
+static const int NEIGHBOR_X[] = {1, 1, 0, -1, -1, -1, 0, 1};
+static const int NEIGHBOR_Z[] = {0, 1, 1, 1, 0, -1, -1, -1};
+static const float STEP_LENGTH[] = {1.0f, 1.41421356f, 1.0f, 1.41421356f, 1.0f, 1.41421356f, 1.0f, 1.41421356f};
+static const glm::vec2 STEP_DIRECTION[] = {
+        glm::vec2(1.0f, 0.0f), glm::vec2(0.70710678f, 0.70710678f), glm::vec2(0.0f, 1.0f), glm::vec2(-0.70710678f, 0.70710678f),
+        glm::vec2(-1.0f, 0.0f), glm::vec2(-0.70710678f, -0.70710678f), glm::vec2(0.0f, -1.0f), glm::vec2(0.70710678f, -0.70710678f)
+};
+
+static const float UNREACHABLE = std::numeric_limits<float>::infinity();
+
+FlowField::FlowField(float worldSize, float cellSize)
+    : _worldSize(worldSize),
+      _cellSize(cellSize),
+      _width(static_cast<int>(std::ceil(2.0f * worldSize / cellSize))),
+      _stats{0, 0, 0.0, 0.0}
+{
+    clear();
+}
+
+void FlowField::clear() {
+    _staticCost.assign(static_cast<size_t>(_width) * _width, DEFAULT_COST);
+    _cost = _staticCost;
+    _isChanged.assign(_cost.size(), 0);
+    _changedCells.clear();
+    _goals.clear();
+}
+
+void FlowField::addStaticObstacle(glm::vec2 center, float radius) {
+    _forEachCellInCircle(center, radius, [this](int cell) {
+        _staticCost[cell] = IMPASSABLE;
+        _setCost(cell, IMPASSABLE);
+    });
+}
+
+void FlowField::stampCircle(glm::vec2 center, float radius, uint8_t cost) {
+    _forEachCellInCircle(center, radius, [this, cost](int cell) {
+        _setCost(cell, std::max(_staticCost[cell], cost));
+    });
+}
+
+void FlowField::clearCircle(glm::vec2 center, float radius) {
+    _forEachCellInCircle(center, radius, [this](int cell) {
+        _setCost(cell, _staticCost[cell]);
+    });
+}
+
+FlowField::GoalId FlowField::addGoal(glm::vec2 position) {
+    int cell = _cellIndex(position);
+
+    // walk out ring by ring until a passable cell turns up
+    int centerX = cell % _width;
+    int centerZ = cell / _width;
+    for(int ring = 1; _cost[cell] == IMPASSABLE && ring < _width; ++ring) {
+        for(int z = centerZ - ring; z <= centerZ + ring && _cost[cell] == IMPASSABLE; ++z) {
+            for(int x = centerX - ring; x <= centerX + ring; ++x) {
+                if(x < 0 || z < 0 || x >= _width || z >= _width) continue;
+                if(_cost[z * _width + x] != IMPASSABLE) {
+                    cell = z * _width + x;
+                    break;
+                }
+            }
+        }
+    }
+
+    Goal goal;
+    goal.cell = cell;
+    _goals.push_back(goal);
+    return static_cast<GoalId>(_goals.size() - 1);
+}
+
+void FlowField::build() {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // goals are independent, hand them out to the workers one at a time
+    std::atomic<size_t> nextGoal(0);
+    std::atomic<unsigned int> cellsIntegrated(0);
+    auto worker = [this, &nextGoal, &cellsIntegrated]() {
+        for(size_t goal = nextGoal++; goal < _goals.size(); goal = nextGoal++) {
+            cellsIntegrated += _integrate(_goals[goal]);
+        }
+    };
+
+    size_t numThreads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), _goals.size());
+    std::vector<std::thread> threads;
+    for(size_t i = 1; i < numThreads; ++i) threads.emplace_back(worker);
+    worker();
+    for(std::thread& thread : threads) thread.join();
+
+    for(int cell : _changedCells) _isChanged[cell] = 0;
+    _changedCells.clear();
+
+    _stats.cellsIntegrated = cellsIntegrated;
+    _stats.lastBuildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void FlowField::update() {
+    if(_changedCells.empty()) return;
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // repairs touch a handful of cells, spinning up threads would cost more than they save
+    unsigned int cellsRepaired = 0;
+    for(Goal& goal : _goals) cellsRepaired += _repair(goal);
+
+    for(int cell : _changedCells) _isChanged[cell] = 0;
+    _changedCells.clear();
+
+    _stats.cellsRepaired = cellsRepaired;
+    _stats.lastUpdateMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+glm::vec2 FlowField::getDirection(GoalId goal, glm::vec2 position) const {
+    uint8_t flow = _goals[goal].flow[_cellIndex(position)];
+    return flow == NO_FLOW ? glm::vec2(0.0f) : STEP_DIRECTION[flow];
+}
+
+float FlowField::getIntegratedCost(GoalId goal, glm::vec2 position) const {
+    return _goals[goal].integration[_cellIndex(position)];
+}
+
+int FlowField::_cellIndex(glm::vec2 position) const {
+    int x = static_cast<int>(std::floor((position.x + _worldSize) / _cellSize));
+    int z = static_cast<int>(std::floor((position.y + _worldSize) / _cellSize));
+    x = std::min(std::max(x, 0), _width - 1);
+    z = std::min(std::max(z, 0), _width - 1);
+    return z * _width + x;
+}
+
+glm::vec2 FlowField::_cellCenter(int cell) const {
+    return glm::vec2((cell % _width + 0.5f) * _cellSize - _worldSize, (cell / _width + 0.5f) * _cellSize - _worldSize);
+}
+
+int FlowField::_neighbor(int cell, int direction) const {
+    int x = cell % _width + NEIGHBOR_X[direction];
+    int z = cell / _width + NEIGHBOR_Z[direction];
+    if(x < 0 || z < 0 || x >= _width || z >= _width) return -1;
+    return z * _width + x;
+}
+
+bool FlowField::_canStep(int cell, int direction) const {
+    int neighbor = _neighbor(cell, direction);
+    if(neighbor < 0 || _cost[neighbor] == IMPASSABLE) return false;
+    if(direction % 2 == 0) return true;
+    // no cutting diagonally past the corner of a blocked cell
+    return _cost[_neighbor(cell, direction - 1)] != IMPASSABLE && _cost[_neighbor(cell, (direction + 1) % NUM_NEIGHBORS)] != IMPASSABLE;
+}
+
+void FlowField::_setCost(int cell, uint8_t cost) {
+    if(_cost[cell] == cost) return;
+    _cost[cell] = cost;
+    if(!_isChanged[cell]) {
+        _isChanged[cell] = 1;
+        _changedCells.push_back(cell);
+    }
+}
+
+template<typename Function>
+void FlowField::_forEachCellInCircle(glm::vec2 center, float radius, Function function) {
+    int minCell = _cellIndex(center - glm::vec2(radius));
+    int maxCell = _cellIndex(center + glm::vec2(radius));
+    for(int z = minCell / _width; z <= maxCell / _width; ++z) {
+        for(int x = minCell % _width; x <= maxCell % _width; ++x) {
+            // closest point of the cell to the center
+            glm::vec2 cellMin(x * _cellSize - _worldSize, z * _cellSize - _worldSize);
+            glm::vec2 closest = glm::clamp(center, cellMin, cellMin + glm::vec2(_cellSize));
+            glm::vec2 offset = closest - center;
+            if(glm::dot(offset, offset) <= radius * radius) function(z * _width + x);
+        }
+    }
+}
+
+unsigned int FlowField::_integrate(Goal& goal) const {
+    goal.integration.assign(_cost.size(), UNREACHABLE);
+    goal.flow.assign(_cost.size(), NO_FLOW);
+    goal.marked.assign(_cost.size(), 0);
+    goal.heap.clear();
+    if(_cost[goal.cell] == IMPASSABLE) return 0;
+
+    goal.integration[goal.cell] = 0.0f;
+    goal.heap.push_back({0.0f, goal.cell});
+    return _runDijkstra(goal);
+}
+
+unsigned int FlowField::_repair(Goal& goal) const {
+    // everything whose shortest path ran through a changed cell hangs below it in the
+    // tree the flow pointers form; collect those subtrees and forget their values.
+    // The neighbours go in as well, a changed cell also decides which diagonal steps
+    // may cut past its corners.
+    goal.invalidated.clear();
+    for(int cell : _changedCells) {
+        for(int direction = -1; direction < NUM_NEIGHBORS; ++direction) {
+            int seed = (direction < 0 ? cell : _neighbor(cell, direction));
+            if(seed < 0 || goal.marked[seed]) continue;
+            goal.marked[seed] = 1;
+            goal.invalidated.push_back(seed);
+        }
+    }
+    for(size_t i = 0; i < goal.invalidated.size(); ++i) {
+        int cell = goal.invalidated[i];
+        for(int direction = 0; direction < NUM_NEIGHBORS; ++direction) {
+            int neighbor = _neighbor(cell, direction);
+            if(neighbor < 0 || goal.marked[neighbor]) continue;
+            if(goal.flow[neighbor] == (direction + 4) % NUM_NEIGHBORS) {
+                goal.marked[neighbor] = 1;
+                goal.invalidated.push_back(neighbor);
+            }
+        }
+    }
+    for(int cell : goal.invalidated) {
+        goal.integration[cell] = UNREACHABLE;
+        goal.flow[cell] = NO_FLOW;
+    }
+
+    // regrow from the goal and from the still valid cells around the hole; a cell that
+    // got cheaper is in the hole as well, so improvements spread out from it too
+    goal.heap.clear();
+    if(goal.marked[goal.cell] && _cost[goal.cell] != IMPASSABLE) {
+        goal.integration[goal.cell] = 0.0f;
+        goal.heap.push_back({0.0f, goal.cell});
+    }
+    for(int cell : goal.invalidated) {
+        for(int direction = 0; direction < NUM_NEIGHBORS; ++direction) {
+            int neighbor = _neighbor(cell, direction);
+            if(neighbor < 0 || goal.marked[neighbor] || goal.integration[neighbor] == UNREACHABLE) continue;
+            goal.heap.push_back({goal.integration[neighbor], neighbor});
+        }
+    }
+    std::make_heap(goal.heap.begin(), goal.heap.end(), std::greater<HeapEntry>());
+
+    for(int cell : goal.invalidated) goal.marked[cell] = 0;
+    return _runDijkstra(goal);
+}
+
+unsigned int FlowField::_runDijkstra(Goal& goal) const {
+    unsigned int settled = 0;
+    while(!goal.heap.empty()) {
+        std::pop_heap(goal.heap.begin(), goal.heap.end(), std::greater<HeapEntry>());
+        HeapEntry entry = goal.heap.back();
+        goal.heap.pop_back();
+        // stale entry, the cell was reached more cheaply since
+        if(entry.cost > goal.integration[entry.cell]) continue;
+        settled++;
+
+        for(int direction = 0; direction < NUM_NEIGHBORS; ++direction) {
+            // agents move the other way, from the neighbour into this cell
+            int neighbor = _neighbor(entry.cell, direction);
+            if(neighbor < 0 || _cost[neighbor] == IMPASSABLE || !_canStep(neighbor, (direction + 4) % NUM_NEIGHBORS)) continue;
+            float cost = entry.cost + _cost[neighbor] * STEP_LENGTH[direction];
+            if(cost < goal.integration[neighbor]) {
+                goal.integration[neighbor] = cost;
+                goal.flow[neighbor] = static_cast<uint8_t>((direction + 4) % NUM_NEIGHBORS);
+                goal.heap.push_back({cost, neighbor});
+                std::push_heap(goal.heap.begin(), goal.heap.end(), std::greater<HeapEntry>());
+            }
+        }
+    }
+    return settled;
+}
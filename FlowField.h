@@ -0,0 +1,110 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Flow field navigation on a uniform grid over the ground plane.
+// A cost field holds what it takes to cross each cell (scenery is
+// impassable). For every goal an integration field holds the path cost from
+// each cell to the goal, built with Dijkstra over the 8-neighbourhood, and a
+// flow field holds the neighbour to step to next. Any number of agents then
+// steer with one cell lookup each, no matter how many share a goal.
+// Goals are integrated on worker threads; cost changes only repair the part
+// of each field whose shortest paths ran through the changed cells.
+class FlowField {
+public:
+    typedef int GoalId;
+
+    struct Stats {
+        unsigned int cellsIntegrated;
+        unsigned int cellsRepaired;
+        double lastBuildMs;
+        double lastUpdateMs;
+    };
+
+    static constexpr uint8_t DEFAULT_COST = 1;
+    static constexpr uint8_t IMPASSABLE = 255;
+
+    FlowField(float worldSize, float cellSize = 1.0f);
+
+    // resets every cell to the default cost and forgets all goals
+    void clear();
+
+    // makes every cell the circle touches impassable for good
+    void addStaticObstacle(glm::vec2 center, float radius);
+    // raises the cost of the cells in the circle until clearCircle puts the static cost back
+    void stampCircle(glm::vec2 center, float radius, uint8_t cost);
+    void clearCircle(glm::vec2 center, float radius);
+
+    // snaps to the nearest passable cell, call build() afterwards
+    GoalId addGoal(glm::vec2 position);
+    size_t getNumGoals() const { return _goals.size(); }
+    glm::vec2 getGoalPosition(GoalId goal) const { return _cellCenter(_goals[goal].cell); }
+
+    // integrates every goal from scratch, one goal per worker thread
+    void build();
+    // repairs all goals after stampCircle/clearCircle, cheap when few cells changed
+    void update();
+
+    // unit direction to walk toward the goal, zero at the goal or where it cannot be reached
+    glm::vec2 getDirection(GoalId goal, glm::vec2 position) const;
+    // path cost left to the goal, INFINITY when it cannot be reached
+    float getIntegratedCost(GoalId goal, glm::vec2 position) const;
+    bool isPassable(glm::vec2 position) const { return _cost[_cellIndex(position)] != IMPASSABLE; }
+
+    int getWidth() const { return _width; }
+    const Stats& getStats() const { return _stats; }
+
+private:
+    // 8-neighbourhood, counter clockwise from +X so (k + 4) % 8 is the opposite direction
+    static constexpr int NUM_NEIGHBORS = 8;
+    static constexpr uint8_t NO_FLOW = NUM_NEIGHBORS;
+
+    struct HeapEntry {
+        float cost;
+        int cell;
+        bool operator>(const HeapEntry& other) const { return cost > other.cost; }
+    };
+
+    struct Goal {
+        int cell;
+        std::vector<float> integration;
+        // neighbour index toward the goal, NO_FLOW at the goal and for unreachable cells;
+        // doubles as the parent pointer of the shortest path tree when repairing
+        std::vector<uint8_t> flow;
+        // scratch kept between repairs so steady state updates do not allocate
+        std::vector<HeapEntry> heap;
+        std::vector<int> invalidated;
+        std::vector<uint8_t> marked;
+    };
+
+    float _worldSize;
+    float _cellSize;
+    int _width;
+    std::vector<uint8_t> _staticCost;
+    std::vector<uint8_t> _cost;
+    std::vector<Goal> _goals;
+
+    std::vector<int> _changedCells;
+    std::vector<uint8_t> _isChanged;
+
+    Stats _stats;
+
+    int _cellIndex(glm::vec2 position) const;
+    glm::vec2 _cellCenter(int cell) const;
+    int _neighbor(int cell, int direction) const;
+    bool _canStep(int cell, int direction) const;
+    void _setCost(int cell, uint8_t cost);
+
+    template<typename Function>
+    void _forEachCellInCircle(glm::vec2 center, float radius, Function function);
+
+    unsigned int _integrate(Goal& goal) const;
+    unsigned int _repair(Goal& goal) const;
+    unsigned int _runDijkstra(Goal& goal) const;
+};
+
+#endif // FLOW_FIELD_H
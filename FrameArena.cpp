@@ -0,0 +1,58 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+FrameArena::FrameArena(size_t capacity)
+    : _pBlock(static_cast<unsigned char*>(::operator new(capacity))),
+      _capacity(capacity),
+      _offset(0),
+      _bytesUsed(0),
+      _highWaterMark(0)
+{}
+
+FrameArena::~FrameArena() {
+    for(void* pBlock : _overflowBlocks) ::operator delete(pBlock);
+    ::operator delete(_pBlock);
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    if(bytes == 0) bytes = 1;
+
+    // align the address rather than the offset, the block itself is only max_align_t aligned
+    uintptr_t base = reinterpret_cast<uintptr_t>(_pBlock);
+    size_t start = alignUp(base + _offset, alignment) - base;
+    if(start + bytes <= _capacity) {
+        _bytesUsed += (start - _offset) + bytes;
+        _offset = start + bytes;
+        _highWaterMark = std::max(_highWaterMark, _bytesUsed);
+        return _pBlock + start;
+    }
+
+    // out of room this frame, take a separate block and grow on the next reset
+    void* pOverflow = ::operator new(bytes + alignment);
+    _overflowBlocks.push_back(pOverflow);
+    _bytesUsed += bytes + alignment;
+    _highWaterMark = std::max(_highWaterMark, _bytesUsed);
+    uintptr_t address = alignUp(reinterpret_cast<uintptr_t>(pOverflow), alignment);
+    return reinterpret_cast<void*>(address);
+}
+
+void FrameArena::reset() {
+    if(!_overflowBlocks.empty()) {
+        for(void* pBlock : _overflowBlocks) ::operator delete(pBlock);
+        _overflowBlocks.clear();
+
+        // leave headroom so a slightly bigger frame does not overflow again
+        ::operator delete(_pBlock);
+        _capacity = _highWaterMark + _highWaterMark / 2;
+        _pBlock = static_cast<unsigned char*>(::operator new(_capacity));
+    }
+    _offset = 0;
+    _bytesUsed = 0;
+}
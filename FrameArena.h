@@ -0,0 +1,70 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+// Linear allocator for data that only lives for one frame.
+// Allocation bumps an offset, nothing is freed individually and reset()
+// releases everything at once at the top of the next frame.
+// When a frame outgrows the block, extra blocks are taken from the heap and
+// the next reset() replaces everything with one block big enough for the
+// high water mark, so the arena stops touching the heap once frames settle.
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity = DEFAULT_CAPACITY);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    void reset();
+
+    size_t getCapacity() const { return _capacity; }
+    size_t getBytesUsed() const { return _bytesUsed; }
+    size_t getHighWaterMark() const { return _highWaterMark; }
+
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+private:
+    unsigned char* _pBlock;
+    size_t _capacity;
+    size_t _offset;
+    // bytes handed out this frame, including overflow blocks
+    size_t _bytesUsed;
+    size_t _highWaterMark;
+    std::vector<void*> _overflowBlocks;
+};
+
+// STL allocator handing out memory from a FrameArena. deallocate() is a
+// no-op, containers using it must not outlive the frame they were built in.
+template<typename T>
+class FrameAllocator {
+public:
+    typedef T value_type;
+
+    explicit FrameAllocator(FrameArena* pArena) : _pArena(pArena) {}
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U>& other) : _pArena(other.getArena()) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(_pArena->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    FrameArena* getArena() const { return _pArena; }
+
+private:
+    FrameArena* _pArena;
+};
+
+template<typename T, typename U>
+bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b) { return a.getArena() == b.getArena(); }
+template<typename T, typename U>
+bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b) { return a.getArena() != b.getArena(); }
+
+// vector whose storage is released when the arena resets, reserve() up front
+// since every regrowth leaves the old buffer behind until the end of the frame
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+#endif // FRAME_ARENA_H
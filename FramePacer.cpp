@@ -0,0 +1,67 @@
+#include "FramePacer.h"
+
+#include <thread>
+
+FramePacer::FramePacer()
+    : _pacing(false),
+      _periodMs(1000.0 / 60.0),
+      _workEstimateMs(0.0),
+      _hasSwapped(false),
+      _lastLatencyMs(0.0),
+      _latencyHistory(LATENCY_HISTORY, 0.0),
+      _latencyHead(0),
+      _latencyCount(0)
+{}
+
+void FramePacer::setPacing(bool enabled, double refreshRateHz) {
+    _pacing = enabled && refreshRateHz > 0.0;
+    if(refreshRateHz > 0.0) _periodMs = 1000.0 / refreshRateHz;
+}
+
+void FramePacer::waitForInput() {
+    if(!_pacing || !_hasSwapped) return;
+
+    // with vsync the swap returns close to a vblank, the next one is a period later
+    double delayMs = _periodMs - _workEstimateMs - SAFETY_MS;
+    if(delayMs <= 0.0) return;
+    Clock::time_point wake = _lastSwap + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(delayMs));
+
+    // the OS sleep overshoots by up to a millisecond, spin the rest
+    Clock::time_point coarseWake = wake - std::chrono::milliseconds(1);
+    if(Clock::now() < coarseWake) std::this_thread::sleep_until(coarseWake);
+    while(Clock::now() < wake) std::this_thread::yield();
+}
+
+void FramePacer::inputSampled() {
+    _inputTime = Clock::now();
+}
+
+void FramePacer::workDone() {
+    double workMs = std::chrono::duration<double, std::milli>(Clock::now() - _inputTime).count();
+    // jump up at once so a slow frame is not followed by a missed vsync, come down slowly
+    if(workMs > _workEstimateMs) {
+        _workEstimateMs = workMs;
+    } else {
+        _workEstimateMs += DECAY * (workMs - _workEstimateMs);
+    }
+}
+
+void FramePacer::frameSwapped() {
+    _lastSwap = Clock::now();
+    _hasSwapped = true;
+
+    _lastLatencyMs = std::chrono::duration<double, std::milli>(_lastSwap - _inputTime).count();
+    _latencyHistory[_latencyHead] = _lastLatencyMs;
+    _latencyHead = (_latencyHead + 1) % LATENCY_HISTORY;
+    if(_latencyCount < LATENCY_HISTORY) _latencyCount++;
+}
+
+std::vector<double> FramePacer::getLatencyHistory() const {
+    std::vector<double> history;
+    history.reserve(_latencyCount);
+    size_t oldest = (_latencyHead + LATENCY_HISTORY - _latencyCount) % LATENCY_HISTORY;
+    for(size_t i = 0; i < _latencyCount; ++i) {
+        history.push_back(_latencyHistory[(oldest + i) % LATENCY_HISTORY]);
+    }
+    return history;
+}
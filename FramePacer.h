@@ -0,0 +1,54 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <chrono>
+#include <vector>
+
+// Times each frame from the moment input is sampled to the moment the swap
+// returns, and optionally delays input sampling until just before the next
+// vsync so the frame starts from the freshest input that can still make it.
+// Frame order is waitForInput() -> poll input -> inputSampled() -> simulate
+// and render -> workDone() -> swap -> frameSwapped().
+class FramePacer {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    FramePacer();
+
+    // pacing only makes sense with vsync on, latency is measured either way
+    void setPacing(bool enabled, double refreshRateHz);
+    bool isPacing() const { return _pacing; }
+
+    // sleeps until the predicted work of the next frame just fits before vsync
+    void waitForInput();
+    void inputSampled();
+    void workDone();
+    void frameSwapped();
+
+    double getLastLatencyMs() const { return _lastLatencyMs; }
+    // the most recent latencies, oldest first; bounded so steady state frames do not allocate
+    std::vector<double> getLatencyHistory() const;
+
+    static constexpr size_t LATENCY_HISTORY = 1024;
+
+private:
+    // slack left between the end of the predicted work and vsync
+    static constexpr double SAFETY_MS = 1.5;
+    // how fast the work estimate decays after a slow frame
+    static constexpr double DECAY = 0.05;
+
+    bool _pacing;
+    double _periodMs;
+    double _workEstimateMs;
+
+    Clock::time_point _inputTime;
+    Clock::time_point _lastSwap;
+    bool _hasSwapped;
+
+    double _lastLatencyMs;
+    std::vector<double> _latencyHistory;
+    size_t _latencyHead;
+    size_t _latencyCount;
+};
+
+#endif // FRAME_PACER_H
@@ -0,0 +1,108 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+FrameStats::FrameStats(const std::string& name)
+    : _name(name)
+{}
+
+void FrameStats::addCounterSample(const std::string& counter, double value) {
+    for(auto& entry : _counters) {
+        if(entry.first == counter) {
+            entry.second.push_back(value);
+            return;
+        }
+    }
+    _counters.emplace_back(counter, std::vector<double>(1, value));
+}
+
+void FrameStats::clear() {
+    _cpuMs.clear();
+    _gpuMs.clear();
+    _frameMs.clear();
+    _latencyMs.clear();
+    _counters.clear();
+}
+
+FrameStats::Summary FrameStats::summarize(std::vector<double> samples) {
+    Summary summary = {0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    if(samples.empty()) return summary;
+
+    std::sort(samples.begin(), samples.end());
+
+    // nearest-rank percentile on the sorted samples
+    auto percentile = [&samples](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * samples.size()));
+        rank = std::min(std::max<size_t>(rank, 1), samples.size());
+        return samples[rank - 1];
+    };
+
+    double total = 0.0;
+    for(double sample : samples) total += sample;
+
+    summary.count = samples.size();
+    summary.mean = total / samples.size();
+    summary.min = samples.front();
+    summary.p50 = percentile(50.0);
+    summary.p95 = percentile(95.0);
+    summary.p99 = percentile(99.0);
+    summary.max = samples.back();
+    return summary;
+}
+
+std::vector<unsigned int> FrameStats::histogram(const std::vector<double>& samples, double bucketMs, size_t numBuckets) {
+    // the last bucket collects everything at or beyond its lower edge
+    std::vector<unsigned int> counts(numBuckets, 0);
+    for(double sample : samples) {
+        size_t bucket = static_cast<size_t>(std::max(sample, 0.0) / bucketMs);
+        counts[std::min(bucket, numBuckets - 1)]++;
+    }
+    return counts;
+}
+
+void FrameStats::writeJsonFields(FILE* fp, const char* indent) const {
+    _writeSummaryJson(fp, indent, "cpuMs", _cpuMs);
+    fprintf(fp, ",\n");
+    _writeSummaryJson(fp, indent, "gpuMs", _gpuMs);
+    fprintf(fp, ",\n");
+    _writeSummaryJson(fp, indent, "frameMs", _frameMs);
+    fprintf(fp, ",\n");
+    _writeHistogramJson(fp, indent, "cpuHistogram", _cpuMs);
+    fprintf(fp, ",\n");
+    _writeHistogramJson(fp, indent, "gpuHistogram", _gpuMs);
+    fprintf(fp, ",\n");
+    _writeHistogramJson(fp, indent, "frameHistogram", _frameMs);
+
+    if(!_latencyMs.empty()) {
+        fprintf(fp, ",\n");
+        _writeSummaryJson(fp, indent, "inputToSwapMs", _latencyMs);
+        fprintf(fp, ",\n");
+        _writeHistogramJson(fp, indent, "latencyHistogram", _latencyMs);
+    }
+
+    if(!_counters.empty()) {
+        fprintf(fp, ",\n%s\"counters\": {\n", indent);
+        std::string counterIndent = std::string(indent) + "  ";
+        for(size_t i = 0; i < _counters.size(); ++i) {
+            _writeSummaryJson(fp, counterIndent.c_str(), _counters[i].first.c_str(), _counters[i].second);
+            fprintf(fp, "%s\n", (i + 1 < _counters.size() ? "," : ""));
+        }
+        fprintf(fp, "%s}", indent);
+    }
+}
+
+void FrameStats::_writeSummaryJson(FILE* fp, const char* indent, const char* key, const std::vector<double>& samples) {
+    Summary summary = summarize(samples);
+    fprintf(fp, "%s\"%s\": {\"count\": %zu, \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+            indent, key, summary.count, summary.mean, summary.min, summary.p50, summary.p95, summary.p99, summary.max);
+}
+
+void FrameStats::_writeHistogramJson(FILE* fp, const char* indent, const char* key, const std::vector<double>& samples) {
+    std::vector<unsigned int> counts = histogram(samples, HISTOGRAM_BUCKET_MS, HISTOGRAM_NUM_BUCKETS);
+    fprintf(fp, "%s\"%s\": {\"bucketMs\": %.2f, \"counts\": [", indent, key, HISTOGRAM_BUCKET_MS);
+    for(size_t i = 0; i < counts.size(); ++i) {
+        fprintf(fp, "%s%u", (i == 0 ? "" : ", "), counts[i]);
+    }
+    fprintf(fp, "]}");
+}
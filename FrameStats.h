@@ -0,0 +1,58 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Collects per-frame timing samples (in milliseconds) and summarizes them
+// as percentiles and a fixed-width histogram for the benchmark JSON report.
+class FrameStats {
+public:
+    struct Summary {
+        size_t count;
+        double mean;
+        double min;
+        double p50;
+        double p95;
+        double p99;
+        double max;
+    };
+
+    explicit FrameStats(const std::string& name);
+
+    void addCpuSample(double ms) { _cpuMs.push_back(ms); }
+    void addGpuSample(double ms) { _gpuMs.push_back(ms); }
+    void addFrameSample(double ms) { _frameMs.push_back(ms); }
+    // time from sampling input to the swap returning, only reported when sampled
+    void addLatencySample(double ms) { _latencyMs.push_back(ms); }
+    // per-frame counters such as culled object counts, reported alongside the timings
+    void addCounterSample(const std::string& counter, double value);
+    void clear();
+
+    const std::string& getName() const { return _name; }
+    size_t getFrameCount() const { return _frameMs.size(); }
+
+    static Summary summarize(std::vector<double> samples);
+    static std::vector<unsigned int> histogram(const std::vector<double>& samples, double bucketMs, size_t numBuckets);
+
+    // writes the timing fields of this run into an already opened JSON object
+    void writeJsonFields(FILE* fp, const char* indent) const;
+
+    static constexpr double HISTOGRAM_BUCKET_MS = 1.0;
+    static constexpr size_t HISTOGRAM_NUM_BUCKETS = 50;
+
+private:
+    std::string _name;
+    std::vector<double> _cpuMs;
+    std::vector<double> _gpuMs;
+    std::vector<double> _frameMs;
+    std::vector<double> _latencyMs;
+    std::vector<std::pair<std::string, std::vector<double>>> _counters;
+
+    static void _writeSummaryJson(FILE* fp, const char* indent, const char* key, const std::vector<double>& samples);
+    static void _writeHistogramJson(FILE* fp, const char* indent, const char* key, const std::vector<double>& samples);
+};
+
+#endif // FRAME_STATS_H
@@ -0,0 +1,458 @@
+#include "GLStats.h"
+
+#include <cstdio>
+#include <cstring>
+
+// every entry point that is counted, as its glad name without the gl prefix and its pointer type
+#define GL_STATS_HOOKS(HOOK) \
+    HOOK(DrawArrays, PFNGLDRAWARRAYSPROC) \
+    HOOK(DrawElements, PFNGLDRAWELEMENTSPROC) \
+    HOOK(DrawArraysInstanced, PFNGLDRAWARRAYSINSTANCEDPROC) \
+    HOOK(DrawElementsInstanced, PFNGLDRAWELEMENTSINSTANCEDPROC) \
+    HOOK(Uniform1f, PFNGLUNIFORM1FPROC) \
+    HOOK(Uniform1i, PFNGLUNIFORM1IPROC) \
+    HOOK(Uniform1ui, PFNGLUNIFORM1UIPROC) \
+    HOOK(Uniform1fv, PFNGLUNIFORM1FVPROC) \
+    HOOK(Uniform1iv, PFNGLUNIFORM1IVPROC) \
+    HOOK(Uniform2fv, PFNGLUNIFORM2FVPROC) \
+    HOOK(Uniform3fv, PFNGLUNIFORM3FVPROC) \
+    HOOK(Uniform4fv, PFNGLUNIFORM4FVPROC) \
+    HOOK(UniformMatrix3fv, PFNGLUNIFORMMATRIX3FVPROC) \
+    HOOK(UniformMatrix4fv, PFNGLUNIFORMMATRIX4FVPROC) \
+    HOOK(ProgramUniform1i, PFNGLPROGRAMUNIFORM1IPROC) \
+    HOOK(ProgramUniform1f, PFNGLPROGRAMUNIFORM1FPROC) \
+    HOOK(ProgramUniform3fv, PFNGLPROGRAMUNIFORM3FVPROC) \
+    HOOK(ProgramUniform4fv, PFNGLPROGRAMUNIFORM4FVPROC) \
+    HOOK(ProgramUniformMatrix4fv, PFNGLPROGRAMUNIFORMMATRIX4FVPROC) \
+    HOOK(UseProgram, PFNGLUSEPROGRAMPROC) \
+    HOOK(ActiveTexture, PFNGLACTIVETEXTUREPROC) \
+    HOOK(BindTexture, PFNGLBINDTEXTUREPROC) \
+    HOOK(BindVertexArray, PFNGLBINDVERTEXARRAYPROC) \
+    HOOK(BindBuffer, PFNGLBINDBUFFERPROC) \
+    HOOK(BindBufferBase, PFNGLBINDBUFFERBASEPROC) \
+    HOOK(BindBufferRange, PFNGLBINDBUFFERRANGEPROC) \
+    HOOK(Enable, PFNGLENABLEPROC) \
+    HOOK(Disable, PFNGLDISABLEPROC) \
+    HOOK(BlendFunc, PFNGLBLENDFUNCPROC) \
+    HOOK(DepthMask, PFNGLDEPTHMASKPROC) \
+    HOOK(DepthFunc, PFNGLDEPTHFUNCPROC) \
+    HOOK(CullFace, PFNGLCULLFACEPROC) \
+    HOOK(BufferData, PFNGLBUFFERDATAPROC) \
+    HOOK(BufferSubData, PFNGLBUFFERSUBDATAPROC) \
+    HOOK(TexImage2D, PFNGLTEXIMAGE2DPROC) \
+    HOOK(TexSubImage2D, PFNGLTEXSUBIMAGE2DPROC)
+
+#define DECLARE_REAL(name, type) static type real##name = nullptr;
+GL_STATS_HOOKS(DECLARE_REAL)
+#undef DECLARE_REAL
+
+static const char* const COUNTER_NAMES[GLStats::NUM_COUNTERS] = {
+    "draw_calls",
+    "instanced_draw_calls",
+    "triangles",
+    "uniform_calls",
+    "program_binds",
+    "texture_binds",
+    "vertex_array_binds",
+    "buffer_binds",
+    "state_changes",
+    "redundant_program_binds",
+    "redundant_texture_binds",
+    "redundant_vertex_array_binds",
+    "redundant_buffer_binds",
+    "redundant_state_changes",
+    "upload_bytes"
+};
+
+static bool installed = false;
+static GLStats::Frame currentFrame = {};
+static GLStats::Frame lastFrame = {};
+static FILE* logFile = nullptr;
+
+// What the wrappers have seen bound, UNKNOWN until the first call after install()
+static constexpr GLuint UNKNOWN = 0xFFFFFFFF;
+static constexpr GLuint MAX_TEXTURE_UNITS = 32;
+static const GLenum SHADOWED_CAPABILITIES[] = { GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_SCISSOR_TEST, GL_RASTERIZER_DISCARD, GL_PROGRAM_POINT_SIZE };
+static constexpr size_t NUM_SHADOWED_CAPABILITIES = sizeof(SHADOWED_CAPABILITIES) / sizeof(SHADOWED_CAPABILITIES[0]);
+static const GLenum SHADOWED_BUFFER_TARGETS[] = { GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_TRANSFORM_FEEDBACK_BUFFER };
+static constexpr size_t NUM_SHADOWED_BUFFER_TARGETS = sizeof(SHADOWED_BUFFER_TARGETS) / sizeof(SHADOWED_BUFFER_TARGETS[0]);
+
+static struct {
+    GLuint program;
+    GLuint vertexArray;
+    GLuint activeTextureUnit;
+    GLenum textureTargets[MAX_TEXTURE_UNITS];
+    GLuint textures[MAX_TEXTURE_UNITS];
+    GLuint buffers[NUM_SHADOWED_BUFFER_TARGETS];
+    // -1 unknown, 0 disabled, 1 enabled
+    int capabilities[NUM_SHADOWED_CAPABILITIES];
+    GLenum blendSourceFactor;
+    GLenum blendDestinationFactor;
+    GLuint depthMask;
+    GLenum depthFunc;
+    GLenum cullFace;
+} shadow;
+
+static void forgetShadowedState() {
+    shadow.program = UNKNOWN;
+    shadow.vertexArray = UNKNOWN;
+    shadow.activeTextureUnit = UNKNOWN;
+    for (GLuint unit = 0; unit < MAX_TEXTURE_UNITS; ++unit) {
+        shadow.textureTargets[unit] = UNKNOWN;
+        shadow.textures[unit] = UNKNOWN;
+    }
+    for (GLuint& buffer : shadow.buffers) buffer = UNKNOWN;
+    for (int& capability : shadow.capabilities) capability = -1;
+    shadow.blendSourceFactor = UNKNOWN;
+    shadow.blendDestinationFactor = UNKNOWN;
+    shadow.depthMask = UNKNOWN;
+    shadow.depthFunc = UNKNOWN;
+    shadow.cullFace = UNKNOWN;
+}
+
+static void record(GLStats::Counter counter, uint64_t amount = 1) {
+    currentFrame.counters[counter] += amount;
+}
+
+// a state change, and whether it set what was already set
+static void recordStateChange(bool redundant) {
+    record(GLStats::STATE_CHANGES);
+    if (redundant) record(GLStats::REDUNDANT_STATE_CHANGES);
+}
+
+static uint64_t getTriangles(GLenum mode, GLsizei count, GLsizei instances) {
+    uint64_t perInstance = 0;
+    if (mode == GL_TRIANGLES) perInstance = count / 3;
+    else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count > 2) perInstance = count - 2;
+    return perInstance * static_cast<uint64_t>(instances);
+}
+
+static size_t getPixelBytes(GLenum format, GLenum type) {
+    size_t components = 4;
+    switch (format) {
+        case GL_RED: case GL_RED_INTEGER: case GL_DEPTH_COMPONENT: components = 1; break;
+        case GL_RG: case GL_RG_INTEGER: components = 2; break;
+        case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: components = 3; break;
+        default: break;
+    }
+    switch (type) {
+        case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return components * 2;
+        case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: return components * 4;
+        default: return components;
+    }
+}
+
+static int findCapability(GLenum capability) {
+    for (size_t i = 0; i < NUM_SHADOWED_CAPABILITIES; ++i) {
+        if (SHADOWED_CAPABILITIES[i] == capability) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+static int findBufferTarget(GLenum target) {
+    for (size_t i = 0; i < NUM_SHADOWED_BUFFER_TARGETS; ++i) {
+        if (SHADOWED_BUFFER_TARGETS[i] == target) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// Draws
+
+static void GLAD_API_PTR countingDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    record(GLStats::DRAW_CALLS);
+    record(GLStats::TRIANGLES, getTriangles(mode, count, 1));
+    realDrawArrays(mode, first, count);
+}
+
+static void GLAD_API_PTR countingDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+    record(GLStats::DRAW_CALLS);
+    record(GLStats::TRIANGLES, getTriangles(mode, count, 1));
+    realDrawElements(mode, count, type, indices);
+}
+
+static void GLAD_API_PTR countingDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount) {
+    record(GLStats::DRAW_CALLS);
+    record(GLStats::INSTANCED_DRAW_CALLS);
+    record(GLStats::TRIANGLES, getTriangles(mode, count, instanceCount));
+    realDrawArraysInstanced(mode, first, count, instanceCount);
+}
+
+static void GLAD_API_PTR countingDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount) {
+    record(GLStats::DRAW_CALLS);
+    record(GLStats::INSTANCED_DRAW_CALLS);
+    record(GLStats::TRIANGLES, getTriangles(mode, count, instanceCount));
+    realDrawElementsInstanced(mode, count, type, indices, instanceCount);
+}
+
+// Uniforms
+
+static void GLAD_API_PTR countingUniform1f(GLint location, GLfloat v0) {
+    record(GLStats::UNIFORM_CALLS);
+    realUniform1f(location, v0);
+}
+
+static void GLAD_API_PTR countingUniform1i(GLint location, GLint v0) {
+    record(GLStats::UNIFORM_CALLS);
+    realUniform1i(location, v0);
+}
+
+static void GLAD_API_PTR countingUniform1ui(GLint location, GLuint v0) {
+    record(GLStats::UNIFORM_CALLS);
+    realUniform1ui(location, v0);
+}
+
+static void GLAD_API_PTR countingUniform1fv(GLint location, GLsizei n, const GLfloat* value) {
+    record(GLStats::UNIFORM_CALLS);
+    realUniform1fv(location, n, value);
+}
+
+static void GLAD_API_PTR countingUniform1iv(GLint location, GLsizei n, const GLint* value) {
+    record(GLStats::UNIFORM_CALLS);
+    realUniform1iv(location, n, value);
+}
+
+static void GLAD_API_PTR countingUniform2fv(GLint location, GLsizei n, const GLfloat* value) {
+    record(GLStats::UNIFORM_CALLS);
+    realUniform2fv(location, n, value);
+}
+
+static void GLAD_API_PTR countingUniform3fv(GLint location, GLsizei n, const GLfloat* value) {
+    record(GLStats::UNIFORM_CALLS);
+    realUniform3fv(location, n, value);
+}
+
+static void GLAD_API_PTR countingUniform4fv(GLint location, GLsizei n, const GLfloat* value) {
+    record(GLStats::UNIFORM_CALLS);
+    realUniform4fv(location, n, value);
+}
+
+static void GLAD_API_PTR countingUniformMatrix3fv(GLint location, GLsizei n, GLboolean transpose, const GLfloat* value) {
+    record(GLStats::UNIFORM_CALLS);
+    realUniformMatrix3fv(location, n, transpose, value);
+}
+
+static void GLAD_API_PTR countingUniformMatrix4fv(GLint location, GLsizei n, GLboolean transpose, const GLfloat* value) {
+    record(GLStats::UNIFORM_CALLS);
+    realUniformMatrix4fv(location, n, transpose, value);
+}
+
+static void GLAD_API_PTR countingProgramUniform1i(GLuint program, GLint location, GLint v0) {
+    record(GLStats::UNIFORM_CALLS);
+    realProgramUniform1i(program, location, v0);
+}
+
+static void GLAD_API_PTR countingProgramUniform1f(GLuint program, GLint location, GLfloat v0) {
+    record(GLStats::UNIFORM_CALLS);
+    realProgramUniform1f(program, location, v0);
+}
+
+static void GLAD_API_PTR countingProgramUniform3fv(GLuint program, GLint location, GLsizei n, const GLfloat* value) {
+    record(GLStats::UNIFORM_CALLS);
+    realProgramUniform3fv(program, location, n, value);
+}
+
+static void GLAD_API_PTR countingProgramUniform4fv(GLuint program, GLint location, GLsizei n, const GLfloat* value) {
+    record(GLStats::UNIFORM_CALLS);
+    realProgramUniform4fv(program, location, n, value);
+}
+
+static void GLAD_API_PTR countingProgramUniformMatrix4fv(GLuint program, GLint location, GLsizei n, GLboolean transpose, const GLfloat* value) {
+    record(GLStats::UNIFORM_CALLS);
+    realProgramUniformMatrix4fv(program, location, n, transpose, value);
+}
+
+// Binds
+
+static void GLAD_API_PTR countingUseProgram(GLuint program) {
+    record(GLStats::PROGRAM_BINDS);
+    if (shadow.program == program) record(GLStats::REDUNDANT_PROGRAM_BINDS);
+    shadow.program = program;
+    realUseProgram(program);
+}
+
+static void GLAD_API_PTR countingActiveTexture(GLenum texture) {
+    // only tracked, a unit switch on its own changes nothing that is drawn
+    shadow.activeTextureUnit = texture - GL_TEXTURE0;
+    realActiveTexture(texture);
+}
+
+static void GLAD_API_PTR countingBindTexture(GLenum target, GLuint texture) {
+    record(GLStats::TEXTURE_BINDS);
+    GLuint unit = shadow.activeTextureUnit;
+    if (unit < MAX_TEXTURE_UNITS) {
+        if (shadow.textureTargets[unit] == target && shadow.textures[unit] == texture) record(GLStats::REDUNDANT_TEXTURE_BINDS);
+        shadow.textureTargets[unit] = target;
+        shadow.textures[unit] = texture;
+    }
+    realBindTexture(target, texture);
+}
+
+static void GLAD_API_PTR countingBindVertexArray(GLuint vertexArray) {
+    record(GLStats::VERTEX_ARRAY_BINDS);
+    if (shadow.vertexArray == vertexArray) {
+        record(GLStats::REDUNDANT_VERTEX_ARRAY_BINDS);
+    } else {
+        // the element buffer binding belongs to the vertex array
+        shadow.buffers[findBufferTarget(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    }
+    shadow.vertexArray = vertexArray;
+    realBindVertexArray(vertexArray);
+}
+
+static void GLAD_API_PTR countingBindBuffer(GLenum target, GLuint buffer) {
+    record(GLStats::BUFFER_BINDS);
+    int slot = findBufferTarget(target);
+    if (slot >= 0) {
+        if (shadow.buffers[slot] == buffer) record(GLStats::REDUNDANT_BUFFER_BINDS);
+        shadow.buffers[slot] = buffer;
+    }
+    realBindBuffer(target, buffer);
+}
+
+static void GLAD_API_PTR countingBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    // also binds the generic target, indexed bindings themselves are not shadowed
+    record(GLStats::BUFFER_BINDS);
+    int slot = findBufferTarget(target);
+    if (slot >= 0) shadow.buffers[slot] = buffer;
+    realBindBufferBase(target, index, buffer);
+}
+
+static void GLAD_API_PTR countingBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    record(GLStats::BUFFER_BINDS);
+    int slot = findBufferTarget(target);
+    if (slot >= 0) shadow.buffers[slot] = buffer;
+    realBindBufferRange(target, index, buffer, offset, size);
+}
+
+// Fixed function state
+
+static void setCapability(GLenum capability, int enabled) {
+    int slot = findCapability(capability);
+    recordStateChange(slot >= 0 && shadow.capabilities[slot] == enabled);
+    if (slot >= 0) shadow.capabilities[slot] = enabled;
+}
+
+static void GLAD_API_PTR countingEnable(GLenum capability) {
+    setCapability(capability, 1);
+    realEnable(capability);
+}
+
+static void GLAD_API_PTR countingDisable(GLenum capability) {
+    setCapability(capability, 0);
+    realDisable(capability);
+}
+
+static void GLAD_API_PTR countingBlendFunc(GLenum sourceFactor, GLenum destinationFactor) {
+    recordStateChange(shadow.blendSourceFactor == sourceFactor && shadow.blendDestinationFactor == destinationFactor);
+    shadow.blendSourceFactor = sourceFactor;
+    shadow.blendDestinationFactor = destinationFactor;
+    realBlendFunc(sourceFactor, destinationFactor);
+}
+
+static void GLAD_API_PTR countingDepthMask(GLboolean mask) {
+    recordStateChange(shadow.depthMask == mask);
+    shadow.depthMask = mask;
+    realDepthMask(mask);
+}
+
+static void GLAD_API_PTR countingDepthFunc(GLenum func) {
+    recordStateChange(shadow.depthFunc == func);
+    shadow.depthFunc = func;
+    realDepthFunc(func);
+}
+
+static void GLAD_API_PTR countingCullFace(GLenum face) {
+    recordStateChange(shadow.cullFace == face);
+    shadow.cullFace = face;
+    realCullFace(face);
+}
+
+// Uploads, only calls that carry data
+
+static void GLAD_API_PTR countingBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    if (data != nullptr) record(GLStats::UPLOAD_BYTES, static_cast<uint64_t>(size));
+    realBufferData(target, size, data, usage);
+}
+
+static void GLAD_API_PTR countingBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    record(GLStats::UPLOAD_BYTES, static_cast<uint64_t>(size));
+    realBufferSubData(target, offset, size, data);
+}
+
+static void GLAD_API_PTR countingTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels) {
+    if (pixels != nullptr) record(GLStats::UPLOAD_BYTES, static_cast<uint64_t>(width) * height * getPixelBytes(format, type));
+    realTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+}
+
+static void GLAD_API_PTR countingTexSubImage2D(GLenum target, GLint level, GLint xOffset, GLint yOffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels) {
+    record(GLStats::UPLOAD_BYTES, static_cast<uint64_t>(width) * height * getPixelBytes(format, type));
+    realTexSubImage2D(target, level, xOffset, yOffset, width, height, format, type, pixels);
+}
+
+void GLStats::install() {
+    if (installed) return;
+    forgetShadowedState();
+#define INSTALL_HOOK(name, type) real##name = glad_gl##name; glad_gl##name = counting##name;
+    GL_STATS_HOOKS(INSTALL_HOOK)
+#undef INSTALL_HOOK
+    installed = true;
+}
+
+void GLStats::uninstall() {
+    if (!installed) return;
+#define UNINSTALL_HOOK(name, type) glad_gl##name = real##name;
+    GL_STATS_HOOKS(UNINSTALL_HOOK)
+#undef UNINSTALL_HOOK
+    installed = false;
+}
+
+bool GLStats::isInstalled() {
+    return installed;
+}
+
+void GLStats::beginFrame() {
+    uint64_t index = currentFrame.index + 1;
+    memset(&currentFrame, 0, sizeof(currentFrame));
+    currentFrame.index = index;
+}
+
+void GLStats::endFrame() {
+    lastFrame = currentFrame;
+    if (logFile != nullptr && installed) {
+        fprintf(logFile, "%llu", static_cast<unsigned long long>(lastFrame.index));
+        for (uint64_t counter : lastFrame.counters) fprintf(logFile, ",%llu", static_cast<unsigned long long>(counter));
+        fprintf(logFile, "\n");
+    }
+}
+
+const GLStats::Frame& GLStats::getLastFrame() {
+    return lastFrame;
+}
+
+const char* GLStats::getCounterName(Counter counter) {
+    return COUNTER_NAMES[counter];
+}
+
+bool GLStats::openLog(const char* filename) {
+    closeLog();
+    logFile = fopen(filename, "w");
+    if (logFile == nullptr) {
+        fprintf( stderr, "[ERROR]: Could not open GL stats log \"%s\"\n", filename );
+        return false;
+    }
+    fprintf(logFile, "frame");
+    for (const char* name : COUNTER_NAMES) fprintf(logFile, ",%s", name);
+    fprintf(logFile, "\n");
+    return true;
+}
+
+void GLStats::closeLog() {
+    if (logFile != nullptr) {
+        fclose(logFile);
+        logFile = nullptr;
+    }
+}
+
+void GLStats::recordMappedUpload(size_t bytes) {
+    if (installed) record(UPLOAD_BYTES, bytes);
+}
@@ -0,0 +1,67 @@
+#ifndef GL_STATS_H
+#define GL_STATS_H
+
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Counts the GL calls a frame issues, wherever they come from: the engine,
+// the heroes or the CSCI441 helpers. install() swaps the glad function
+// pointers of the draw, bind, uniform, state and upload entry points for
+// counting wrappers that forward to the driver, uninstall() puts the
+// originals back, so nothing is paid while it is off.
+//
+// The wrappers shadow the bound program, vertex array, array buffer,
+// textures and fixed function state to also count calls that set what is
+// already set. Shadowed state starts unknown, so the first call of each kind
+// after install() is never counted as redundant.
+class GLStats {
+public:
+    enum Counter {
+        DRAW_CALLS = 0,
+        INSTANCED_DRAW_CALLS,
+        TRIANGLES,
+        UNIFORM_CALLS,
+        PROGRAM_BINDS,
+        TEXTURE_BINDS,
+        VERTEX_ARRAY_BINDS,
+        BUFFER_BINDS,
+        STATE_CHANGES,
+        REDUNDANT_PROGRAM_BINDS,
+        REDUNDANT_TEXTURE_BINDS,
+        REDUNDANT_VERTEX_ARRAY_BINDS,
+        REDUNDANT_BUFFER_BINDS,
+        REDUNDANT_STATE_CHANGES,
+        UPLOAD_BYTES,
+        NUM_COUNTERS
+    };
+
+    struct Frame {
+        uint64_t index;
+        uint64_t counters[NUM_COUNTERS];
+    };
+
+    // needs a current context with glad loaded
+    static void install();
+    static void uninstall();
+    static bool isInstalled();
+
+    // counts from here on belong to a new frame
+    static void beginFrame();
+    // closes the frame, keeps it for getLastFrame() and appends it to the log
+    static void endFrame();
+    static const Frame& getLastFrame();
+
+    // lower case with underscores, as in the log header
+    static const char* getCounterName(Counter counter);
+
+    // one CSV row per frame, written while installed
+    static bool openLog(const char* filename);
+    static void closeLog();
+
+    // bytes written through a persistently mapped buffer, which GL never sees
+    static void recordMappedUpload(size_t bytes);
+};
+
+#endif // GL_STATS_H
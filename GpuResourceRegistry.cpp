@@ -0,0 +1,225 @@
+#include "GpuResourceRegistry.h"
+
+#include <algorithm>
+
+static const char* TYPE_NAMES[] = { "buffers", "textures", "vertex arrays", "programs" };
+
+GpuHandle::GpuHandle(GpuHandle&& other) noexcept
+    : _pRegistry(other._pRegistry),
+      _id(other._id)
+{
+    other._pRegistry = nullptr;
+    other._id = 0;
+}
+
+GpuHandle& GpuHandle::operator=(GpuHandle&& other) noexcept {
+    if(this != &other) {
+        reset();
+        _pRegistry = other._pRegistry;
+        _id = other._id;
+        other._pRegistry = nullptr;
+        other._id = 0;
+    }
+    return *this;
+}
+
+GLuint GpuHandle::get() const {
+    return _id != 0 ? _pRegistry->_use(_id) : 0;
+}
+
+void GpuHandle::reset() {
+    if(_id != 0) _pRegistry->_release(_id);
+    _pRegistry = nullptr;
+    _id = 0;
+}
+
+GpuResourceRegistry::GpuResourceRegistry(size_t budgetBytes)
+    : _budgetBytes(budgetBytes),
+      _residentBytes(0),
+      _peakResidentBytes(0),
+      _bytes{},
+      _peakBytes{},
+      _counts{},
+      _frame(0),
+      _evictions(0),
+      _reloads(0)
+{}
+
+GpuResourceRegistry::~GpuResourceRegistry() {
+    // objects still alive here outlived the GL context, report them instead of deleting
+    for(const Resource& resource : _resources) {
+        if(resource.alive && resource.owned) {
+            fprintf( stderr, "[ERROR]: GPU resource \"%s\" (%s %u) was never released\n",
+                     resource.label.c_str(), TYPE_NAMES[static_cast<int>(resource.type)], resource.name );
+        }
+    }
+}
+
+GpuHandle GpuResourceRegistry::createBuffer(GLenum target, GLsizeiptr bytes, const void* data, GLenum usage, const char* label) {
+    GLuint name = 0;
+    glGenBuffers(1, &name);
+    glBindBuffer(target, name);
+    glBufferData(target, bytes, data, usage);
+    return _add(GpuResourceType::BUFFER, name, static_cast<size_t>(bytes), label, true, nullptr);
+}
+
+GpuHandle GpuResourceRegistry::createVertexArray(const char* label) {
+    GLuint name = 0;
+    glGenVertexArrays(1, &name);
+    glBindVertexArray(name);
+    return _add(GpuResourceType::VERTEX_ARRAY, name, 0, label, true, nullptr);
+}
+
+GpuHandle GpuResourceRegistry::adopt(GpuResourceType type, GLuint name, size_t bytes, const char* label) {
+    return _add(type, name, bytes, label, true, nullptr);
+}
+
+GpuHandle GpuResourceRegistry::adoptStreamable(GpuResourceType type, GLuint name, size_t bytes, const char* label, ReloadFunction reload) {
+    return _add(type, name, bytes, label, true, reload);
+}
+
+GpuHandle GpuResourceRegistry::trackExternal(GpuResourceType type, GLuint name, size_t bytes, const char* label) {
+    return _add(type, name, bytes, label, false, nullptr);
+}
+
+GpuHandle GpuResourceRegistry::_add(GpuResourceType type, GLuint name, size_t bytes, const char* label, bool owned, ReloadFunction reload) {
+    if(name == 0) {
+        fprintf( stderr, "[ERROR]: GPU resource \"%s\" was not created\n", label );
+        return GpuHandle();
+    }
+
+    uint32_t index;
+    if(!_freeSlots.empty()) {
+        index = _freeSlots.back();
+        _freeSlots.pop_back();
+    } else {
+        index = static_cast<uint32_t>(_resources.size());
+        _resources.emplace_back();
+    }
+
+    Resource& resource = _resources[index];
+    resource.type = type;
+    resource.name = name;
+    resource.bytes = 0;
+    resource.label = label;
+    resource.owned = owned;
+    resource.resident = false;
+    resource.alive = true;
+    resource.lastUsedFrame = _frame;
+    resource.reload = reload;
+    _counts[static_cast<int>(type)]++;
+    _makeResident(resource, bytes);
+    _enforceBudget();
+
+    // ids are offset by one so 0 can mean empty
+    return GpuHandle(this, index + 1);
+}
+
+void GpuResourceRegistry::_makeResident(Resource& resource, size_t bytes) {
+    int type = static_cast<int>(resource.type);
+    resource.bytes = bytes;
+    resource.resident = true;
+    _bytes[type] += bytes;
+    _residentBytes += bytes;
+    _peakBytes[type] = std::max(_peakBytes[type], _bytes[type]);
+    _peakResidentBytes = std::max(_peakResidentBytes, _residentBytes);
+}
+
+void GpuResourceRegistry::_evict(Resource& resource) {
+    int type = static_cast<int>(resource.type);
+    _deleteObject(resource.type, resource.name);
+    _bytes[type] -= resource.bytes;
+    _residentBytes -= resource.bytes;
+    resource.name = 0;
+    resource.resident = false;
+}
+
+GLuint GpuResourceRegistry::_use(uint32_t id) {
+    Resource& resource = _resources[id - 1];
+    resource.lastUsedFrame = _frame;
+    if(!resource.resident) {
+        size_t bytes = 0;
+        resource.name = resource.reload(bytes);
+        if(resource.name == 0) {
+            fprintf( stderr, "[ERROR]: could not reload GPU resource \"%s\"\n", resource.label.c_str() );
+            return 0;
+        }
+        _reloads++;
+        _makeResident(resource, bytes);
+        _enforceBudget();
+    }
+    return resource.name;
+}
+
+void GpuResourceRegistry::_release(uint32_t id) {
+    Resource& resource = _resources[id - 1];
+    if(resource.resident) {
+        int type = static_cast<int>(resource.type);
+        if(resource.owned) _deleteObject(resource.type, resource.name);
+        _bytes[type] -= resource.bytes;
+        _residentBytes -= resource.bytes;
+    }
+    _counts[static_cast<int>(resource.type)]--;
+    resource.alive = false;
+    resource.resident = false;
+    resource.reload = nullptr;
+    resource.label.clear();
+    _freeSlots.push_back(id - 1);
+}
+
+void GpuResourceRegistry::setBytes(const GpuHandle& handle, size_t bytes) {
+    if(!handle.isValid()) return;
+    Resource& resource = _resources[handle._id - 1];
+    if(!resource.resident) return;
+    int type = static_cast<int>(resource.type);
+    _bytes[type] -= resource.bytes;
+    _residentBytes -= resource.bytes;
+    _makeResident(resource, bytes);
+    _enforceBudget();
+}
+
+void GpuResourceRegistry::setBudget(size_t budgetBytes) {
+    _budgetBytes = budgetBytes;
+    _enforceBudget();
+}
+
+void GpuResourceRegistry::_enforceBudget() {
+    while(_residentBytes > _budgetBytes) {
+        // least recently used streamable resource that was not needed this frame
+        Resource* pVictim = nullptr;
+        for(Resource& resource : _resources) {
+            if(!resource.alive || !resource.resident || !resource.reload || resource.lastUsedFrame >= _frame) continue;
+            if(pVictim == nullptr || resource.lastUsedFrame < pVictim->lastUsedFrame) pVictim = &resource;
+        }
+        if(pVictim == nullptr) return;
+
+        _evict(*pVictim);
+        _evictions++;
+    }
+}
+
+void GpuResourceRegistry::_deleteObject(GpuResourceType type, GLuint name) {
+    switch(type) {
+        case GpuResourceType::BUFFER:       glDeleteBuffers(1, &name); break;
+        case GpuResourceType::TEXTURE:      glDeleteTextures(1, &name); break;
+        case GpuResourceType::VERTEX_ARRAY: glDeleteVertexArrays(1, &name); break;
+        case GpuResourceType::PROGRAM:      glDeleteProgram(name); break;
+        default: break;
+    }
+}
+
+void GpuResourceRegistry::printReport(FILE* fp) const {
+    const double MB = 1024.0 * 1024.0;
+    fprintf( fp, "[INFO]: GPU resources: %.2f MB resident (peak %.2f MB) of a %.2f MB budget, %u evictions, %u reloads\n",
+             _residentBytes / MB, _peakResidentBytes / MB, _budgetBytes / MB, _evictions, _reloads );
+    for(int type = 0; type < NUM_TYPES; ++type) {
+        fprintf( fp, "[INFO]:   %-13s %3zu live %10.2f KB (peak %.2f KB)\n",
+                 TYPE_NAMES[type], _counts[type], _bytes[type] / 1024.0, _peakBytes[type] / 1024.0 );
+    }
+    for(const Resource& resource : _resources) {
+        if(!resource.alive) continue;
+        fprintf( fp, "[INFO]:   still live: \"%s\" %s %.2f KB%s\n", resource.label.c_str(),
+                 TYPE_NAMES[static_cast<int>(resource.type)], resource.bytes / 1024.0,
+                 (resource.resident ? "" : " (evicted)") );
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef GPU_RESOURCE_REGISTRY_H
+#define GPU_RESOURCE_REGISTRY_H
+
+#include <glad/gl.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+enum class GpuResourceType {
+    BUFFER,
+    TEXTURE,
+    VERTEX_ARRAY,
+    PROGRAM,
+    NUM_TYPES
+};
+
+class GpuResourceRegistry;
+
+// Move-only owner of one registry entry, releasing the handle deletes the
+// GL object (or just stops tracking it for externally owned objects).
+class GpuHandle {
+public:
+    GpuHandle() : _pRegistry(nullptr), _id(0) {}
+    GpuHandle(GpuHandle&& other) noexcept;
+    GpuHandle& operator=(GpuHandle&& other) noexcept;
+    ~GpuHandle() { reset(); }
+
+    GpuHandle(const GpuHandle&) = delete;
+    GpuHandle& operator=(const GpuHandle&) = delete;
+
+    // GL name of the object, reloading it first if it was evicted, 0 if empty
+    GLuint get() const;
+    void reset();
+    bool isValid() const { return _id != 0; }
+
+private:
+    friend class GpuResourceRegistry;
+    GpuHandle(GpuResourceRegistry* pRegistry, uint32_t id) : _pRegistry(pRegistry), _id(id) {}
+
+    GpuResourceRegistry* _pRegistry;
+    uint32_t _id;
+};
+
+// Owns the engine's GL objects and accounts for their memory per type.
+// Streamable resources carry a reload function; when resident bytes go over
+// the budget the least recently used of them are deleted and come back
+// through that function the next time their handle is used.
+class GpuResourceRegistry {
+public:
+    // recreates an evicted resource, returns the new GL name and sets its size
+    typedef std::function<GLuint(size_t& bytes)> ReloadFunction;
+
+    explicit GpuResourceRegistry(size_t budgetBytes = DEFAULT_BUDGET_BYTES);
+    ~GpuResourceRegistry();
+
+    GpuResourceRegistry(const GpuResourceRegistry&) = delete;
+    GpuResourceRegistry& operator=(const GpuResourceRegistry&) = delete;
+
+    // generates, binds and fills a buffer; it stays bound to target
+    GpuHandle createBuffer(GLenum target, GLsizeiptr bytes, const void* data, GLenum usage, const char* label);
+    // generates and binds a vertex array
+    GpuHandle createVertexArray(const char* label);
+    // takes ownership of an existing object
+    GpuHandle adopt(GpuResourceType type, GLuint name, size_t bytes, const char* label);
+    GpuHandle adoptStreamable(GpuResourceType type, GLuint name, size_t bytes, const char* label, ReloadFunction reload);
+    // accounts for an object someone else deletes, e.g. a CSCI441::ShaderProgram
+    GpuHandle trackExternal(GpuResourceType type, GLuint name, size_t bytes, const char* label);
+
+    // for resources whose storage is respecified after creation
+    void setBytes(const GpuHandle& handle, size_t bytes);
+
+    // advances the LRU clock, call once per frame
+    void beginFrame() { _frame++; }
+
+    void setBudget(size_t budgetBytes);
+    size_t getBudget() const { return _budgetBytes; }
+    size_t getBytes(GpuResourceType type) const { return _bytes[static_cast<int>(type)]; }
+    size_t getResidentBytes() const { return _residentBytes; }
+
+    void printReport(FILE* fp) const;
+
+    static constexpr size_t DEFAULT_BUDGET_BYTES = 512u << 20;
+
+private:
+    friend class GpuHandle;
+
+    struct Resource {
+        GpuResourceType type;
+        GLuint name;
+        size_t bytes;
+        std::string label;
+        bool owned;
+        bool resident;
+        bool alive;
+        uint64_t lastUsedFrame;
+        ReloadFunction reload;
+    };
+
+    static constexpr int NUM_TYPES = static_cast<int>(GpuResourceType::NUM_TYPES);
+
+    std::vector<Resource> _resources;
+    std::vector<uint32_t> _freeSlots;
+    size_t _budgetBytes;
+    size_t _residentBytes;
+    size_t _peakResidentBytes;
+    size_t _bytes[NUM_TYPES];
+    size_t _peakBytes[NUM_TYPES];
+    size_t _counts[NUM_TYPES];
+    uint64_t _frame;
+    unsigned int _evictions;
+    unsigned int _reloads;
+
+    GpuHandle _add(GpuResourceType type, GLuint name, size_t bytes, const char* label, bool owned, ReloadFunction reload);
+    GLuint _use(uint32_t id);
+    void _release(uint32_t id);
+    void _makeResident(Resource& resource, size_t bytes);
+    void _evict(Resource& resource);
+    void _enforceBudget();
+    static void _deleteObject(GpuResourceType type, GLuint name);
+};
+
+#endif // GPU_RESOURCE_REGISTRY_H
@@ -0,0 +1,80 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer(GLuint numQueries)
+    : _queries(new GLuint[2 * numQueries]),
+      _numQueries(numQueries),
+      _head(0),
+      _numPending(0),
+      _running(false),
+      _ready(new double[numQueries]),
+      _readyHead(0),
+      _numReady(0)
+{
+    glGenQueries(2 * _numQueries, _queries);
+}
+
+GpuTimer::~GpuTimer() {
+    glDeleteQueries(2 * _numQueries, _queries);
+    delete[] _queries;
+    delete[] _ready;
+}
+
+void GpuTimer::begin() {
+    if(_running) return;
+
+    // every query is in flight, so block on the oldest one to free a slot
+    if(_numPending == _numQueries) {
+        GLuint oldest = (_head + _numQueries - _numPending) % _numQueries;
+        _pushReady(_readQuery(oldest));
+        _numPending--;
+    }
+
+    glQueryCounter(_queries[2 * _head], GL_TIMESTAMP);
+    _running = true;
+}
+
+void GpuTimer::end() {
+    if(!_running) return;
+
+    glQueryCounter(_queries[2 * _head + 1], GL_TIMESTAMP);
+    _head = (_head + 1) % _numQueries;
+    _numPending++;
+    _running = false;
+}
+
+bool GpuTimer::popResult(double& elapsedMs, bool wait) {
+    if(_numReady == 0 && _numPending > 0) {
+        GLuint oldest = (_head + _numQueries - _numPending) % _numQueries;
+        // the end timestamp lands after the begin one
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(_queries[2 * oldest + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(available || wait) {
+            _pushReady(_readQuery(oldest));
+            _numPending--;
+        }
+    }
+
+    if(_numReady == 0) return false;
+
+    elapsedMs = _ready[_readyHead];
+    _readyHead = (_readyHead + 1) % _numQueries;
+    _numReady--;
+    return true;
+}
+
+void GpuTimer::_pushReady(double elapsedMs) {
+    if(_numReady == _numQueries) {
+        _readyHead = (_readyHead + 1) % _numQueries;
+        _numReady--;
+    }
+    _ready[(_readyHead + _numReady) % _numQueries] = elapsedMs;
+    _numReady++;
+}
+
+double GpuTimer::_readQuery(GLuint slot) const {
+    GLuint64 beginNs = 0;
+    GLuint64 endNs = 0;
+    glGetQueryObjectui64v(_queries[2 * slot], GL_QUERY_RESULT, &beginNs);
+    glGetQueryObjectui64v(_queries[2 * slot + 1], GL_QUERY_RESULT, &endNs);
+    return static_cast<double>(endNs - beginNs) / 1.0e6;
+}
@@ -0,0 +1,39 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/gl.h>
+
+// Measures GPU time with a small ring of GL_TIMESTAMP query pairs so results
+// can be read back a few frames later without stalling the pipeline.
+// Timestamps rather than GL_TIME_ELAPSED, so timers may nest: a whole frame
+// timer runs around the scene and post-processing timers of the main view.
+class GpuTimer {
+public:
+    explicit GpuTimer(GLuint numQueries = 4);
+    ~GpuTimer();
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void begin();
+    void end();
+
+    // pops the oldest finished measurement in milliseconds, optionally waiting for it
+    bool popResult(double& elapsedMs, bool wait = false);
+
+private:
+    GLuint* _queries;   // begin and end timestamp of each slot
+    GLuint _numQueries;
+    GLuint _head;       // next query to issue
+    GLuint _numPending; // queries issued but not yet read back
+    bool _running;
+    // results read back but not yet popped, a ring of _numQueries so steady frames do not allocate
+    double* _ready;
+    GLuint _readyHead;  // oldest result
+    GLuint _numReady;
+
+    double _readQuery(GLuint slot) const;
+    // drops the oldest result if nobody popped it in time
+    void _pushReady(double elapsedMs);
+};
+
+#endif // GPU_TIMER_H
@@ -0,0 +1,36 @@
+#include "HeroMovement.h"
+
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265f
+#endif
+
+glm::vec3 HeroMovement::step(glm::vec3 position, float heading, bool forward) {
+    glm::vec3 offset = glm::vec3(sin(heading), 0.0f, cos(heading)) * SPEED;
+    return forward ? position + offset : position - offset;
+}
+
+float HeroMovement::turn(float heading, bool left) {
+    float turnSpeed = glm::radians(2.0f);
+    if (left) {
+        heading += turnSpeed;
+        if (heading >= 2.0f * M_PI) heading -= 2.0f * M_PI;
+    } else {
+        heading -= turnSpeed;
+        if (heading < 0.0f) heading += 2.0f * M_PI;
+    }
+    return heading;
+}
+
+glm::vec3 HeroMovement::resolve(CollisionWorld& world, CollisionWorld::BodyId body, float worldSize,
+                                glm::vec3 currentPosition, glm::vec3 targetPosition) {
+    // Bounds Checking to keep the hero within the scene
+    targetPosition.x = glm::clamp(targetPosition.x, -worldSize, worldSize);
+    targetPosition.z = glm::clamp(targetPosition.z, -worldSize, worldSize);
+
+    // the hero may have been placed directly since the last step
+    world.setBodyPosition(body, glm::vec2(currentPosition.x, currentPosition.z));
+    glm::vec2 resolved = world.moveBody(body, glm::vec2(targetPosition.x, targetPosition.z));
+    return glm::vec3(resolved.x, targetPosition.y, resolved.y);
+}
@@ -0,0 +1,24 @@
+#ifndef HERO_MOVEMENT_H
+#define HERO_MOVEMENT_H
+
+#include <glm/glm.hpp>
+
+#include "CollisionWorld.h"
+
+// Movement the vehicle, the UFO and Lucid share: fixed steps along the
+// heading, which faces +Z at zero, and fixed turns that keep the heading in
+// [0, 2pi). A step is only a wish until resolve() has kept it on the island
+// and slid it along whatever it ran into.
+namespace HeroMovement {
+    // distance of one step
+    constexpr float SPEED = 0.2f;
+
+    glm::vec3 step(glm::vec3 position, float heading, bool forward);
+    float turn(float heading, bool left);
+
+    // clamps the target to +-worldSize, then sweeps the body from the current position to it
+    glm::vec3 resolve(CollisionWorld& world, CollisionWorld::BodyId body, float worldSize,
+                      glm::vec3 currentPosition, glm::vec3 targetPosition);
+}
+
+#endif // HERO_MOVEMENT_H
@@ -0,0 +1,205 @@
+#include "InputJournal.h"
+
+#include <cstring>
+
+static const char JOURNAL_MAGIC[4] = {'M', 'P', 'I', 'J'};
+
+InputJournal::InputJournal()
+    : _worldSeed(0),
+      _environmentDensity(0.0f),
+      _tickCount(0)
+{}
+
+void InputJournal::clear() {
+    _events.clear();
+    _tickCount = 0;
+}
+
+void InputJournal::record(const InputEvent& event) {
+    _events.push_back(event);
+    if(event.tick > _tickCount) _tickCount = event.tick;
+}
+
+bool InputJournal::save(const char* filename) const {
+    std::vector<uint8_t> bytes;
+    bytes.reserve(24 + _events.size() * 4);
+
+    bytes.insert(bytes.end(), JOURNAL_MAGIC, JOURNAL_MAGIC + 4);
+    bytes.push_back(VERSION & 0xFF);
+    bytes.push_back(VERSION >> 8);
+    bytes.push_back(0);
+    bytes.push_back(0);
+    _writeU32(bytes, _worldSeed);
+    uint32_t densityBits;
+    memcpy(&densityBits, &_environmentDensity, sizeof(densityBits));
+    _writeU32(bytes, densityBits);
+    _writeU32(bytes, _tickCount);
+    _writeU32(bytes, static_cast<uint32_t>(_events.size()));
+
+    uint32_t previousTick = 0;
+    for(const InputEvent& event : _events) {
+        _writeVarint(bytes, event.tick - previousTick);
+        previousTick = event.tick;
+
+        bytes.push_back(static_cast<uint8_t>(event.type) | static_cast<uint8_t>((event.action & 0x3) << 2));
+        switch(event.type) {
+            case InputEventType::KEY: {
+                // zigzag so GLFW_KEY_UNKNOWN (-1) stays a single byte
+                uint32_t zigzag = (static_cast<uint32_t>(event.code) << 1) ^ static_cast<uint32_t>(event.code >> 31);
+                _writeVarint(bytes, zigzag);
+                bytes.push_back(static_cast<uint8_t>(event.mods));
+                break;
+            }
+            case InputEventType::MOUSE_BUTTON:
+                bytes.push_back(static_cast<uint8_t>(event.code));
+                bytes.push_back(static_cast<uint8_t>(event.mods));
+                break;
+            case InputEventType::CURSOR_POSITION: {
+                uint32_t xBits, yBits;
+                memcpy(&xBits, &event.x, sizeof(xBits));
+                memcpy(&yBits, &event.y, sizeof(yBits));
+                _writeU32(bytes, xBits);
+                _writeU32(bytes, yBits);
+                break;
+            }
+        }
+    }
+
+    FILE* fp = fopen(filename, "wb");
+    if(!fp) {
+        fprintf( stderr, "[ERROR]: Could not open input journal \"%s\" for writing\n", filename );
+        return false;
+    }
+    size_t written = fwrite(bytes.data(), 1, bytes.size(), fp);
+    fclose(fp);
+
+    if(written != bytes.size()) {
+        fprintf( stderr, "[ERROR]: Could not write input journal \"%s\"\n", filename );
+        return false;
+    }
+    fprintf( stdout, "[INFO]: wrote %zu input events over %u ticks to %s (%zu bytes)\n",
+             _events.size(), _tickCount, filename, bytes.size() );
+    return true;
+}
+
+bool InputJournal::load(const char* filename) {
+    FILE* fp = fopen(filename, "rb");
+    if(!fp) {
+        fprintf( stderr, "[ERROR]: Could not open input journal \"%s\"\n", filename );
+        return false;
+    }
+    std::vector<uint8_t> bytes;
+    uint8_t buffer[4096];
+    size_t numRead;
+    while((numRead = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        bytes.insert(bytes.end(), buffer, buffer + numRead);
+    }
+    fclose(fp);
+
+    if(bytes.size() < 24 || memcmp(bytes.data(), JOURNAL_MAGIC, 4) != 0) {
+        fprintf( stderr, "[ERROR]: \"%s\" is not an input journal\n", filename );
+        return false;
+    }
+    uint16_t version = bytes[4] | (bytes[5] << 8);
+    if(version != VERSION) {
+        fprintf( stderr, "[ERROR]: input journal \"%s\" has unsupported version %u\n", filename, version );
+        return false;
+    }
+
+    size_t offset = 8;
+    uint32_t densityBits, eventCount;
+    _readU32(bytes, offset, _worldSeed);
+    _readU32(bytes, offset, densityBits);
+    memcpy(&_environmentDensity, &densityBits, sizeof(densityBits));
+    _readU32(bytes, offset, _tickCount);
+    _readU32(bytes, offset, eventCount);
+
+    _events.clear();
+    _events.reserve(eventCount);
+    uint32_t tick = 0;
+    for(uint32_t i = 0; i < eventCount; ++i) {
+        InputEvent event = {};
+        uint32_t delta;
+        if(!_readVarint(bytes, offset, delta) || offset >= bytes.size()) break;
+        tick += delta;
+        event.tick = tick;
+
+        uint8_t header = bytes[offset++];
+        event.type = static_cast<InputEventType>(header & 0x3);
+        event.action = (header >> 2) & 0x3;
+
+        bool ok = true;
+        switch(event.type) {
+            case InputEventType::KEY: {
+                uint32_t zigzag;
+                ok = _readVarint(bytes, offset, zigzag) && offset < bytes.size();
+                if(ok) {
+                    event.code = static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+                    event.mods = bytes[offset++];
+                }
+                break;
+            }
+            case InputEventType::MOUSE_BUTTON:
+                ok = offset + 2 <= bytes.size();
+                if(ok) {
+                    event.code = bytes[offset++];
+                    event.mods = bytes[offset++];
+                }
+                break;
+            case InputEventType::CURSOR_POSITION: {
+                uint32_t xBits, yBits;
+                ok = _readU32(bytes, offset, xBits) && _readU32(bytes, offset, yBits);
+                if(ok) {
+                    memcpy(&event.x, &xBits, sizeof(xBits));
+                    memcpy(&event.y, &yBits, sizeof(yBits));
+                }
+                break;
+            }
+            default:
+                ok = false;
+                break;
+        }
+        if(!ok) break;
+        _events.push_back(event);
+    }
+
+    if(_events.size() != eventCount) {
+        fprintf( stderr, "[ERROR]: input journal \"%s\" is truncated (%zu of %u events)\n", filename, _events.size(), eventCount );
+        return false;
+    }
+    fprintf( stdout, "[INFO]: read %zu input events over %u ticks from %s\n", _events.size(), _tickCount, filename );
+    return true;
+}
+
+void InputJournal::_writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while(value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool InputJournal::_readVarint(const std::vector<uint8_t>& in, size_t& offset, uint32_t& value) {
+    value = 0;
+    for(int shift = 0; shift < 35 && offset < in.size(); shift += 7) {
+        uint8_t byte = in[offset++];
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+void InputJournal::_writeU32(std::vector<uint8_t>& out, uint32_t value) {
+    for(int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+bool InputJournal::_readU32(const std::vector<uint8_t>& in, size_t& offset, uint32_t& value) {
+    if(offset + 4 > in.size()) return false;
+    value = 0;
+    for(int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(in[offset++]) << (8 * i);
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef INPUT_JOURNAL_H
+#define INPUT_JOURNAL_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+enum class InputEventType : uint8_t {
+    KEY = 0,
+    MOUSE_BUTTON = 1,
+    CURSOR_POSITION = 2
+};
+
+// One GLFW input event stamped with the simulation tick it was applied before
+struct InputEvent {
+    uint32_t tick;
+    InputEventType type;
+    int32_t code;   // key or mouse button
+    int32_t action;
+    int32_t mods;
+    float x, y;     // cursor position
+};
+
+// Records input events against the simulation tick and stores them in a
+// compact binary file so a session can be replayed deterministically.
+//
+// File layout (little endian):
+//   header  "MPIJ" | u16 version | u16 reserved | u32 world seed | f32 density
+//           | u32 tick count | u32 event count
+//   events  varint tick delta | u8 type (low 2 bits) + action (next 2 bits)
+//           | payload:  key    -> zigzag varint key, u8 mods
+//                       button -> u8 button, u8 mods
+//                       cursor -> f32 x, f32 y
+class InputJournal {
+public:
+    InputJournal();
+
+    void clear();
+    void setWorld(uint32_t seed, float density) { _worldSeed = seed; _environmentDensity = density; }
+    void setTickCount(uint32_t tickCount) { _tickCount = tickCount; }
+
+    void record(const InputEvent& event);
+
+    bool save(const char* filename) const;
+    bool load(const char* filename);
+
+    uint32_t getWorldSeed() const { return _worldSeed; }
+    float getEnvironmentDensity() const { return _environmentDensity; }
+    uint32_t getTickCount() const { return _tickCount; }
+    const std::vector<InputEvent>& getEvents() const { return _events; }
+
+    static constexpr uint16_t VERSION = 1;
+
+private:
+    std::vector<InputEvent> _events;
+    uint32_t _worldSeed;
+    float _environmentDensity;
+    uint32_t _tickCount;
+
+    static void _writeVarint(std::vector<uint8_t>& out, uint32_t value);
+    static bool _readVarint(const std::vector<uint8_t>& in, size_t& offset, uint32_t& value);
+    static void _writeU32(std::vector<uint8_t>& out, uint32_t value);
+    static bool _readU32(const std::vector<uint8_t>& in, size_t& offset, uint32_t& value);
+};
+
+#endif // INPUT_JOURNAL_H
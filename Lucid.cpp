@@ -1,21 +1,23 @@
 #include "Lucid.h"
 
+#include "HeroMovement.h"
+
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include <CSCI441/OpenGLUtils.hpp>
 
-Lucid::Lucid(GLuint shaderProgramHandle, GLint mvpMatrixLocation, GLint normalMatrixLocation,
+Lucid::Lucid(GLuint shaderProgramHandle, TransformRing* pTransformRing,
              GLint materialAmbientLocation, GLint materialDiffuseLocation,
              GLint materialSpecularLocation, GLint materialShininessLocation)
     : _shaderProgramHandle(shaderProgramHandle),
-      _mvpMatrixLocation(mvpMatrixLocation),
-      _normalMatrixLocation(normalMatrixLocation),
+      _pTransformRing(pTransformRing),
       _materialAmbientLocation(materialAmbientLocation),
       _materialDiffuseLocation(materialDiffuseLocation),
       _materialSpecularLocation(materialSpecularLocation),
       _materialShininessLocation(materialShininessLocation),
       _position(10.0f, 0.0f, 10.0f),
+      _boundingRadius(1.0f), // roughly the wing span
       _heading(0.0f),
       _wingAngle(0.0f)
 {}
@@ -40,31 +42,21 @@ void Lucid::move() {
 }
 
 void Lucid::moveForward() {
-    float speed = 0.2f;
-    // Updated movement vector to align with +Z-axis front
-    _position += glm::vec3(sin(_heading), 0.0f, cos(_heading)) * speed;
+    _position = HeroMovement::step(_position, _heading, true);
     move();
 }
 
 void Lucid::moveBackward() {
-    float speed = 0.2f;
-    // Updated movement vector to align with +Z-axis front
-    _position -= glm::vec3(sin(_heading), 0.0f, cos(_heading)) * speed;
+    _position = HeroMovement::step(_position, _heading, false);
     move();
 }
 
 void Lucid::turnLeft() {
-    float turnSpeed = glm::radians(2.0f);
-    _heading += turnSpeed;
-
-    if (_heading >= 2.0f * M_PI) _heading -= 2.0f * M_PI;
+    _heading = HeroMovement::turn(_heading, true);
 }
 
 void Lucid::turnRight() {
-    float turnSpeed = glm::radians(2.0f);
-    _heading -= turnSpeed;
-
-    if (_heading < 0.0f) _heading += 2.0f * M_PI;
+    _heading = HeroMovement::turn(_heading, false);
 }
 
 void Lucid::_drawUpperWing(bool isLeftWing, glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx ) const {
@@ -79,11 +71,8 @@ void Lucid::_drawUpperWing(bool isLeftWing, glm::mat4 modelMtx, glm::mat4 viewMt
 
     modelMtx = glm::rotate( modelMtx, (1.0f) * _wingAngle, CSCI441::Z_AXIS );
 
-    glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-    glm::mat3 normalMtx = glm::transpose(glm::inverse(glm::mat3(modelMtx)));
-
-    glUniformMatrix4fv(_mvpMatrixLocation, 1, GL_FALSE, glm::value_ptr(mvpMtx));
-    glUniformMatrix3fv(_normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMtx));
+    // Send matrices to shader
+    _pTransformRing->bindTransforms(modelMtx, projMtx * viewMtx);
 
     glm::vec3 ambient(0.1f, 0.1f, 0.1f);
     glm::vec3 diffuse(_colorWing);
@@ -113,11 +102,8 @@ void Lucid::_drawLowerWing(bool isLeftWing, glm::mat4 modelMtx, glm::mat4 viewMt
 
     modelMtx = glm::rotate( modelMtx, (-1.0f) * _wingAngle, CSCI441::Z_AXIS );
 
-    glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-    glm::mat3 normalMtx = glm::transpose(glm::inverse(glm::mat3(modelMtx)));
-
-    glUniformMatrix4fv(_mvpMatrixLocation, 1, GL_FALSE, glm::value_ptr(mvpMtx));
-    glUniformMatrix3fv(_normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMtx));
+    // Send matrices to shader
+    _pTransformRing->bindTransforms(modelMtx, projMtx * viewMtx);
 
     glm::vec3 ambient(0.1f, 0.1f, 0.1f);
     glm::vec3 diffuse(_colorWing);
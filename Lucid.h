@@ -6,9 +6,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "TransformRing.h"
+
 class Lucid {
 public:
-    Lucid(GLuint shaderProgramHandle, GLint mvpMatrixLocation, GLint normalMatrixLocation,
+    Lucid(GLuint shaderProgramHandle, TransformRing* pTransformRing,
           GLint materialAmbientLocation, GLint materialDiffuseLocation,
           GLint materialSpecularLocation, GLint materialShininessLocation);
 
@@ -28,8 +30,7 @@ public:
 
 private:
     GLuint _shaderProgramHandle;
-    GLint _mvpMatrixLocation;
-    GLint _normalMatrixLocation;
+    TransformRing* _pTransformRing;
     GLint _materialAmbientLocation;
     GLint _materialDiffuseLocation;
     GLint _materialSpecularLocation;
@@ -1,29 +1,72 @@
 #include "MPEngine.h"
 #include <stb_image.h>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <thread>
 
 #ifndef M_PI
 #define M_PI 3.14159265f
 #endif
 
-float getRand() {
-    return static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-}
+// Scenery materials, shared by the main view and the inset views
+const MPEngine::Material MPEngine::TRUNK_MATERIAL = {
+    glm::vec3(0.2f, 0.2f, 0.2f), glm::vec3(99 / 255.f, 39 / 255.f, 9 / 255.f), glm::vec3(0.3f, 0.3f, 0.3f), 32.0f
+};
+const MPEngine::Material MPEngine::LEAVES_MATERIAL = {
+    glm::vec3(0.2f, 0.2f, 0.2f), glm::vec3(46 / 255.f, 143 / 255.f, 41 / 255.f), glm::vec3(0.3f, 0.3f, 0.3f), 32.0f
+};
+const MPEngine::Material MPEngine::POST_MATERIAL = {
+    glm::vec3(0.2f, 0.2f, 0.2f), glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(0.3f, 0.3f, 0.3f), 32.0f
+};
+// Bounds of the scenery relative to its base, see the draw calls in _renderOpaquePass
+static const glm::vec3 TREE_BOUNDS_MIN(-3.0f, 0.0f, -3.0f), TREE_BOUNDS_MAX(3.0f, 13.0f, 3.0f);
+static const glm::vec3 LAMP_BOUNDS_MIN(-0.5f, 0.0f, -0.5f), LAMP_BOUNDS_MAX(0.5f, 7.5f, 0.5f);
+// Trees are queried as trunk and leaves, a single box would catch rays passing under the leaves
+static const glm::vec3 TRUNK_BOUNDS_MIN(-1.0f, 0.0f, -1.0f), TRUNK_BOUNDS_MAX(1.0f, 5.0f, 1.0f);
+static const glm::vec3 LEAVES_BOUNDS_MIN(-3.0f, 5.0f, -3.0f), LEAVES_BOUNDS_MAX(3.0f, 13.0f, 3.0f);
+
+// the bulbs glow blue like their point lights
+const MPEngine::Material MPEngine::BULB_MATERIAL = {
+    glm::vec3(0.2f, 0.2f, 0.5f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.5f, 0.5f, 0.5f), 64.0f
+};
+
+const glm::vec3 MPEngine::BULB_EMISSION(0.0f, 0.0f, 1.5f);
+
+// Lucid::_drawUpperWing's ambient, specular and shininess
+const MPEngine::Material MPEngine::WING_MATERIAL = {
+    glm::vec3(0.1f, 0.1f, 0.1f), glm::vec3(1.0f, 0.8f, 1.0f), glm::vec3(0.3f, 0.3f, 0.3f), 32.0f
+};
 
 MPEngine::MPEngine()
     : CSCI441::OpenGLEngine(4, 1,
-                                 1280, 720, // Increased window size for better view
+                                 QualitySettings::DEFAULT_WINDOW_WIDTH, QualitySettings::DEFAULT_WINDOW_HEIGHT,
                                  "MP - Over Hill and Under Hill"),
-        _pFreeCam(nullptr),
+        _pRenderStateCache(new RenderStateCache()),
+        _pTransformRing(new TransformRing()),
+        _pFrameArena(new FrameArena()),
+        _pOcclusionCuller(new OcclusionCuller()),
+        _pCollisionWorld(new CollisionWorld(WORLD_SIZE)),
+        _pSceneQuery(new SceneQuery()),
+        _pFlowField(new FlowField(WORLD_SIZE)),
+        _pAgentVehicle(nullptr),
+        _pAgentUFO(nullptr),
+        _pFlock(new Flock(std::max(1u, std::thread::hardware_concurrency()))),
         _pArcballCam(nullptr),
         _pFPCam(nullptr),
+        _pFreeCam(nullptr),
         _pVehicle(nullptr),
         _pUFO(nullptr),
+        _pButterfly(nullptr),
         _animationTime(0.0f),
-        _groundVAO(0),
+        _environmentDensity(0.02f),
+        _worldSeed(static_cast<unsigned int>(time(0))),
         _numGroundPoints(0)
 {
     for(auto& key : _keys) key = GL_FALSE;
 
+    _applyQualitySettings();
+
     _mousePosition = glm::vec2(MOUSE_UNINITIALIZED, MOUSE_UNINITIALIZED );
     _leftMouseButtonState = GLFW_RELEASE;
 }
@@ -32,16 +75,43 @@ MPEngine::~MPEngine() {
     delete _lightingShaderProgram;
     delete _textureShaderProgram;
     delete _skyboxShaderProgram;
+    delete _multiviewShaderProgram;
+    delete _swarmShaderProgram;
+    delete _overlayShaderProgram;
+    delete _bloomDownsampleShaderProgram;
+    delete _bloomUpsampleShaderProgram;
+    delete _toneMapShaderProgram;
     delete _pFreeCam;
     delete _pArcballCam;
     delete _pFPCam;
     delete _pVehicle;
     delete _pUFO;
+    delete _pButterfly;
+    delete _pAgentVehicle;
+    delete _pAgentUFO;
+    delete _pOcclusionCuller;
+    delete _pRenderStateCache;
+    delete _pTransformRing;
+    delete _pCollisionWorld;
+    delete _pSceneQuery;
+    delete _pFlowField;
+    delete _pFlock;
+    delete _pFrameArena;
 }
 
 void MPEngine::mSetupTextures() {
+    // Both textures can be reloaded from disk, so the registry may evict them
+    // when over budget. Reloading binds on whatever unit is active, the state
+    // cache has to forget its bindings afterwards.
+    size_t textureBytes = 0;
     glActiveTexture(GL_TEXTURE0);
-    _texHandles[TEXTURE_ID::RUG] = _loadAndRegisterTexture("images/groundImage.png");
+    GLuint groundTexture = _loadAndRegisterTexture("images/groundImage.png", textureBytes);
+    _textures[TEXTURE_ID::RUG] = _gpuResources.adoptStreamable(GpuResourceType::TEXTURE, groundTexture, textureBytes, "ground texture",
+        [this](size_t& bytes) {
+            GLuint texture = _loadAndRegisterTexture("images/groundImage.png", bytes);
+            _pRenderStateCache->invalidate();
+            return texture;
+        });
 
     // Load and assign the skybox cubemap to texture unit 1
     glActiveTexture(GL_TEXTURE1);
@@ -53,11 +123,17 @@ void MPEngine::mSetupTextures() {
         "images/skyImage.png", // +Z
         "images/skyImage.png"  // -Z
     };
-    _texHandles[TEXTURE_ID::SKY] = _loadAndRegisterCubemap(facesCubemap);
+    GLuint skyTexture = _loadAndRegisterCubemap(facesCubemap, textureBytes);
+    _textures[TEXTURE_ID::SKY] = _gpuResources.adoptStreamable(GpuResourceType::TEXTURE, skyTexture, textureBytes, "sky cubemap",
+        [this, facesCubemap](size_t& bytes) {
+            GLuint texture = _loadAndRegisterCubemap(facesCubemap, bytes);
+            _pRenderStateCache->invalidate();
+            return texture;
+        });
 
 }
 
-GLuint MPEngine::_loadAndRegisterTexture(const char* FILENAME) {
+GLuint MPEngine::_loadAndRegisterTexture(const char* FILENAME, size_t& bytes) {
     // our handle to the GPU
     GLuint textureHandle = 0;
 
@@ -88,6 +164,8 @@ GLuint MPEngine::_loadAndRegisterTexture(const char* FILENAME) {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         // TODO #07 - transfer image data to the GPU
         glTexImage2D(GL_TEXTURE_2D, 0, STORAGE_TYPE, imageWidth, imageHeight, 0, STORAGE_TYPE, GL_UNSIGNED_BYTE, data);
+        // drivers pad RGB texels to four bytes
+        bytes = static_cast<size_t>(imageWidth) * imageHeight * 4;
 
         fprintf( stdout, "[INFO]: %s texture map read in with handle %d\n", FILENAME, textureHandle);
 
@@ -101,24 +179,36 @@ GLuint MPEngine::_loadAndRegisterTexture(const char* FILENAME) {
     return textureHandle;
 }
 
-GLuint MPEngine::_loadAndRegisterCubemap(const std::vector<const char*>& facesCubemap) {
+GLuint MPEngine::_loadAndRegisterCubemap(const std::vector<const char*>& facesCubemap, size_t& bytes) {
+    // Load every face first, the sky's ambient light is projected from all six
+    SphericalHarmonics::CubemapFace faces[SphericalHarmonics::NUM_FACES];
+    unsigned char* faceData[SphericalHarmonics::NUM_FACES] = {nullptr};
+    bool loaded = true;
+    for (unsigned int i = 0; i < 6 && loaded; i++) {
+        // three channels, the storage is RGB8
+        faceData[i] = stbi_load(facesCubemap[i], &faces[i].width, &faces[i].height, &faces[i].channels, 3);
+        faces[i].pixels = faceData[i];
+        faces[i].channels = 3;
+        if (!faceData[i]) {
+            std::cerr << "[ERROR]: Failed to load cubemap face: " << facesCubemap[i] << std::endl;
+            loaded = false;
+        } else if (faces[i].width != faces[0].width || faces[i].height != faces[0].height) {
+            std::cerr << "[ERROR]: Cubemap face " << facesCubemap[i] << " is not the size of the first face" << std::endl;
+            loaded = false;
+        }
+    }
+    if (!loaded) {
+        for (unsigned char* data : faceData) if (data) stbi_image_free(data);
+        return 0;
+    }
+    int width = faces[0].width, height = faces[0].height;
+
     GLuint cubemapTexture;
     glGenTextures(1, &cubemapTexture);
     glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
 
-    // Initialize variables to retrieve width, height, and channel info
-    int width = 512, height = 512, nrChannels = 3;
-
-    // Load the first face to get dimensions (assuming all faces are the same size)
-    unsigned char* data = stbi_load(facesCubemap[0], &width, &height, &nrChannels, 0);
-    if (data) {
-        // Allocate immutable storage
-        glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_RGB8, width, height);
-        stbi_image_free(data); // Free this initial data after getting dimensions
-    } else {
-        std::cerr << "[ERROR]: Failed to load initial cubemap face for dimensions." << std::endl;
-        return 0;
-    }
+    // Allocate immutable storage
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_RGB8, width, height);
 
     // Set texture parameters
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -129,43 +219,380 @@ GLuint MPEngine::_loadAndRegisterCubemap(const std::vector<const char*>& facesCu
 
     // Load data for each face with glTexSubImage2D
     for (unsigned int i = 0; i < 6; i++) {
-        data = stbi_load(facesCubemap[i], &width, &height, &nrChannels, 0);
-        if (data) {
-            glTexSubImage2D(
-                GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                0, 0, 0, width, height,
-                GL_RGB, GL_UNSIGNED_BYTE,
-                data
-            );
-            stbi_image_free(data);
+        glTexSubImage2D(
+            GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+            0, 0, 0, width, height,
+            GL_RGB, GL_UNSIGNED_BYTE,
+            faceData[i]
+        );
+    }
+
+    // streaming the cubemap back in brings the same faces, their light is already known
+    if (!_isSkyAmbientProjected) {
+        _skyAmbient = SphericalHarmonics::computeAmbient(faces, SKY_AMBIENT_CACHE);
+        _isSkyAmbientProjected = true;
+    }
+    for (unsigned char* data : faceData) stbi_image_free(data);
+
+    // RGB8 storage padded to four bytes per texel, six faces
+    bytes = static_cast<size_t>(width) * height * 4 * 6;
+    return cubemapTexture;
+}
+
+
+void MPEngine::_rebuildCollisionWorld() {
+    _pCollisionWorld->clear();
+
+    // Static obstacles, radii match the trunk, post and building geometry
+    for (const TreeData& tree : _trees) {
+        _pCollisionWorld->addStaticCircle(glm::vec2(tree.position.x, tree.position.z), TREE_TRUNK_RADIUS);
+    }
+    for (const LampData& lamp : _lamps) {
+        _pCollisionWorld->addStaticCircle(glm::vec2(lamp.position.x, lamp.position.z), LAMP_POST_RADIUS);
+    }
+    for (const BuildingData& building : _buildings) {
+        _pCollisionWorld->addStaticCircle(glm::vec2(building.position.x, building.position.z), building.boundingRadius);
+    }
+
+    // Heroes are dynamic bodies so they collide with each other as well
+    if (_pVehicle == nullptr || _pUFO == nullptr || _pButterfly == nullptr) return;
+    _heroBodies[static_cast<int>(HeroType::VEHICLE)] = _pCollisionWorld->addBody(
+            glm::vec2(_pVehicle->getPosition().x, _pVehicle->getPosition().z), _pVehicle->getBoundingRadius());
+    _heroBodies[static_cast<int>(HeroType::UFO)] = _pCollisionWorld->addBody(
+            glm::vec2(_pUFO->getPosition().x, _pUFO->getPosition().z), _pUFO->getBoundingRadius());
+    _heroBodies[static_cast<int>(HeroType::LUCID)] = _pCollisionWorld->addBody(
+            glm::vec2(_pButterfly->getPosition().x, _pButterfly->getPosition().z), _pButterfly->getBoundingRadius());
+}
+
+glm::vec3 MPEngine::_resolveHeroMovement(HeroType hero, glm::vec3 currentPosition, glm::vec3 targetPosition) {
+    return HeroMovement::resolve(*_pCollisionWorld, _heroBodies[static_cast<int>(hero)], WORLD_SIZE, currentPosition, targetPosition);
+}
+
+void MPEngine::_rebuildSceneQuery() {
+    _pSceneQuery->clear();
+
+    for (GLuint i = 0; i < _trees.size(); ++i) {
+        glm::vec3 position = _trees[i].position;
+        _pSceneQuery->addStaticBox(SceneQuery::ObjectType::TREE, i, position + TRUNK_BOUNDS_MIN, position + TRUNK_BOUNDS_MAX);
+        _pSceneQuery->addStaticBox(SceneQuery::ObjectType::TREE, i, position + LEAVES_BOUNDS_MIN, position + LEAVES_BOUNDS_MAX);
+    }
+    for (GLuint i = 0; i < _lamps.size(); ++i) {
+        glm::vec3 position = _lamps[i].position;
+        _pSceneQuery->addStaticBox(SceneQuery::ObjectType::LAMP, i, position + LAMP_BOUNDS_MIN, position + LAMP_BOUNDS_MAX);
+    }
+    for (GLuint i = 0; i < _buildings.size(); ++i) {
+        glm::vec3 extent(_buildings[i].boundingRadius);
+        _pSceneQuery->addStaticBox(SceneQuery::ObjectType::BUILDING, i, _buildings[i].position - extent, _buildings[i].position + extent);
+    }
+    _pSceneQuery->buildStatic();
+
+    // the heroes move every tick, their boxes are refit in _updateSceneQuery()
+    if (_pVehicle == nullptr || _pUFO == nullptr || _pButterfly == nullptr) return;
+    for (int hero = 0; hero < 3; ++hero) {
+        _heroQueryBoxes[hero] = _pSceneQuery->addDynamicBox(SceneQuery::ObjectType::HERO, hero, glm::vec3(0.0f), glm::vec3(0.0f));
+    }
+    _updateSceneQuery();
+}
+
+void MPEngine::_updateSceneQuery() {
+    if (_pVehicle == nullptr || _pUFO == nullptr || _pButterfly == nullptr) return;
+
+    const glm::vec3 positions[3] = {_pVehicle->getPosition(), _pUFO->getPosition(), _pButterfly->getPosition()};
+    const GLfloat radii[3] = {_pVehicle->getBoundingRadius(), _pUFO->getBoundingRadius(), _pButterfly->getBoundingRadius()};
+    for (int hero = 0; hero < 3; ++hero) {
+        _pSceneQuery->moveDynamicBox(_heroQueryBoxes[hero], positions[hero] - glm::vec3(radii[hero]), positions[hero] + glm::vec3(radii[hero]));
+    }
+    _pSceneQuery->refit();
+}
+
+void MPEngine::_updateCameraCollision() {
+    // a camera out of use starts over without easing when it comes back
+    if (currCamera == CameraType::ARCBALL) {
+        float distance = _arcballCollision.update(*_pSceneQuery, _pArcballCam->getTarget(), _pArcballCam->getDesiredPosition());
+        _pArcballCam->setDistanceLimit(distance);
+    } else {
+        _arcballCollision.reset();
+    }
+
+    if (currCamera == CameraType::FIRSTPERSON) {
+        float height = _firstPersonCollision.update(*_pSceneQuery, _pFPCam->getHeroPosition(), _pFPCam->getDesiredPosition());
+        _pFPCam->setHeightLimit(height);
+    } else {
+        _firstPersonCollision.reset();
+    }
+}
+
+void MPEngine::_pickObject(glm::vec2 cursorPosition) {
+    GLint windowWidth, windowHeight, framebufferWidth, framebufferHeight;
+    glfwGetWindowSize(mpWindow, &windowWidth, &windowHeight);
+    glfwGetFramebufferSize(mpWindow, &framebufferWidth, &framebufferHeight);
+    if (windowWidth <= 0 || windowHeight <= 0 || framebufferWidth <= 0 || framebufferHeight <= 0) return;
+
+    // unproject the cursor onto the near and far planes of the main view
+    glm::mat4 viewMtx, projMtx;
+    _getCameraMatrices(framebufferWidth, framebufferHeight, viewMtx, projMtx);
+    glm::mat4 inverseViewProjMtx = glm::inverse(projMtx * viewMtx);
+    glm::vec2 ndc(2.0f * cursorPosition.x / windowWidth - 1.0f, 1.0f - 2.0f * cursorPosition.y / windowHeight);
+    glm::vec4 nearPoint = inverseViewProjMtx * glm::vec4(ndc.x, ndc.y, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverseViewProjMtx * glm::vec4(ndc.x, ndc.y, 1.0f, 1.0f);
+    glm::vec3 start = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 end = glm::vec3(farPoint) / farPoint.w;
+
+    SceneQuery::Hit hit;
+    if (!_pSceneQuery->segmentCast(start, end, hit)) {
+        fprintf( stdout, "[INFO]: picked nothing\n" );
+        return;
+    }
+
+    const char* HERO_NAMES[3] = {"vehicle", "ufo", "butterfly"};
+    glm::vec3 point = start + glm::normalize(end - start) * hit.distance;
+    switch (hit.type) {
+        case SceneQuery::ObjectType::TREE:
+            fprintf( stdout, "[INFO]: picked tree %u", hit.index );
+            break;
+        case SceneQuery::ObjectType::LAMP:
+            fprintf( stdout, "[INFO]: picked lamp %u", hit.index );
+            break;
+        case SceneQuery::ObjectType::BUILDING:
+            fprintf( stdout, "[INFO]: picked building %u", hit.index );
+            break;
+        case SceneQuery::ObjectType::HERO:
+            fprintf( stdout, "[INFO]: picked the %s", HERO_NAMES[hit.index] );
+            break;
+    }
+    fprintf( stdout, " at (%.2f, %.2f, %.2f), %.2f units away\n", point.x, point.y, point.z, hit.distance );
+}
+
+void MPEngine::_rebuildNavigation() {
+    _pFlowField->clear();
+
+    // the same obstacles the heroes collide with, grown so agents keep their distance
+    for (const TreeData& tree : _trees) {
+        _pFlowField->addStaticObstacle(glm::vec2(tree.position.x, tree.position.z), TREE_TRUNK_RADIUS + AGENT_CLEARANCE);
+    }
+    for (const LampData& lamp : _lamps) {
+        _pFlowField->addStaticObstacle(glm::vec2(lamp.position.x, lamp.position.z), LAMP_POST_RADIUS + AGENT_CLEARANCE);
+    }
+    for (const BuildingData& building : _buildings) {
+        _pFlowField->addStaticObstacle(glm::vec2(building.position.x, building.position.z), building.boundingRadius + AGENT_CLEARANCE);
+    }
+
+    // the four corners of the island and its center
+    const GLfloat GOAL_OFFSET = WORLD_SIZE * 0.7f;
+    _pFlowField->addGoal(glm::vec2(-GOAL_OFFSET, -GOAL_OFFSET));
+    _pFlowField->addGoal(glm::vec2( GOAL_OFFSET, -GOAL_OFFSET));
+    _pFlowField->addGoal(glm::vec2(-GOAL_OFFSET,  GOAL_OFFSET));
+    _pFlowField->addGoal(glm::vec2( GOAL_OFFSET,  GOAL_OFFSET));
+    _pFlowField->addGoal(glm::vec2(0.0f, 0.0f));
+    _pFlowField->build();
+    _heroObstacleStamped = false;
+
+    fprintf( stdout, "[INFO]: flow fields for %zu goals over %dx%d cells integrated in %.2f ms\n",
+             _pFlowField->getNumGoals(), _pFlowField->getWidth(), _pFlowField->getWidth(), _pFlowField->getStats().lastBuildMs );
+
+    // spawn on reachable cells; seeded from the world so replays see the same agents
+    _agentRandom.seed(_worldSeed);
+    std::uniform_real_distribution<float> spawnDistribution(-WORLD_SIZE * 0.9f, WORLD_SIZE * 0.9f);
+    std::uniform_int_distribution<int> goalDistribution(0, static_cast<int>(_pFlowField->getNumGoals()) - 1);
+    _agents.clear();
+    _agents.reserve(_agentCount);
+    const GLuint MAX_SPAWN_ATTEMPTS = 100;
+    for (GLuint i = 0; i < _agentCount; ++i) {
+        Agent agent;
+        agent.type = (i % 2 == 0 ? HeroType::VEHICLE : HeroType::UFO);
+        agent.goal = goalDistribution(_agentRandom);
+        agent.heading = 0.0f;
+        for (GLuint attempt = 0; attempt < MAX_SPAWN_ATTEMPTS; ++attempt) {
+            agent.position = glm::vec3(spawnDistribution(_agentRandom), 0.0f, spawnDistribution(_agentRandom));
+            if (_pFlowField->getIntegratedCost(agent.goal, glm::vec2(agent.position.x, agent.position.z)) < INFINITY) break;
+        }
+        _agents.push_back(agent);
+    }
+}
+
+void MPEngine::_updateAgents() {
+    if (_pVehicle == nullptr || _pUFO == nullptr || _pButterfly == nullptr) return;
+
+    // the player's hero is a moving obstacle, only the cells it left and entered are repaired
+    glm::vec3 heroPosition;
+    float heroHeading;
+    _getHeroPlacement(currHero, heroPosition, heroHeading);
+    glm::vec2 heroObstacle(heroPosition.x, heroPosition.z);
+    if (!_heroObstacleStamped || glm::length(heroObstacle - _heroObstaclePosition) >= 1.0f) {
+        if (_heroObstacleStamped) {
+            _pFlowField->clearCircle(_heroObstaclePosition, HERO_AVOIDANCE_RADIUS);
+        }
+        _pFlowField->stampCircle(heroObstacle, HERO_AVOIDANCE_RADIUS, HERO_AVOIDANCE_COST);
+        _pFlowField->update();
+        _heroObstaclePosition = heroObstacle;
+        _heroObstacleStamped = true;
+    }
+
+    std::uniform_int_distribution<int> goalDistribution(0, static_cast<int>(_pFlowField->getNumGoals()) - 1);
+    for (Agent& agent : _agents) {
+        glm::vec2 position(agent.position.x, agent.position.z);
+        glm::vec2 direction = _pFlowField->getDirection(agent.goal, position);
+
+        // arrived, or the destination cannot be reached from here: head somewhere else
+        if (direction == glm::vec2(0.0f) || _pFlowField->getIntegratedCost(agent.goal, position) < AGENT_ARRIVAL_COST) {
+            agent.goal = goalDistribution(_agentRandom);
+            continue;
+        }
+
+        position += direction * AGENT_SPEED;
+        agent.position = glm::vec3(position.x, agent.position.y, position.y);
+
+        // turn toward the direction of travel, headings follow the heroes' +Z forward
+        float turn = std::remainder(atan2f(direction.x, direction.y) - agent.heading, 2.0f * static_cast<float>(M_PI));
+        agent.heading += glm::clamp(turn, -AGENT_TURN_RATE, AGENT_TURN_RATE);
+    }
+}
+
+void MPEngine::_drawAgents(glm::mat4 viewMtx, glm::mat4 projMtx) const {
+    for (const Agent& agent : _agents) {
+        if (agent.type == HeroType::VEHICLE) {
+            _pAgentVehicle->setPosition(agent.position);
+            _pAgentVehicle->setHeading(agent.heading);
+            _pAgentVehicle->drawVehicle(viewMtx, projMtx);
         } else {
-            std::cerr << "[ERROR]: Failed to load cubemap face: " << facesCubemap[i] << std::endl;
-            return 0;
+            _pAgentUFO->setPosition(agent.position);
+            _pAgentUFO->setHeading(agent.heading);
+            _pAgentUFO->drawUFO(viewMtx, projMtx);
         }
     }
+}
 
-    return cubemapTexture;
+void MPEngine::_rebuildSwarm() {
+    Flock::Parameters parameters;
+    parameters.boundsHalfSize = WORLD_SIZE * 0.9f;
+    parameters.minHeight = 0.5f;
+    parameters.maxHeight = 5.0f;
+    _pFlock->setParameters(parameters);
+
+    // trunks and posts as the heroes collide with them
+    _pFlock->clearObstacles();
+    for (const TreeData& tree : _trees) {
+        _pFlock->addObstacle(glm::vec2(tree.position.x, tree.position.z), TREE_TRUNK_RADIUS);
+    }
+    for (const LampData& lamp : _lamps) {
+        _pFlock->addObstacle(glm::vec2(lamp.position.x, lamp.position.z), LAMP_POST_RADIUS);
+    }
+
+    // seeded from the world so replays see the same swarm
+    _swarmRandom.seed(_worldSeed);
+    std::uniform_real_distribution<float> centerDistribution(-parameters.boundsHalfSize, parameters.boundsHalfSize);
+    std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+    std::uniform_real_distribution<float> jitterDistribution(-1.0f, 1.0f);
+
+    _pFlock->clear();
+    _swarm.clear();
+    _swarm.reserve(_swarmSize);
+    glm::vec3 flockCenter(0.0f);
+    float flockHeading = 0.0f;
+    for (GLuint i = 0; i < _swarmSize; ++i) {
+        // each flock starts loosely packed, heading roughly the same way
+        if (i % SWARM_FLOCK_SIZE == 0) {
+            flockCenter = glm::vec3(centerDistribution(_swarmRandom), 1.0f + 3.0f * unitDistribution(_swarmRandom), centerDistribution(_swarmRandom));
+            flockHeading = glm::two_pi<float>() * unitDistribution(_swarmRandom);
+        }
+        glm::vec3 position = flockCenter + glm::vec3(3.0f * jitterDistribution(_swarmRandom), 0.5f * jitterDistribution(_swarmRandom), 3.0f * jitterDistribution(_swarmRandom));
+        float heading = flockHeading + 0.5f * jitterDistribution(_swarmRandom);
+        float speed = parameters.minSpeed + (parameters.maxSpeed - parameters.minSpeed) * unitDistribution(_swarmRandom);
+        _pFlock->addAgent(position, glm::vec3(speed * sinf(heading), 0.0f, speed * cosf(heading)));
+
+        SwarmButterfly butterfly;
+        butterfly.phase = unitDistribution(_swarmRandom);
+        // around the pi / 20 per tick of Lucid::move
+        butterfly.flapRate = (0.8f + 0.4f * unitDistribution(_swarmRandom)) / ButterflySwarm::NUM_FRAMES;
+        _swarm.push_back(butterfly);
+    }
+    _swarmInstances.resize(_swarm.size());
+    _updateSwarm();
 }
 
+void MPEngine::_updateSwarm() {
+    _pFlock->update();
+
+    // the flock keeps its agents in cell order, the instance order does not matter to the draw
+    for (size_t slot = 0; slot < _pFlock->getNumAgents(); ++slot) {
+        SwarmButterfly& butterfly = _swarm[_pFlock->getId(slot)];
+        butterfly.phase = fmodf(butterfly.phase + butterfly.flapRate, 1.0f);
 
-bool MPEngine::checkCollision(const glm::vec3& pos1, float radius1,
-                               const glm::vec3& pos2, float radius2) {
-    float distanceSquared = glm::dot(pos1 - pos2, pos1 - pos2);
-    return distanceSquared <= ((radius1 + radius2) * (radius1 + radius2));
+        // facing where it flies, bobbing with the wings
+        glm::vec3 position = _pFlock->getPosition(slot);
+        glm::vec3 velocity = _pFlock->getVelocity(slot);
+        position.y += 0.15f * sinf(glm::two_pi<float>() * butterfly.phase);
+        _swarmInstances[slot].positionHeading = glm::vec4(position, atan2f(velocity.x, velocity.z));
+        _swarmInstances[slot].phase = butterfly.phase;
+    }
 }
 
-bool MPEngine::isMovementValid(const glm::vec3& newPosition) const {
-    float vehicleRadius = _pVehicle->getBoundingRadius();
+void MPEngine::_drawButterflySwarm(glm::mat4 viewMtx, glm::mat4 projMtx) const {
+    if (_butterflySwarm.getNumInstances() == 0) return;
 
-    for(const BuildingData& building : _buildings) {
-        if(checkCollision(newPosition, vehicleRadius, building.position, building.boundingRadius)) {
-            return false;
+    _pRenderStateCache->useProgram(_swarmShaderProgram->getShaderProgramHandle());
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(viewMtx)[3]);
+    glUniform3fv(_swarmLightingUniformLocations.viewPos, 1, glm::value_ptr(cameraPosition));
+    glm::mat4 viewProjMtx = projMtx * viewMtx;
+    glUniformMatrix4fv(_swarmShaderUniformLocations.viewProjection, 1, GL_FALSE, glm::value_ptr(viewProjMtx));
+    _sendLightUniforms(_swarmLightingUniformLocations);
+    _sendMaterialUniforms(_swarmLightingUniformLocations, WING_MATERIAL);
+
+    _pRenderStateCache->bindTexture(SWARM_TEXTURE_UNIT, GL_TEXTURE_2D, _butterflySwarm.getAnimationTexture());
+    _butterflySwarm.draw();
+}
+
+void MPEngine::_setGLStatsEnabled(bool enabled) {
+    _glStatsEnabled = enabled;
+    if (enabled) {
+        GLStats::install();
+        GLStats::beginFrame();
+    } else {
+        GLStats::uninstall();
+    }
+}
+
+void MPEngine::_drawStatsOverlay(GLint framebufferWidth, GLint framebufferHeight) {
+    const GLStats::Frame& frame = GLStats::getLastFrame();
+    char line[64];
+    _statsOverlay.clear();
+    snprintf(line, sizeof(line), "GL CALLS FRAME %llu", static_cast<unsigned long long>(frame.index));
+    _statsOverlay.addLine(line);
+    for (GLuint counter = 0; counter < GLStats::NUM_COUNTERS; ++counter) {
+        // counter names as in the log, with spaces
+        int length = snprintf(line, sizeof(line), "%-29s %llu", GLStats::getCounterName(static_cast<GLStats::Counter>(counter)),
+                              static_cast<unsigned long long>(frame.counters[counter]));
+        for (int i = 0; i < length && line[i] != ' '; ++i) {
+            if (line[i] == '_') line[i] = ' ';
         }
+        _statsOverlay.addLine(line);
     }
-    return true;
+    if (_postProcessEnabled) {
+        for (GLuint pass = 0; pass < PostProcess::NUM_PASSES; ++pass) {
+            PostProcess::Pass postPass = static_cast<PostProcess::Pass>(pass);
+            snprintf(line, sizeof(line), "%-29s %.2f MS", PostProcess::getPassName(postPass), _postProcess.getPassTime(postPass));
+            _statsOverlay.addLine(line);
+        }
+        snprintf(line, sizeof(line), "%-29s %.2f OF %.2f MS", "post process at 1080p", _postProcess.getCostAt1080p(), PostProcess::BUDGET_MS_1080P);
+        _statsOverlay.addLine(line);
+    }
+
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
+    _pRenderStateCache->setEnabled(GL_DEPTH_TEST, false);
+    _pRenderStateCache->setEnabled(GL_CULL_FACE, false);
+    _pRenderStateCache->setEnabled(GL_BLEND, true);
+    _pRenderStateCache->setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    _pRenderStateCache->useProgram(_overlayShaderProgram->getShaderProgramHandle());
+    glUniform2f(_overlayShaderUniformLocations.screenSize, static_cast<GLfloat>(framebufferWidth), static_cast<GLfloat>(framebufferHeight));
+    // readable on high density displays too
+    glUniform1f(_overlayShaderUniformLocations.pixelScale, (framebufferHeight > 1200 ? 3.0f : 2.0f));
+    _pRenderStateCache->bindTexture(OVERLAY_TEXTURE_UNIT, GL_TEXTURE_2D, _statsOverlay.getFontTexture());
+    _statsOverlay.draw();
 }
 
 void MPEngine::handleKeyEvent(GLint key, GLint action, GLint mods) {
+    _recordEvent(InputEventType::KEY, key, action, mods, glm::vec2(0.0f));
+
     if (key >= 0 && key < NUM_KEYS) {
         _keys[key] = ((action == GLFW_PRESS) || (action == GLFW_REPEAT));
     }
@@ -175,7 +602,7 @@ void MPEngine::handleKeyEvent(GLint key, GLint action, GLint mods) {
             // Quit!
             case GLFW_KEY_Q:
             case GLFW_KEY_ESCAPE:
-                setWindowShouldClose();
+                if (!_headless) setWindowShouldClose();
                 break;
 
                 // Zoom In/Out with Space
@@ -211,6 +638,44 @@ void MPEngine::handleKeyEvent(GLint key, GLint action, GLint mods) {
             case GLFW_KEY_5:
                 currCamera = CameraType::FREECAM; // Switch to Freecam immediately
                 break;
+            case GLFW_KEY_M:
+                if (action == GLFW_PRESS) {
+                    _insetViewsEnabled = !_insetViewsEnabled;
+                    fprintf( stdout, "[INFO]: minimap and hero cam %s\n", (_insetViewsEnabled ? "on" : "off") );
+                }
+                break;
+            case GLFW_KEY_O:
+                if (action == GLFW_PRESS) {
+                    _occlusionCullingEnabled = !_occlusionCullingEnabled;
+                    fprintf( stdout, "[INFO]: occlusion culling %s\n", (_occlusionCullingEnabled ? "on" : "off") );
+                }
+                break;
+            case GLFW_KEY_G:
+                if (action == GLFW_PRESS && !_headless) {
+                    _setGLStatsEnabled(!_glStatsEnabled);
+                    fprintf( stdout, "[INFO]: GL call counters %s\n", (_glStatsEnabled ? "on" : "off") );
+                }
+                break;
+            case GLFW_KEY_H:
+                if (action == GLFW_PRESS) {
+                    _postProcessEnabled = !_postProcessEnabled;
+                    fprintf( stdout, "[INFO]: HDR post-processing %s\n", (_postProcessEnabled ? "on" : "off") );
+                }
+                break;
+            case GLFW_KEY_B:
+                if (action == GLFW_PRESS) _togglePostProcessPass(PostProcess::BLOOM_DOWNSAMPLE_HALF);
+                break;
+            case GLFW_KEY_N:
+                // the quarter level is only worth its downsample with the upsample that brings it back
+                if (action == GLFW_PRESS) {
+                    _togglePostProcessPass(PostProcess::BLOOM_DOWNSAMPLE_QUARTER);
+                    _postProcess.setPassEnabled(PostProcess::BLOOM_UPSAMPLE, _postProcess.isPassEnabled(PostProcess::BLOOM_DOWNSAMPLE_QUARTER));
+                }
+                break;
+            case GLFW_KEY_T:
+                if (action == GLFW_PRESS) _togglePostProcessPass(PostProcess::TONE_MAP);
+                break;
+
             case GLFW_KEY_6:
                 currCamera = CameraType::FIRSTPERSON; // Switch to First Person view
 
@@ -237,6 +702,8 @@ void MPEngine::handleKeyEvent(GLint key, GLint action, GLint mods) {
 
 
 void MPEngine::handleMouseButtonEvent(GLint button, GLint action, GLint mods) {
+    _recordEvent(InputEventType::MOUSE_BUTTON, button, action, mods, glm::vec2(0.0f));
+
     // if the event is for the left mouse button
     if( button == GLFW_MOUSE_BUTTON_LEFT ) {
         // update the left mouse button's state
@@ -253,9 +720,14 @@ void MPEngine::handleMouseButtonEvent(GLint button, GLint action, GLint mods) {
             _zooming = false;
         }
     }
+    else if( button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS && !_headless && _mousePosition.x != MOUSE_UNINITIALIZED ) {
+        _pickObject(_mousePosition);
+    }
 }
 
 void MPEngine::handleCursorPositionEvent(glm::vec2 currMousePosition) {
+    _recordEvent(InputEventType::CURSOR_POSITION, 0, 0, 0, currMousePosition);
+
     // if mouse hasn't moved in the window, prevent camera from flipping out
     if(_mousePosition.x == MOUSE_UNINITIALIZED) {
         _mousePosition = currMousePosition;
@@ -309,46 +781,28 @@ void MPEngine::mSetupGLFW() {
 }
 
 void MPEngine::mSetupOpenGL() {
-    glEnable( GL_DEPTH_TEST );                        // enable depth testing
-    glDepthFunc( GL_LESS );                           // use less than depth test
+    // the context is new, nothing the cache remembers is valid
+    _pRenderStateCache->invalidate();
 
-    glEnable(GL_BLEND);                                // enable blending
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);// use one minus blending equation
+    _pRenderStateCache->setEnabled(GL_DEPTH_TEST, true);                // enable depth testing
+    _pRenderStateCache->setDepthFunc(GL_LESS);                          // use less than depth test
+
+    // blending is switched on per pass, see _renderTranslucentPass
+    _pRenderStateCache->setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);// use one minus blending equation
 
 //glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    _logQualitySettings();
+
+    // glad is loaded by now, the counters can take over its pointers
+    if (!_glStatsLogFilename.empty()) GLStats::openLog(_glStatsLogFilename.c_str());
+    if (_glStatsEnabled) GLStats::install();
 }
 
 void MPEngine::mSetupShaders() {
     _lightingShaderProgram = new CSCI441::ShaderProgram("shaders/lighting.vs.glsl", "shaders/lighting.fs.glsl");
-    // Retrieve uniform locations
-    _lightingShaderUniformLocations.mvpMatrix = _lightingShaderProgram->getUniformLocation("mvpMatrix");
-    _lightingShaderUniformLocations.normalMatrix = _lightingShaderProgram->getUniformLocation("normalMatrix");
-    _lightingShaderUniformLocations.modelMatrix = _lightingShaderProgram->getUniformLocation("modelMatrix");
-    _lightingShaderUniformLocations.viewPos = _lightingShaderProgram->getUniformLocation("viewPos");
-
-    // Material properties
-    _lightingShaderUniformLocations.materialAmbient = _lightingShaderProgram->getUniformLocation("material.ambient");
-    _lightingShaderUniformLocations.materialDiffuse = _lightingShaderProgram->getUniformLocation("material.diffuse");
-    _lightingShaderUniformLocations.materialSpecular = _lightingShaderProgram->getUniformLocation("material.specular");
-    _lightingShaderUniformLocations.materialShininess = _lightingShaderProgram->getUniformLocation("material.shininess");
-
-    // Directional Light
-    _lightingShaderUniformLocations.dirLightDirection = _lightingShaderProgram->getUniformLocation("dirLight.direction");
-    _lightingShaderUniformLocations.dirLightColor = _lightingShaderProgram->getUniformLocation("dirLight.color");
-
-    // Point Lights
-    _lightingShaderUniformLocations.numPointLights = _lightingShaderProgram->getUniformLocation("numPointLights");
-    _lightingShaderUniformLocations.pointLightPositions = _lightingShaderProgram->getUniformLocation("pointLightPositions");
-    _lightingShaderUniformLocations.pointLightColors = _lightingShaderProgram->getUniformLocation("pointLightColors");
-    _lightingShaderUniformLocations.pointLightConstants = _lightingShaderProgram->getUniformLocation("pointLightConstants");
-    _lightingShaderUniformLocations.pointLightLinears = _lightingShaderProgram->getUniformLocation("pointLightLinears");
-    _lightingShaderUniformLocations.pointLightQuadratics = _lightingShaderProgram->getUniformLocation("pointLightQuadratics");
-
-    // Spot Light
-    _lightingShaderUniformLocations.spotLightDirection = _lightingShaderProgram->getUniformLocation("spotLightDirection");
-    _lightingShaderUniformLocations.spotLightPosition = _lightingShaderProgram->getUniformLocation("spotLightPosition");
-    _lightingShaderUniformLocations.spotLightWidth = _lightingShaderProgram->getUniformLocation("spotLightWidth");
-    _lightingShaderUniformLocations.spotLightColor = _lightingShaderProgram->getUniformLocation("spotLightColor");
+    _getLightingUniformLocations(_lightingShaderProgram, _lightingShaderUniformLocations);
+    TransformRing::bindBlock(_lightingShaderProgram->getShaderProgramHandle(), "DrawTransform");
 
     // Attribute locations
     _lightingShaderAttributeLocations.vPos = _lightingShaderProgram->getAttributeLocation("vPos");
@@ -365,15 +819,98 @@ void MPEngine::mSetupShaders() {
     _skyboxShaderUniformLocations.skybox = _skyboxShaderProgram->getUniformLocation("skybox");
     _skyboxShaderUniformLocations.view = _skyboxShaderProgram->getUniformLocation("view");
     _skyboxShaderUniformLocations.projection = _skyboxShaderProgram->getUniformLocation("projection");
+
+    _multiviewShaderProgram = new CSCI441::ShaderProgram("shaders/lighting_multiview.vs.glsl", "shaders/lighting_multiview.gs.glsl", "shaders/lighting.fs.glsl");
+    _getLightingUniformLocations(_multiviewShaderProgram, _multiviewLightingUniformLocations);
+    _multiviewShaderUniformLocations.viewProjections = _multiviewShaderProgram->getUniformLocation("viewProjections");
+    _multiviewShaderUniformLocations.viewPositions = _multiviewShaderProgram->getUniformLocation("viewPositions");
+    _multiviewShaderUniformLocations.viewMask = _multiviewShaderProgram->getUniformLocation("viewMask");
+
+    _swarmShaderProgram = new CSCI441::ShaderProgram("shaders/butterfly_swarm.vs.glsl", "shaders/lighting.fs.glsl");
+    _getLightingUniformLocations(_swarmShaderProgram, _swarmLightingUniformLocations);
+    _swarmShaderUniformLocations.viewProjection = _swarmShaderProgram->getUniformLocation("viewProjection");
+    _swarmShaderUniformLocations.animationTexture = _swarmShaderProgram->getUniformLocation("animationTexture");
+
+    _overlayShaderProgram = new CSCI441::ShaderProgram("shaders/stats_overlay.vs.glsl", "shaders/stats_overlay.fs.glsl");
+    _overlayShaderUniformLocations.screenSize = _overlayShaderProgram->getUniformLocation("screenSize");
+    _overlayShaderUniformLocations.pixelScale = _overlayShaderProgram->getUniformLocation("pixelScale");
+    _overlayShaderUniformLocations.font = _overlayShaderProgram->getUniformLocation("font");
+
+    _bloomDownsampleShaderProgram = new CSCI441::ShaderProgram("shaders/post.vs.glsl", "shaders/bloom_downsample.fs.glsl");
+    _bloomUpsampleShaderProgram = new CSCI441::ShaderProgram("shaders/post.vs.glsl", "shaders/bloom_upsample.fs.glsl");
+    _toneMapShaderProgram = new CSCI441::ShaderProgram("shaders/post.vs.glsl", "shaders/tone_map.fs.glsl");
+    _postProcess.setPrograms(_bloomDownsampleShaderProgram->getShaderProgramHandle(),
+                             _bloomUpsampleShaderProgram->getShaderProgramHandle(),
+                             _toneMapShaderProgram->getShaderProgramHandle());
+
+    // the ShaderProgram objects delete their programs, the registry only accounts for them
+    _programHandles[0] = _gpuResources.trackExternal(GpuResourceType::PROGRAM, _lightingShaderProgram->getShaderProgramHandle(), 0, "lighting program");
+    _programHandles[1] = _gpuResources.trackExternal(GpuResourceType::PROGRAM, _textureShaderProgram->getShaderProgramHandle(), 0, "texture program");
+    _programHandles[2] = _gpuResources.trackExternal(GpuResourceType::PROGRAM, _skyboxShaderProgram->getShaderProgramHandle(), 0, "skybox program");
+    _programHandles[3] = _gpuResources.trackExternal(GpuResourceType::PROGRAM, _multiviewShaderProgram->getShaderProgramHandle(), 0, "multiview lighting program");
+    _programHandles[4] = _gpuResources.trackExternal(GpuResourceType::PROGRAM, _swarmShaderProgram->getShaderProgramHandle(), 0, "butterfly swarm program");
+    _programHandles[5] = _gpuResources.trackExternal(GpuResourceType::PROGRAM, _overlayShaderProgram->getShaderProgramHandle(), 0, "stats overlay program");
+    _programHandles[6] = _gpuResources.trackExternal(GpuResourceType::PROGRAM, _bloomDownsampleShaderProgram->getShaderProgramHandle(), 0, "bloom downsample program");
+    _programHandles[7] = _gpuResources.trackExternal(GpuResourceType::PROGRAM, _bloomUpsampleShaderProgram->getShaderProgramHandle(), 0, "bloom upsample program");
+    _programHandles[8] = _gpuResources.trackExternal(GpuResourceType::PROGRAM, _toneMapShaderProgram->getShaderProgramHandle(), 0, "tone map program");
+
+    // samplers never change unit, set them once instead of every frame
+    _textureShaderProgram->setProgramUniform(_textureShaderUniformLocations.aTextMap, 0);
+    _skyboxShaderProgram->setProgramUniform(_skyboxShaderUniformLocations.skybox, 1);
+    _swarmShaderProgram->setProgramUniform(_swarmShaderUniformLocations.animationTexture, static_cast<GLint>(SWARM_TEXTURE_UNIT));
+    _overlayShaderProgram->setProgramUniform(_overlayShaderUniformLocations.font, static_cast<GLint>(OVERLAY_TEXTURE_UNIT));
+}
+
+void MPEngine::_getLightingUniformLocations(const CSCI441::ShaderProgram* pShaderProgram, LightingShaderUniformLocations& locations) const {
+    // uniforms a program does not use come back as -1 and are ignored by glUniform*
+    locations.normalMatrix = pShaderProgram->getUniformLocation("normalMatrix");
+    locations.modelMatrix = pShaderProgram->getUniformLocation("modelMatrix");
+    locations.viewPos = pShaderProgram->getUniformLocation("viewPos");
+
+    // Material properties
+    locations.materialAmbient = pShaderProgram->getUniformLocation("material.ambient");
+    locations.materialDiffuse = pShaderProgram->getUniformLocation("material.diffuse");
+    locations.materialSpecular = pShaderProgram->getUniformLocation("material.specular");
+    locations.materialShininess = pShaderProgram->getUniformLocation("material.shininess");
+
+    // Directional Light
+    locations.dirLightDirection = pShaderProgram->getUniformLocation("dirLight.direction");
+    locations.dirLightColor = pShaderProgram->getUniformLocation("dirLight.color");
+
+    // Point Lights
+    locations.numPointLights = pShaderProgram->getUniformLocation("numPointLights");
+    locations.pointLightPositions = pShaderProgram->getUniformLocation("pointLightPositions");
+    locations.pointLightColors = pShaderProgram->getUniformLocation("pointLightColors");
+    locations.pointLightConstants = pShaderProgram->getUniformLocation("pointLightConstants");
+    locations.pointLightLinears = pShaderProgram->getUniformLocation("pointLightLinears");
+    locations.pointLightQuadratics = pShaderProgram->getUniformLocation("pointLightQuadratics");
+
+    // Spot Light
+    locations.spotLightDirection = pShaderProgram->getUniformLocation("spotLightDirection");
+    locations.spotLightPosition = pShaderProgram->getUniformLocation("spotLightPosition");
+    locations.spotLightWidth = pShaderProgram->getUniformLocation("spotLightWidth");
+    locations.spotLightColor = pShaderProgram->getUniformLocation("spotLightColor");
+
+    // Sky ambient light
+    locations.skyAmbient = pShaderProgram->getUniformLocation("skyAmbient");
+    locations.emission = pShaderProgram->getUniformLocation("emission");
 }
 
 void MPEngine::mSetupBuffers() {
     //connect our 3D Object Library to our shader
     CSCI441::setVertexAttributeLocations( _lightingShaderAttributeLocations.vPos, _lightingShaderAttributeLocations.vNormal);
 
+    _pTransformRing->create(_gpuResources);
+    _createParticleEffects();
+    _butterflySwarm.create(_gpuResources, _swarmSize);
+    _statsOverlay.create(_gpuResources);
+    _primitiveMeshes.upload(_gpuResources, _lightingShaderAttributeLocations.vPos, _lightingShaderAttributeLocations.vNormal);
     _createGroundBuffers();
     _createSkyBuffers();
-    _generateEnvironment();
+    // a loaded scene already holds the world, only generate one otherwise
+    if (!_sceneLoaded) {
+        _generateEnvironment();
+    }
 }
 
 void MPEngine::_createSkyBuffers() {
@@ -399,23 +936,16 @@ void MPEngine::_createSkyBuffers() {
     };
 
     // Create VAO for the skybox
-    glGenVertexArrays(1, &_skyboxVAO);
-    if (_skyboxVAO == 0) {
+    _skyboxVAO = _gpuResources.createVertexArray("skybox VAO");
+    if (!_skyboxVAO.isValid()) {
         std::cerr << "[ERROR]: Skybox VAO not generated correctly." << std::endl;
     }
-    glBindVertexArray(_skyboxVAO);
 
     // Create VBO for skybox vertices
-    GLuint skyboxVBO;
-    glGenBuffers(1, &skyboxVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
+    _skyboxVBO = _gpuResources.createBuffer(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW, "skybox VBO");
 
     // Create EBO for skybox indices
-    GLuint skyboxEBO;
-    glGenBuffers(1, &skyboxEBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, skyboxEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(skyboxIndices), skyboxIndices, GL_STATIC_DRAW);
+    _skyboxEBO = _gpuResources.createBuffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(skyboxIndices), skyboxIndices, GL_STATIC_DRAW, "skybox EBO");
 
     // Set vertex attribute pointers
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
@@ -428,111 +958,86 @@ void MPEngine::_createSkyBuffers() {
 
 
 void MPEngine::_createGroundBuffers() {
-    struct Vertex {
-        glm::vec3 position;
-        float normalX;
-        float normalY;
-        float normalZ;
-        glm::vec2 texCoords;
+    FullVertex groundQuad[4] = {
+        {{-1.0f, 0.0f, -1.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
+        {{ 1.0f, 0.0f, -1.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
+        {{-1.0f, 0.0f,  1.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 1.0f}},
+        {{ 1.0f, 0.0f,  1.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 1.0f}}
     };
 
-    Vertex groundQuad[4] = {
-        {{-1.0f, 0.0f, -1.0f}, 0.0f, 1.0f, 0.0f, {0.0f, 0.0f}},
-        {{ 1.0f, 0.0f, -1.0f}, 0.0f, 1.0f, 0.0f, {1.0f, 0.0f}},
-        {{-1.0f, 0.0f,  1.0f}, 0.0f, 1.0f, 0.0f, {0.0f, 1.0f}},
-        {{ 1.0f, 0.0f,  1.0f}, 0.0f, 1.0f, 0.0f, {1.0f, 1.0f}}
-    };
+    // the quad spans [-1,1] and is scaled by WORLD_SIZE when drawn, so snorm16 positions are exact
+    CompactVertex compactGroundQuad[4];
+    for (int i = 0; i < 4; ++i) {
+        compactGroundQuad[i] = packVertex(groundQuad[i], VertexFormat::COMPACT_SNORM16);
+    }
 
     GLushort indices[4] = {0, 1, 2, 3};
 
     _numGroundPoints = 4;
 
-    glGenVertexArrays(1, &_groundVAO);
-    glBindVertexArray(_groundVAO);
-
-    GLuint vbods[2]; // 0 - VBO, 1 - IBO
-    glGenBuffers(2, vbods);
-    glBindBuffer(GL_ARRAY_BUFFER, vbods[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(groundQuad), groundQuad, GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(_lightingShaderAttributeLocations.vPos);
-    glVertexAttribPointer(_lightingShaderAttributeLocations.vPos, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)nullptr);
+    _groundVAO = _gpuResources.createVertexArray("ground VAO");
+    _groundVBO = _gpuResources.createBuffer(GL_ARRAY_BUFFER, sizeof(compactGroundQuad), compactGroundQuad, GL_STATIC_DRAW, "ground VBO");
 
-    glEnableVertexAttribArray(_lightingShaderAttributeLocations.vNormal);
-    glVertexAttribPointer(_lightingShaderAttributeLocations.vNormal, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, normalX)));
+    // only the texture shader draws the ground, it has no normal input
+    setVertexAttributes(VertexFormat::COMPACT_SNORM16, _textureShaderAttributeLocations.vPos, -1, _textureShaderAttributeLocations.aTextCoords);
 
-    glEnableVertexAttribArray(_textureShaderAttributeLocations.vPos);
-    glVertexAttribPointer(_textureShaderAttributeLocations.vPos, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    _groundIBO = _gpuResources.createBuffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW, "ground IBO");
+}
 
-    glEnableVertexAttribArray(_textureShaderAttributeLocations.aTextCoords);
-    glVertexAttribPointer(_textureShaderAttributeLocations.aTextCoords, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, texCoords)));
+void MPEngine::regenerateEnvironment(float density, unsigned int seed) {
+    _environmentDensity = density;
+    _worldSeed = seed;
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbods[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    _trees.clear();
+    _lamps.clear();
+    _generateEnvironment();
+    _rebuildCollisionWorld();
+    _rebuildSceneQuery();
+    _rebuildNavigation();
+    _rebuildSwarm();
 }
 
 void MPEngine::_generateEnvironment() {
-    srand(static_cast<unsigned int>(time(0)));
-
-    // Grid parameters
-    const GLfloat GRID_WIDTH = WORLD_SIZE * 1.8f;
-    const GLfloat GRID_LENGTH = WORLD_SIZE * 1.8f;
-    const GLfloat GRID_SPACING_WIDTH = 1.0f;
-    const GLfloat GRID_SPACING_LENGTH = 1.0f;
-
-    // Precomputed parameters based on above
-    const GLfloat LEFT_END_POINT = -GRID_WIDTH / 2.0f - 5.0f;
-    const GLfloat RIGHT_END_POINT = GRID_WIDTH / 2.0f + 5.0f;
-    const GLfloat BOTTOM_END_POINT = -GRID_LENGTH / 2.0f - 5.0f;
-    const GLfloat TOP_END_POINT = GRID_LENGTH / 2.0f + 5.0f;
-
-    // Generate Objects
-    for(int i = LEFT_END_POINT; i < RIGHT_END_POINT; i += GRID_SPACING_WIDTH) {
-        for(int j = BOTTOM_END_POINT; j < TOP_END_POINT; j += GRID_SPACING_LENGTH) {
-            // Don't just draw an object ANYWHERE.
-            if( i % 2 && j % 2 && getRand() < 0.02f ) {
-                // Translate to spot
-                glm::mat4 transToSpotMtx = glm::translate(glm::mat4(1.0f), glm::vec3(i, 0.0f, j));
-
-                // Choose whether to make object a tree/lamppost
-                if (getRand() > 0.2) {
-                    glm::mat4 transLeavesMtx = glm::translate(transToSpotMtx, glm::vec3(0, 5, 0));
-                    TreeData currentTree = {transToSpotMtx, transLeavesMtx};
-                    _trees.emplace_back(currentTree);
-                } else {
-                    glm::mat4 transLightMtx = glm::translate(transToSpotMtx, glm::vec3(0, 7, 0));
-
-                    // Store lamp properties
-                    glm::vec3 lampPosition = glm::vec3(transLightMtx[3]);
-                    LampData currentLamp = {transToSpotMtx, transLightMtx, lampPosition};
-                    _lamps.emplace_back(currentLamp);
-                }
-            }
-        }
-    }
+    WorldGenerator::generate(WORLD_SIZE, _environmentDensity, _worldSeed, _trees, _lamps);
 }
 
 void MPEngine::mSetupScene() {
+    _createSceneObjects();
+}
+
+void MPEngine::_createSceneObjects() {
+    // headless replays run without a GL context, so there is no shader program to hand out
+    GLuint shaderProgramHandle = (_lightingShaderProgram != nullptr ? _lightingShaderProgram->getShaderProgramHandle() : 0);
+
     // Create the Vehicle
-    _pVehicle = new Vehicle(_lightingShaderProgram->getShaderProgramHandle(),
-                            _lightingShaderUniformLocations.mvpMatrix,
-                            _lightingShaderUniformLocations.normalMatrix,
+    _pVehicle = new Vehicle(shaderProgramHandle,
+                            _pTransformRing,
                             _lightingShaderUniformLocations.materialAmbient,
                             _lightingShaderUniformLocations.materialDiffuse,
                             _lightingShaderUniformLocations.materialSpecular,
                             _lightingShaderUniformLocations.materialShininess);
 
 
-    _pUFO = new UFO(_lightingShaderProgram->getShaderProgramHandle(), _lightingShaderUniformLocations.mvpMatrix,
-                            _lightingShaderUniformLocations.normalMatrix,
+    _pUFO = new UFO(shaderProgramHandle, _pTransformRing,
+                            _lightingShaderUniformLocations.materialAmbient,
+                            _lightingShaderUniformLocations.materialDiffuse,
+                            _lightingShaderUniformLocations.materialSpecular,
+                            _lightingShaderUniformLocations.materialShininess);
+
+    _pButterfly = new Lucid(shaderProgramHandle,
+                            _pTransformRing,
                             _lightingShaderUniformLocations.materialAmbient,
                             _lightingShaderUniformLocations.materialDiffuse,
                             _lightingShaderUniformLocations.materialSpecular,
                             _lightingShaderUniformLocations.materialShininess);
 
-    _pButterfly = new Lucid(_lightingShaderProgram->getShaderProgramHandle(),
-                            _lightingShaderUniformLocations.mvpMatrix,
-                            _lightingShaderUniformLocations.normalMatrix,
+    _pAgentVehicle = new Vehicle(shaderProgramHandle,
+                            _pTransformRing,
+                            _lightingShaderUniformLocations.materialAmbient,
+                            _lightingShaderUniformLocations.materialDiffuse,
+                            _lightingShaderUniformLocations.materialSpecular,
+                            _lightingShaderUniformLocations.materialShininess);
+    _pAgentUFO = new UFO(shaderProgramHandle, _pTransformRing,
                             _lightingShaderUniformLocations.materialAmbient,
                             _lightingShaderUniformLocations.materialDiffuse,
                             _lightingShaderUniformLocations.materialSpecular,
@@ -561,73 +1066,33 @@ void MPEngine::mSetupScene() {
     } else if (currHero == HeroType::LUCID) {
         _pFPCam->updatePositionAndOrientation(_pUFO->getPosition(), _pUFO->getHeading());
     }
+
+    _applyLoadedHeroes();
+    _rebuildCollisionWorld();
+    _rebuildSceneQuery();
+    _rebuildNavigation();
+    _rebuildSwarm();
 }
 
 void MPEngine::_renderScene(glm::mat4 viewMtx, glm::mat4 projMtx) const {
+    // Opaque geometry front-to-back first, then the sky into whatever is still
+    // at the far plane, then translucent geometry over the finished depth buffer
+    _renderOpaquePass(viewMtx, projMtx);
+    _renderSkyPass(viewMtx, projMtx);
+    _renderTranslucentPass(viewMtx, projMtx);
+
+    // glClear honours the depth mask, leave it writable for the next frame
+    _pRenderStateCache->setDepthMask(GL_TRUE);
+}
 
-    _textureShaderProgram->useProgram();
-
-    // Setup the model matrix for the ground
-    glm::mat4 groundModelMtx = glm::scale(glm::mat4(1.0f), glm::vec3(WORLD_SIZE, 1.0f, WORLD_SIZE));
-    glm::mat4 mvpMtx = projMtx * viewMtx * groundModelMtx;
-
-    // Set uniform for the texture shader's MVP matrix
-    _textureShaderProgram->setProgramUniform(_textureShaderUniformLocations.mvpMatrix, mvpMtx);
-
-    // Bind the ground texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::RUG]);
-    glUniform1i(_textureShaderUniformLocations.aTextMap, 0);
-
-    // Bind and draw the ground VAO
-    glBindVertexArray(_groundVAO);
-    glDrawElements(GL_TRIANGLE_STRIP, _numGroundPoints, GL_UNSIGNED_SHORT, nullptr);
-    glEnable(GL_CULL_FACE);
-
-    _skyboxShaderProgram->useProgram();
-
-    // Set up depth function for skybox rendering
-    glDepthFunc(GL_LEQUAL);
-
-    // Bind the skybox cubemap texture to texture unit 1
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, _texHandles[TEXTURE_ID::SKY]);
-    glUniform1i(_skyboxShaderUniformLocations.skybox, 1);
-
-
-    // Bind VAO and draw the skybox using glDrawElements
-    glBindVertexArray(_skyboxVAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0); // Use glDrawElements to draw with indices
-    glBindVertexArray(0);
-
-    // Reset depth function
-    glDepthFunc(GL_LESS);
-
-    // Bind the texture shader for ground rendering
-    glDisable(GL_CULL_FACE);
-
-    const int MAX_POINT_LIGHTS = 10;
-
-    // Arrays to hold point light data
-    glm::vec3 pointLightPositions[MAX_POINT_LIGHTS];
-    glm::vec3 pointLightColors[MAX_POINT_LIGHTS];
-    float pointLightConstants[MAX_POINT_LIGHTS];
-    float pointLightLinears[MAX_POINT_LIGHTS];
-    float pointLightQuadratics[MAX_POINT_LIGHTS];
-
-    // Determine the number of point lights
-    int numPointLights = std::min(static_cast<int>(_lamps.size()), MAX_POINT_LIGHTS);
-
-    // Populate the point light arrays
-    for(int i = 0; i < numPointLights; ++i) {
-        pointLightPositions[i] = _lamps[i].position;
-        pointLightColors[i] = glm::vec3(0.0f, 0.0f, 1.0f); // Blue color
-        pointLightConstants[i] = 1.0f;
-        pointLightLinears[i] = 0.09f;
-        pointLightQuadratics[i] = 0.032f;
-    }
+void MPEngine::_renderOpaquePass(glm::mat4 viewMtx, glm::mat4 projMtx) const {
+    _pRenderStateCache->setEnabled(GL_DEPTH_TEST, true);
+    _pRenderStateCache->setEnabled(GL_BLEND, false);
+    _pRenderStateCache->setEnabled(GL_CULL_FACE, false);
+    _pRenderStateCache->setDepthFunc(GL_LESS);
+    _pRenderStateCache->setDepthMask(GL_TRUE);
 
-    _lightingShaderProgram->useProgram();
+    _pRenderStateCache->useProgram(_lightingShaderProgram->getShaderProgramHandle());
     glm::vec3 cameraPosition;
     if (currCamera == CameraType::ARCBALL) {
         cameraPosition = _pArcballCam->getPosition();
@@ -640,157 +1105,458 @@ void MPEngine::_renderScene(glm::mat4 viewMtx, glm::mat4 projMtx) const {
     // Send the camera position to the shader
     glUniform3fv(_lightingShaderUniformLocations.viewPos, 1, glm::value_ptr(cameraPosition));
 
-    // Set directional light uniforms using the correct uniform names and locations
-    glm::vec3 lightDirection(-1.0f, -1.0f, -1.0f);
-    glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
-    glUniform3fv(_lightingShaderUniformLocations.dirLightDirection, 1, glm::value_ptr(lightDirection));
-    glUniform3fv(_lightingShaderUniformLocations.dirLightColor, 1, glm::value_ptr(lightColor));
-
-    glUniform1i(_lightingShaderUniformLocations.numPointLights, numPointLights);
-    glUniform3fv(_lightingShaderUniformLocations.pointLightPositions, numPointLights, glm::value_ptr(pointLightPositions[0]));
-    glUniform3fv(_lightingShaderUniformLocations.pointLightColors, numPointLights, glm::value_ptr(pointLightColors[0]));
-    glUniform1fv(_lightingShaderUniformLocations.pointLightConstants, numPointLights, pointLightConstants);
-    glUniform1fv(_lightingShaderUniformLocations.pointLightLinears, numPointLights, pointLightLinears);
-    glUniform1fv(_lightingShaderUniformLocations.pointLightQuadratics, numPointLights, pointLightQuadratics);
+    _sendLightUniforms(_lightingShaderUniformLocations);
 
-    // Set spot light uniforms
-    glm::vec3 spotLightPos(0,10,0);
-    glm::vec3 spotLightDir(0.0f, -1.0f, 0.0f);
-    glm::vec3 spotLightColor(1.0f, 0.0f, 0.0f);
-    GLint spotLightWidth = glm::cos(glm::radians(10.0f));
-    glUniform3fv(_lightingShaderUniformLocations.spotLightPosition, 1, glm::value_ptr(spotLightPos));
-    glUniform3fv(_lightingShaderUniformLocations.spotLightDirection, 1, glm::value_ptr(spotLightDir));
-    glUniform3fv(_lightingShaderUniformLocations.spotLightColor, 1, glm::value_ptr(spotLightColor));
-    glUniform1i(_lightingShaderUniformLocations.spotLightWidth, spotLightWidth);
+    // The heroes sit right in front of the arcball and first person cameras, draw them first
+    _pVehicle->drawVehicle(viewMtx, projMtx);
+    _pUFO->drawUFO(viewMtx, projMtx);
+    _pButterfly->drawLucid(viewMtx, projMtx);
+    _drawAgents(viewMtx, projMtx);
 
+    // Trees and lamps were sorted front-to-back in _prepareFrame,
+    // materials only change once per batch and detail once per mesh
     //// BEGIN DRAWING THE TREES ////
     // Draw trunks
-    for(const TreeData& tree : _trees){
-        _computeAndSendMatrixUniforms(tree.modelMatrixTrunk, viewMtx, projMtx);
-
-        // Set material properties for tree trunks
-        glm::vec3 trunkAmbient(0.2f, 0.2f, 0.2f);
-        glm::vec3 trunkDiffuse(99 / 255.f, 39 / 255.f, 9 / 255.f);
-        glm::vec3 trunkSpecular(0.3f, 0.3f, 0.3f);
-        float trunkShininess = 32.0f;
-
-        glUniform3fv(_lightingShaderUniformLocations.materialAmbient, 1, glm::value_ptr(trunkAmbient));
-        glUniform3fv(_lightingShaderUniformLocations.materialDiffuse, 1, glm::value_ptr(trunkDiffuse));
-        glUniform3fv(_lightingShaderUniformLocations.materialSpecular, 1, glm::value_ptr(trunkSpecular));
-        glUniform1f(_lightingShaderUniformLocations.materialShininess, trunkShininess);
-        _computeAndSendMatrixUniforms(tree.modelMatrixTrunk, viewMtx, projMtx);
-        CSCI441::drawSolidCylinder(1, 1, 5, 16, 16);
+    _sendMaterialUniforms(_lightingShaderUniformLocations, TRUNK_MATERIAL);
+    for(size_t i = 0; i < _visibleTrees.size(); ++i){
+        int detailLevel = (i < _numNearTrees ? _nearDetailLevel : _farDetailLevel);
+        if (i == 0 || i == _numNearTrees) _primitiveMeshes.bind(PrimitiveMeshes::Mesh::TREE_TRUNK, detailLevel);
+        const TreeData& tree = _trees[_visibleTrees[i]];
+        _computeAndSendMatrixUniforms(getInstanceMatrix(tree), viewMtx, projMtx);
+        _primitiveMeshes.draw(PrimitiveMeshes::Mesh::TREE_TRUNK, detailLevel);
     }
 
     // Draw leaves
-    for(const TreeData& tree : _trees){
-        _computeAndSendMatrixUniforms(tree.modelMatrixLeaves, viewMtx, projMtx);
-
-        // Set material properties for tree leaves
-        glm::vec3 leavesAmbient(0.2f, 0.2f, 0.2f);
-        glm::vec3 leavesDiffuse(46 / 255.f, 143 / 255.f, 41 / 255.f);
-        glm::vec3 leavesSpecular(0.3f, 0.3f, 0.3f);
-        float leavesShininess = 32.0f;
-
-        glUniform3fv(_lightingShaderUniformLocations.materialAmbient, 1, glm::value_ptr(leavesAmbient));
-        glUniform3fv(_lightingShaderUniformLocations.materialDiffuse, 1, glm::value_ptr(leavesDiffuse));
-        glUniform3fv(_lightingShaderUniformLocations.materialSpecular, 1, glm::value_ptr(leavesSpecular));
-        glUniform1f(_lightingShaderUniformLocations.materialShininess, leavesShininess);
-        _computeAndSendMatrixUniforms(tree.modelMatrixLeaves, viewMtx, projMtx);
-        CSCI441::drawSolidCone(3, 8, 16, 16);
+    _sendMaterialUniforms(_lightingShaderUniformLocations, LEAVES_MATERIAL);
+    for(size_t i = 0; i < _visibleTrees.size(); ++i){
+        int detailLevel = (i < _numNearTrees ? _nearDetailLevel : _farDetailLevel);
+        if (i == 0 || i == _numNearTrees) _primitiveMeshes.bind(PrimitiveMeshes::Mesh::TREE_LEAVES, detailLevel);
+        const TreeData& tree = _trees[_visibleTrees[i]];
+        _computeAndSendMatrixUniforms(glm::translate(getInstanceMatrix(tree), glm::vec3(0.0f, TREE_LEAVES_HEIGHT, 0.0f)), viewMtx, projMtx);
+        _primitiveMeshes.draw(PrimitiveMeshes::Mesh::TREE_LEAVES, detailLevel);
     }
     //// END DRAWING THE TREES ////
 
     //// BEGIN DRAWING THE LAMPS ////
     // Draw posts
-    for (const LampData &lamp: _lamps) {
-        _computeAndSendMatrixUniforms(lamp.modelMatrixPost, viewMtx, projMtx);
+    _sendMaterialUniforms(_lightingShaderUniformLocations, POST_MATERIAL);
+    for (size_t i = 0; i < _visibleLamps.size(); ++i) {
+        int detailLevel = (i < _numNearLamps ? _nearDetailLevel : _farDetailLevel);
+        if (i == 0 || i == _numNearLamps) _primitiveMeshes.bind(PrimitiveMeshes::Mesh::LAMP_POST, detailLevel);
+        const LampData &lamp = _lamps[_visibleLamps[i]];
+        _computeAndSendMatrixUniforms(getInstanceMatrix(lamp), viewMtx, projMtx);
+        _primitiveMeshes.draw(PrimitiveMeshes::Mesh::LAMP_POST, detailLevel);
+    }
+
+    // Draw lights
+    _sendMaterialUniforms(_lightingShaderUniformLocations, BULB_MATERIAL);
+    glUniform3fv(_lightingShaderUniformLocations.emission, 1, glm::value_ptr(BULB_EMISSION));
+    for (size_t i = 0; i < _visibleLamps.size(); ++i) {
+        int detailLevel = (i < _numNearLamps ? _nearDetailLevel : _farDetailLevel);
+        if (i == 0 || i == _numNearLamps) _primitiveMeshes.bind(PrimitiveMeshes::Mesh::LAMP_BULB, detailLevel);
+        const LampData &lamp = _lamps[_visibleLamps[i]];
+        _computeAndSendMatrixUniforms(glm::translate(getInstanceMatrix(lamp), glm::vec3(0.0f, LAMP_LIGHT_HEIGHT, 0.0f)), viewMtx, projMtx);
+        _primitiveMeshes.draw(PrimitiveMeshes::Mesh::LAMP_BULB, detailLevel);
+    }
+    // the heroes come first next frame and do not send a material of their own
+    glUniform3fv(_lightingShaderUniformLocations.emission, 1, glm::value_ptr(glm::vec3(0.0f)));
+    //// END DRAWING THE LAMPS ////
+
+    // all the ambient butterflies in one draw, with their own program
+    _drawButterflySwarm(viewMtx, projMtx);
+
+    // The ground covers most of the screen but lies behind everything else,
+    // drawing it last lets early depth testing reject the hidden part
+    _drawGround(viewMtx, projMtx);
+}
+
+void MPEngine::_drawGround(glm::mat4 viewMtx, glm::mat4 projMtx) const {
+    _pRenderStateCache->useProgram(_textureShaderProgram->getShaderProgramHandle());
+
+    glm::mat4 groundModelMtx = glm::scale(glm::mat4(1.0f), glm::vec3(WORLD_SIZE, 1.0f, WORLD_SIZE));
+    glm::mat4 mvpMtx = projMtx * viewMtx * groundModelMtx;
+    _textureShaderProgram->setProgramUniform(_textureShaderUniformLocations.mvpMatrix, mvpMtx);
+
+    _pRenderStateCache->bindTexture(0, GL_TEXTURE_2D, _textures[TEXTURE_ID::RUG].get());
+    glBindVertexArray(_groundVAO.get());
+    glDrawElements(GL_TRIANGLE_STRIP, _numGroundPoints, GL_UNSIGNED_SHORT, nullptr);
+}
 
-        // Set material properties for lamp posts
-        glm::vec3 postAmbient(0.2f, 0.2f, 0.2f);
-        glm::vec3 postDiffuse(0.5f, 0.5f, 0.5f);
-        glm::vec3 postSpecular(0.3f, 0.3f, 0.3f);
-        float postShininess = 32.0f;
+void MPEngine::_renderSkyPass(glm::mat4 viewMtx, glm::mat4 projMtx) const {
+    // skybox.vs.glsl writes z = w so the cube lands exactly on the far plane,
+    // with LEQUAL it only shades pixels no geometry covered this frame
+    _pRenderStateCache->setDepthFunc(GL_LEQUAL);
+    _pRenderStateCache->setDepthMask(GL_FALSE);
+    // the cube is wound counter-clockwise from the outside and seen from within
+    _pRenderStateCache->setEnabled(GL_CULL_FACE, true);
+    _pRenderStateCache->setCullFace(GL_FRONT);
+
+    _pRenderStateCache->useProgram(_skyboxShaderProgram->getShaderProgramHandle());
+
+    // drop the translation so the sky stays centered on the eye
+    glm::mat4 skyViewMtx = glm::mat4(glm::mat3(viewMtx));
+    _skyboxShaderProgram->setProgramUniform(_skyboxShaderUniformLocations.view, skyViewMtx);
+    _skyboxShaderProgram->setProgramUniform(_skyboxShaderUniformLocations.projection, projMtx);
+
+    _pRenderStateCache->bindTexture(1, GL_TEXTURE_CUBE_MAP, _textures[TEXTURE_ID::SKY].get());
+    glBindVertexArray(_skyboxVAO.get());
+    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr);
+}
+
+void MPEngine::_renderTranslucentPass(glm::mat4 viewMtx, glm::mat4 projMtx) const {
+    // Blended geometry tests against the finished depth buffer without writing to it
+    // and must be submitted back-to-front. The particles blend additively, which
+    // does not depend on the order.
+    _pRenderStateCache->setEnabled(GL_BLEND, true);
+    _pRenderStateCache->setEnabled(GL_CULL_FACE, false);
+    _pRenderStateCache->setDepthFunc(GL_LESS);
+    _pRenderStateCache->setDepthMask(GL_FALSE);
 
-        glUniform3fv(_lightingShaderUniformLocations.materialAmbient, 1, glm::value_ptr(postAmbient));
-        glUniform3fv(_lightingShaderUniformLocations.materialDiffuse, 1, glm::value_ptr(postDiffuse));
-        glUniform3fv(_lightingShaderUniformLocations.materialSpecular, 1, glm::value_ptr(postSpecular));
-        glUniform1f(_lightingShaderUniformLocations.materialShininess, postShininess);
+    _particleSystem.draw(*_pRenderStateCache, viewMtx, projMtx);
+}
 
-        CSCI441::drawSolidCylinder(0.2, 0.2, 7, 16, 16);
+void MPEngine::_createParticleEffects() {
+    _particleSystem.clearEmitters();
+
+    // UFO tractor beam, motes lifted off the ground up into the hull
+    ParticleSystem::Emitter beam = {};
+    beam.radius = 1.0f;
+    beam.velocity = glm::vec3(0.0f, 1.2f, 0.0f);
+    beam.spread = 0.1f;
+    beam.lifetime = 0.9f;
+    beam.startColor = glm::vec4(0.4f, 1.0f, 0.6f, 0.6f);
+    beam.endColor = glm::vec4(0.1f, 0.6f, 1.0f, 0.0f);
+    beam.size = 0.06f;
+    beam.active = true;
+    _beamEmitter = _particleSystem.addEmitter(beam, 8192);
+
+    // vehicle exhaust, smoke drifting back and up
+    ParticleSystem::Emitter exhaust = {};
+    exhaust.radius = 0.1f;
+    exhaust.spread = 0.3f;
+    exhaust.acceleration = glm::vec3(0.0f, 0.6f, 0.0f);
+    exhaust.lifetime = 1.5f;
+    exhaust.startColor = glm::vec4(0.5f, 0.5f, 0.5f, 0.3f);
+    exhaust.endColor = glm::vec4(0.2f, 0.2f, 0.2f, 0.0f);
+    exhaust.size = 0.25f;
+    exhaust.active = true;
+    _exhaustEmitter = _particleSystem.addEmitter(exhaust, 8192);
+
+    // butterfly dust, sparkles left hanging in the air behind it
+    ParticleSystem::Emitter dust = {};
+    dust.radius = 0.5f;
+    dust.spread = 0.15f;
+    dust.acceleration = glm::vec3(0.0f, -0.2f, 0.0f);
+    dust.lifetime = 2.0f;
+    dust.startColor = glm::vec4(1.0f, 0.85f, 0.4f, 0.8f);
+    dust.endColor = glm::vec4(1.0f, 0.4f, 0.8f, 0.0f);
+    dust.size = 0.05f;
+    dust.active = true;
+    _dustEmitter = _particleSystem.addEmitter(dust, 4096);
+
+    // a blue halo around every lit lamp, placed once the lamps exist
+    ParticleSystem::Emitter glow = {};
+    glow.radius = 0.2f;
+    glow.spread = 0.2f;
+    glow.lifetime = 1.0f;
+    glow.startColor = glm::vec4(0.3f, 0.4f, 1.0f, 0.5f);
+    glow.endColor = glm::vec4(0.0f, 0.1f, 1.0f, 0.0f);
+    glow.size = 0.1f;
+    for (GLuint i = 0; i < NUM_LAMP_GLOWS; ++i) {
+        GLuint emitter = _particleSystem.addEmitter(glow, 1024);
+        if (i == 0) _firstGlowEmitter = emitter;
     }
 
-    // Draw lights
-    for (const LampData &lamp: _lamps) {
-        _computeAndSendMatrixUniforms(lamp.modelMatrixLight, viewMtx, projMtx);
+    _particleSystem.create(_gpuResources, _gpuParticles);
+}
+
+void MPEngine::_updateParticles() {
+    ParticleSystem::Emitter& beam = _particleSystem.getEmitter(_beamEmitter);
+    beam.position = _pUFO->getPosition();
 
-        // Set material properties for lamp lights
-        glm::vec3 lightAmbient(0.2f, 0.2f, 0.5f);
-        glm::vec3 lightDiffuse(0.0f, 0.0f, 1.0f); // Blue color
-        glm::vec3 lightSpecular(0.5f, 0.5f, 0.5f);
-        float lightShininess = 64.0f;
+    // the tailpipe is at the back of the body, the vehicle faces +Z at heading zero
+    glm::vec3 forward(sinf(_pVehicle->getHeading()), 0.0f, cosf(_pVehicle->getHeading()));
+    ParticleSystem::Emitter& exhaust = _particleSystem.getEmitter(_exhaustEmitter);
+    exhaust.position = _pVehicle->getPosition() - forward * 1.6f + glm::vec3(0.0f, 0.6f, 0.0f);
+    exhaust.velocity = -forward * 1.5f + glm::vec3(0.0f, 0.3f, 0.0f);
 
-        glUniform3fv(_lightingShaderUniformLocations.materialAmbient, 1, glm::value_ptr(lightAmbient));
-        glUniform3fv(_lightingShaderUniformLocations.materialDiffuse, 1, glm::value_ptr(lightDiffuse));
-        glUniform3fv(_lightingShaderUniformLocations.materialSpecular, 1, glm::value_ptr(lightSpecular));
-        glUniform1f(_lightingShaderUniformLocations.materialShininess, lightShininess);
+    ParticleSystem::Emitter& dust = _particleSystem.getEmitter(_dustEmitter);
+    dust.position = _pButterfly->getPosition() + glm::vec3(0.0f, 0.85f, 0.0f);
 
-        CSCI441::drawSolidSphere(0.5, 16, 16);
+    for (GLuint i = 0; i < NUM_LAMP_GLOWS; ++i) {
+        ParticleSystem::Emitter& glow = _particleSystem.getEmitter(_firstGlowEmitter + i);
+        glow.active = i < _lamps.size() && i < _quality.lightLimit;
+        if (glow.active) glow.position = _getLampLightPosition(_lamps[i]);
     }
-    //// END DRAWING THE LAMPS ////
 
-    _pVehicle->drawVehicle(viewMtx, projMtx);
-    _pUFO->drawUFO(viewMtx, projMtx);
-    _pButterfly->drawLucid(viewMtx, projMtx);
+    _particleSystem.update(*_pRenderStateCache, PARTICLE_TIME_STEP);
 }
 
-void MPEngine::_updateScene() {
-    // Backup distance to move back upon collision
-    const float BACKUP_DISTANCE = 0.5f;
+void MPEngine::_prepareFrame(glm::mat4 viewMtx, glm::mat4 projMtx) {
+    _visibleTrees.clear();
+    _visibleLamps.clear();
 
-    // Check current hero type and handle movement for vehicles
-    if (currHero == HeroType::VEHICLE) {
-        bool moved = false;
-        glm::vec3 currentPosition = _pVehicle->getPosition();
-        glm::vec3 newPosition = currentPosition;
+    glm::vec3 eyePosition = glm::vec3(glm::inverse(viewMtx)[3]);
 
-        // Calculate movement direction based on heading
-        glm::vec3 forward = glm::vec3(sin(_pVehicle->getHeading()), 0.0f, cos(_pVehicle->getHeading()));
-        glm::vec3 backward = -forward;
+    if (_occlusionCullingEnabled) {
+        _cullScenery(viewMtx, projMtx, eyePosition);
+    } else {
+        for (GLuint i = 0; i < _trees.size(); ++i) _visibleTrees.push_back(i);
+        for (GLuint i = 0; i < _lamps.size(); ++i) _visibleLamps.push_back(i);
+    }
 
-        // Vehicle Controls - Calculate Proposed New Position
-        if (_keys[GLFW_KEY_W]) {
-            newPosition += forward * 0.2f;
-        }
-        if (_keys[GLFW_KEY_S]) {
-            newPosition += backward * 0.2f;
-        }
-        if ((_keys[GLFW_KEY_W] || _keys[GLFW_KEY_S])) {
-            if (isMovementValid(newPosition)) {
-                // Apply movement
-                if (_keys[GLFW_KEY_W]) {
-                    _pVehicle->driveForward();
-                }
-                if (_keys[GLFW_KEY_S]) {
-                    _pVehicle->driveBackward();
-                }
-                moved = true;
-            } else {
-                // Collision detected
-                glm::vec3 backupDirection = (_keys[GLFW_KEY_W]) ? -forward : forward;
-                glm::vec3 backupPosition = currentPosition + backupDirection * BACKUP_DISTANCE;
-
-                // Check if backup position is valid
-                if (isMovementValid(backupPosition)) {
-                    _pVehicle->setPosition(backupPosition);
-                    moved = true;
-                }
-            }
-        }
+    // front-to-back so early depth testing rejects whatever is hidden behind nearer scenery
+    _sortFrontToBack(_visibleTrees, eyePosition, true);
+    _sortFrontToBack(_visibleLamps, eyePosition, false);
+    _numNearTrees = _countNearScenery(_visibleTrees, eyePosition, true);
+    _numNearLamps = _countNearScenery(_visibleLamps, eyePosition, false);
 
-        // Handle Turning Independently
-        if (_keys[GLFW_KEY_A]) {
-            _pVehicle->turnLeft();
+    _butterflySwarm.setInstances(_swarmInstances);
+}
+
+void MPEngine::_getHeroPlacement(HeroType hero, glm::vec3& position, float& heading) const {
+    if (hero == HeroType::VEHICLE) {
+        position = _pVehicle->getPosition();
+        heading = _pVehicle->getHeading();
+    } else if (hero == HeroType::UFO) {
+        position = _pUFO->getPosition();
+        heading = _pUFO->getHeading();
+    } else {
+        position = _pButterfly->getPosition();
+        heading = _pButterfly->getHeading();
+    }
+}
+
+void MPEngine::_prepareInsetViews(GLint framebufferWidth, GLint framebufferHeight) {
+    const GLint MARGIN = 10;
+    const GLsizei SIZE = framebufferHeight / 4;
+    const GLint X = framebufferWidth - SIZE - MARGIN;
+
+    glm::vec3 heroPosition;
+    float heroHeading;
+    _getHeroPlacement(currHero, heroPosition, heroHeading);
+
+    _insetViews.clear();
+
+    // top-down minimap around the hero, -Z up
+    glm::mat4 minimapViewMtx = glm::lookAt(heroPosition + glm::vec3(0.0f, 50.0f, 0.0f), heroPosition, glm::vec3(0.0f, 0.0f, -1.0f));
+    glm::mat4 minimapProjMtx = glm::ortho(-MINIMAP_RADIUS, MINIMAP_RADIUS, -MINIMAP_RADIUS, MINIMAP_RADIUS, 1.0f, 100.0f);
+    _insetViews.addView(minimapViewMtx, minimapProjMtx, X, framebufferHeight - SIZE - MARGIN, SIZE, SIZE);
+
+    // chase camera behind the hero
+    glm::vec3 forward(sinf(heroHeading), 0.0f, cosf(heroHeading));
+    glm::mat4 heroCamViewMtx = glm::lookAt(heroPosition - forward * 6.0f + glm::vec3(0.0f, 3.0f, 0.0f),
+                                           heroPosition + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 heroCamProjMtx = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, _quality.farPlane);
+    _insetViews.addView(heroCamViewMtx, heroCamProjMtx, X, framebufferHeight - 2 * (SIZE + MARGIN), SIZE, SIZE);
+
+    // every object is tested once against all the inset frusta
+    _insetTrees.clear();
+    _insetLamps.clear();
+    for (GLuint i = 0; i < _trees.size(); ++i) {
+        GLuint viewMask = _insetViews.testBox(_trees[i].position + TREE_BOUNDS_MIN, _trees[i].position + TREE_BOUNDS_MAX);
+        if (viewMask != 0) _insetTrees.emplace_back(i, viewMask);
+    }
+    for (GLuint i = 0; i < _lamps.size(); ++i) {
+        GLuint viewMask = _insetViews.testBox(_lamps[i].position + LAMP_BOUNDS_MIN, _lamps[i].position + LAMP_BOUNDS_MAX);
+        if (viewMask != 0) _insetLamps.emplace_back(i, viewMask);
+    }
+}
+
+void MPEngine::_renderInsetViews() const {
+    const GLuint numViews = _insetViews.getNumViews();
+
+    // the insets go over the finished main view, keep every draw inside its own rectangle
+    _pRenderStateCache->setEnabled(GL_SCISSOR_TEST, true);
+    _pRenderStateCache->setDepthMask(GL_TRUE);
+
+    // the heroes and the ground are a handful of draws, they go view by view
+    for (GLuint i = 0; i < numViews; ++i) {
+        const MultiView::View& view = _insetViews.getView(i);
+        glViewport(view.viewport[0], view.viewport[1], view.viewport[2], view.viewport[3]);
+        glScissor(view.viewport[0], view.viewport[1], view.viewport[2], view.viewport[3]);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        _pRenderStateCache->setEnabled(GL_DEPTH_TEST, true);
+        _pRenderStateCache->setEnabled(GL_BLEND, false);
+        _pRenderStateCache->setEnabled(GL_CULL_FACE, false);
+        _pRenderStateCache->setDepthFunc(GL_LESS);
+        _pRenderStateCache->setDepthMask(GL_TRUE);
+
+        // the light uniforms are still set from the main view
+        _pRenderStateCache->useProgram(_lightingShaderProgram->getShaderProgramHandle());
+        glUniform3fv(_lightingShaderUniformLocations.viewPos, 1, glm::value_ptr(view.eyePosition));
+        _pVehicle->drawVehicle(view.viewMtx, view.projMtx);
+        _pUFO->drawUFO(view.viewMtx, view.projMtx);
+        _pButterfly->drawLucid(view.viewMtx, view.projMtx);
+
+        _drawGround(view.viewMtx, view.projMtx);
+    }
+
+    // The scenery is drawn once for all views, one instance per view it is visible in
+    _insetViews.applyViewports();
+    _pRenderStateCache->useProgram(_multiviewShaderProgram->getShaderProgramHandle());
+    _sendLightUniforms(_multiviewLightingUniformLocations);
+    glUniformMatrix4fv(_multiviewShaderUniformLocations.viewProjections, numViews, GL_FALSE, glm::value_ptr(_insetViews.getViewProjections()[0]));
+    glUniform3fv(_multiviewShaderUniformLocations.viewPositions, numViews, glm::value_ptr(_insetViews.getEyePositions()[0]));
+
+    // the insets are small, far detail is plenty
+    _sendMaterialUniforms(_multiviewLightingUniformLocations, TRUNK_MATERIAL);
+    _primitiveMeshes.bind(PrimitiveMeshes::Mesh::TREE_TRUNK, _farDetailLevel);
+    for (const std::pair<GLuint, GLuint>& tree : _insetTrees) {
+        _sendMultiviewModelUniforms(getInstanceMatrix(_trees[tree.first]), tree.second);
+        _primitiveMeshes.drawInstanced(PrimitiveMeshes::Mesh::TREE_TRUNK, _farDetailLevel, MultiView::countViews(tree.second));
+    }
+
+    _sendMaterialUniforms(_multiviewLightingUniformLocations, LEAVES_MATERIAL);
+    _primitiveMeshes.bind(PrimitiveMeshes::Mesh::TREE_LEAVES, _farDetailLevel);
+    for (const std::pair<GLuint, GLuint>& tree : _insetTrees) {
+        _sendMultiviewModelUniforms(glm::translate(getInstanceMatrix(_trees[tree.first]), glm::vec3(0.0f, TREE_LEAVES_HEIGHT, 0.0f)), tree.second);
+        _primitiveMeshes.drawInstanced(PrimitiveMeshes::Mesh::TREE_LEAVES, _farDetailLevel, MultiView::countViews(tree.second));
+    }
+
+    _sendMaterialUniforms(_multiviewLightingUniformLocations, POST_MATERIAL);
+    _primitiveMeshes.bind(PrimitiveMeshes::Mesh::LAMP_POST, _farDetailLevel);
+    for (const std::pair<GLuint, GLuint>& lamp : _insetLamps) {
+        _sendMultiviewModelUniforms(getInstanceMatrix(_lamps[lamp.first]), lamp.second);
+        _primitiveMeshes.drawInstanced(PrimitiveMeshes::Mesh::LAMP_POST, _farDetailLevel, MultiView::countViews(lamp.second));
+    }
+
+    _sendMaterialUniforms(_multiviewLightingUniformLocations, BULB_MATERIAL);
+    _primitiveMeshes.bind(PrimitiveMeshes::Mesh::LAMP_BULB, _farDetailLevel);
+    for (const std::pair<GLuint, GLuint>& lamp : _insetLamps) {
+        _sendMultiviewModelUniforms(glm::translate(getInstanceMatrix(_lamps[lamp.first]), glm::vec3(0.0f, LAMP_LIGHT_HEIGHT, 0.0f)), lamp.second);
+        _primitiveMeshes.drawInstanced(PrimitiveMeshes::Mesh::LAMP_BULB, _farDetailLevel, MultiView::countViews(lamp.second));
+    }
+
+    // the sky fills what is left of each view
+    for (GLuint i = 0; i < numViews; ++i) {
+        const MultiView::View& view = _insetViews.getView(i);
+        glViewport(view.viewport[0], view.viewport[1], view.viewport[2], view.viewport[3]);
+        glScissor(view.viewport[0], view.viewport[1], view.viewport[2], view.viewport[3]);
+        _renderSkyPass(view.viewMtx, view.projMtx);
+    }
+
+    // glClear honours the scissor test and the depth mask, leave both open for the next frame
+    _pRenderStateCache->setEnabled(GL_SCISSOR_TEST, false);
+    _pRenderStateCache->setDepthMask(GL_TRUE);
+}
+
+void MPEngine::_sendMultiviewModelUniforms(glm::mat4 modelMtx, GLuint viewMask) const {
+    glm::mat3 normalMtx = glm::transpose(glm::inverse(glm::mat3(modelMtx)));
+    glUniformMatrix4fv(_multiviewLightingUniformLocations.modelMatrix, 1, GL_FALSE, glm::value_ptr(modelMtx));
+    glUniformMatrix3fv(_multiviewLightingUniformLocations.normalMatrix, 1, GL_FALSE, glm::value_ptr(normalMtx));
+    glUniform1i(_multiviewShaderUniformLocations.viewMask, static_cast<GLint>(viewMask));
+}
+
+void MPEngine::_sortFrontToBack(std::vector<GLuint>& indices, glm::vec3 eyePosition, bool trees) {
+    FrameVector<std::pair<float, GLuint>> drawOrder{FrameAllocator<std::pair<float, GLuint>>(_pFrameArena)};
+    drawOrder.reserve(indices.size());
+    for (GLuint index : indices) {
+        glm::vec3 position = trees ? _trees[index].position : _lamps[index].position;
+        glm::vec3 offset = position - eyePosition;
+        drawOrder.emplace_back(glm::dot(offset, offset), index);
+    }
+    std::sort(drawOrder.begin(), drawOrder.end());
+    for (size_t i = 0; i < drawOrder.size(); ++i) {
+        indices[i] = drawOrder[i].second;
+    }
+}
+
+size_t MPEngine::_countNearScenery(const std::vector<GLuint>& indices, glm::vec3 eyePosition, bool trees) const {
+    // with a single detail level there is nothing to switch to
+    if (_farDetailLevel == _nearDetailLevel) return indices.size();
+
+    // the indices are sorted front to back, so the near ones come first
+    const float lodDistance = LOD_DISTANCE * _quality.lodBias;
+    size_t numNear = 0;
+    while (numNear < indices.size()) {
+        glm::vec3 position = trees ? _trees[indices[numNear]].position : _lamps[indices[numNear]].position;
+        glm::vec3 offset = position - eyePosition;
+        if (glm::dot(offset, offset) >= lodDistance * lodDistance) break;
+        ++numNear;
+    }
+    return numNear;
+}
+
+void MPEngine::_cullScenery(glm::mat4 viewMtx, glm::mat4 projMtx, glm::vec3 eyePosition) {
+    // Boxes inscribed in the trunk cylinder and the lower part of the leaves cone
+    const glm::vec3 TRUNK_OCCLUDER_MIN(-0.7f, 0.0f, -0.7f), TRUNK_OCCLUDER_MAX(0.7f, 5.0f, 0.7f);
+    const glm::vec3 LEAVES_OCCLUDER_MIN(-1.06f, 5.0f, -1.06f), LEAVES_OCCLUDER_MAX(1.06f, 9.0f, 1.06f);
+
+    _pOcclusionCuller->beginFrame(projMtx * viewMtx);
+
+    // the trees closest to the eye hide the most, rasterize only those
+    FrameVector<std::pair<float, GLuint>> occluderCandidates{FrameAllocator<std::pair<float, GLuint>>(_pFrameArena)};
+    occluderCandidates.reserve(_trees.size());
+    for (GLuint i = 0; i < _trees.size(); ++i) {
+        glm::vec3 offset = _trees[i].position - eyePosition;
+        occluderCandidates.emplace_back(glm::dot(offset, offset), i);
+    }
+    size_t numOccluders = std::min<size_t>(MAX_OCCLUDERS, occluderCandidates.size());
+    std::partial_sort(occluderCandidates.begin(), occluderCandidates.begin() + numOccluders, occluderCandidates.end());
+    for (size_t i = 0; i < numOccluders; ++i) {
+        glm::vec3 treePosition = _trees[occluderCandidates[i].second].position;
+        _pOcclusionCuller->addOccluder(treePosition + TRUNK_OCCLUDER_MIN, treePosition + TRUNK_OCCLUDER_MAX);
+        _pOcclusionCuller->addOccluder(treePosition + LEAVES_OCCLUDER_MIN, treePosition + LEAVES_OCCLUDER_MAX);
+    }
+    _pOcclusionCuller->buildHierarchy();
+
+    for (GLuint i = 0; i < _trees.size(); ++i) {
+        glm::vec3 treePosition = _trees[i].position;
+        if (_pOcclusionCuller->testBox(treePosition + TREE_BOUNDS_MIN, treePosition + TREE_BOUNDS_MAX) == OcclusionCuller::Result::VISIBLE) {
+            _visibleTrees.push_back(i);
+        }
+    }
+    for (GLuint i = 0; i < _lamps.size(); ++i) {
+        glm::vec3 lampPosition = _lamps[i].position;
+        if (_pOcclusionCuller->testBox(lampPosition + LAMP_BOUNDS_MIN, lampPosition + LAMP_BOUNDS_MAX) == OcclusionCuller::Result::VISIBLE) {
+            _visibleLamps.push_back(i);
+        }
+    }
+}
+
+void MPEngine::_checkFrameAllocations() {
+    _framesRendered++;
+    if (!_assertNoAllocations || !AllocationTracker::isEnabled()) return;
+
+    // the journal legitimately grows while recording
+    if (_framesRendered <= STEADY_STATE_FRAMES || _inputMode == InputMode::RECORD) return;
+
+    size_t allocations = AllocationTracker::getFrameAllocations();
+    if (allocations > 0) {
+        fprintf( stderr, "[ERROR]: frame %u made %zu heap allocations (%zu bytes) in steady state\n",
+                 _framesRendered, allocations, AllocationTracker::getFrameBytes() );
+        assert(allocations == 0);
+    }
+}
+
+void MPEngine::_updateScene() {
+    // feed recorded input for this tick before any state is read
+    if (_inputMode == InputMode::REPLAY) {
+        _replayEventsForTick();
+    }
+
+    // Check current hero type and handle movement for vehicles
+    if (currHero == HeroType::VEHICLE) {
+        bool moved = false;
+        glm::vec3 currentPosition = _pVehicle->getPosition();
+
+        // Vehicle Controls - move, then sweep the step against the collision world
+        if (_keys[GLFW_KEY_W] || _keys[GLFW_KEY_S]) {
+            if (_keys[GLFW_KEY_W]) {
+                _pVehicle->driveForward();
+            }
+            if (_keys[GLFW_KEY_S]) {
+                _pVehicle->driveBackward();
+            }
+            _pVehicle->setPosition(_resolveHeroMovement(HeroType::VEHICLE, currentPosition, _pVehicle->getPosition()));
+            moved = true;
+        }
+
+        // Handle Turning Independently
+        if (_keys[GLFW_KEY_A]) {
+            _pVehicle->turnLeft();
             moved = true;
         }
         if (_keys[GLFW_KEY_D]) {
@@ -802,51 +1568,20 @@ void MPEngine::_updateScene() {
             // Update camera target to the vehicle's position
             _pArcballCam->setTarget(_pVehicle->getPosition());
         }
-
-        // Bounds Checking to keep the vehicle within the scene
-        glm::vec3 pos = _pVehicle->getPosition();
-        float halfWorld = WORLD_SIZE;
-        pos.x = glm::clamp(pos.x, -halfWorld, halfWorld);
-        pos.z = glm::clamp(pos.z, -halfWorld, halfWorld);
-        _pVehicle->setPosition(pos);
     } else if (currHero == HeroType::UFO) {
         bool moved = false;
         glm::vec3 currentPosition = _pUFO->getPosition();
-        glm::vec3 newPosition = currentPosition;
 
-        // Calculate movement direction based on heading
-        glm::vec3 forward = glm::vec3(sin(_pUFO->getHeading()), 0.0f, cos(_pUFO->getHeading()));
-        glm::vec3 backward = -forward;
-
-        // UFO Controls - Calculate Proposed New Position
-        if (_keys[GLFW_KEY_W]) {
-            newPosition += forward * 0.2f; // Move forward
-        }
-        if (_keys[GLFW_KEY_S]) {
-            newPosition += backward * 0.2f; // Move backward
-        }
-        if ((_keys[GLFW_KEY_W] || _keys[GLFW_KEY_S])) {
-            if (isMovementValid(newPosition)) {
-                // Apply movement
-                if (_keys[GLFW_KEY_W]) {
-                    _pUFO->flyForward();
-                }
-                if (_keys[GLFW_KEY_S]) {
-                    _pUFO->flyBackward();
-                }
-                moved = true;
-            } else {
-                // Collision detected
-                glm::vec3 backupDirection = (_keys[GLFW_KEY_W]) ? -forward : forward;
-                glm::vec3 backupPosition = currentPosition + backupDirection * BACKUP_DISTANCE;
-
-                // Check if backup position is valid
-                if (isMovementValid(backupPosition)) {
-                    _pUFO->setPosition(backupPosition);
-                    moved = true;
-                }
-                // If backup position is not valid, we could log a message or handle differently
+        // UFO Controls - move, then sweep the step against the collision world
+        if (_keys[GLFW_KEY_W] || _keys[GLFW_KEY_S]) {
+            if (_keys[GLFW_KEY_W]) {
+                _pUFO->flyForward();
             }
+            if (_keys[GLFW_KEY_S]) {
+                _pUFO->flyBackward();
+            }
+            _pUFO->setPosition(_resolveHeroMovement(HeroType::UFO, currentPosition, _pUFO->getPosition()));
+            moved = true;
         }
 
         // Handle Turning Independently
@@ -863,51 +1598,20 @@ void MPEngine::_updateScene() {
             // Update camera target to the UFO's position
             _pArcballCam->setTarget(_pUFO->getPosition());
         }
-
-        // Bounds Checking
-        glm::vec3 pos = _pUFO->getPosition();
-        float halfWorld = WORLD_SIZE;
-        pos.x = glm::clamp(pos.x, -halfWorld, halfWorld);
-        pos.z = glm::clamp(pos.z, -halfWorld, halfWorld);
-        _pUFO->setPosition(pos);
     } else if (currHero == HeroType::LUCID) {
         bool moved = false;
         glm::vec3 currentPosition = _pButterfly->getPosition();
-        glm::vec3 newPosition = currentPosition;
-
-        // Calculate movement direction based on heading
-        glm::vec3 forward = glm::vec3(sin(_pButterfly->getHeading()), 0.0f, cos(_pButterfly->getHeading()));
-        glm::vec3 backward = -forward;
 
-        // Controls - Calculate Proposed New Position
-        if (_keys[GLFW_KEY_W]) {
-            newPosition += forward * 0.2f; // Move forward
-        }
-        if (_keys[GLFW_KEY_S]) {
-            newPosition += backward * 0.2f; // Move backward
-        }
-        if ((_keys[GLFW_KEY_W] || _keys[GLFW_KEY_S])) {
-            if (isMovementValid(newPosition)) {
-                // Apply movement
-                if (_keys[GLFW_KEY_W]) {
-                    _pButterfly->moveForward();
-                }
-                if (_keys[GLFW_KEY_S]) {
-                    _pButterfly->moveBackward();
-                }
-                moved = true;
-            } else {
-                // Collision detected
-                glm::vec3 backupDirection = (_keys[GLFW_KEY_W]) ? -forward : forward;
-                glm::vec3 backupPosition = currentPosition + backupDirection * BACKUP_DISTANCE;
-
-                // Check if backup position is valid
-                if (isMovementValid(backupPosition)) {
-                    _pButterfly->setPosition(backupPosition);
-                    moved = true;
-                }
-                // If backup position is not valid, we could log a message or handle differently
+        // Controls - move, then sweep the step against the collision world
+        if (_keys[GLFW_KEY_W] || _keys[GLFW_KEY_S]) {
+            if (_keys[GLFW_KEY_W]) {
+                _pButterfly->moveForward();
+            }
+            if (_keys[GLFW_KEY_S]) {
+                _pButterfly->moveBackward();
             }
+            _pButterfly->setPosition(_resolveHeroMovement(HeroType::LUCID, currentPosition, _pButterfly->getPosition()));
+            moved = true;
         }
 
         // Handle Turning Independently
@@ -924,13 +1628,6 @@ void MPEngine::_updateScene() {
             // Update camera target to position
             _pArcballCam->setTarget(_pButterfly->getPosition());
         }
-
-        // Bounds Checking
-        glm::vec3 pos = _pButterfly->getPosition();
-        float halfWorld = WORLD_SIZE;
-        pos.x = glm::clamp(pos.x, -halfWorld, halfWorld);
-        pos.z = glm::clamp(pos.z, -halfWorld, halfWorld);
-        _pButterfly->setPosition(pos);
     }
 
     // Handle Free Camera Movement
@@ -982,11 +1679,92 @@ void MPEngine::_updateScene() {
             _pFPCam->updatePositionAndOrientation(_pButterfly->getPosition(), _pButterfly->getHeading());
         }
     }
+    _updateCameraCollision();
+
+    _updateAgents();
+    _updateSwarm();
+    _updateSceneQuery();
+
+    _simulationTick++;
+}
+
+void MPEngine::_getCameraMatrices(GLint framebufferWidth, GLint framebufferHeight, glm::mat4& viewMtx, glm::mat4& projMtx) const {
+    // every camera draws out to the quality tier's far plane
+    projMtx = glm::perspective(glm::radians(45.0f),
+                               static_cast<float>(framebufferWidth) / framebufferHeight,
+                               0.1f, _quality.farPlane);
+    if (currCamera == CameraType::ARCBALL) {
+        viewMtx = _pArcballCam->getViewMatrix();
+    }
+    else if (currCamera == CameraType::FREECAM) {
+        viewMtx = _pFreeCam->getViewMatrix();
+    }
+
+    if (currCamera == CameraType::FIRSTPERSON) {
+        //set the view mtx to the first person camera
+        viewMtx = _pFPCam->getViewMatrix();
+    }
+}
+
+void MPEngine::_beginMainView(GLint framebufferWidth, GLint framebufferHeight) {
+    _dynamicResolution.setHDR(_postProcessEnabled);
+    if (_isSceneOffscreen()) {
+        _dynamicResolution.beginScene(_gpuResources, *_pRenderStateCache, framebufferWidth, framebufferHeight);
+    }
+}
+
+void MPEngine::_endMainView(GLint framebufferWidth, GLint framebufferHeight) {
+    if (_postProcessEnabled) {
+        _dynamicResolution.endSceneInTarget();
+        _postProcess.apply(_gpuResources, *_pRenderStateCache,
+                           _dynamicResolution.getColorTexture(),
+                           _dynamicResolution.getRenderWidth(), _dynamicResolution.getRenderHeight(),
+                           _dynamicResolution.getTargetWidth(), _dynamicResolution.getTargetHeight(),
+                           0, framebufferWidth, framebufferHeight);
+    } else if (_isSceneScaled()) {
+        _dynamicResolution.endScene();
+    }
+}
+
+void MPEngine::_togglePostProcessPass(PostProcess::Pass pass) {
+    _postProcess.setPassEnabled(pass, !_postProcess.isPassEnabled(pass));
+    fprintf( stdout, "[INFO]: post-process pass %s %s\n", PostProcess::getPassName(pass),
+             (_postProcess.isPassEnabled(pass) ? "on" : "off") );
+}
+
+void MPEngine::_startFramePacing() {
+    double refreshRate = 0.0;
+    const GLFWvidmode* pVideoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    if (pVideoMode != nullptr) refreshRate = pVideoMode->refreshRate;
+
+    _framePacer.setPacing(_framePacingEnabled, refreshRate);
+    if (_framePacingEnabled) {
+        if (_framePacer.isPacing()) {
+            fprintf( stdout, "[INFO]: pacing frames to a %.0f Hz display\n", refreshRate );
+        } else {
+            fprintf( stderr, "[ERROR]: could not read the display refresh rate, frame pacing is off\n" );
+        }
+    }
 }
 
 void MPEngine::run() {
+    _startFramePacing();
 
     while (!glfwWindowShouldClose(mpWindow)) { // Check if the window was instructed to be closed
+        // everything allocated from the arena last frame is dead now
+        _pFrameArena->reset();
+        AllocationTracker::beginFrame();
+        _gpuResources.beginFrame();
+        if (_glStatsEnabled) GLStats::beginFrame();
+
+        // Sample input as late as possible, then simulate and draw this frame from it
+        _framePacer.waitForInput();
+        glfwPollEvents();
+        _framePacer.inputSampled();
+        _updateScene();
+        // the particles advance on the GPU, outside the simulation the headless replay runs
+        _updateParticles();
+
         glDrawBuffer(GL_BACK); // Work with our back frame buffer
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Clear the current color contents and depth buffer in the window
 
@@ -997,35 +1775,1136 @@ void MPEngine::run() {
         glViewport(0, 0, framebufferWidth, framebufferHeight);
         glm::mat4 projMtx;
         glm::mat4 viewMtx;
+        _getCameraMatrices(framebufferWidth, framebufferHeight, viewMtx, projMtx);
 
-        if (currCamera == CameraType::ARCBALL) {
-            projMtx = glm::perspective(glm::radians(45.0f),
-                                       static_cast<float>(framebufferWidth) / framebufferHeight,
-                                       0.1f, 100.0f);
-            viewMtx = _pArcballCam->getViewMatrix();
+        // Cull the scenery, then draw the scene
+        _prepareFrame(viewMtx, projMtx);
+        _beginMainView(framebufferWidth, framebufferHeight);
+        _renderScene(viewMtx, projMtx);
+        _endMainView(framebufferWidth, framebufferHeight);
+
+        // Minimap and hero cam over the corner, both from a single traversal
+        if (_insetViewsEnabled) {
+            _prepareInsetViews(framebufferWidth, framebufferHeight);
+            _renderInsetViews();
         }
-        else if (currCamera == CameraType::FREECAM) {
-            projMtx = _pFreeCam->getProjectionMatrix();
-            viewMtx = _pFreeCam->getViewMatrix();
+
+        _pTransformRing->endFrame();
+        // the overlay's own calls are left out of the count it shows
+        if (_glStatsEnabled) {
+            GLStats::endFrame();
+            _drawStatsOverlay(framebufferWidth, framebufferHeight);
         }
+        _framePacer.workDone();
+        glfwSwapBuffers(mpWindow);
+        _framePacer.frameSwapped();
 
-        if (currCamera == CameraType::FIRSTPERSON) {
-            //set the view mtx and proj mtx to the first person cameras
-            projMtx = glm::perspective(glm::radians(45.0f),
-                                       static_cast<float>(framebufferWidth) / framebufferHeight,
-                                       0.1f, 100.0f);
-            viewMtx = _pFPCam->getViewMatrix();
+        _checkFrameAllocations();
+
+        if (_inputMode == InputMode::REPLAY && _isReplayFinished()) {
+            fprintf( stdout, "[INFO]: replay finished after %u ticks\n", _simulationTick );
+            setWindowShouldClose();
         }
+    }
 
-        // Draw the scene
-        _renderScene(viewMtx, projMtx);
+    FrameStats::Summary latency = FrameStats::summarize(_framePacer.getLatencyHistory());
+    if (latency.count > 0) {
+        fprintf( stdout, "[INFO]: input to swap latency over the last %zu frames: p50 %.2f ms, p95 %.2f ms, max %.2f ms\n",
+                 latency.count, latency.p50, latency.p95, latency.max );
+    }
+
+    if (_inputMode == InputMode::RECORD) {
+        _inputJournal.setTickCount(_simulationTick);
+        _inputJournal.save(_journalFilename.c_str());
+    }
+}
+
+//*************************************************************************************
+//
+// Benchmarking
+
+void MPEngine::runBenchmark(const char* outputFilename) {
+    const float DENSITIES[] = {0.02f, 0.1f, 0.25f, 0.5f, 1.0f};
+    const unsigned int BENCHMARK_SEED = 441;
+
+    // the ground level walk runs twice so the occlusion culling gain shows up directly
+    const struct {
+        CameraType type;
+        const char* name;
+        CameraPath path;
+        bool occlusionCulling;
+    } RUNS[] = {
+        {CameraType::ARCBALL,     "arcball",     CameraPath::arcballOrbit(WORLD_SIZE),    true},
+        {CameraType::FREECAM,     "freecam",     CameraPath::freeCamFlyover(WORLD_SIZE),  true},
+        {CameraType::FIRSTPERSON, "firstperson", CameraPath::firstPersonWalk(WORLD_SIZE), true},
+        {CameraType::FIRSTPERSON, "firstperson", CameraPath::firstPersonWalk(WORLD_SIZE), false}
+    };
+
+    FILE* fp = fopen(outputFilename, "w");
+    if(!fp) {
+        fprintf( stderr, "[ERROR]: Could not open benchmark output \"%s\"\n", outputFilename );
+        return;
+    }
+
+    // measure the work itself, not the display refresh rate
+    glfwSwapInterval(0);
+
+    CameraType previousCamera = currCamera;
+    bool previousOcclusionCulling = _occlusionCullingEnabled;
+    fprintf(fp, "{\n  \"benchmark\": \"flythrough\",\n  \"frameRate\": %.1f,\n  \"seed\": %u,\n  \"runs\": [", BENCHMARK_FRAME_RATE, BENCHMARK_SEED);
+
+    bool firstRun = true;
+    bool aborted = false;
+    for(float density : DENSITIES) {
+        regenerateEnvironment(density, BENCHMARK_SEED);
+
+        for(const auto& run : RUNS) {
+            FrameStats stats(run.name);
+            fprintf( stdout, "[INFO]: benchmarking %s camera at density %.2f (%zu trees, %zu lamps), occlusion culling %s\n",
+                     run.name, density, _trees.size(), _lamps.size(), (run.occlusionCulling ? "on" : "off") );
+            if(!_runFlythrough(run.type, run.path, run.occlusionCulling, stats)) {
+                aborted = true;
+                break;
+            }
+
+            fprintf(fp, "%s\n    {\n", (firstRun ? "" : ","));
+            fprintf(fp, "      \"camera\": \"%s\",\n", run.name);
+            fprintf(fp, "      \"density\": %.3f,\n", density);
+            fprintf(fp, "      \"trees\": %zu,\n", _trees.size());
+            fprintf(fp, "      \"lamps\": %zu,\n", _lamps.size());
+            fprintf(fp, "      \"occlusionCulling\": %s,\n", (run.occlusionCulling ? "true" : "false"));
+            stats.writeJsonFields(fp, "      ");
+            fprintf(fp, "\n    }");
+            firstRun = false;
+        }
+        if(aborted) break;
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+    fclose(fp);
+
+    currCamera = previousCamera;
+    _occlusionCullingEnabled = previousOcclusionCulling;
+    glfwSwapInterval(1);
 
-        // Update the scene based on input
+    if(aborted) {
+        fprintf( stdout, "[INFO]: benchmark aborted, partial results written to %s\n", outputFilename );
+    } else {
+        fprintf( stdout, "[INFO]: benchmark results written to %s\n", outputFilename );
+    }
+}
+
+void MPEngine::_applyCameraKey(CameraType cameraType, const CameraKey& key) {
+    if (cameraType == CameraType::ARCBALL) {
+        _pArcballCam->setTarget(key.position);
+        _pArcballCam->setOrientation(key.theta, key.phi, key.radius);
+    } else if (cameraType == CameraType::FREECAM) {
+        _pFreeCam->setPosition(key.position);
+        _pFreeCam->setTheta(key.theta);
+        _pFreeCam->setPhi(key.phi);
+        _pFreeCam->recomputeOrientation();
+    } else if (cameraType == CameraType::FIRSTPERSON) {
+        _pFPCam->updatePositionAndOrientation(key.position, key.theta);
+    }
+}
+
+bool MPEngine::_runFlythrough(CameraType cameraType, const CameraPath& path, bool occlusionCulling, FrameStats& stats) {
+    typedef std::chrono::high_resolution_clock Clock;
+
+    currCamera = cameraType;
+    _occlusionCullingEnabled = occlusionCulling;
+
+    // fixed simulation step so every run renders exactly the same frames
+    const GLuint NUM_FRAMES = static_cast<GLuint>(path.getDuration() * BENCHMARK_FRAME_RATE) + 1;
+    GpuTimer gpuTimer;
+    Clock::time_point lastSwap = Clock::now();
+
+    for(GLuint frame = 0; frame < BENCHMARK_WARMUP_FRAMES + NUM_FRAMES; ++frame) {
+        if(glfwWindowShouldClose(mpWindow)) return false;
+
+        bool recording = frame >= BENCHMARK_WARMUP_FRAMES;
+        GLuint pathFrame = recording ? frame - BENCHMARK_WARMUP_FRAMES : 0;
+
+        _pFrameArena->reset();
+        AllocationTracker::beginFrame();
+        _gpuResources.beginFrame();
+        _pTransformRing->resetStats();
+
+        // same order as run(): input, simulation, then the frame drawn from them
+        glfwPollEvents();
+        Clock::time_point cpuStart = Clock::now();
         _updateScene();
+        // after the simulation, which puts the first person camera back on the hero
+        _applyCameraKey(cameraType, path.sample(pathFrame / BENCHMARK_FRAME_RATE));
+        if(recording) gpuTimer.begin();
+        _updateParticles();
+
+        glDrawBuffer(GL_BACK);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        GLint framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(mpWindow, &framebufferWidth, &framebufferHeight);
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
+
+        glm::mat4 projMtx;
+        glm::mat4 viewMtx;
+        _getCameraMatrices(framebufferWidth, framebufferHeight, viewMtx, projMtx);
+
+        _prepareFrame(viewMtx, projMtx);
+        _beginMainView(framebufferWidth, framebufferHeight);
+        _renderScene(viewMtx, projMtx);
+        _endMainView(framebufferWidth, framebufferHeight);
+
+        _pTransformRing->endFrame();
+        if(recording) gpuTimer.end();
+        Clock::time_point cpuEnd = Clock::now();
+
+        glfwSwapBuffers(mpWindow);
+        Clock::time_point swapEnd = Clock::now();
+        // read before the stats below allocate for their own samples
+        size_t heapAllocations = AllocationTracker::getFrameAllocations();
+
+        if(recording) {
+            stats.addCpuSample(std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count());
+            stats.addFrameSample(std::chrono::duration<double, std::milli>(swapEnd - lastSwap).count());
+            stats.addLatencySample(std::chrono::duration<double, std::milli>(swapEnd - cpuStart).count());
+            stats.addCounterSample("treesDrawn", static_cast<double>(_visibleTrees.size()));
+            stats.addCounterSample("lampsDrawn", static_cast<double>(_visibleLamps.size()));
+            if(occlusionCulling) {
+                const OcclusionCuller::Stats& cullStats = _pOcclusionCuller->getStats();
+                stats.addCounterSample("occludersRasterized", cullStats.occludersRasterized);
+                stats.addCounterSample("frustumCulled", cullStats.frustumCulled);
+                stats.addCounterSample("occluded", cullStats.occluded);
+            }
+            if(AllocationTracker::isEnabled()) {
+                stats.addCounterSample("heapAllocations", static_cast<double>(heapAllocations));
+            }
+            // should stay at zero, a wait means the ring is too small for the draw count
+            stats.addCounterSample("transformRingWaits", _pTransformRing->getStats().fenceWaits);
+
+            double gpuMs;
+            while(gpuTimer.popResult(gpuMs)) stats.addGpuSample(gpuMs);
+        }
+        lastSwap = swapEnd;
+    }
+
+    // collect the queries still in flight
+    double gpuMs;
+    while(gpuTimer.popResult(gpuMs, true)) stats.addGpuSample(gpuMs);
+    return true;
+}
+
+void MPEngine::runBandwidthBenchmark(const char* outputFilename) {
+    const struct {
+        VertexFormat format;
+        const char* name;
+    } VERTEX_FORMATS[] = {
+        {VertexFormat::FULL_FLOAT,      "fullFloat"},
+        {VertexFormat::COMPACT_HALF,    "compactHalf"},
+        {VertexFormat::COMPACT_SNORM16, "compactSnorm16"}
+    };
+
+    FILE* fp = fopen(outputFilename, "w");
+    if(!fp) {
+        fprintf( stderr, "[ERROR]: Could not open benchmark output \"%s\"\n", outputFilename );
+        return;
+    }
+
+    // rolling hills on a [-1,1] grid so the positions fit snorm16 without rescaling
+    const GLuint RESOLUTION = BANDWIDTH_GRID_RESOLUTION;
+    const GLfloat AMPLITUDE = 0.1f;
+    const GLfloat FREQUENCY = 12.0f;
+    std::vector<FullVertex> vertices;
+    vertices.reserve(RESOLUTION * RESOLUTION);
+    for(GLuint z = 0; z < RESOLUTION; ++z) {
+        for(GLuint x = 0; x < RESOLUTION; ++x) {
+            GLfloat u = x / static_cast<GLfloat>(RESOLUTION - 1);
+            GLfloat v = z / static_cast<GLfloat>(RESOLUTION - 1);
+            GLfloat px = u * 2.0f - 1.0f;
+            GLfloat pz = v * 2.0f - 1.0f;
+            GLfloat height = AMPLITUDE * sinf(FREQUENCY * px) * cosf(FREQUENCY * pz);
+            GLfloat slopeX = AMPLITUDE * FREQUENCY * cosf(FREQUENCY * px) * cosf(FREQUENCY * pz);
+            GLfloat slopeZ = -AMPLITUDE * FREQUENCY * sinf(FREQUENCY * px) * sinf(FREQUENCY * pz);
+            vertices.push_back({glm::vec3(px, height, pz), glm::normalize(glm::vec3(-slopeX, 1.0f, -slopeZ)), glm::vec2(u, v)});
+        }
+    }
+
+    std::vector<GLuint> indices;
+    indices.reserve((RESOLUTION - 1) * (RESOLUTION - 1) * 6);
+    for(GLuint z = 0; z < RESOLUTION - 1; ++z) {
+        for(GLuint x = 0; x < RESOLUTION - 1; ++x) {
+            GLuint corner = z * RESOLUTION + x;
+            indices.insert(indices.end(), {corner, corner + RESOLUTION, corner + 1,
+                                           corner + 1, corner + RESOLUTION, corner + RESOLUTION + 1});
+        }
+    }
+    // created on the array target so no vertex array picks it up, each test binds it to its own
+    glBindVertexArray(0);
+    GpuHandle indexBuffer = _gpuResources.createBuffer(GL_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW, "bandwidth IBO");
+
+    CSCI441::ShaderProgram* pShaderProgram = new CSCI441::ShaderProgram("shaders/bandwidth.vs.glsl", "shaders/bandwidth.fs.glsl");
+    GpuHandle programHandle = _gpuResources.trackExternal(GpuResourceType::PROGRAM, pShaderProgram->getShaderProgramHandle(), 0, "bandwidth program");
+
+    // measure the work itself, not the display refresh rate
+    glfwSwapInterval(0);
+
+    fprintf(fp, "{\n  \"benchmark\": \"bandwidth\",\n  \"vertices\": %zu,\n  \"indices\": %zu,\n  \"drawsPerFrame\": %u,\n  \"vertexFetch\": [",
+            vertices.size(), indices.size(), BANDWIDTH_DRAWS_PER_FRAME);
+
+    bool aborted = false;
+    for(size_t i = 0; i < sizeof(VERTEX_FORMATS) / sizeof(VERTEX_FORMATS[0]) && !aborted; ++i) {
+        FrameStats stats(VERTEX_FORMATS[i].name);
+        size_t vertexBufferBytes = 0;
+        fprintf( stdout, "[INFO]: benchmarking vertex fetch with the %s format\n", VERTEX_FORMATS[i].name );
+        if(!_runVertexFetchTest(VERTEX_FORMATS[i].format, vertices, pShaderProgram, indexBuffer.get(),
+                                static_cast<GLsizei>(indices.size()), stats, vertexBufferBytes)) {
+            aborted = true;
+            break;
+        }
+
+        fprintf(fp, "%s\n    {\n", (i == 0 ? "" : ","));
+        fprintf(fp, "      \"format\": \"%s\",\n", VERTEX_FORMATS[i].name);
+        fprintf(fp, "      \"stride\": %zu,\n", getVertexStride(VERTEX_FORMATS[i].format));
+        fprintf(fp, "      \"vertexBufferBytes\": %zu,\n", vertexBufferBytes);
+        stats.writeJsonFields(fp, "      ");
+        fprintf(fp, "\n    }");
+    }
+
+    fprintf(fp, "\n  ],\n  \"instanceUpload\": [");
+    for(int compact = 0; compact < 2 && !aborted; ++compact) {
+        const char* name = (compact ? "compactInstance" : "matrixPair");
+        FrameStats stats(name);
+        size_t bytesPerFrame = 0;
+        fprintf( stdout, "[INFO]: benchmarking instance upload with the %s layout\n", name );
+        if(!_runInstanceUploadTest(compact != 0, stats, bytesPerFrame)) {
+            aborted = true;
+            break;
+        }
+
+        fprintf(fp, "%s\n    {\n", (compact ? "," : ""));
+        fprintf(fp, "      \"layout\": \"%s\",\n", name);
+        fprintf(fp, "      \"instances\": %u,\n", BANDWIDTH_INSTANCES);
+        fprintf(fp, "      \"bytesPerFrame\": %zu,\n", bytesPerFrame);
+        stats.writeJsonFields(fp, "      ");
+        fprintf(fp, "\n    }");
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+    fclose(fp);
+
+    programHandle.reset();
+    delete pShaderProgram;
+    indexBuffer.reset();
+    // the tests bound programs and buffers behind the cache's back
+    _pRenderStateCache->invalidate();
+    glfwSwapInterval(1);
+
+    if(aborted) {
+        fprintf( stdout, "[INFO]: benchmark aborted, partial results written to %s\n", outputFilename );
+    } else {
+        fprintf( stdout, "[INFO]: benchmark results written to %s\n", outputFilename );
+    }
+}
+
+bool MPEngine::_runVertexFetchTest(VertexFormat format, const std::vector<FullVertex>& vertices, CSCI441::ShaderProgram* pShaderProgram,
+                                   GLuint indexBuffer, GLsizei numIndices, FrameStats& stats, size_t& vertexBufferBytes) {
+    typedef std::chrono::high_resolution_clock Clock;
+
+    // a tiny viewport keeps rasterization cheap so vertex fetch dominates
+    const GLsizei VIEWPORT_SIZE = 64;
+
+    std::vector<CompactVertex> compactVertices;
+    const void* pVertexData = vertices.data();
+    vertexBufferBytes = vertices.size() * sizeof(FullVertex);
+    if(format != VertexFormat::FULL_FLOAT) {
+        compactVertices.reserve(vertices.size());
+        for(const FullVertex& vertex : vertices) {
+            compactVertices.push_back(packVertex(vertex, format));
+        }
+        pVertexData = compactVertices.data();
+        vertexBufferBytes = compactVertices.size() * sizeof(CompactVertex);
+    }
+
+    GpuHandle vao = _gpuResources.createVertexArray("bandwidth VAO");
+    GpuHandle vbo = _gpuResources.createBuffer(GL_ARRAY_BUFFER, vertexBufferBytes, pVertexData, GL_STATIC_DRAW, "bandwidth VBO");
+    setVertexAttributes(format, 0, 1, 2);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+    _pRenderStateCache->useProgram(pShaderProgram->getShaderProgramHandle());
+    _pRenderStateCache->setEnabled(GL_DEPTH_TEST, true);
+    _pRenderStateCache->setEnabled(GL_BLEND, false);
+    _pRenderStateCache->setEnabled(GL_CULL_FACE, false);
+    _pRenderStateCache->setDepthFunc(GL_LESS);
+    _pRenderStateCache->setDepthMask(GL_TRUE);
+    pShaderProgram->setProgramUniform(pShaderProgram->getUniformLocation("octahedralNormals"), (format == VertexFormat::FULL_FLOAT ? 0 : 1));
+    // looking straight down at the grid
+    glm::mat4 mvpMtx = glm::rotate(glm::mat4(1.0f), static_cast<GLfloat>(M_PI) / 2.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+    pShaderProgram->setProgramUniform(pShaderProgram->getUniformLocation("mvpMatrix"), mvpMtx);
+
+    const double BYTES_PER_FRAME = static_cast<double>(vertexBufferBytes) * BANDWIDTH_DRAWS_PER_FRAME;
+    GpuTimer gpuTimer;
+    Clock::time_point lastSwap = Clock::now();
+    bool completed = true;
+    for(GLuint frame = 0; frame < BENCHMARK_WARMUP_FRAMES + BANDWIDTH_FRAMES; ++frame) {
+        if(glfwWindowShouldClose(mpWindow)) {
+            completed = false;
+            break;
+        }
+
+        bool recording = frame >= BENCHMARK_WARMUP_FRAMES;
+        Clock::time_point cpuStart = Clock::now();
+        if(recording) gpuTimer.begin();
+
+        glDrawBuffer(GL_BACK);
+        glViewport(0, 0, VIEWPORT_SIZE, VIEWPORT_SIZE);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for(GLuint draw = 0; draw < BANDWIDTH_DRAWS_PER_FRAME; ++draw) {
+            glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, (void*)0);
+        }
+
+        if(recording) gpuTimer.end();
+        Clock::time_point cpuEnd = Clock::now();
 
         glfwSwapBuffers(mpWindow);
         glfwPollEvents();
+        Clock::time_point swapEnd = Clock::now();
+
+        if(recording) {
+            stats.addCpuSample(std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count());
+            stats.addFrameSample(std::chrono::duration<double, std::milli>(swapEnd - lastSwap).count());
+            double gpuMs;
+            while(gpuTimer.popResult(gpuMs)) {
+                stats.addGpuSample(gpuMs);
+                stats.addCounterSample("vertexGBps", BYTES_PER_FRAME / (gpuMs * 1.0e6));
+            }
+        }
+        lastSwap = swapEnd;
+    }
+
+    // collect the queries still in flight
+    double gpuMs;
+    while(completed && gpuTimer.popResult(gpuMs, true)) {
+        stats.addGpuSample(gpuMs);
+        stats.addCounterSample("vertexGBps", BYTES_PER_FRAME / (gpuMs * 1.0e6));
     }
+    glBindVertexArray(0);
+    return completed;
+}
+
+bool MPEngine::_runInstanceUploadTest(bool compact, FrameStats& stats, size_t& bytesPerFrame) {
+    typedef std::chrono::high_resolution_clock Clock;
+
+    // the placements are rebuilt and streamed every frame, as a moving or paged world would
+    const GLuint GRID_WIDTH = 128;
+    bytesPerFrame = BANDWIDTH_INSTANCES * (compact ? sizeof(CompactInstance) : 2 * sizeof(glm::mat4));
+    std::vector<glm::mat4> matrixInstances;
+    std::vector<CompactInstance> compactInstances;
+    if(compact) {
+        compactInstances.reserve(BANDWIDTH_INSTANCES);
+    } else {
+        matrixInstances.reserve(2 * BANDWIDTH_INSTANCES);
+    }
+
+    glBindVertexArray(0);
+    GpuHandle instanceBuffer = _gpuResources.createBuffer(GL_ARRAY_BUFFER, bytesPerFrame, nullptr, GL_STREAM_DRAW, "bandwidth instance VBO");
+
+    GpuTimer gpuTimer;
+    Clock::time_point lastSwap = Clock::now();
+    bool completed = true;
+    for(GLuint frame = 0; frame < BENCHMARK_WARMUP_FRAMES + BANDWIDTH_FRAMES; ++frame) {
+        if(glfwWindowShouldClose(mpWindow)) {
+            completed = false;
+            break;
+        }
+
+        bool recording = frame >= BENCHMARK_WARMUP_FRAMES;
+        Clock::time_point cpuStart = Clock::now();
+        if(recording) gpuTimer.begin();
+
+        matrixInstances.clear();
+        compactInstances.clear();
+        for(GLuint i = 0; i < BANDWIDTH_INSTANCES; ++i) {
+            glm::vec3 position(static_cast<GLfloat>(i % GRID_WIDTH) * 2.0f - GRID_WIDTH, 0.0f,
+                               static_cast<GLfloat>(i / GRID_WIDTH) * 2.0f - GRID_WIDTH);
+            if(compact) {
+                compactInstances.push_back(packInstance(position));
+            } else {
+                // the trunk and leaves matrices a TreeData used to hold
+                glm::mat4 trunkMtx = glm::translate(glm::mat4(1.0f), position);
+                matrixInstances.push_back(trunkMtx);
+                matrixInstances.push_back(glm::translate(trunkMtx, glm::vec3(0.0f, TREE_LEAVES_HEIGHT, 0.0f)));
+            }
+        }
+        // orphan the previous contents so the upload does not wait on the GPU
+        glBufferData(GL_ARRAY_BUFFER, bytesPerFrame, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytesPerFrame, (compact ? static_cast<const void*>(compactInstances.data()) : matrixInstances.data()));
+
+        if(recording) gpuTimer.end();
+        Clock::time_point cpuEnd = Clock::now();
+
+        glfwSwapBuffers(mpWindow);
+        glfwPollEvents();
+        Clock::time_point swapEnd = Clock::now();
+
+        if(recording) {
+            double cpuMs = std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count();
+            stats.addCpuSample(cpuMs);
+            stats.addFrameSample(std::chrono::duration<double, std::milli>(swapEnd - lastSwap).count());
+            stats.addCounterSample("uploadGBps", bytesPerFrame / (cpuMs * 1.0e6));
+            double gpuMs;
+            while(gpuTimer.popResult(gpuMs)) stats.addGpuSample(gpuMs);
+        }
+        lastSwap = swapEnd;
+    }
+
+    double gpuMs;
+    while(completed && gpuTimer.popResult(gpuMs, true)) stats.addGpuSample(gpuMs);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return completed;
+}
+
+void MPEngine::runParticleBenchmark(const char* outputFilename) {
+    const GLuint PARTICLE_COUNTS[] = {4096, 16384, 65536, 262144, 1048576};
+
+    FILE* fp = fopen(outputFilename, "w");
+    if(!fp) {
+        fprintf( stderr, "[ERROR]: Could not open benchmark output \"%s\"\n", outputFilename );
+        return;
+    }
+
+    // measure the work itself, not the display refresh rate
+    glfwSwapInterval(0);
+
+    fprintf(fp, "{\n  \"benchmark\": \"particles\",\n  \"frames\": %u,\n  \"runs\": [", PARTICLE_BENCHMARK_FRAMES);
+
+    bool firstRun = true;
+    bool aborted = false;
+    for(GLuint numParticles : PARTICLE_COUNTS) {
+        for(int gpu = 1; gpu >= 0 && !aborted; --gpu) {
+            const char* path = (gpu ? "gpu" : "cpu");
+            FrameStats stats(path);
+            fprintf( stdout, "[INFO]: benchmarking %u particles simulated on the %s\n", numParticles, path );
+            if(!_runParticleTest(numParticles, gpu != 0, stats)) {
+                aborted = true;
+                break;
+            }
+
+            fprintf(fp, "%s\n    {\n", (firstRun ? "" : ","));
+            fprintf(fp, "      \"simulation\": \"%s\",\n", path);
+            fprintf(fp, "      \"particles\": %u,\n", numParticles);
+            stats.writeJsonFields(fp, "      ");
+            fprintf(fp, "\n    }");
+            firstRun = false;
+        }
+        if(aborted) break;
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+    fclose(fp);
+
+    glfwSwapInterval(1);
+
+    if(aborted) {
+        fprintf( stdout, "[INFO]: benchmark aborted, partial results written to %s\n", outputFilename );
+    } else {
+        fprintf( stdout, "[INFO]: benchmark results written to %s\n", outputFilename );
+    }
+}
+
+bool MPEngine::_runParticleTest(GLuint numParticles, bool gpuSimulation, FrameStats& stats) {
+    typedef std::chrono::high_resolution_clock Clock;
+
+    // one fountain in front of the camera, every particle alive and on screen
+    ParticleSystem particleSystem;
+    ParticleSystem::Emitter fountain = {};
+    fountain.radius = 0.5f;
+    fountain.velocity = glm::vec3(0.0f, 6.0f, 0.0f);
+    fountain.spread = 2.0f;
+    fountain.acceleration = glm::vec3(0.0f, -9.8f, 0.0f);
+    fountain.lifetime = 1.2f;
+    fountain.startColor = glm::vec4(1.0f, 0.8f, 0.3f, 0.5f);
+    fountain.endColor = glm::vec4(1.0f, 0.2f, 0.1f, 0.0f);
+    fountain.size = 0.05f;
+    fountain.active = true;
+    particleSystem.addEmitter(fountain, numParticles);
+    if(!particleSystem.create(_gpuResources, gpuSimulation)) return false;
+    if(particleSystem.isGpuSimulation() != gpuSimulation) {
+        fprintf( stderr, "[ERROR]: particle simulation fell back to the CPU, skipping the GPU run\n" );
+        return false;
+    }
+
+    GLint framebufferWidth, framebufferHeight;
+    glfwGetFramebufferSize(mpWindow, &framebufferWidth, &framebufferHeight);
+    glm::mat4 viewMtx = glm::lookAt(glm::vec3(0.0f, 2.0f, 8.0f), glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projMtx = glm::perspective(glm::radians(45.0f), static_cast<float>(framebufferWidth) / framebufferHeight, 0.1f, 100.0f);
+
+    _pRenderStateCache->setEnabled(GL_DEPTH_TEST, true);
+    _pRenderStateCache->setEnabled(GL_BLEND, true);
+    _pRenderStateCache->setEnabled(GL_CULL_FACE, false);
+    _pRenderStateCache->setDepthFunc(GL_LESS);
+    _pRenderStateCache->setDepthMask(GL_FALSE);
+
+    GpuTimer gpuTimer;
+    Clock::time_point lastSwap = Clock::now();
+    bool completed = true;
+    for(GLuint frame = 0; frame < BENCHMARK_WARMUP_FRAMES + PARTICLE_BENCHMARK_FRAMES; ++frame) {
+        if(glfwWindowShouldClose(mpWindow)) {
+            completed = false;
+            break;
+        }
+
+        bool recording = frame >= BENCHMARK_WARMUP_FRAMES;
+        Clock::time_point cpuStart = Clock::now();
+        if(recording) gpuTimer.begin();
+
+        glDrawBuffer(GL_BACK);
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        particleSystem.update(*_pRenderStateCache, PARTICLE_TIME_STEP);
+        particleSystem.draw(*_pRenderStateCache, viewMtx, projMtx);
+
+        if(recording) gpuTimer.end();
+        Clock::time_point cpuEnd = Clock::now();
+
+        glfwSwapBuffers(mpWindow);
+        glfwPollEvents();
+        Clock::time_point swapEnd = Clock::now();
+
+        if(recording) {
+            stats.addCpuSample(std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count());
+            stats.addFrameSample(std::chrono::duration<double, std::milli>(swapEnd - lastSwap).count());
+            stats.addCounterSample("updateUs", particleSystem.getStats().updateUs);
+            double gpuMs;
+            while(gpuTimer.popResult(gpuMs)) stats.addGpuSample(gpuMs);
+        }
+        lastSwap = swapEnd;
+    }
+
+    double gpuMs;
+    while(completed && gpuTimer.popResult(gpuMs, true)) stats.addGpuSample(gpuMs);
+    _pRenderStateCache->setDepthMask(GL_TRUE);
+    return completed;
+}
+
+void MPEngine::runFlockBenchmark(const char* outputFilename) {
+    const GLuint AGENT_COUNTS[] = {1024, 4096, 16384, 65536, 131072};
+    const unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    FILE* fp = fopen(outputFilename, "w");
+    if(!fp) {
+        fprintf( stderr, "[ERROR]: Could not open benchmark output \"%s\"\n", outputFilename );
+        return;
+    }
+
+    fprintf(fp, "{\n  \"benchmark\": \"flocking\",\n  \"ticks\": %u,\n  \"runs\": [", FLOCK_BENCHMARK_TICKS);
+
+    bool firstRun = true;
+    for(GLuint numAgents : AGENT_COUNTS) {
+        for(unsigned int numThreads : {1u, maxThreads}) {
+            FrameStats stats("flocking");
+            fprintf( stdout, "[INFO]: benchmarking %u flocking agents on %u thread(s)\n", numAgents, numThreads );
+            _runFlockTest(numAgents, numThreads, stats);
+
+            fprintf(fp, "%s\n    {\n", (firstRun ? "" : ","));
+            fprintf(fp, "      \"agents\": %u,\n", numAgents);
+            fprintf(fp, "      \"threads\": %u,\n", numThreads);
+            stats.writeJsonFields(fp, "      ");
+            fprintf(fp, "\n    }");
+            firstRun = false;
+            if(maxThreads == 1) break;
+        }
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+    fclose(fp);
+
+    fprintf( stdout, "[INFO]: benchmark results written to %s\n", outputFilename );
+}
+
+void MPEngine::_runFlockTest(GLuint numAgents, unsigned int numThreads, FrameStats& stats) {
+    typedef std::chrono::high_resolution_clock Clock;
+
+    // the swarm's setup over the current world, agents spread evenly through it
+    Flock flock(numThreads);
+    Flock::Parameters parameters;
+    parameters.boundsHalfSize = WORLD_SIZE * 0.9f;
+    parameters.minHeight = 0.5f;
+    parameters.maxHeight = 5.0f;
+    flock.setParameters(parameters);
+    for (const TreeData& tree : _trees) flock.addObstacle(glm::vec2(tree.position.x, tree.position.z), TREE_TRUNK_RADIUS);
+    for (const LampData& lamp : _lamps) flock.addObstacle(glm::vec2(lamp.position.x, lamp.position.z), LAMP_POST_RADIUS);
+
+    std::mt19937 random(_worldSeed);
+    std::uniform_real_distribution<float> horizontalDistribution(-parameters.boundsHalfSize, parameters.boundsHalfSize);
+    std::uniform_real_distribution<float> heightDistribution(parameters.minHeight, parameters.maxHeight);
+    std::uniform_real_distribution<float> headingDistribution(0.0f, glm::two_pi<float>());
+    for (GLuint i = 0; i < numAgents; ++i) {
+        float heading = headingDistribution(random);
+        flock.addAgent(glm::vec3(horizontalDistribution(random), heightDistribution(random), horizontalDistribution(random)),
+                       glm::vec3(parameters.maxSpeed * sinf(heading), 0.0f, parameters.maxSpeed * cosf(heading)));
+    }
+
+    for(GLuint tick = 0; tick < BENCHMARK_WARMUP_FRAMES + FLOCK_BENCHMARK_TICKS; ++tick) {
+        Clock::time_point start = Clock::now();
+        flock.update();
+        double tickMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        if(tick >= BENCHMARK_WARMUP_FRAMES) {
+            stats.addCpuSample(tickMs);
+            stats.addFrameSample(tickMs);
+            stats.addCounterSample("agentsPerMs", numAgents / std::max(tickMs, 1e-6));
+        }
+    }
+}
+
+void MPEngine::runPostProcessBenchmark(const char* outputFilename) {
+    const struct {
+        const char* name;
+        bool passes[PostProcess::NUM_PASSES];
+    } CONFIGS[] = {
+        {"toneMapOnly", {false, false, false, true}},
+        {"bloomHalf",   {true,  false, false, true}},
+        {"full",        {true,  true,  true,  true}}
+    };
+
+    FILE* fp = fopen(outputFilename, "w");
+    if(!fp) {
+        fprintf( stderr, "[ERROR]: Could not open benchmark output \"%s\"\n", outputFilename );
+        return;
+    }
+
+    // the chain draws into an LDR 1080p target whatever the window size
+    const GLint WIDTH = POST_PROCESS_BENCHMARK_WIDTH;
+    const GLint HEIGHT = POST_PROCESS_BENCHMARK_HEIGHT;
+    GLuint colorTexture;
+    glGenTextures(1, &colorTexture);
+    _pRenderStateCache->bindTexture(0, GL_TEXTURE_2D, colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, WIDTH, HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    GpuHandle colorHandle = _gpuResources.adopt(GpuResourceType::TEXTURE, colorTexture, static_cast<size_t>(WIDTH) * HEIGHT * 4, "post-process benchmark color");
+    GLuint framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if(!complete) {
+        fprintf( stderr, "[ERROR]: post-process benchmark target is incomplete\n" );
+        glDeleteFramebuffers(1, &framebuffer);
+        fclose(fp);
+        return;
+    }
+
+    bool wasPassEnabled[PostProcess::NUM_PASSES];
+    for(GLuint pass = 0; pass < PostProcess::NUM_PASSES; ++pass) {
+        wasPassEnabled[pass] = _postProcess.isPassEnabled(static_cast<PostProcess::Pass>(pass));
+    }
+
+    // measure the work itself, not the display refresh rate
+    glfwSwapInterval(0);
+
+    fprintf(fp, "{\n  \"benchmark\": \"postProcess\",\n  \"width\": %d,\n  \"height\": %d,\n  \"frames\": %u,\n  \"budgetMs\": %.3f,\n  \"runs\": [",
+            WIDTH, HEIGHT, POST_PROCESS_BENCHMARK_FRAMES, PostProcess::BUDGET_MS_1080P);
+
+    bool aborted = false;
+    for(size_t i = 0; i < sizeof(CONFIGS) / sizeof(CONFIGS[0]); ++i) {
+        for(GLuint pass = 0; pass < PostProcess::NUM_PASSES; ++pass) {
+            _postProcess.setPassEnabled(static_cast<PostProcess::Pass>(pass), CONFIGS[i].passes[pass]);
+        }
+        fprintf( stdout, "[INFO]: benchmarking post-processing, %s\n", CONFIGS[i].name );
+        if(!_runPostProcessTest(framebuffer)) {
+            aborted = true;
+            break;
+        }
+
+        fprintf(fp, "%s\n    {\n      \"config\": \"%s\",\n      \"passes\": [", (i == 0 ? "" : ","), CONFIGS[i].name);
+        double totalP50 = 0.0;
+        bool firstPass = true;
+        for(GLuint pass = 0; pass < PostProcess::NUM_PASSES; ++pass) {
+            FrameStats::Summary summary = FrameStats::summarize(_postProcess.getSamples(static_cast<PostProcess::Pass>(pass)));
+            if(summary.count == 0) continue;
+            totalP50 += summary.p50;
+            fprintf(fp, "%s\n        {\"pass\": \"%s\", \"count\": %zu, \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+                    (firstPass ? "" : ","), PostProcess::getPassName(static_cast<PostProcess::Pass>(pass)),
+                    summary.count, summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+            firstPass = false;
+        }
+        fprintf(fp, "\n      ],\n      \"totalP50Ms\": %.4f,\n      \"withinBudget\": %s\n    }",
+                totalP50, (totalP50 <= PostProcess::BUDGET_MS_1080P ? "true" : "false"));
+        fprintf( stdout, "[INFO]: %s takes %.3f ms at 1080p (p50), budget %.1f ms\n", CONFIGS[i].name, totalP50, PostProcess::BUDGET_MS_1080P );
+    }
+
+    fprintf(fp, "\n  ]\n}\n");
+    fclose(fp);
+
+    glfwSwapInterval(1);
+    _postProcess.setKeepSamples(false);
+    _postProcess.clearSamples();
+    for(GLuint pass = 0; pass < PostProcess::NUM_PASSES; ++pass) {
+        _postProcess.setPassEnabled(static_cast<PostProcess::Pass>(pass), wasPassEnabled[pass]);
+    }
+    glDeleteFramebuffers(1, &framebuffer);
+    colorHandle.reset();
+
+    if(aborted) {
+        fprintf( stdout, "[INFO]: benchmark aborted, partial results written to %s\n", outputFilename );
+    } else {
+        fprintf( stdout, "[INFO]: benchmark results written to %s\n", outputFilename );
+    }
+}
+
+bool MPEngine::_runPostProcessTest(GLuint framebuffer) {
+    const GLint WIDTH = POST_PROCESS_BENCHMARK_WIDTH;
+    const GLint HEIGHT = POST_PROCESS_BENCHMARK_HEIGHT;
+
+    // a fixed view over the lamps, the passes cost the same whatever the picture;
+    // the user's camera comes back however the test ends
+    CameraType previousCamera = currCamera;
+    currCamera = CameraType::ARCBALL;
+    glm::mat4 projMtx;
+    glm::mat4 viewMtx;
+    _getCameraMatrices(WIDTH, HEIGHT, viewMtx, projMtx);
+
+    _dynamicResolution.setHDR(true);
+    _postProcess.setKeepSamples(false);
+    for(GLuint frame = 0; frame < BENCHMARK_WARMUP_FRAMES + POST_PROCESS_BENCHMARK_FRAMES; ++frame) {
+        if(glfwWindowShouldClose(mpWindow)) {
+            currCamera = previousCamera;
+            return false;
+        }
+        if(frame == BENCHMARK_WARMUP_FRAMES) {
+            // results of the warmup frames still in flight are dropped with it
+            _postProcess.finishTimers();
+            _postProcess.clearSamples();
+            _postProcess.setKeepSamples(true);
+        }
+
+        _pFrameArena->reset();
+        AllocationTracker::beginFrame();
+        _gpuResources.beginFrame();
+
+        _prepareFrame(viewMtx, projMtx);
+        _dynamicResolution.beginScene(_gpuResources, *_pRenderStateCache, WIDTH, HEIGHT);
+        _renderScene(viewMtx, projMtx);
+        _dynamicResolution.endSceneInTarget();
+        _postProcess.apply(_gpuResources, *_pRenderStateCache,
+                           _dynamicResolution.getColorTexture(),
+                           _dynamicResolution.getRenderWidth(), _dynamicResolution.getRenderHeight(),
+                           _dynamicResolution.getTargetWidth(), _dynamicResolution.getTargetHeight(),
+                           framebuffer, WIDTH, HEIGHT);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        _pTransformRing->endFrame();
+
+        glfwSwapBuffers(mpWindow);
+        glfwPollEvents();
+    }
+    _postProcess.finishTimers();
+    currCamera = previousCamera;
+    return true;
+}
+
+void MPEngine::setQualitySettings(const QualitySettings& settings) {
+    _quality = settings;
+    // mSetupGLFW creates the window at this size
+    mWindowWidth = settings.windowWidth;
+    mWindowHeight = settings.windowHeight;
+    _applyQualitySettings();
+}
+
+void MPEngine::_applyQualitySettings() {
+    _dynamicResolution.setScaleLimit(_quality.renderScale);
+    _nearDetailLevel = PrimitiveMeshes::getDetailLevel(_quality.tessellation);
+    _farDetailLevel = std::max(0, _nearDetailLevel - 1);
+}
+
+void MPEngine::_logQualitySettings() const {
+    fprintf( stdout, "[INFO]: %s quality: far plane %.0f, LOD bias %.2f, %u point lights, render scale %.2f, tessellation %u\n",
+             QualitySettings::getTierName(_quality.tier), _quality.farPlane, _quality.lodBias,
+             _quality.lightLimit, _quality.renderScale, _quality.tessellation );
+}
+
+void MPEngine::selectQualityTier(double targetFrameMs) {
+    const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    if(renderer == nullptr) renderer = "an unknown renderer";
+    // llvmpipe, softpipe and SwiftShader rasterize on the CPU, their frames are long enough to need fewer of them
+    bool softwareRenderer = strstr(renderer, "llvmpipe") != nullptr || strstr(renderer, "softpipe") != nullptr ||
+                            strstr(renderer, "SwiftShader") != nullptr || strstr(renderer, "Software") != nullptr;
+    const GLuint numFrames = softwareRenderer ? QUALITY_BENCHMARK_SOFTWARE_FRAMES : QUALITY_BENCHMARK_FRAMES;
+    fprintf( stdout, "[INFO]: picking the quality tier for %.1f ms frames on %s%s\n",
+             targetFrameMs, renderer, (softwareRenderer ? " (software rasterizer)" : "") );
+
+    // measure the work itself, not the display refresh rate
+    glfwSwapInterval(0);
+
+    CameraType previousCamera = currCamera;
+    glm::vec3 previousTarget = _pArcballCam->getTarget();
+    float previousTheta = _pArcballCam->getTheta();
+    float previousPhi = _pArcballCam->getPhi();
+    float previousRadius = _pArcballCam->getRadius();
+
+    // each tier costs more than the one below, stop at the first that misses
+    QualitySettings::Tier selected = QualitySettings::Tier::LOW;
+    for(int i = 0; i < QualitySettings::NUM_TIERS; ++i) {
+        QualitySettings::Tier tier = static_cast<QualitySettings::Tier>(i);
+        _quality.setTier(tier);
+        _applyQualitySettings();
+
+        double meanFrameMs;
+        if(!_runQualityTest(numFrames, targetFrameMs, meanFrameMs)) break;
+        bool meetsTarget = meanFrameMs <= targetFrameMs;
+        fprintf( stdout, "[INFO]: %s quality runs at %.2f ms per frame%s\n",
+                 QualitySettings::getTierName(tier), meanFrameMs, (meetsTarget ? "" : ", over the target") );
+        if(!meetsTarget) break;
+        selected = tier;
+    }
+
+    _quality.setTier(selected);
+    _applyQualitySettings();
+    _logQualitySettings();
+
+    currCamera = previousCamera;
+    _pArcballCam->setTarget(previousTarget);
+    _pArcballCam->setOrientation(previousTheta, previousPhi, previousRadius);
+    glfwSwapInterval(1);
+}
+
+bool MPEngine::_runQualityTest(GLuint numFrames, double targetFrameMs, double& meanFrameMs) {
+    typedef std::chrono::high_resolution_clock Clock;
+
+    // one orbit over however many frames, so every tier draws the same views
+    const CameraPath path = CameraPath::arcballOrbit(WORLD_SIZE);
+    currCamera = CameraType::ARCBALL;
+
+    double totalMs = 0.0;
+    GLuint recordedFrames = 0;
+    Clock::time_point lastSwap = Clock::now();
+    for(GLuint frame = 0; frame < QUALITY_BENCHMARK_WARMUP_FRAMES + numFrames; ++frame) {
+        if(glfwWindowShouldClose(mpWindow)) return false;
+
+        bool recording = frame >= QUALITY_BENCHMARK_WARMUP_FRAMES;
+        GLuint pathFrame = recording ? frame - QUALITY_BENCHMARK_WARMUP_FRAMES : 0;
+        _applyCameraKey(CameraType::ARCBALL, path.sample(path.getDuration() * pathFrame / numFrames));
+
+        _pFrameArena->reset();
+        AllocationTracker::beginFrame();
+        _gpuResources.beginFrame();
+
+        // the simulation stands still, only the frame as run() draws it is timed
+        glfwPollEvents();
+        glDrawBuffer(GL_BACK);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        GLint framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(mpWindow, &framebufferWidth, &framebufferHeight);
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
+
+        glm::mat4 projMtx;
+        glm::mat4 viewMtx;
+        _getCameraMatrices(framebufferWidth, framebufferHeight, viewMtx, projMtx);
+
+        _prepareFrame(viewMtx, projMtx);
+        _beginMainView(framebufferWidth, framebufferHeight);
+        _renderScene(viewMtx, projMtx);
+        _endMainView(framebufferWidth, framebufferHeight);
+        if (_insetViewsEnabled) {
+            _prepareInsetViews(framebufferWidth, framebufferHeight);
+            _renderInsetViews();
+        }
+        _pTransformRing->endFrame();
+
+        glfwSwapBuffers(mpWindow);
+        Clock::time_point swapEnd = Clock::now();
+        if(recording) {
+            totalMs += std::chrono::duration<double, std::milli>(swapEnd - lastSwap).count();
+            ++recordedFrames;
+            // past this the mean cannot come back under the target
+            if(totalMs > targetFrameMs * numFrames) break;
+        }
+        lastSwap = swapEnd;
+    }
+
+    meanFrameMs = totalMs / recordedFrames;
+    return true;
+}
+
+//*************************************************************************************
+//
+// Input Recording and Replay
+
+void MPEngine::startRecording(const char* filename) {
+    _journalFilename = filename;
+    _inputJournal.clear();
+    _inputJournal.setWorld(_worldSeed, _environmentDensity);
+    _inputMode = InputMode::RECORD;
+}
+
+bool MPEngine::loadReplay(const char* filename) {
+    if (!_inputJournal.load(filename)) {
+        return false;
+    }
+
+    // rebuild the exact world the session was recorded in
+    _worldSeed = _inputJournal.getWorldSeed();
+    _environmentDensity = _inputJournal.getEnvironmentDensity();
+    _replayCursor = 0;
+    _simulationTick = 0;
+    _inputMode = InputMode::REPLAY;
+    return true;
+}
+
+bool MPEngine::runHeadless() {
+    if (_inputMode != InputMode::REPLAY) {
+        fprintf( stderr, "[ERROR]: headless mode requires a replay journal\n" );
+        return false;
+    }
+
+    // no window or GL context: build only the simulation state
+    _headless = true;
+    // a loaded scene already holds the world, the heroes take its poses once created
+    if (!_sceneLoaded) {
+        _generateEnvironment();
+    }
+    _createSceneObjects();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    while (!_isReplayFinished()) {
+        _pFrameArena->reset();
+        _updateScene();
+    }
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    // print the final state so runs can be compared for determinism
+    glm::vec3 vehiclePos = _pVehicle->getPosition();
+    glm::vec3 ufoPos = _pUFO->getPosition();
+    glm::vec3 butterflyPos = _pButterfly->getPosition();
+    glm::vec3 arcballPos = _pArcballCam->getPosition();
+    fprintf( stdout, "[INFO]: replayed %u ticks in %.3f ms (%.3f us/tick)\n",
+             _simulationTick, elapsedMs, (_simulationTick > 0 ? 1000.0 * elapsedMs / _simulationTick : 0.0) );
+    fprintf( stdout, "[INFO]: vehicle (%.4f, %.4f, %.4f) heading %.4f\n", vehiclePos.x, vehiclePos.y, vehiclePos.z, _pVehicle->getHeading() );
+    fprintf( stdout, "[INFO]: ufo (%.4f, %.4f, %.4f) heading %.4f\n", ufoPos.x, ufoPos.y, ufoPos.z, _pUFO->getHeading() );
+    fprintf( stdout, "[INFO]: butterfly (%.4f, %.4f, %.4f) heading %.4f\n", butterflyPos.x, butterflyPos.y, butterflyPos.z, _pButterfly->getHeading() );
+    fprintf( stdout, "[INFO]: arcball camera (%.4f, %.4f, %.4f)\n", arcballPos.x, arcballPos.y, arcballPos.z );
+    return true;
+}
+
+void MPEngine::_recordEvent(InputEventType type, GLint code, GLint action, GLint mods, glm::vec2 position) {
+    if (_inputMode != InputMode::RECORD) return;
+
+    InputEvent event = {};
+    event.tick = _simulationTick;
+    event.type = type;
+    event.code = code;
+    event.action = action;
+    event.mods = mods;
+    event.x = position.x;
+    event.y = position.y;
+    _inputJournal.record(event);
+}
+
+void MPEngine::_replayEventsForTick() {
+    const std::vector<InputEvent>& events = _inputJournal.getEvents();
+    while (_replayCursor < events.size() && events[_replayCursor].tick <= _simulationTick) {
+        const InputEvent& event = events[_replayCursor++];
+        switch (event.type) {
+            case InputEventType::KEY:
+                handleKeyEvent(event.code, event.action, event.mods);
+                break;
+            case InputEventType::MOUSE_BUTTON:
+                handleMouseButtonEvent(event.code, event.action, event.mods);
+                break;
+            case InputEventType::CURSOR_POSITION:
+                handleCursorPositionEvent(glm::vec2(event.x, event.y));
+                break;
+        }
+    }
+}
+
+bool MPEngine::_isReplayFinished() const {
+    return _replayCursor >= _inputJournal.getEvents().size() && _simulationTick >= _inputJournal.getTickCount();
+}
+
+//*************************************************************************************
+//
+// Scene Serialization
+
+bool MPEngine::saveScene(const char* filename) const {
+    // trees and lamps are already stored as scene records
+    const std::vector<SceneTreeRecord>& trees = _trees;
+    const std::vector<SceneLampRecord>& lamps = _lamps;
+
+    std::vector<SceneBuildingRecord> buildings;
+    buildings.reserve(_buildings.size());
+    for (const BuildingData& building : _buildings) {
+        buildings.push_back({building.modelMatrix, glm::vec4(building.color, 1.0f), glm::vec4(building.position, building.boundingRadius)});
+    }
+
+    // heroes are stored in HeroType order
+    std::vector<SceneHeroRecord> heroes;
+    if (_pVehicle != nullptr && _pUFO != nullptr && _pButterfly != nullptr) {
+        heroes.push_back({glm::vec4(_pVehicle->getPosition(), _pVehicle->getHeading())});
+        heroes.push_back({glm::vec4(_pUFO->getPosition(), _pUFO->getHeading())});
+        heroes.push_back({glm::vec4(_pButterfly->getPosition(), _pButterfly->getHeading())});
+    }
+
+    return SceneFile::write(filename, _worldSeed, _environmentDensity, trees, lamps, buildings, heroes);
+}
+
+bool MPEngine::loadScene(const char* filename) {
+    SceneFile sceneFile;
+    if (!sceneFile.open(filename)) {
+        return false;
+    }
+    const SceneFileHeader& header = sceneFile.getHeader();
+
+    // the mapped records are bulk copied, nothing is parsed; the copy is kept in
+    // the engine vectors because culling picks the instances to upload every frame
+    _trees.assign(sceneFile.getTrees(), sceneFile.getTrees() + header.treeCount);
+    _lamps.assign(sceneFile.getLamps(), sceneFile.getLamps() + header.lampCount);
+
+    const SceneBuildingRecord* pBuildings = sceneFile.getBuildings();
+    _buildings.resize(header.buildingCount);
+    for (uint32_t i = 0; i < header.buildingCount; ++i) {
+        _buildings[i] = {pBuildings[i].modelMatrix, glm::vec3(pBuildings[i].color),
+                         glm::vec3(pBuildings[i].positionRadius), pBuildings[i].positionRadius.w};
+    }
+
+    _loadedHeroes.assign(sceneFile.getHeroes(), sceneFile.getHeroes() + header.heroCount);
+
+    _worldSeed = header.worldSeed;
+    _environmentDensity = header.environmentDensity;
+    _sceneLoaded = true;
+
+    // if the heroes already exist move them now, otherwise once they are created
+    _applyLoadedHeroes();
+
+    fprintf( stdout, "[INFO]: loaded scene %s with %u trees, %u lamps, %u buildings\n",
+             filename, header.treeCount, header.lampCount, header.buildingCount );
+    return true;
+}
+
+void MPEngine::_applyLoadedHeroes() {
+    if (_loadedHeroes.empty() || _pVehicle == nullptr || _pUFO == nullptr || _pButterfly == nullptr) return;
+
+    if (_loadedHeroes.size() > 0) {
+        _pVehicle->setPosition(glm::vec3(_loadedHeroes[0].positionHeading));
+        _pVehicle->setHeading(_loadedHeroes[0].positionHeading.w);
+    }
+    if (_loadedHeroes.size() > 1) {
+        _pUFO->setPosition(glm::vec3(_loadedHeroes[1].positionHeading));
+        _pUFO->setHeading(_loadedHeroes[1].positionHeading.w);
+    }
+    if (_loadedHeroes.size() > 2) {
+        _pButterfly->setPosition(glm::vec3(_loadedHeroes[2].positionHeading));
+        _pButterfly->setHeading(_loadedHeroes[2].positionHeading.w);
+    }
+    _loadedHeroes.clear();
+
+    // keep the cameras on the active hero
+    glm::vec3 heroPosition = (currHero == HeroType::VEHICLE ? _pVehicle->getPosition()
+                            : currHero == HeroType::UFO ? _pUFO->getPosition()
+                            : _pButterfly->getPosition());
+    _pArcballCam->setTarget(heroPosition);
 }
 
 //*************************************************************************************
@@ -1034,48 +2913,144 @@ void MPEngine::run() {
 
 void MPEngine::mCleanupShaders() {
     fprintf( stdout, "[INFO]: ...deleting Shaders.\n" );
+    for (GpuHandle& programHandle : _programHandles) programHandle.reset();
     delete _lightingShaderProgram;
     delete _textureShaderProgram;
+    delete _skyboxShaderProgram;
+    delete _multiviewShaderProgram;
+    delete _swarmShaderProgram;
+    delete _overlayShaderProgram;
+    delete _bloomDownsampleShaderProgram;
+    delete _bloomUpsampleShaderProgram;
+    delete _toneMapShaderProgram;
+    _lightingShaderProgram = nullptr;
+    _textureShaderProgram = nullptr;
+    _skyboxShaderProgram = nullptr;
+    _multiviewShaderProgram = nullptr;
+    _swarmShaderProgram = nullptr;
+    _overlayShaderProgram = nullptr;
+    _bloomDownsampleShaderProgram = nullptr;
+    _bloomUpsampleShaderProgram = nullptr;
+    _toneMapShaderProgram = nullptr;
 }
 
 void MPEngine::mCleanupBuffers() {
     fprintf( stdout, "[INFO]: ...deleting VAOs....\n" );
     CSCI441::deleteObjectVAOs();
-    glDeleteVertexArrays( 1, &_groundVAO );
+    _primitiveMeshes.release();
+    _groundVAO.reset();
+    _skyboxVAO.reset();
 
     fprintf( stdout, "[INFO]: ...deleting VBOs....\n" );
     CSCI441::deleteObjectVBOs();
+    _groundVBO.reset();
+    _groundIBO.reset();
+    _skyboxVBO.reset();
+    _skyboxEBO.reset();
+
+    _pTransformRing->release();
+    _particleSystem.release();
+    _butterflySwarm.release();
+    _statsOverlay.release();
+
+    fprintf( stdout, "[INFO]: ...deleting framebuffers..\n" );
+    _dynamicResolution.release();
+    _postProcess.release();
 
     fprintf( stdout, "[INFO]: ...deleting models..\n" );
     delete _pVehicle;
     delete _pUFO;
+    delete _pButterfly;
+    delete _pAgentVehicle;
+    delete _pAgentUFO;
+    _pVehicle = nullptr;
+    _pUFO = nullptr;
+    _pButterfly = nullptr;
+    _pAgentVehicle = nullptr;
+    _pAgentUFO = nullptr;
 }
 
 void MPEngine::mCleanupTextures() {
     fprintf( stdout, "[INFO]: ...deleting textures\n" );
     // TODO #23 - delete textures
-    glDeleteTextures(1, &_texHandles[RUG]);
-    glDeleteTextures(1, &_texHandles[SKY]);
+    for (GpuHandle& texture : _textures) texture.reset();
+}
 
+void MPEngine::mCleanupOpenGL() {
+    GLStats::uninstall();
+    GLStats::closeLog();
+
+    // every handle is released by now, anything still listed leaked
+    _gpuResources.printReport(stdout);
 }
 
 //*************************************************************************************
 //
 // Private Helper Functions
 
-void MPEngine::_computeAndSendMatrixUniforms(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx) const {
-    // Compute the Model-View-Projection matrix
-    glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
+void MPEngine::_sendLightUniforms(const LightingShaderUniformLocations& locations) const {
+    const int MAX_POINT_LIGHTS = static_cast<int>(QualitySettings::MAX_POINT_LIGHTS);
+
+    // Arrays to hold point light data
+    glm::vec3 pointLightPositions[MAX_POINT_LIGHTS];
+    glm::vec3 pointLightColors[MAX_POINT_LIGHTS];
+    float pointLightConstants[MAX_POINT_LIGHTS];
+    float pointLightLinears[MAX_POINT_LIGHTS];
+    float pointLightQuadratics[MAX_POINT_LIGHTS];
 
-    // Send MVP matrix to shader
-    glUniformMatrix4fv(_lightingShaderUniformLocations.mvpMatrix, 1, GL_FALSE, glm::value_ptr(mvpMtx));
+    // Determine the number of point lights, the quality tier may light fewer lamps than the shaders can
+    int numPointLights = std::min(static_cast<int>(_lamps.size()), static_cast<int>(_quality.lightLimit));
 
-    // Compute and send the Normal matrix
-    glm::mat3 normalMtx = glm::transpose(glm::inverse(glm::mat3(modelMtx)));
-    glUniformMatrix3fv(_lightingShaderUniformLocations.normalMatrix, 1, GL_FALSE, glm::value_ptr(normalMtx));
+    // Populate the point light arrays
+    for(int i = 0; i < numPointLights; ++i) {
+        pointLightPositions[i] = _getLampLightPosition(_lamps[i]);
+        pointLightColors[i] = glm::vec3(0.0f, 0.0f, 1.0f); // Blue color
+        pointLightConstants[i] = 1.0f;
+        pointLightLinears[i] = 0.09f;
+        pointLightQuadratics[i] = 0.032f;
+    }
+
+    // Set directional light uniforms using the correct uniform names and locations
+    glm::vec3 lightDirection(-1.0f, -1.0f, -1.0f);
+    glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
+    glUniform3fv(locations.dirLightDirection, 1, glm::value_ptr(lightDirection));
+    glUniform3fv(locations.dirLightColor, 1, glm::value_ptr(lightColor));
+
+    glUniform1i(locations.numPointLights, numPointLights);
+    glUniform3fv(locations.pointLightPositions, numPointLights, glm::value_ptr(pointLightPositions[0]));
+    glUniform3fv(locations.pointLightColors, numPointLights, glm::value_ptr(pointLightColors[0]));
+    glUniform1fv(locations.pointLightConstants, numPointLights, pointLightConstants);
+    glUniform1fv(locations.pointLightLinears, numPointLights, pointLightLinears);
+    glUniform1fv(locations.pointLightQuadratics, numPointLights, pointLightQuadratics);
+
+    // Set spot light uniforms
+    glm::vec3 spotLightPos(0,10,0);
+    glm::vec3 spotLightDir(0.0f, -1.0f, 0.0f);
+    glm::vec3 spotLightColor(1.0f, 0.0f, 0.0f);
+    // spotLightWidth is a float in the shader, glUniform1i on it is an invalid operation
+    GLfloat spotLightWidth = glm::cos(glm::radians(10.0f));
+    glUniform3fv(locations.spotLightPosition, 1, glm::value_ptr(spotLightPos));
+    glUniform3fv(locations.spotLightDirection, 1, glm::value_ptr(spotLightDir));
+    glUniform3fv(locations.spotLightColor, 1, glm::value_ptr(spotLightColor));
+    glUniform1f(locations.spotLightWidth, spotLightWidth);
+
+    glUniform3fv(locations.skyAmbient, SphericalHarmonics::NUM_COEFFICIENTS, glm::value_ptr(_skyAmbient[0]));
+}
+
+void MPEngine::_sendMaterialUniforms(const LightingShaderUniformLocations& locations, const Material& material) const {
+    glUniform3fv(locations.materialAmbient, 1, glm::value_ptr(material.ambient));
+    glUniform3fv(locations.materialDiffuse, 1, glm::value_ptr(material.diffuse));
+    glUniform3fv(locations.materialSpecular, 1, glm::value_ptr(material.specular));
+    glUniform1f(locations.materialShininess, material.shininess);
+}
 
-    // Send model matrix to shader
-    glUniformMatrix4fv(_lightingShaderUniformLocations.modelMatrix, 1, GL_FALSE, glm::value_ptr(modelMtx));
+glm::vec3 MPEngine::_getLampLightPosition(const LampData& lamp) const {
+    return lamp.position + glm::vec3(0.0f, LAMP_LIGHT_HEIGHT * getInstanceScale(lamp), 0.0f);
+}
+
+void MPEngine::_computeAndSendMatrixUniforms(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx) const {
+    // MVP, normal and model matrix are written into the transform ring and bound by offset
+    _pTransformRing->bindTransforms(modelMtx, projMtx * viewMtx);
 }
 
 //*************************************************************************************
@@ -1084,18 +3059,24 @@ void MPEngine::_computeAndSendMatrixUniforms(glm::mat4 modelMtx, glm::mat4 viewM
 
 void mp_engine_keyboard_callback(GLFWwindow *window, int key, int scancode, int action, int mods ) {
     auto engine = (MPEngine*) glfwGetWindowUserPointer(window);
+    // live input would break a deterministic replay
+    if(engine->isReplaying()) return;
 
     engine->handleKeyEvent(key, action, mods);
 }
 
 void mp_engine_cursor_callback(GLFWwindow *window, double x, double y ) {
     auto engine = (MPEngine*) glfwGetWindowUserPointer(window);
+    // live input would break a deterministic replay
+    if(engine->isReplaying()) return;
 
     engine->handleCursorPositionEvent(glm::vec2(x, y));
 }
 
 void mp_engine_mouse_button_callback(GLFWwindow *window, int button, int action, int mods ) {
     auto engine = (MPEngine*) glfwGetWindowUserPointer(window);
+    // live input would break a deterministic replay
+    if(engine->isReplaying()) return;
 
     engine->handleMouseButtonEvent(button, action, mods);
 }
\ No newline at end of file
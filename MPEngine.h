@@ -12,7 +12,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <string.h>
+#include <string>
 #include <vector>
+#include <random>
 
 //#include "FPSCamera.hpp"
 #include "ArcballCamera.h"
@@ -20,6 +22,36 @@
 #include "UFO.h"
 #include "Lucid.h"
 #include "FPCamera.h"
+#include "CameraPath.h"
+#include "FrameStats.h"
+#include "GpuTimer.h"
+#include "InputJournal.h"
+#include "SceneFile.h"
+#include "OcclusionCuller.h"
+#include "RenderStateCache.h"
+#include "CollisionWorld.h"
+#include "FrameArena.h"
+#include "AllocationTracker.h"
+#include "GpuResourceRegistry.h"
+#include "VertexAttributes.h"
+#include "PrimitiveMeshes.h"
+#include "MultiView.h"
+#include "DynamicResolution.h"
+#include "FramePacer.h"
+#include "TransformRing.h"
+#include "FlowField.h"
+#include "ParticleSystem.h"
+#include "ButterflySwarm.h"
+#include "Flock.h"
+#include "GLStats.h"
+#include "StatsOverlay.h"
+#include "QualitySettings.h"
+#include "WorldGenerator.h"
+#include "HeroMovement.h"
+#include "SceneQuery.h"
+#include "CameraCollision.h"
+#include "SphericalHarmonics.h"
+#include "PostProcess.h"
 
 // Forward Declarations of Callback Functions
 void mp_engine_keyboard_callback(GLFWwindow *window, int key, int scancode, int action, int mods );
@@ -47,13 +79,68 @@ public:
     CameraType currCamera = CameraType::ARCBALL;
     void run() final;
 
+    // Benchmarking
+    void runBenchmark(const char* outputFilename);
+    // Compares the compact vertex and instance formats against the full float ones
+    void runBandwidthBenchmark(const char* outputFilename);
+    void regenerateEnvironment(float density, unsigned int seed);
+
+    // Input recording and deterministic replay
+    void startRecording(const char* filename);
+    bool loadReplay(const char* filename);
+    // false without a replay journal to run
+    bool runHeadless();
+    bool isReplaying() const { return _inputMode == InputMode::REPLAY; }
+
+    // Fails an assert on any heap allocation once frames reach steady state,
+    // needs a build configured with MP_TRACK_ALLOCATIONS
+    void setAllocationAssert(bool enabled) { _assertNoAllocations = enabled; }
+
+    // Bytes of streamable GPU assets (textures) allowed before the least recently used are evicted
+    void setVramBudget(size_t budgetBytes) { _gpuResources.setBudget(budgetBytes); }
+
+    // Renders the scene below window resolution as needed to hold a GPU frame time budget
+    void setDynamicResolution(double targetFrameMs) { _dynamicResolution.setTargetFrameTime(targetFrameMs); _dynamicResolutionEnabled = true; }
+
+    // Renders the main view in HDR and tone maps it with bloom, on by default; H, B, N and T toggle it and its passes
+    void setPostProcessEnabled(bool enabled) { _postProcessEnabled = enabled; }
+    // Post-processing pass times at 1080p with tone mapping only, half resolution bloom and the full chain
+    void runPostProcessBenchmark(const char* outputFilename);
+
+    // Delays input sampling until just before vsync so frames start from the freshest input
+    void setFramePacing(bool enabled) { _framePacingEnabled = enabled; }
+
+    // Number of autonomous vehicles and UFOs roaming the island
+    void setAgentCount(GLuint count) { _agentCount = count; }
+
+    // Simulates the particle effects on the CPU instead of with transform feedback
+    void setGpuParticles(bool enabled) { _gpuParticles = enabled; }
+    // Particle update and draw cost over growing particle counts, GPU against CPU
+    void runParticleBenchmark(const char* outputFilename);
+
+    // Number of ambient butterflies drawn through the vertex animation texture
+    void setSwarmSize(GLuint count) { _swarmSize = count; }
+    // Flocking update cost over growing swarms, on one thread and on all of them
+    void runFlockBenchmark(const char* outputFilename);
+
+    // Counts GL calls per frame from the start and logs them to a CSV file, G toggles the counting and its overlay
+    void setGLStatsLog(const char* filename) { _glStatsLogFilename = filename; _glStatsEnabled = true; }
+
+    // Window size, draw distance, scenery detail, light count and render scale, set before initialize
+    void setQualitySettings(const QualitySettings& settings);
+    const QualitySettings& getQualitySettings() const { return _quality; }
+    // Times a short orbit at each tier from low up and keeps the highest whose mean frame
+    // time meets the target, needs the window; settings pinned by name are left alone
+    void selectQualityTier(double targetFrameMs);
+
+    // Scene serialization
+    bool saveScene(const char* filename) const;
+    bool loadScene(const char* filename);
+
     // Event Handlers
     void handleKeyEvent(GLint key, GLint action, GLint mods);
     void handleMouseButtonEvent(GLint button, GLint action, GLint mods); // Updated to include mods
     void handleCursorPositionEvent(glm::vec2 currMousePosition);
-    static bool checkCollision(const glm::vec3& pos1, float radius1,
-                               const glm::vec3& pos2, float radius2);
-    bool isMovementValid(const glm::vec3& newPosition) const;
 
     static constexpr GLfloat MOUSE_UNINITIALIZED = -9999.0f;
 
@@ -64,14 +151,219 @@ private:
     void mSetupShaders() final;
     void mSetupBuffers() final;
     void mSetupScene() final;
+    void _createSceneObjects();
 
     void mCleanupBuffers() final;
     void mCleanupShaders() final;
     void mCleanupTextures() final;
+    void mCleanupOpenGL() final;
+
+    // Owns every GL object below; declared before the handles so it outlives them
+    GpuResourceRegistry _gpuResources;
 
     // Rendering
     void _renderScene(glm::mat4 viewMtx, glm::mat4 projMtx) const;
+    void _renderOpaquePass(glm::mat4 viewMtx, glm::mat4 projMtx) const;
+    void _renderSkyPass(glm::mat4 viewMtx, glm::mat4 projMtx) const;
+    void _renderTranslucentPass(glm::mat4 viewMtx, glm::mat4 projMtx) const;
+    void _drawGround(glm::mat4 viewMtx, glm::mat4 projMtx) const;
     void _updateScene();
+    void _getCameraMatrices(GLint framebufferWidth, GLint framebufferHeight, glm::mat4& viewMtx, glm::mat4& projMtx) const;
+    void _prepareFrame(glm::mat4 viewMtx, glm::mat4 projMtx);
+    void _sortFrontToBack(std::vector<GLuint>& indices, glm::vec3 eyePosition, bool trees);
+    // held by pointer so the const render passes can update it
+    RenderStateCache* _pRenderStateCache;
+    // per-draw transforms of the lighting shader, also shared with the heroes
+    TransformRing* _pTransformRing;
+
+    // Input is sampled right before simulation, the pacer times it to the swap
+    FramePacer _framePacer;
+    bool _framePacingEnabled = false;
+    void _startFramePacing();
+
+    // Per-frame transient memory, reset at the top of every frame
+    static constexpr GLuint STEADY_STATE_FRAMES = 120;
+    FrameArena* _pFrameArena;
+    GLuint _framesRendered = 0;
+    bool _assertNoAllocations = false;
+    void _checkFrameAllocations();
+
+    // Occlusion Culling
+    static constexpr GLuint MAX_OCCLUDERS = 48;
+    OcclusionCuller* _pOcclusionCuller;
+    bool _occlusionCullingEnabled = true;
+    std::vector<GLuint> _visibleTrees;
+    std::vector<GLuint> _visibleLamps;
+    void _cullScenery(glm::mat4 viewMtx, glm::mat4 projMtx, glm::vec3 eyePosition);
+
+    // Dynamic resolution, the main view is scaled to hold the frame time budget
+    DynamicResolution _dynamicResolution;
+    bool _dynamicResolutionEnabled = false;
+
+    // Quality tier, scenery beyond LOD_DISTANCE times the LOD bias is drawn one detail level coarser
+    static constexpr GLfloat LOD_DISTANCE = 30.0f;
+    QualitySettings _quality;
+    int _nearDetailLevel;
+    int _farDetailLevel;
+    // leading entries of _visibleTrees and _visibleLamps drawn at the near detail level
+    size_t _numNearTrees = 0;
+    size_t _numNearLamps = 0;
+    void _applyQualitySettings();
+    void _logQualitySettings() const;
+    size_t _countNearScenery(const std::vector<GLuint>& indices, glm::vec3 eyePosition, bool trees) const;
+    // whether the main view goes through the offscreen target of _dynamicResolution
+    bool _isSceneScaled() const { return _dynamicResolutionEnabled || _quality.renderScale < DynamicResolution::MAX_SCALE; }
+    bool _isSceneOffscreen() const { return _postProcessEnabled || _isSceneScaled(); }
+
+    // HDR post-processing of the main view, the scene goes through _dynamicResolution's target
+    PostProcess _postProcess;
+    bool _postProcessEnabled = true;
+    // binds the target the main view renders into, if any
+    void _beginMainView(GLint framebufferWidth, GLint framebufferHeight);
+    // brings the main view to the default framebuffer
+    void _endMainView(GLint framebufferWidth, GLint framebufferHeight);
+    void _togglePostProcessPass(PostProcess::Pass pass);
+
+    // Startup quality benchmark
+    static constexpr GLuint QUALITY_BENCHMARK_WARMUP_FRAMES = 10;
+    static constexpr GLuint QUALITY_BENCHMARK_FRAMES = 60;
+    // software rasterizers are slow enough that fewer frames already tell the tiers apart
+    static constexpr GLuint QUALITY_BENCHMARK_SOFTWARE_FRAMES = 20;
+    // false when the window was closed, gives up early once the mean cannot meet the target
+    bool _runQualityTest(GLuint numFrames, double targetFrameMs, double& meanFrameMs);
+
+    // Minimap and hero cam insets, drawn from one traversal through MultiView
+    static constexpr GLfloat MINIMAP_RADIUS = 30.0f;
+    MultiView _insetViews;
+    bool _insetViewsEnabled = true;
+    // scenery index and mask of the inset views it is visible in
+    std::vector<std::pair<GLuint, GLuint>> _insetTrees;
+    std::vector<std::pair<GLuint, GLuint>> _insetLamps;
+    void _prepareInsetViews(GLint framebufferWidth, GLint framebufferHeight);
+    void _renderInsetViews() const;
+    void _sendMultiviewModelUniforms(glm::mat4 modelMtx, GLuint viewMask) const;
+    void _getHeroPlacement(HeroType hero, glm::vec3& position, float& heading) const;
+
+    // GL call counters of the last frame, shown over the corner while counting
+    StatsOverlay _statsOverlay;
+    bool _glStatsEnabled = false;
+    std::string _glStatsLogFilename;
+    void _setGLStatsEnabled(bool enabled);
+    void _drawStatsOverlay(GLint framebufferWidth, GLint framebufferHeight);
+
+    // Collision
+    static constexpr GLfloat TREE_TRUNK_RADIUS = 1.0f;
+    static constexpr GLfloat LAMP_POST_RADIUS = 0.2f;
+    CollisionWorld* _pCollisionWorld;
+    CollisionWorld::BodyId _heroBodies[3];
+    void _rebuildCollisionWorld();
+    glm::vec3 _resolveHeroMovement(HeroType hero, glm::vec3 currentPosition, glm::vec3 targetPosition);
+
+    // Ray and sphere casts against the scenery and the heroes, right click picks through it
+    SceneQuery* _pSceneQuery;
+    uint32_t _heroQueryBoxes[3];
+    void _rebuildSceneQuery();
+    // moves the heroes' boxes to where they are now
+    void _updateSceneQuery();
+    void _pickObject(glm::vec2 cursorPosition);
+
+    // Pulls the arcball and first person eyes in front of the scenery between them and the hero
+    CameraCollision _arcballCollision;
+    CameraCollision _firstPersonCollision;
+    void _updateCameraCollision();
+
+    // Autonomous agents, steered by one flow field per destination
+    static constexpr GLuint DEFAULT_AGENT_COUNT = 200;
+    static constexpr GLfloat AGENT_SPEED = 0.15f;
+    static constexpr GLfloat AGENT_TURN_RATE = 0.1f;
+    // kept between agents and scenery on top of the obstacle radius
+    static constexpr GLfloat AGENT_CLEARANCE = 1.0f;
+    // path cost to the destination at which an agent picks the next one
+    static constexpr GLfloat AGENT_ARRIVAL_COST = 2.0f;
+    // agents route around the player's hero unless there is no other way
+    static constexpr GLfloat HERO_AVOIDANCE_RADIUS = 3.0f;
+    static constexpr uint8_t HERO_AVOIDANCE_COST = 8;
+    struct Agent {
+        HeroType type;
+        glm::vec3 position;
+        float heading;
+        FlowField::GoalId goal;
+    };
+    FlowField* _pFlowField;
+    std::vector<Agent> _agents;
+    GLuint _agentCount = DEFAULT_AGENT_COUNT;
+    // separate from rand() so the agents cannot shift the world generation
+    std::mt19937 _agentRandom;
+    glm::vec2 _heroObstaclePosition;
+    bool _heroObstacleStamped = false;
+    // drawn once per agent at its placement
+    Vehicle* _pAgentVehicle;
+    UFO* _pAgentUFO;
+    void _rebuildNavigation();
+    void _updateAgents();
+    void _drawAgents(glm::mat4 viewMtx, glm::mat4 projMtx) const;
+
+    // Particle effects: UFO tractor beam, vehicle exhaust, butterfly dust and lamp glows
+    static constexpr GLfloat PARTICLE_TIME_STEP = 1.0f / 60.0f;
+    // one per lamp _sendLightUniforms can light
+    static constexpr GLuint NUM_LAMP_GLOWS = QualitySettings::MAX_POINT_LIGHTS;
+    ParticleSystem _particleSystem;
+    bool _gpuParticles = true;
+    GLuint _beamEmitter = 0;
+    GLuint _exhaustEmitter = 0;
+    GLuint _dustEmitter = 0;
+    GLuint _firstGlowEmitter = 0;
+    void _createParticleEffects();
+    // moves the emitters with the heroes and advances the particles, needs the GL context
+    void _updateParticles();
+
+    // Ambient butterflies, flocking around the trees and lamp posts and drawn by a single instanced call
+    static constexpr GLuint DEFAULT_SWARM_SIZE = 2000;
+    // butterflies start out in flocks of this many
+    static constexpr GLuint SWARM_FLOCK_SIZE = 25;
+    // indexed by Flock::getId
+    struct SwarmButterfly {
+        float phase;
+        // flap cycles per tick
+        float flapRate;
+    };
+    ButterflySwarm _butterflySwarm;
+    Flock* _pFlock;
+    GLuint _swarmSize = DEFAULT_SWARM_SIZE;
+    std::vector<SwarmButterfly> _swarm;
+    std::vector<ButterflySwarm::Instance> _swarmInstances;
+    std::mt19937 _swarmRandom;
+    void _rebuildSwarm();
+    void _updateSwarm();
+    void _drawButterflySwarm(glm::mat4 viewMtx, glm::mat4 projMtx) const;
+
+    // Scripted flythrough for benchmarking
+    static constexpr GLfloat BENCHMARK_FRAME_RATE = 60.0f;
+    static constexpr GLuint BENCHMARK_WARMUP_FRAMES = 30;
+    void _applyCameraKey(CameraType cameraType, const CameraKey& key);
+    bool _runFlythrough(CameraType cameraType, const CameraPath& path, bool occlusionCulling, FrameStats& stats);
+
+    // Vertex and instance bandwidth benchmark
+    static constexpr GLuint BANDWIDTH_GRID_RESOLUTION = 512;
+    static constexpr GLuint BANDWIDTH_DRAWS_PER_FRAME = 8;
+    static constexpr GLuint BANDWIDTH_FRAMES = 240;
+    static constexpr GLuint BANDWIDTH_INSTANCES = 16384;
+    bool _runVertexFetchTest(VertexFormat format, const std::vector<FullVertex>& vertices, CSCI441::ShaderProgram* pShaderProgram, GLuint indexBuffer, GLsizei numIndices, FrameStats& stats, size_t& vertexBufferBytes);
+    bool _runInstanceUploadTest(bool compact, FrameStats& stats, size_t& bytesPerFrame);
+
+    // Particle scaling benchmark
+    static constexpr GLuint PARTICLE_BENCHMARK_FRAMES = 240;
+    bool _runParticleTest(GLuint numParticles, bool gpuSimulation, FrameStats& stats);
+
+    // Flocking scaling benchmark, simulation only
+    static constexpr GLuint FLOCK_BENCHMARK_TICKS = 240;
+    void _runFlockTest(GLuint numAgents, unsigned int numThreads, FrameStats& stats);
+
+    // Post-processing benchmark, every pass timed into a 1080p offscreen target
+    static constexpr GLuint POST_PROCESS_BENCHMARK_FRAMES = 240;
+    static constexpr GLint POST_PROCESS_BENCHMARK_WIDTH = 1920;
+    static constexpr GLint POST_PROCESS_BENCHMARK_HEIGHT = 1080;
+    bool _runPostProcessTest(GLuint framebuffer);
 
     // Input Tracking
     static constexpr GLuint NUM_KEYS = GLFW_KEY_LAST;
@@ -79,6 +371,22 @@ private:
     glm::vec2 _mousePosition;
     GLint _leftMouseButtonState;
 
+    // Input Journal
+    enum class InputMode {
+        LIVE,
+        RECORD,
+        REPLAY
+    };
+    InputMode _inputMode = InputMode::LIVE;
+    InputJournal _inputJournal;
+    std::string _journalFilename;
+    size_t _replayCursor = 0;
+    uint32_t _simulationTick = 0;
+    bool _headless = false;
+    void _recordEvent(InputEventType type, GLint code, GLint action, GLint mods, glm::vec2 position);
+    void _replayEventsForTick();
+    bool _isReplayFinished() const;
+
     // Camera and Vehicle
     ArcballCamera* _pArcballCam;
     FPCamera* _pFPCam;
@@ -94,20 +402,39 @@ private:
     // Animation State
     float _animationTime;
 
+    // World generation
+    float _environmentDensity;
+    unsigned int _worldSeed;
+    bool _sceneLoaded = false;
+    std::vector<SceneHeroRecord> _loadedHeroes;
+    void _applyLoadedHeroes();
+
     // Ground
     static constexpr GLfloat WORLD_SIZE = 55.0f;
-    GLuint _groundVAO;
+    GpuHandle _groundVAO;
+    GpuHandle _groundVBO;
+    GpuHandle _groundIBO;
     GLsizei _numGroundPoints;
 
+    // Scenery meshes, generated at compile time
+    PrimitiveMeshes _primitiveMeshes;
+
     //Sky
-    GLuint _skyboxVAO;
+    GpuHandle _skyboxVAO;
+    GpuHandle _skyboxVBO;
+    GpuHandle _skyboxEBO;
 
     //***************************************************************************
     // Shader Program Information
 
     GLuint _groundTexture;
-    GLuint _loadAndRegisterTexture(const char* FILENAME);
-    GLuint _loadAndRegisterCubemap(const std::vector<const char*>& faces);
+    GLuint _loadAndRegisterTexture(const char* FILENAME, size_t& bytes);
+    GLuint _loadAndRegisterCubemap(const std::vector<const char*>& faces, size_t& bytes);
+
+    // the sky's ambient light, white everywhere until the cubemap has been projected
+    SphericalHarmonics::Coefficients _skyAmbient = SphericalHarmonics::constantAmbient(glm::vec3(1.0f));
+    bool _isSkyAmbientProjected = false;
+    static constexpr const char* SKY_AMBIENT_CACHE = "sky_ambient.shcache";
 
     void mSetupTextures();
     /// \desc total number of textures in our scene
@@ -119,9 +446,11 @@ private:
         SKY = 1
     };
     /// \desc texture handles for our textures
-    GLuint _texHandles[NUM_TEXTURES];
+    GpuHandle _textures[NUM_TEXTURES];
+    /// \desc registry entries for the lighting, texture, skybox, multiview lighting, swarm, overlay and post-processing programs
+    GpuHandle _programHandles[9];
     /// \desc shader program that performs texturing
-    CSCI441::ShaderProgram* _textureShaderProgram;
+    CSCI441::ShaderProgram* _textureShaderProgram = nullptr;
     /// \desc stores the locations of all of our shader uniforms
     struct TextureShaderUniformLocations {
         /// \desc precomputed MVP matrix location
@@ -148,20 +477,17 @@ private:
     std::vector<BuildingData> _buildings;
     const std::vector<BuildingData>& getBuildings() const { return _buildings; }
 
-    // Lamps
-    struct LampData {
-        glm::mat4 modelMatrixPost;
-        glm::mat4 modelMatrixLight;
-        glm::vec3 position;
-    };
+    // Lamps and trees only translate, their part matrices are rebuilt from
+    // the compact instance when drawn
+    static constexpr GLfloat LAMP_LIGHT_HEIGHT = 7.0f;
+    static constexpr GLfloat TREE_LEAVES_HEIGHT = 5.0f;
+    typedef CompactInstance LampData;
     std::vector<LampData> _lamps;
+    glm::vec3 _getLampLightPosition(const LampData& lamp) const;
 
 
     // Trees
-    struct TreeData {
-        glm::mat4 modelMatrixTrunk;
-        glm::mat4 modelMatrixLeaves;
-    };
+    typedef CompactInstance TreeData;
     std::vector<TreeData> _trees;
     const std::vector<TreeData>& getTrees() const { return _trees; }
 
@@ -176,7 +502,7 @@ private:
     // Shaders
     CSCI441::ShaderProgram* _lightingShaderProgram = nullptr;
     struct LightingShaderUniformLocations {
-        GLint mvpMatrix;
+        // -1 for the lighting program, which gets them from the DrawTransform block
         GLint normalMatrix;
         GLint modelMatrix;
         GLint viewPos;
@@ -204,8 +530,65 @@ private:
         GLint spotLightDirection;
         GLint spotLightWidth;
         GLint spotLightColor;
+
+        // Sky ambient light
+        GLint skyAmbient;
+
+        // Light the surface gives off itself, only the lamp bulbs have any
+        GLint emission;
     }_lightingShaderUniformLocations;
 
+    void _getLightingUniformLocations(const CSCI441::ShaderProgram* pShaderProgram, LightingShaderUniformLocations& locations) const;
+    void _sendLightUniforms(const LightingShaderUniformLocations& locations) const;
+
+    struct Material {
+        glm::vec3 ambient;
+        glm::vec3 diffuse;
+        glm::vec3 specular;
+        float shininess;
+    };
+    static const Material TRUNK_MATERIAL;
+    static const Material LEAVES_MATERIAL;
+    static const Material POST_MATERIAL;
+    static const Material BULB_MATERIAL;
+    // bright enough to bloom once the main view is HDR
+    static const glm::vec3 BULB_EMISSION;
+    void _sendMaterialUniforms(const LightingShaderUniformLocations& locations, const Material& material) const;
+
+    // Lighting for the inset views, lighting.vs.glsl run once per view
+    CSCI441::ShaderProgram* _multiviewShaderProgram = nullptr;
+    LightingShaderUniformLocations _multiviewLightingUniformLocations;
+    struct MultiviewShaderUniformLocations {
+        GLint viewProjections;
+        GLint viewPositions;
+        GLint viewMask;
+    } _multiviewShaderUniformLocations;
+
+    // Lighting for the butterfly swarm, wings animated from a texture
+    CSCI441::ShaderProgram* _swarmShaderProgram = nullptr;
+    LightingShaderUniformLocations _swarmLightingUniformLocations;
+    struct SwarmShaderUniformLocations {
+        GLint viewProjection;
+        GLint animationTexture;
+    } _swarmShaderUniformLocations;
+    static constexpr GLuint SWARM_TEXTURE_UNIT = 2;
+
+    // Text of the GL stats overlay
+    CSCI441::ShaderProgram* _overlayShaderProgram = nullptr;
+    struct OverlayShaderUniformLocations {
+        GLint screenSize;
+        GLint pixelScale;
+        GLint font;
+    } _overlayShaderUniformLocations;
+    static constexpr GLuint OVERLAY_TEXTURE_UNIT = 3;
+
+    // Bloom and tone mapping, their uniforms are PostProcess's business
+    CSCI441::ShaderProgram* _bloomDownsampleShaderProgram = nullptr;
+    CSCI441::ShaderProgram* _bloomUpsampleShaderProgram = nullptr;
+    CSCI441::ShaderProgram* _toneMapShaderProgram = nullptr;
+    // the diffuse color comes from the wings
+    static const Material WING_MATERIAL;
+
     struct LightingShaderAttributeLocations {
         GLint vPos;
         GLint vNormal;
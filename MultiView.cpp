@@ -0,0 +1,70 @@
+#include "MultiView.h"
+
+MultiView::MultiView()
+    : _numViews(0)
+{}
+
+bool MultiView::addView(const glm::mat4& viewMtx, const glm::mat4& projMtx, GLint x, GLint y, GLsizei width, GLsizei height) {
+    if(_numViews >= MAX_VIEWS) return false;
+
+    View& view = _views[_numViews];
+    view.viewMtx = viewMtx;
+    view.projMtx = projMtx;
+    view.viewProjMtx = projMtx * viewMtx;
+    view.eyePosition = glm::vec3(glm::inverse(viewMtx)[3]);
+    view.viewport[0] = x;
+    view.viewport[1] = y;
+    view.viewport[2] = width;
+    view.viewport[3] = height;
+    _viewProjMatrices[_numViews] = view.viewProjMtx;
+    _eyePositions[_numViews] = view.eyePosition;
+
+    // planes straight from the rows of the view projection matrix (Gribb/Hartmann)
+    const glm::mat4& m = view.viewProjMtx;
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+    glm::vec4* planes = _planes[_numViews];
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 + row1;
+    planes[3] = row3 - row1;
+    planes[4] = row3 + row2;
+    planes[5] = row3 - row2;
+
+    _numViews++;
+    return true;
+}
+
+GLuint MultiView::testBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+    GLuint viewMask = 0;
+    for(GLuint view = 0; view < _numViews; ++view) {
+        bool inside = true;
+        for(int i = 0; i < 6 && inside; ++i) {
+            const glm::vec4& plane = _planes[view][i];
+            // the corner furthest along the plane normal
+            glm::vec3 corner(plane.x >= 0.0f ? boxMax.x : boxMin.x,
+                             plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                             plane.z >= 0.0f ? boxMax.z : boxMin.z);
+            inside = glm::dot(glm::vec3(plane), corner) + plane.w >= 0.0f;
+        }
+        if(inside) viewMask |= 1u << view;
+    }
+    return viewMask;
+}
+
+GLsizei MultiView::countViews(GLuint viewMask) {
+    GLsizei count = 0;
+    for(; viewMask != 0; viewMask &= viewMask - 1) count++;
+    return count;
+}
+
+void MultiView::applyViewports() const {
+    for(GLuint i = 0; i < _numViews; ++i) {
+        const GLint* viewport = _views[i].viewport;
+        glViewportIndexedf(i, static_cast<GLfloat>(viewport[0]), static_cast<GLfloat>(viewport[1]),
+                           static_cast<GLfloat>(viewport[2]), static_cast<GLfloat>(viewport[3]));
+        glScissorIndexed(i, viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+}
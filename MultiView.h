@@ -0,0 +1,53 @@
+#ifndef MULTI_VIEW_H
+#define MULTI_VIEW_H
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+// A set of small secondary views (minimap, hero cam) rendered from one scene
+// traversal. Each object is tested against every view frustum once and gets a
+// mask of the views it shows up in; it is then drawn once with one instance per
+// set bit and the multiview geometry shader sends instance n to the viewport of
+// the n-th view in the mask.
+class MultiView {
+public:
+    // must match MAX_VIEWS in shaders/lighting_multiview.vs.glsl
+    static constexpr GLuint MAX_VIEWS = 4;
+
+    struct View {
+        glm::mat4 viewMtx;
+        glm::mat4 projMtx;
+        glm::mat4 viewProjMtx;
+        glm::vec3 eyePosition;
+        GLint viewport[4];      // x, y, width, height
+    };
+
+    MultiView();
+
+    void clear() { _numViews = 0; }
+    // returns false once MAX_VIEWS views were added
+    bool addView(const glm::mat4& viewMtx, const glm::mat4& projMtx, GLint x, GLint y, GLsizei width, GLsizei height);
+
+    GLuint getNumViews() const { return _numViews; }
+    const View& getView(GLuint index) const { return _views[index]; }
+    // packed for glUniformMatrix4fv / glUniform3fv
+    const glm::mat4* getViewProjections() const { return _viewProjMatrices; }
+    const glm::vec3* getEyePositions() const { return _eyePositions; }
+
+    // bit i is set when the box intersects the frustum of view i
+    GLuint testBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+    static GLsizei countViews(GLuint viewMask);
+
+    // sets viewport and scissor rectangle i of the viewport array to view i
+    void applyViewports() const;
+
+private:
+    View _views[MAX_VIEWS];
+    glm::mat4 _viewProjMatrices[MAX_VIEWS];
+    glm::vec3 _eyePositions[MAX_VIEWS];
+    // left, right, bottom, top, near, far; inside when dot(plane, (p, 1)) >= 0
+    glm::vec4 _planes[MAX_VIEWS][6];
+    GLuint _numViews;
+};
+
+#endif // MULTI_VIEW_H
@@ -0,0 +1,189 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+// clip space w below this is treated as crossing the near plane
+static const float MIN_CLIP_W = 1e-3f;
+
+static void getBoxCorners(const glm::vec3& boxMin, const glm::vec3& boxMax, glm::vec3 corners[8]) {
+    for(int i = 0; i < 8; ++i) {
+        corners[i] = glm::vec3((i & 1) ? boxMax.x : boxMin.x,
+                               (i & 2) ? boxMax.y : boxMin.y,
+                               (i & 4) ? boxMax.z : boxMin.z);
+    }
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+    : _width(width),
+      _height(height),
+      _viewProjMtx(1.0f),
+      _stats{0, 0, 0, 0}
+{
+    int levelWidth = width, levelHeight = height;
+    while(true) {
+        _levelSizes.emplace_back(levelWidth, levelHeight);
+        _levels.emplace_back(static_cast<size_t>(levelWidth) * levelHeight, 1.0f);
+        if(levelWidth == 1 && levelHeight == 1) break;
+        levelWidth = std::max(1, (levelWidth + 1) / 2);
+        levelHeight = std::max(1, (levelHeight + 1) / 2);
+    }
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& viewProjMtx) {
+    _viewProjMtx = viewProjMtx;
+    std::fill(_levels[0].begin(), _levels[0].end(), 1.0f);
+    _stats = {0, 0, 0, 0};
+}
+
+glm::vec3 OcclusionCuller::_toScreen(const glm::vec4& clip) const {
+    // NDC to pixel coordinates with depth remapped to [0, 1]
+    float invW = 1.0f / clip.w;
+    return glm::vec3((clip.x * invW * 0.5f + 0.5f) * _width,
+                     (clip.y * invW * 0.5f + 0.5f) * _height,
+                     clip.z * invW * 0.5f + 0.5f);
+}
+
+void OcclusionCuller::addOccluder(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    static const int BOX_TRIANGLES[12][3] = {
+        {0, 2, 1}, {1, 2, 3},   // -z
+        {4, 5, 6}, {5, 7, 6},   // +z
+        {0, 1, 4}, {1, 5, 4},   // -y
+        {2, 6, 3}, {3, 6, 7},   // +y
+        {0, 4, 2}, {2, 4, 6},   // -x
+        {1, 3, 5}, {3, 7, 5}    // +x
+    };
+
+    glm::vec3 corners[8];
+    getBoxCorners(boxMin, boxMax, corners);
+
+    glm::vec3 screen[8];
+    for(int i = 0; i < 8; ++i) {
+        glm::vec4 clip = _viewProjMtx * glm::vec4(corners[i], 1.0f);
+        // skip occluders touching the near plane instead of clipping them, it only loses occlusion
+        if(clip.w < MIN_CLIP_W) return;
+        screen[i] = _toScreen(clip);
+    }
+
+    for(const auto& triangle : BOX_TRIANGLES) {
+        _rasterizeTriangle(screen[triangle[0]], screen[triangle[1]], screen[triangle[2]]);
+    }
+    _stats.occludersRasterized++;
+}
+
+void OcclusionCuller::_rasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2) {
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if(std::fabs(area) < 1e-8f) return;
+    float invArea = 1.0f / area;
+
+    int minX = std::max(0, static_cast<int>(std::floor(std::min({v0.x, v1.x, v2.x}))));
+    int maxX = std::min(_width - 1, static_cast<int>(std::ceil(std::max({v0.x, v1.x, v2.x}))));
+    int minY = std::max(0, static_cast<int>(std::floor(std::min({v0.y, v1.y, v2.y}))));
+    int maxY = std::min(_height - 1, static_cast<int>(std::ceil(std::max({v0.y, v1.y, v2.y}))));
+    if(minX > maxX || minY > maxY) return;
+
+    std::vector<float>& depth = _levels[0];
+    for(int y = minY; y <= maxY; ++y) {
+        float py = y + 0.5f;
+        for(int x = minX; x <= maxX; ++x) {
+            float px = x + 0.5f;
+            // barycentric weights from edge functions, either winding is accepted
+            float w0 = ((v1.x - px) * (v2.y - py) - (v1.y - py) * (v2.x - px)) * invArea;
+            float w1 = ((v2.x - px) * (v0.y - py) - (v2.y - py) * (v0.x - px)) * invArea;
+            float w2 = 1.0f - w0 - w1;
+            if(w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+            // screen space depth (z/w) interpolates linearly
+            float z = w0 * v0.z + w1 * v1.z + w2 * v2.z;
+            float& stored = depth[static_cast<size_t>(y) * _width + x];
+            if(z < stored) stored = std::max(z, 0.0f);
+        }
+    }
+}
+
+void OcclusionCuller::buildHierarchy() {
+    for(size_t level = 1; level < _levels.size(); ++level) {
+        const std::vector<float>& below = _levels[level - 1];
+        std::vector<float>& current = _levels[level];
+        const glm::ivec2 belowSize = _levelSizes[level - 1];
+        const glm::ivec2 size = _levelSizes[level];
+
+        for(int y = 0; y < size.y; ++y) {
+            int y0 = std::min(2 * y, belowSize.y - 1);
+            int y1 = std::min(2 * y + 1, belowSize.y - 1);
+            for(int x = 0; x < size.x; ++x) {
+                int x0 = std::min(2 * x, belowSize.x - 1);
+                int x1 = std::min(2 * x + 1, belowSize.x - 1);
+                current[static_cast<size_t>(y) * size.x + x] = std::max(
+                    std::max(below[static_cast<size_t>(y0) * belowSize.x + x0], below[static_cast<size_t>(y0) * belowSize.x + x1]),
+                    std::max(below[static_cast<size_t>(y1) * belowSize.x + x0], below[static_cast<size_t>(y1) * belowSize.x + x1]));
+            }
+        }
+    }
+}
+
+OcclusionCuller::Result OcclusionCuller::testBox(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    _stats.tested++;
+
+    glm::vec3 corners[8];
+    getBoxCorners(boxMin, boxMax, corners);
+
+    // outcodes for the six clip planes; a box fully outside any one plane is culled
+    int allOutside = 0x3F;
+    bool crossesNear = false;
+    glm::vec4 clip[8];
+    for(int i = 0; i < 8; ++i) {
+        clip[i] = _viewProjMtx * glm::vec4(corners[i], 1.0f);
+        int outside = 0;
+        if(clip[i].x < -clip[i].w) outside |= 0x01;
+        if(clip[i].x >  clip[i].w) outside |= 0x02;
+        if(clip[i].y < -clip[i].w) outside |= 0x04;
+        if(clip[i].y >  clip[i].w) outside |= 0x08;
+        if(clip[i].z < -clip[i].w) outside |= 0x10;
+        if(clip[i].z >  clip[i].w) outside |= 0x20;
+        allOutside &= outside;
+        if(clip[i].w < MIN_CLIP_W) crossesNear = true;
+    }
+    if(allOutside != 0) {
+        _stats.frustumCulled++;
+        return Result::FRUSTUM_CULLED;
+    }
+    if(crossesNear) return Result::VISIBLE;
+
+    glm::vec2 screenMin(static_cast<float>(_width), static_cast<float>(_height));
+    glm::vec2 screenMax(0.0f);
+    float nearestDepth = 1.0f;
+    for(int i = 0; i < 8; ++i) {
+        glm::vec3 screen = _toScreen(clip[i]);
+        screenMin = glm::min(screenMin, glm::vec2(screen.x, screen.y));
+        screenMax = glm::max(screenMax, glm::vec2(screen.x, screen.y));
+        nearestDepth = std::min(nearestDepth, screen.z);
+    }
+    screenMin = glm::max(screenMin, glm::vec2(0.0f));
+    screenMax = glm::min(screenMax, glm::vec2(static_cast<float>(_width - 1), static_cast<float>(_height - 1)));
+
+    // pick the pyramid level where the rectangle spans at most a couple of texels
+    float extent = std::max(screenMax.x - screenMin.x, screenMax.y - screenMin.y);
+    int level = extent > 1.0f ? static_cast<int>(std::ceil(std::log2(extent))) : 0;
+    level = std::min(level, static_cast<int>(_levels.size()) - 1);
+
+    const glm::ivec2 size = _levelSizes[level];
+    const std::vector<float>& depth = _levels[level];
+    int x0 = std::min(static_cast<int>(screenMin.x) >> level, size.x - 1);
+    int x1 = std::min(static_cast<int>(screenMax.x) >> level, size.x - 1);
+    int y0 = std::min(static_cast<int>(screenMin.y) >> level, size.y - 1);
+    int y1 = std::min(static_cast<int>(screenMax.y) >> level, size.y - 1);
+
+    float farthestOccluder = 0.0f;
+    for(int y = y0; y <= y1; ++y) {
+        for(int x = x0; x <= x1; ++x) {
+            farthestOccluder = std::max(farthestOccluder, depth[static_cast<size_t>(y) * size.x + x]);
+        }
+    }
+
+    if(nearestDepth > farthestOccluder) {
+        _stats.occluded++;
+        return Result::OCCLUDED;
+    }
+    return Result::VISIBLE;
+}
@@ -0,0 +1,50 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// Low resolution CPU occlusion culler. Nearby occluders are rasterized as
+// boxes into a small depth buffer, a hierarchical max-depth pyramid (Hi-Z)
+// is built from it, and bounding boxes are then tested against the pyramid
+// before any draw call is issued for them.
+class OcclusionCuller {
+public:
+    enum class Result {
+        VISIBLE,
+        FRUSTUM_CULLED,
+        OCCLUDED
+    };
+
+    struct Stats {
+        unsigned int occludersRasterized;
+        unsigned int tested;
+        unsigned int frustumCulled;
+        unsigned int occluded;
+    };
+
+    OcclusionCuller(int width = 256, int height = 128);
+
+    void beginFrame(const glm::mat4& viewProjMtx);
+    // boxes passed here must lie inside the real geometry so culling stays conservative
+    void addOccluder(const glm::vec3& boxMin, const glm::vec3& boxMax);
+    void buildHierarchy();
+
+    Result testBox(const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+    const Stats& getStats() const { return _stats; }
+
+private:
+    int _width;
+    int _height;
+    glm::mat4 _viewProjMtx;
+    // level 0 is the rasterized depth buffer, each level above holds the max of 2x2 texels below
+    std::vector<std::vector<float>> _levels;
+    std::vector<glm::ivec2> _levelSizes;
+    Stats _stats;
+
+    void _rasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+    glm::vec3 _toScreen(const glm::vec4& clip) const;
+};
+
+#endif // OCCLUSION_CULLER_H
@@ -0,0 +1,394 @@
+#include "ParticleSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARTICLE_SSE
+#endif
+
+// PCG hash, shaders/particle_update.vs.glsl uses the same one
+static uint32_t hashParticle(uint32_t x) {
+    uint32_t state = x * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// uniform in [0, 1], differs per particle, frame and draw k
+static GLfloat randomParticle(uint32_t particle, uint32_t frame, uint32_t k) {
+    return static_cast<GLfloat>(hashParticle(particle ^ hashParticle(frame * 8u + k))) / 4294967295.0f;
+}
+
+ParticleSystem::ParticleSystem()
+    : _numParticles(0),
+      _gpuSimulation(false),
+      _current(0),
+      _frame(0),
+      _updateUniformLocations{-1, -1, -1, -1, -1, -1},
+      _renderUniformLocations{-1, -1, -1, -1, -1, -1},
+      _stats{0, 0.0}
+{}
+
+ParticleSystem::~ParticleSystem() {
+    release();
+}
+
+GLuint ParticleSystem::addEmitter(const Emitter& emitter, GLuint numParticles) {
+    if(_emitters.size() >= MAX_EMITTERS) {
+        fprintf( stderr, "[ERROR]: particle systems are limited to %u emitters\n", MAX_EMITTERS );
+        return MAX_EMITTERS - 1;
+    }
+    _emitters.push_back(emitter);
+    _numParticles += numParticles;
+    _emitterEnds.push_back(_numParticles);
+    return static_cast<GLuint>(_emitters.size() - 1);
+}
+
+void ParticleSystem::clearEmitters() {
+    _emitters.clear();
+    _emitterEnds.clear();
+    _numParticles = 0;
+}
+
+bool ParticleSystem::create(GpuResourceRegistry& registry, bool gpuSimulation) {
+    release();
+
+    GLuint renderProgram = _linkProgram("shaders/particle.vs.glsl", "shaders/particle.fs.glsl", nullptr, 0);
+    if(renderProgram == 0) return false;
+    _renderProgram = registry.adopt(GpuResourceType::PROGRAM, renderProgram, 0, "particle render program");
+    _renderUniformLocations.viewMatrix = glGetUniformLocation(renderProgram, "viewMatrix");
+    _renderUniformLocations.projectionMatrix = glGetUniformLocation(renderProgram, "projectionMatrix");
+    _renderUniformLocations.emitterEnds = glGetUniformLocation(renderProgram, "emitterEnds");
+    _renderUniformLocations.emitterStartColors = glGetUniformLocation(renderProgram, "emitterStartColors");
+    _renderUniformLocations.emitterEndColors = glGetUniformLocation(renderProgram, "emitterEndColors");
+    _renderUniformLocations.emitterSizes = glGetUniformLocation(renderProgram, "emitterSizes");
+
+    _gpuSimulation = gpuSimulation;
+    if(_gpuSimulation) {
+        const char* const FEEDBACK_VARYINGS[] = {"outPositionAge", "outVelocityLifetime"};
+        GLuint updateProgram = _linkProgram("shaders/particle_update.vs.glsl", nullptr, FEEDBACK_VARYINGS, 2);
+        if(updateProgram == 0) {
+            fprintf( stderr, "[ERROR]: particle update program failed, simulating particles on the CPU\n" );
+            _gpuSimulation = false;
+        } else {
+            _updateProgram = registry.adopt(GpuResourceType::PROGRAM, updateProgram, 0, "particle update program");
+            _updateUniformLocations.deltaTime = glGetUniformLocation(updateProgram, "deltaTime");
+            _updateUniformLocations.frameSeed = glGetUniformLocation(updateProgram, "frameSeed");
+            _updateUniformLocations.emitterEnds = glGetUniformLocation(updateProgram, "emitterEnds");
+            _updateUniformLocations.emitterPositionRadius = glGetUniformLocation(updateProgram, "emitterPositionRadius");
+            _updateUniformLocations.emitterVelocitySpread = glGetUniformLocation(updateProgram, "emitterVelocitySpread");
+            _updateUniformLocations.emitterAccelerationLifetime = glGetUniformLocation(updateProgram, "emitterAccelerationLifetime");
+        }
+    }
+
+    std::vector<Particle> particles;
+    _initialParticles(particles);
+    GLsizeiptr bytes = static_cast<GLsizeiptr>(particles.size() * sizeof(Particle));
+
+    // the CPU path streams into a single buffer, the GPU path ping-pongs between two
+    GLuint numBuffers = (_gpuSimulation ? 2 : 1);
+    for(GLuint i = 0; i < numBuffers; ++i) {
+        _vertexArrays[i] = registry.createVertexArray("particle VAO");
+        _buffers[i] = registry.createBuffer(GL_ARRAY_BUFFER, bytes, particles.data(),
+                                            (_gpuSimulation ? GL_DYNAMIC_COPY : GL_STREAM_DRAW), "particle VBO");
+        // one particle per instance, for drawing as well as for the update
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, positionAge));
+        glVertexAttribDivisor(0, 1);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Particle), (void*)offsetof(Particle, velocityLifetime));
+        glVertexAttribDivisor(1, 1);
+    }
+    glBindVertexArray(0);
+    _current = 0;
+    _frame = 0;
+
+    if(!_gpuSimulation) {
+        _arrays.positionX.resize(_numParticles);
+        _arrays.positionY.resize(_numParticles);
+        _arrays.positionZ.resize(_numParticles);
+        _arrays.velocityX.resize(_numParticles);
+        _arrays.velocityY.resize(_numParticles);
+        _arrays.velocityZ.resize(_numParticles);
+        _arrays.age.resize(_numParticles);
+        _arrays.lifetime.resize(_numParticles);
+        for(GLuint i = 0; i < _numParticles; ++i) {
+            _arrays.positionX[i] = particles[i].positionAge.x;
+            _arrays.positionY[i] = particles[i].positionAge.y;
+            _arrays.positionZ[i] = particles[i].positionAge.z;
+            _arrays.age[i] = particles[i].positionAge.w;
+            _arrays.velocityX[i] = particles[i].velocityLifetime.x;
+            _arrays.velocityY[i] = particles[i].velocityLifetime.y;
+            _arrays.velocityZ[i] = particles[i].velocityLifetime.z;
+            _arrays.lifetime[i] = particles[i].velocityLifetime.w;
+        }
+        _staging = std::move(particles);
+    }
+
+    _stats = {_numParticles, 0.0};
+    fprintf( stdout, "[INFO]: %u particles from %zu emitters, simulated on the %s\n", _numParticles, _emitters.size(),
+             (_gpuSimulation ? "GPU with transform feedback" : "CPU") );
+    return true;
+}
+
+void ParticleSystem::release() {
+    for(GpuHandle& vertexArray : _vertexArrays) vertexArray.reset();
+    for(GpuHandle& buffer : _buffers) buffer.reset();
+    _updateProgram.reset();
+    _renderProgram.reset();
+    _arrays = ParticleArrays();
+    _staging.clear();
+}
+
+void ParticleSystem::update(RenderStateCache& stateCache, GLfloat deltaTime) {
+    if(_numParticles == 0 || !_renderProgram.isValid()) return;
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if(_gpuSimulation) {
+        _updateOnGpu(stateCache, deltaTime);
+    } else {
+        _updateOnCpu(deltaTime);
+    }
+    _frame++;
+
+    _stats.updateUs = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void ParticleSystem::draw(RenderStateCache& stateCache, const glm::mat4& viewMtx, const glm::mat4& projMtx) const {
+    if(_numParticles == 0 || !_renderProgram.isValid()) return;
+
+    GLint emitterEnds[MAX_EMITTERS];
+    glm::vec4 startColors[MAX_EMITTERS];
+    glm::vec4 endColors[MAX_EMITTERS];
+    GLfloat sizes[MAX_EMITTERS];
+    GLsizei numEmitters = static_cast<GLsizei>(_emitters.size());
+    for(GLsizei i = 0; i < numEmitters; ++i) {
+        emitterEnds[i] = static_cast<GLint>(_emitterEnds[i]);
+        startColors[i] = _emitters[i].startColor;
+        endColors[i] = _emitters[i].endColor;
+        sizes[i] = _emitters[i].size;
+    }
+
+    // additive, the result does not depend on the order the particles land in
+    stateCache.setBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    stateCache.useProgram(_renderProgram.get());
+    glUniformMatrix4fv(_renderUniformLocations.viewMatrix, 1, GL_FALSE, &viewMtx[0][0]);
+    glUniformMatrix4fv(_renderUniformLocations.projectionMatrix, 1, GL_FALSE, &projMtx[0][0]);
+    glUniform1iv(_renderUniformLocations.emitterEnds, numEmitters, emitterEnds);
+    glUniform4fv(_renderUniformLocations.emitterStartColors, numEmitters, &startColors[0][0]);
+    glUniform4fv(_renderUniformLocations.emitterEndColors, numEmitters, &endColors[0][0]);
+    glUniform1fv(_renderUniformLocations.emitterSizes, numEmitters, sizes);
+
+    glBindVertexArray(_vertexArrays[_current].get());
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(_numParticles));
+    glBindVertexArray(0);
+
+    // the rest of the engine blends with the standard alpha over
+    stateCache.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void ParticleSystem::_updateOnGpu(RenderStateCache& stateCache, GLfloat deltaTime) {
+    GLint emitterEnds[MAX_EMITTERS];
+    glm::vec4 positionRadius[MAX_EMITTERS];
+    glm::vec4 velocitySpread[MAX_EMITTERS];
+    glm::vec4 accelerationLifetime[MAX_EMITTERS];
+    GLsizei numEmitters = static_cast<GLsizei>(_emitters.size());
+    for(GLsizei i = 0; i < numEmitters; ++i) {
+        const Emitter& emitter = _emitters[i];
+        emitterEnds[i] = static_cast<GLint>(_emitterEnds[i]);
+        positionRadius[i] = glm::vec4(emitter.position, emitter.radius);
+        velocitySpread[i] = glm::vec4(emitter.velocity, emitter.spread);
+        // a zero lifetime tells the shader not to respawn
+        accelerationLifetime[i] = glm::vec4(emitter.acceleration, (emitter.active ? emitter.lifetime : 0.0f));
+    }
+
+    stateCache.useProgram(_updateProgram.get());
+    glUniform1f(_updateUniformLocations.deltaTime, deltaTime);
+    glUniform1ui(_updateUniformLocations.frameSeed, _frame);
+    glUniform1iv(_updateUniformLocations.emitterEnds, numEmitters, emitterEnds);
+    glUniform4fv(_updateUniformLocations.emitterPositionRadius, numEmitters, &positionRadius[0][0]);
+    glUniform4fv(_updateUniformLocations.emitterVelocitySpread, numEmitters, &velocitySpread[0][0]);
+    glUniform4fv(_updateUniformLocations.emitterAccelerationLifetime, numEmitters, &accelerationLifetime[0][0]);
+
+    // read the current buffer as instances of a single point, capture into the other one
+    GLuint next = 1 - _current;
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(_vertexArrays[_current].get());
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, _buffers[next].get());
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArraysInstanced(GL_POINTS, 0, 1, static_cast<GLsizei>(_numParticles));
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    _current = next;
+}
+
+void ParticleSystem::_updateOnCpu(GLfloat deltaTime) {
+    ParticleArrays& a = _arrays;
+    GLuint begin = 0;
+    for(size_t e = 0; e < _emitters.size(); ++e) {
+        const Emitter& emitter = _emitters[e];
+        const GLuint END = _emitterEnds[e];
+        GLuint i = begin;
+
+#ifdef PARTICLE_SSE
+        const __m128 DELTA_TIME = _mm_set1_ps(deltaTime);
+        const __m128 ZERO = _mm_setzero_ps();
+        const __m128 ACCELERATION_X = _mm_set1_ps(emitter.acceleration.x * deltaTime);
+        const __m128 ACCELERATION_Y = _mm_set1_ps(emitter.acceleration.y * deltaTime);
+        const __m128 ACCELERATION_Z = _mm_set1_ps(emitter.acceleration.z * deltaTime);
+        for(; i + 4 <= END; i += 4) {
+            __m128 age = _mm_add_ps(_mm_loadu_ps(&a.age[i]), DELTA_TIME);
+            __m128 lifetime = _mm_loadu_ps(&a.lifetime[i]);
+            __m128 expired = _mm_cmpge_ps(age, lifetime);
+            // born and not yet expired, the rest keep their position
+            __m128 alive = _mm_andnot_ps(expired, _mm_cmpge_ps(age, ZERO));
+            _mm_storeu_ps(&a.age[i], age);
+
+            __m128 velocityX = _mm_add_ps(_mm_loadu_ps(&a.velocityX[i]), _mm_and_ps(alive, ACCELERATION_X));
+            __m128 velocityY = _mm_add_ps(_mm_loadu_ps(&a.velocityY[i]), _mm_and_ps(alive, ACCELERATION_Y));
+            __m128 velocityZ = _mm_add_ps(_mm_loadu_ps(&a.velocityZ[i]), _mm_and_ps(alive, ACCELERATION_Z));
+            _mm_storeu_ps(&a.velocityX[i], velocityX);
+            _mm_storeu_ps(&a.velocityY[i], velocityY);
+            _mm_storeu_ps(&a.velocityZ[i], velocityZ);
+            _mm_storeu_ps(&a.positionX[i], _mm_add_ps(_mm_loadu_ps(&a.positionX[i]), _mm_and_ps(alive, _mm_mul_ps(velocityX, DELTA_TIME))));
+            _mm_storeu_ps(&a.positionY[i], _mm_add_ps(_mm_loadu_ps(&a.positionY[i]), _mm_and_ps(alive, _mm_mul_ps(velocityY, DELTA_TIME))));
+            _mm_storeu_ps(&a.positionZ[i], _mm_add_ps(_mm_loadu_ps(&a.positionZ[i]), _mm_and_ps(alive, _mm_mul_ps(velocityZ, DELTA_TIME))));
+
+            int expiredMask = _mm_movemask_ps(expired);
+            if(expiredMask != 0 && emitter.active) {
+                for(GLuint lane = 0; lane < 4; ++lane) {
+                    if(expiredMask & (1 << lane)) _respawn(i + lane, emitter);
+                }
+            }
+        }
+#endif
+
+        // what is left over, or everything without SSE
+        for(; i < END; ++i) {
+            a.age[i] += deltaTime;
+            if(a.age[i] >= a.lifetime[i]) {
+                if(emitter.active) _respawn(i, emitter);
+            } else if(a.age[i] >= 0.0f) {
+                a.velocityX[i] += emitter.acceleration.x * deltaTime;
+                a.velocityY[i] += emitter.acceleration.y * deltaTime;
+                a.velocityZ[i] += emitter.acceleration.z * deltaTime;
+                a.positionX[i] += a.velocityX[i] * deltaTime;
+                a.positionY[i] += a.velocityY[i] * deltaTime;
+                a.positionZ[i] += a.velocityZ[i] * deltaTime;
+            }
+        }
+        begin = END;
+    }
+
+    for(GLuint i = 0; i < _numParticles; ++i) {
+        _staging[i].positionAge = glm::vec4(a.positionX[i], a.positionY[i], a.positionZ[i], a.age[i]);
+        _staging[i].velocityLifetime = glm::vec4(a.velocityX[i], a.velocityY[i], a.velocityZ[i], a.lifetime[i]);
+    }
+
+    // orphan the previous contents so the upload does not wait on the draw still reading them
+    GLsizeiptr bytes = static_cast<GLsizeiptr>(_numParticles * sizeof(Particle));
+    glBindBuffer(GL_ARRAY_BUFFER, _buffers[0].get());
+    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, _staging.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ParticleSystem::_respawn(GLuint particle, const Emitter& emitter) {
+    // same draws as the update shader
+    GLfloat angle = randomParticle(particle, _frame, 0) * 6.28318531f;
+    GLfloat radius = emitter.radius * sqrtf(randomParticle(particle, _frame, 1));
+    _arrays.positionX[particle] = emitter.position.x + cosf(angle) * radius;
+    _arrays.positionY[particle] = emitter.position.y;
+    _arrays.positionZ[particle] = emitter.position.z + sinf(angle) * radius;
+    _arrays.velocityX[particle] = emitter.velocity.x + (randomParticle(particle, _frame, 2) * 2.0f - 1.0f) * emitter.spread;
+    _arrays.velocityY[particle] = emitter.velocity.y + (randomParticle(particle, _frame, 3) * 2.0f - 1.0f) * emitter.spread;
+    _arrays.velocityZ[particle] = emitter.velocity.z + (randomParticle(particle, _frame, 4) * 2.0f - 1.0f) * emitter.spread;
+    _arrays.lifetime[particle] = emitter.lifetime * (0.75f + 0.5f * randomParticle(particle, _frame, 5));
+    _arrays.age[particle] = 0.0f;
+}
+
+void ParticleSystem::_initialParticles(std::vector<Particle>& particles) const {
+    particles.resize(_numParticles);
+    GLuint begin = 0;
+    for(size_t e = 0; e < _emitters.size(); ++e) {
+        for(GLuint i = begin; i < _emitterEnds[e]; ++i) {
+            // unborn with a zero lifetime, the first update that brings the age to zero
+            // spawns them, staggered over one lifetime so emission starts out steady
+            GLfloat age = -randomParticle(i, UINT_MAX, 6) * _emitters[e].lifetime;
+            particles[i].positionAge = glm::vec4(_emitters[e].position, age);
+            particles[i].velocityLifetime = glm::vec4(0.0f);
+        }
+        begin = _emitterEnds[e];
+    }
+}
+
+GLuint ParticleSystem::_compileShader(GLenum type, const char* filename) {
+    std::ifstream file(filename);
+    if(!file) {
+        fprintf( stderr, "[ERROR]: Could not open shader \"%s\"\n", filename );
+        return 0;
+    }
+    std::stringstream source;
+    source << file.rdbuf();
+    std::string sourceString = source.str();
+    const char* pSource = sourceString.c_str();
+
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &pSource, nullptr);
+    glCompileShader(shader);
+
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if(status != GL_TRUE) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        fprintf( stderr, "[ERROR]: Could not compile \"%s\": %s\n", filename, log );
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint ParticleSystem::_linkProgram(const char* vertexFilename, const char* fragmentFilename, const char* const* feedbackVaryings, GLsizei numFeedbackVaryings) {
+    // CSCI441::ShaderProgram links in its constructor, too early to declare the captured varyings
+    GLuint vertexShader = _compileShader(GL_VERTEX_SHADER, vertexFilename);
+    GLuint fragmentShader = (fragmentFilename != nullptr ? _compileShader(GL_FRAGMENT_SHADER, fragmentFilename) : 0);
+    if(vertexShader == 0 || (fragmentFilename != nullptr && fragmentShader == 0)) {
+        if(vertexShader != 0) glDeleteShader(vertexShader);
+        if(fragmentShader != 0) glDeleteShader(fragmentShader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    if(fragmentShader != 0) glAttachShader(program, fragmentShader);
+    if(numFeedbackVaryings > 0) {
+        glTransformFeedbackVaryings(program, numFeedbackVaryings, feedbackVaryings, GL_INTERLEAVED_ATTRIBS);
+    }
+    glLinkProgram(program);
+
+    // the program keeps the compiled stages alive for as long as it needs them
+    glDeleteShader(vertexShader);
+    if(fragmentShader != 0) glDeleteShader(fragmentShader);
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if(status != GL_TRUE) {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        fprintf( stderr, "[ERROR]: Could not link \"%s\": %s\n", vertexFilename, log );
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
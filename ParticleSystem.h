@@ -0,0 +1,137 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "GpuResourceRegistry.h"
+#include "RenderStateCache.h"
+
+// Particle effects simulated without touching the CPU per particle.
+// Every emitter owns a fixed range of the particle buffer; a particle that
+// outlives its lifetime respawns at its emitter, so the count never changes
+// and nothing is allocated after create().
+//
+// On the GPU path particles live in two vertex buffers. Each update runs the
+// particles of one buffer through a vertex shader and captures the result
+// into the other with transform feedback, with rasterization discarded; the
+// two swap roles every update. The CPU path keeps the particles in structure
+// of arrays form, integrates four at a time with SSE and streams the result
+// into the same buffer layout. Both draw the current buffer as instanced
+// camera facing quads, blended additively so they need no sorting.
+class ParticleSystem {
+public:
+    // launch parameters, positions and velocities in world space
+    struct Emitter {
+        glm::vec3 position;
+        // particles spawn on a horizontal disc of this radius around the position
+        GLfloat radius;
+        glm::vec3 velocity;
+        // random velocity added per axis, up to this much either way
+        GLfloat spread;
+        glm::vec3 acceleration;
+        // mean lifetime in seconds, each particle varies it by +-25%
+        GLfloat lifetime;
+        glm::vec4 startColor;
+        glm::vec4 endColor;
+        // half the width of a particle at birth, it shrinks to half of that by the end
+        GLfloat size;
+        // an inactive emitter lets its particles die out instead of respawning them
+        bool active;
+    };
+
+    struct Stats {
+        GLuint particles;
+        // microseconds the CPU spent in the last update, simulating or issuing it
+        double updateUs;
+    };
+
+    static constexpr GLuint MAX_EMITTERS = 16;
+
+    ParticleSystem();
+    ~ParticleSystem();
+    ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+    // emitters get their share of the buffer in the order they are added, before create()
+    GLuint addEmitter(const Emitter& emitter, GLuint numParticles);
+    Emitter& getEmitter(GLuint emitter) { return _emitters[emitter]; }
+    GLuint getNumEmitters() const { return static_cast<GLuint>(_emitters.size()); }
+    void clearEmitters();
+
+    // allocates the buffers and programs, falls back to the CPU path when the
+    // transform feedback program cannot be built
+    bool create(GpuResourceRegistry& registry, bool gpuSimulation);
+    void release();
+    bool isGpuSimulation() const { return _gpuSimulation; }
+
+    // advances every particle by a fixed step
+    void update(RenderStateCache& stateCache, GLfloat deltaTime);
+    // expects the translucent pass state, sets its own blending
+    void draw(RenderStateCache& stateCache, const glm::mat4& viewMtx, const glm::mat4& projMtx) const;
+
+    const Stats& getStats() const { return _stats; }
+
+private:
+    // interleaved vertex layout of both buffers and the transform feedback output
+    struct Particle {
+        glm::vec4 positionAge;
+        glm::vec4 velocityLifetime;
+    };
+
+    // the CPU copy, one array per component
+    struct ParticleArrays {
+        std::vector<GLfloat> positionX, positionY, positionZ;
+        std::vector<GLfloat> velocityX, velocityY, velocityZ;
+        std::vector<GLfloat> age, lifetime;
+    };
+
+    std::vector<Emitter> _emitters;
+    // one past the last particle of each emitter
+    std::vector<GLuint> _emitterEnds;
+    GLuint _numParticles;
+
+    bool _gpuSimulation;
+    GpuHandle _buffers[2];
+    GpuHandle _vertexArrays[2];
+    // buffer holding the latest state
+    GLuint _current;
+    uint32_t _frame;
+
+    GpuHandle _updateProgram;
+    GpuHandle _renderProgram;
+    struct UpdateUniformLocations {
+        GLint deltaTime;
+        GLint frameSeed;
+        GLint emitterEnds;
+        GLint emitterPositionRadius;
+        GLint emitterVelocitySpread;
+        GLint emitterAccelerationLifetime;
+    } _updateUniformLocations;
+    struct RenderUniformLocations {
+        GLint viewMatrix;
+        GLint projectionMatrix;
+        GLint emitterEnds;
+        GLint emitterStartColors;
+        GLint emitterEndColors;
+        GLint emitterSizes;
+    } _renderUniformLocations;
+
+    ParticleArrays _arrays;
+    std::vector<Particle> _staging;
+
+    Stats _stats;
+
+    void _updateOnGpu(RenderStateCache& stateCache, GLfloat deltaTime);
+    void _updateOnCpu(GLfloat deltaTime);
+    void _respawn(GLuint particle, const Emitter& emitter);
+    void _initialParticles(std::vector<Particle>& particles) const;
+
+    static GLuint _compileShader(GLenum type, const char* filename);
+    static GLuint _linkProgram(const char* vertexFilename, const char* fragmentFilename, const char* const* feedbackVaryings, GLsizei numFeedbackVaryings);
+};
+
+#endif // PARTICLE_SYSTEM_H
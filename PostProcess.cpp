@@ -0,0 +1,272 @@
+#include "PostProcess.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    const char* PASS_NAMES[PostProcess::NUM_PASSES] = {
+        "bloom downsample half",
+        "bloom downsample quarter",
+        "bloom upsample",
+        "tone map"
+    };
+
+    const double PIXELS_1080P = 1920.0 * 1080.0;
+
+    // maps the destination's texture coordinates onto the used corner of a source texture,
+    // clamping taps to the last used texel so nothing stale past it bleeds in
+    void sendSourceRegion(GLint scaleLocation, GLint maxLocation, GLint usedWidth, GLint usedHeight,
+                          GLint textureWidth, GLint textureHeight) {
+        GLfloat width = static_cast<GLfloat>(textureWidth), height = static_cast<GLfloat>(textureHeight);
+        glUniform2f(scaleLocation, usedWidth / width, usedHeight / height);
+        glUniform2f(maxLocation, (usedWidth - 0.5f) / width, (usedHeight - 0.5f) / height);
+    }
+
+    GLint halfSize(GLint size) { return std::max(1, (size + 1) / 2); }
+}
+
+PostProcess::PostProcess()
+    : _downsampleProgram(0),
+      _upsampleProgram(0),
+      _toneMapProgram(0),
+      _downsampleLocations(),
+      _upsampleLocations(),
+      _toneMapLocations(),
+      _keepSamples(false),
+      _overBudgetReported(false),
+      _vao(0),
+      _destinationWidth(0),
+      _destinationHeight(0)
+{
+    for(int pass = 0; pass < NUM_PASSES; ++pass) {
+        _isPassEnabled[pass] = true;
+        _pTimers[pass] = nullptr;
+        _passMs[pass] = 0.0;
+        _numSamples[pass] = 0;
+    }
+}
+
+PostProcess::~PostProcess() {
+    release();
+}
+
+void PostProcess::setPrograms(GLuint downsampleProgram, GLuint upsampleProgram, GLuint toneMapProgram) {
+    _downsampleProgram = downsampleProgram;
+    _downsampleLocations.source = glGetUniformLocation(downsampleProgram, "source");
+    _downsampleLocations.sourceScale = glGetUniformLocation(downsampleProgram, "sourceScale");
+    _downsampleLocations.sourceMax = glGetUniformLocation(downsampleProgram, "sourceMax");
+    _downsampleLocations.texelSize = glGetUniformLocation(downsampleProgram, "texelSize");
+    _downsampleLocations.threshold = glGetUniformLocation(downsampleProgram, "threshold");
+    _downsampleLocations.knee = glGetUniformLocation(downsampleProgram, "knee");
+
+    _upsampleProgram = upsampleProgram;
+    _upsampleLocations.source = glGetUniformLocation(upsampleProgram, "source");
+    _upsampleLocations.sourceScale = glGetUniformLocation(upsampleProgram, "sourceScale");
+    _upsampleLocations.sourceMax = glGetUniformLocation(upsampleProgram, "sourceMax");
+    _upsampleLocations.texelSize = glGetUniformLocation(upsampleProgram, "texelSize");
+
+    _toneMapProgram = toneMapProgram;
+    _toneMapLocations.scene = glGetUniformLocation(toneMapProgram, "scene");
+    _toneMapLocations.sceneScale = glGetUniformLocation(toneMapProgram, "sceneScale");
+    _toneMapLocations.sceneMax = glGetUniformLocation(toneMapProgram, "sceneMax");
+    _toneMapLocations.bloom = glGetUniformLocation(toneMapProgram, "bloom");
+    _toneMapLocations.bloomScale = glGetUniformLocation(toneMapProgram, "bloomScale");
+    _toneMapLocations.bloomMax = glGetUniformLocation(toneMapProgram, "bloomMax");
+    _toneMapLocations.bloomIntensity = glGetUniformLocation(toneMapProgram, "bloomIntensity");
+    _toneMapLocations.exposure = glGetUniformLocation(toneMapProgram, "exposure");
+    _toneMapLocations.toneMapping = glGetUniformLocation(toneMapProgram, "toneMapping");
+
+    // samplers never change unit, the knee and exposure never change at all
+    glProgramUniform1i(_downsampleProgram, _downsampleLocations.source, static_cast<GLint>(SOURCE_TEXTURE_UNIT));
+    glProgramUniform1f(_downsampleProgram, _downsampleLocations.knee, BLOOM_KNEE);
+    glProgramUniform1i(_upsampleProgram, _upsampleLocations.source, static_cast<GLint>(SOURCE_TEXTURE_UNIT));
+    glProgramUniform1i(_toneMapProgram, _toneMapLocations.scene, static_cast<GLint>(SOURCE_TEXTURE_UNIT));
+    glProgramUniform1i(_toneMapProgram, _toneMapLocations.bloom, static_cast<GLint>(BLOOM_TEXTURE_UNIT));
+    glProgramUniform1f(_toneMapProgram, _toneMapLocations.exposure, EXPOSURE);
+}
+
+void PostProcess::apply(GpuResourceRegistry& registry, RenderStateCache& renderStateCache,
+                        GLuint sourceTexture, GLint sourceWidth, GLint sourceHeight, GLint textureWidth, GLint textureHeight,
+                        GLuint destinationFramebuffer, GLint destinationWidth, GLint destinationHeight) {
+    _readTimers(false);
+
+    if(_vao == 0) glGenVertexArrays(1, &_vao);
+    // the levels follow the source texture, which only grows
+    if(halfSize(textureWidth) > _levels[0].width || halfSize(textureHeight) > _levels[0].height) {
+        _allocateLevels(registry, renderStateCache, textureWidth, textureHeight);
+    }
+    _destinationWidth = destinationWidth;
+    _destinationHeight = destinationHeight;
+
+    GLint halfWidth = halfSize(sourceWidth), halfHeight = halfSize(sourceHeight);
+    GLint quarterWidth = halfSize(halfWidth), quarterHeight = halfSize(halfHeight);
+    bool bloom = _isPassEnabled[BLOOM_DOWNSAMPLE_HALF];
+    bool quarterLevel = bloom && _isPassEnabled[BLOOM_DOWNSAMPLE_QUARTER] && _isPassEnabled[BLOOM_UPSAMPLE];
+
+    renderStateCache.setEnabled(GL_DEPTH_TEST, false);
+    renderStateCache.setEnabled(GL_CULL_FACE, false);
+    renderStateCache.setEnabled(GL_BLEND, false);
+    glBindVertexArray(_vao);
+
+    if(bloom) {
+        _beginPass(BLOOM_DOWNSAMPLE_HALF);
+        glBindFramebuffer(GL_FRAMEBUFFER, _levels[0].framebuffer);
+        glViewport(0, 0, halfWidth, halfHeight);
+        renderStateCache.useProgram(_downsampleProgram);
+        renderStateCache.bindTexture(SOURCE_TEXTURE_UNIT, GL_TEXTURE_2D, sourceTexture);
+        sendSourceRegion(_downsampleLocations.sourceScale, _downsampleLocations.sourceMax, sourceWidth, sourceHeight, textureWidth, textureHeight);
+        glUniform2f(_downsampleLocations.texelSize, 1.0f / textureWidth, 1.0f / textureHeight);
+        glUniform1f(_downsampleLocations.threshold, BLOOM_THRESHOLD);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        _endPass(BLOOM_DOWNSAMPLE_HALF);
+    }
+
+    if(quarterLevel) {
+        _beginPass(BLOOM_DOWNSAMPLE_QUARTER);
+        glBindFramebuffer(GL_FRAMEBUFFER, _levels[1].framebuffer);
+        glViewport(0, 0, quarterWidth, quarterHeight);
+        renderStateCache.bindTexture(SOURCE_TEXTURE_UNIT, GL_TEXTURE_2D, _levels[0].texture.get());
+        sendSourceRegion(_downsampleLocations.sourceScale, _downsampleLocations.sourceMax, halfWidth, halfHeight, _levels[0].width, _levels[0].height);
+        glUniform2f(_downsampleLocations.texelSize, 1.0f / _levels[0].width, 1.0f / _levels[0].height);
+        // the half level is already thresholded
+        glUniform1f(_downsampleLocations.threshold, 0.0f);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        _endPass(BLOOM_DOWNSAMPLE_QUARTER);
+
+        // blurred back up and added onto the half level
+        _beginPass(BLOOM_UPSAMPLE);
+        glBindFramebuffer(GL_FRAMEBUFFER, _levels[0].framebuffer);
+        glViewport(0, 0, halfWidth, halfHeight);
+        renderStateCache.setEnabled(GL_BLEND, true);
+        renderStateCache.setBlendFunc(GL_ONE, GL_ONE);
+        renderStateCache.useProgram(_upsampleProgram);
+        renderStateCache.bindTexture(SOURCE_TEXTURE_UNIT, GL_TEXTURE_2D, _levels[1].texture.get());
+        sendSourceRegion(_upsampleLocations.sourceScale, _upsampleLocations.sourceMax, quarterWidth, quarterHeight, _levels[1].width, _levels[1].height);
+        glUniform2f(_upsampleLocations.texelSize, 1.0f / _levels[1].width, 1.0f / _levels[1].height);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        renderStateCache.setEnabled(GL_BLEND, false);
+        _endPass(BLOOM_UPSAMPLE);
+    }
+
+    // tone mapping off still has to bring the scene to the destination, only its curve is skipped
+    _beginPass(TONE_MAP);
+    glBindFramebuffer(GL_FRAMEBUFFER, destinationFramebuffer);
+    glViewport(0, 0, destinationWidth, destinationHeight);
+    renderStateCache.useProgram(_toneMapProgram);
+    renderStateCache.bindTexture(SOURCE_TEXTURE_UNIT, GL_TEXTURE_2D, sourceTexture);
+    sendSourceRegion(_toneMapLocations.sceneScale, _toneMapLocations.sceneMax, sourceWidth, sourceHeight, textureWidth, textureHeight);
+    if(bloom) {
+        renderStateCache.bindTexture(BLOOM_TEXTURE_UNIT, GL_TEXTURE_2D, _levels[0].texture.get());
+        sendSourceRegion(_toneMapLocations.bloomScale, _toneMapLocations.bloomMax, halfWidth, halfHeight, _levels[0].width, _levels[0].height);
+    }
+    glUniform1f(_toneMapLocations.bloomIntensity, (bloom ? BLOOM_INTENSITY : 0.0f));
+    glUniform1i(_toneMapLocations.toneMapping, (_isPassEnabled[TONE_MAP] ? 1 : 0));
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    _endPass(TONE_MAP);
+
+    glBindVertexArray(0);
+}
+
+void PostProcess::release() {
+    for(Level& level : _levels) {
+        if(level.framebuffer != 0) glDeleteFramebuffers(1, &level.framebuffer);
+        level.framebuffer = 0;
+        level.texture.reset();
+        level.width = 0;
+        level.height = 0;
+    }
+    if(_vao != 0) {
+        glDeleteVertexArrays(1, &_vao);
+        _vao = 0;
+    }
+    for(int pass = 0; pass < NUM_PASSES; ++pass) {
+        delete _pTimers[pass];
+        _pTimers[pass] = nullptr;
+        _numSamples[pass] = 0;
+    }
+}
+
+double PostProcess::getCostAt1080p() const {
+    if(_destinationWidth <= 0 || _destinationHeight <= 0) return 0.0;
+    double totalMs = 0.0;
+    for(int pass = 0; pass < NUM_PASSES; ++pass) totalMs += getPassTime(static_cast<Pass>(pass));
+    return totalMs * PIXELS_1080P / (static_cast<double>(_destinationWidth) * _destinationHeight);
+}
+
+const char* PostProcess::getPassName(Pass pass) {
+    return PASS_NAMES[pass];
+}
+
+void PostProcess::clearSamples() {
+    for(std::vector<double>& samples : _samples) samples.clear();
+}
+
+void PostProcess::finishTimers() {
+    _readTimers(true);
+}
+
+void PostProcess::_allocateLevels(GpuResourceRegistry& registry, RenderStateCache& renderStateCache, GLint textureWidth, GLint textureHeight) {
+    static const char* LABELS[NUM_LEVELS] = {"bloom half level", "bloom quarter level"};
+
+    GLint width = textureWidth, height = textureHeight;
+    for(int i = 0; i < NUM_LEVELS; ++i) {
+        width = halfSize(width);
+        height = halfSize(height);
+        Level& level = _levels[i];
+        if(level.framebuffer == 0) glGenFramebuffers(1, &level.framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, level.framebuffer);
+
+        GLuint texture;
+        glGenTextures(1, &texture);
+        renderStateCache.bindTexture(BLOOM_TEXTURE_UNIT, GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, width, height, 0, GL_RGB, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        level.texture = registry.adopt(GpuResourceType::TEXTURE, texture, static_cast<size_t>(width) * height * 4, LABELS[i]);
+        level.width = width;
+        level.height = height;
+
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if(status != GL_FRAMEBUFFER_COMPLETE) {
+            fprintf( stderr, "[ERROR]: %s target is incomplete (0x%x)\n", LABELS[i], status );
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    fprintf( stdout, "[INFO]: bloom pyramid allocated at %dx%d and %dx%d\n",
+             _levels[0].width, _levels[0].height, _levels[1].width, _levels[1].height );
+}
+
+void PostProcess::_readTimers(bool wait) {
+    for(int pass = 0; pass < NUM_PASSES; ++pass) {
+        if(_pTimers[pass] == nullptr) continue;
+        double elapsedMs;
+        while(_pTimers[pass]->popResult(elapsedMs, wait)) {
+            if(_numSamples[pass] > 0) {
+                _passMs[pass] += SMOOTHING * (elapsedMs - _passMs[pass]);
+            } else {
+                _passMs[pass] = elapsedMs;
+            }
+            ++_numSamples[pass];
+            if(_keepSamples) _samples[pass].push_back(elapsedMs);
+        }
+    }
+
+    // once per run and only after the first frames settle, the overlay and mp_bench --post show the details
+    if(!_overBudgetReported && _numSamples[TONE_MAP] >= BUDGET_CHECK_SAMPLES && getCostAt1080p() > BUDGET_MS_1080P) {
+        fprintf( stdout, "[INFO]: post-processing takes %.2f ms scaled to 1080p, over its %.2f ms budget\n",
+                 getCostAt1080p(), BUDGET_MS_1080P );
+        _overBudgetReported = true;
+    }
+}
+
+void PostProcess::_beginPass(Pass pass) {
+    if(_pTimers[pass] == nullptr) _pTimers[pass] = new GpuTimer();
+    _pTimers[pass]->begin();
+}
+
+void PostProcess::_endPass(Pass pass) {
+    _pTimers[pass]->end();
+}
@@ -0,0 +1,145 @@
+#ifndef POST_PROCESS_H
+#define POST_PROCESS_H
+
+#include <glad/gl.h>
+
+#include <vector>
+
+#include "GpuResourceRegistry.h"
+#include "GpuTimer.h"
+#include "RenderStateCache.h"
+
+// Turns the HDR scene into the displayed image: bloom from a two level
+// pyramid at half and quarter resolution, then exposure, tone mapping and
+// the bloom composite in one pass into the destination framebuffer.
+//
+// The first downsample keeps only what is brighter than BLOOM_THRESHOLD,
+// the quarter level is blurred back up onto the half level with a tent
+// filter and the half level is what gets added to the scene. Levels are
+// GL_R11F_G11F_B10F, four bytes a texel like the LDR targets, and every pass
+// is one full screen triangle with at most nine taps, so at 1080p the whole
+// chain moves under 40 MB of texels, to stay within BUDGET_MS_1080P.
+// Every pass has its own GPU timer and can be switched off; without the
+// quarter level the half level is the whole blur, without the half level
+// there is no bloom, and without tone mapping colors are clamped as the LDR
+// back buffer did.
+class PostProcess {
+public:
+    enum Pass {
+        BLOOM_DOWNSAMPLE_HALF = 0,
+        BLOOM_DOWNSAMPLE_QUARTER,
+        BLOOM_UPSAMPLE,
+        TONE_MAP,
+        NUM_PASSES
+    };
+
+    PostProcess();
+    ~PostProcess();
+    PostProcess(const PostProcess&) = delete;
+    PostProcess& operator=(const PostProcess&) = delete;
+
+    // the engine owns the programs, built from shaders/post.vs.glsl and the bloom and tone map fragment shaders
+    void setPrograms(GLuint downsampleProgram, GLuint upsampleProgram, GLuint toneMapProgram);
+
+    void setPassEnabled(Pass pass, bool enabled) { _isPassEnabled[pass] = enabled; }
+    bool isPassEnabled(Pass pass) const { return _isPassEnabled[pass]; }
+
+    // runs the enabled passes on the scene in the lower left sourceWidth x sourceHeight of
+    // sourceTexture, into the lower left of the destination framebuffer, and leaves it bound
+    void apply(GpuResourceRegistry& registry, RenderStateCache& renderStateCache,
+               GLuint sourceTexture, GLint sourceWidth, GLint sourceHeight, GLint textureWidth, GLint textureHeight,
+               GLuint destinationFramebuffer, GLint destinationWidth, GLint destinationHeight);
+    // deletes the pyramid, the timer queries and the vertex array, call before the context goes away
+    void release();
+
+    // smoothed GPU milliseconds of a pass, 0 while it is switched off
+    double getPassTime(Pass pass) const { return (_isPassEnabled[pass] ? _passMs[pass] : 0.0); }
+    // the enabled passes' time scaled by pixel count to a 1920x1080 destination
+    double getCostAt1080p() const;
+    static const char* getPassName(Pass pass);
+
+    // keeps every pass time read back until clearSamples(), for benchmarks
+    void setKeepSamples(bool keep) { _keepSamples = keep; }
+    const std::vector<double>& getSamples(Pass pass) const { return _samples[pass]; }
+    void clearSamples();
+    // reads back finished pass times, waiting for the ones still in flight
+    void finishTimers();
+
+    static constexpr double BUDGET_MS_1080P = 1.0;
+    // colors brighter than this bloom, the knee blends them in below it
+    static constexpr float BLOOM_THRESHOLD = 1.0f;
+    static constexpr float BLOOM_KNEE = 0.5f;
+    static constexpr float BLOOM_INTENSITY = 0.6f;
+    static constexpr float EXPOSURE = 1.0f;
+    // units the chain binds its inputs to
+    static constexpr GLuint SOURCE_TEXTURE_UNIT = 4;
+    static constexpr GLuint BLOOM_TEXTURE_UNIT = 5;
+
+private:
+    // weight of a new sample in the smoothed pass times
+    static constexpr double SMOOTHING = 0.1;
+    // tone map passes timed before the cost is checked against the budget
+    static constexpr unsigned int BUDGET_CHECK_SAMPLES = 60;
+
+    struct DownsampleLocations {
+        GLint source;
+        GLint sourceScale;
+        GLint sourceMax;
+        GLint texelSize;
+        GLint threshold;
+        GLint knee;
+    };
+    struct UpsampleLocations {
+        GLint source;
+        GLint sourceScale;
+        GLint sourceMax;
+        GLint texelSize;
+    };
+    struct ToneMapLocations {
+        GLint scene;
+        GLint sceneScale;
+        GLint sceneMax;
+        GLint bloom;
+        GLint bloomScale;
+        GLint bloomMax;
+        GLint bloomIntensity;
+        GLint exposure;
+        GLint toneMapping;
+    };
+
+    // one pyramid level, sized for the largest source seen and used in its lower left corner
+    struct Level {
+        GLuint framebuffer = 0;
+        GpuHandle texture;
+        GLint width = 0;
+        GLint height = 0;
+    };
+    static constexpr int NUM_LEVELS = 2;
+
+    GLuint _downsampleProgram;
+    GLuint _upsampleProgram;
+    GLuint _toneMapProgram;
+    DownsampleLocations _downsampleLocations;
+    UpsampleLocations _upsampleLocations;
+    ToneMapLocations _toneMapLocations;
+
+    bool _isPassEnabled[NUM_PASSES];
+    GpuTimer* _pTimers[NUM_PASSES];
+    double _passMs[NUM_PASSES];
+    unsigned int _numSamples[NUM_PASSES];
+    bool _keepSamples;
+    std::vector<double> _samples[NUM_PASSES];
+    bool _overBudgetReported;
+
+    Level _levels[NUM_LEVELS];
+    GLuint _vao;
+    GLint _destinationWidth;
+    GLint _destinationHeight;
+
+    void _allocateLevels(GpuResourceRegistry& registry, RenderStateCache& renderStateCache, GLint textureWidth, GLint textureHeight);
+    void _readTimers(bool wait);
+    void _beginPass(Pass pass);
+    void _endPass(Pass pass);
+};
+
+#endif // POST_PROCESS_H
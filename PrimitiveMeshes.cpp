@@ -0,0 +1,85 @@
+#include "PrimitiveMeshes.h"
+
+#include <string>
+
+using namespace PrimitiveMeshGenerator;
+
+// Same dimensions as the drawSolid* calls they replace, 16 is their tessellation
+template<int N>
+struct SceneryMeshes {
+    static constexpr auto TREE_TRUNK = makeCylinder<N, N>(1.0, 1.0, 5.0);
+    static constexpr auto TREE_LEAVES = makeCone<N, N>(3.0, 8.0);
+    static constexpr auto LAMP_POST = makeCylinder<N, N>(0.2, 0.2, 7.0);
+    static constexpr auto LAMP_BULB = makeSphere<N, N>(0.5);
+};
+
+// the banded order has to beat plain row order or it is not worth having
+static constexpr double ROW_ORDER_ACMR = simulateAcmr(emitGridIndices<16, 16, 16 * 16 * 6>(false, false, 16), VERTEX_CACHE_SIZE);
+static_assert(simulateAcmr(SceneryMeshes<16>::TREE_TRUNK.indices, VERTEX_CACHE_SIZE) < 0.75 * ROW_ORDER_ACMR,
+              "banded indices should transform far fewer vertices than row order");
+static_assert(simulateAcmr(SceneryMeshes<16>::LAMP_BULB.indices, VERTEX_CACHE_SIZE) < 0.8,
+              "sphere indices should stay vertex cache friendly");
+
+static_assert(PrimitiveMeshes::TESSELLATIONS[0] == 8 && PrimitiveMeshes::TESSELLATIONS[1] == 16 && PrimitiveMeshes::TESSELLATIONS[2] == 32,
+              "upload() bakes the detail levels listed in TESSELLATIONS");
+
+int PrimitiveMeshes::getDetailLevel(GLuint tessellation) {
+    for(int level = 0; level < NUM_DETAIL_LEVELS; ++level) {
+        if(TESSELLATIONS[level] == tessellation) return level;
+    }
+    return -1;
+}
+
+template<typename MeshTable>
+void PrimitiveMeshes::_upload(Mesh mesh, int detailLevel, const MeshTable& table, GpuResourceRegistry& registry, GLint positionLocation, GLint normalLocation, const char* label) {
+    MeshBuffers& buffers = _meshes[static_cast<int>(mesh)][detailLevel];
+    std::string name = std::string(label) + " " + std::to_string(TESSELLATIONS[detailLevel]);
+
+    buffers.vao = registry.createVertexArray((name + " VAO").c_str());
+    buffers.vbo = registry.createBuffer(GL_ARRAY_BUFFER, sizeof(table.vertices), table.vertices.data(), GL_STATIC_DRAW, (name + " VBO").c_str());
+    glEnableVertexAttribArray(positionLocation);
+    glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE, sizeof(PrimitiveVertex), (void*)offsetof(PrimitiveVertex, position));
+    glEnableVertexAttribArray(normalLocation);
+    glVertexAttribPointer(normalLocation, 3, GL_FLOAT, GL_FALSE, sizeof(PrimitiveVertex), (void*)offsetof(PrimitiveVertex, normal));
+    buffers.ibo = registry.createBuffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(table.indices), table.indices.data(), GL_STATIC_DRAW, (name + " IBO").c_str());
+    buffers.numIndices = static_cast<GLsizei>(table.indices.size());
+
+    glBindVertexArray(0);
+}
+
+void PrimitiveMeshes::upload(GpuResourceRegistry& registry, GLint positionLocation, GLint normalLocation) {
+    _uploadLevel<8>(0, registry, positionLocation, normalLocation);
+    _uploadLevel<16>(1, registry, positionLocation, normalLocation);
+    _uploadLevel<32>(2, registry, positionLocation, normalLocation);
+}
+
+template<int N>
+void PrimitiveMeshes::_uploadLevel(int detailLevel, GpuResourceRegistry& registry, GLint positionLocation, GLint normalLocation) {
+    _upload(Mesh::TREE_TRUNK, detailLevel, SceneryMeshes<N>::TREE_TRUNK, registry, positionLocation, normalLocation, "tree trunk");
+    _upload(Mesh::TREE_LEAVES, detailLevel, SceneryMeshes<N>::TREE_LEAVES, registry, positionLocation, normalLocation, "tree leaves");
+    _upload(Mesh::LAMP_POST, detailLevel, SceneryMeshes<N>::LAMP_POST, registry, positionLocation, normalLocation, "lamp post");
+    _upload(Mesh::LAMP_BULB, detailLevel, SceneryMeshes<N>::LAMP_BULB, registry, positionLocation, normalLocation, "lamp bulb");
+}
+
+void PrimitiveMeshes::release() {
+    for(auto& levels : _meshes) {
+        for(MeshBuffers& buffers : levels) {
+            buffers.vao.reset();
+            buffers.vbo.reset();
+            buffers.ibo.reset();
+            buffers.numIndices = 0;
+        }
+    }
+}
+
+void PrimitiveMeshes::bind(Mesh mesh, int detailLevel) const {
+    glBindVertexArray(_meshes[static_cast<int>(mesh)][detailLevel].vao.get());
+}
+
+void PrimitiveMeshes::draw(Mesh mesh, int detailLevel) const {
+    glDrawElements(GL_TRIANGLES, _meshes[static_cast<int>(mesh)][detailLevel].numIndices, GL_UNSIGNED_SHORT, (void*)0);
+}
+
+void PrimitiveMeshes::drawInstanced(Mesh mesh, int detailLevel, GLsizei instanceCount) const {
+    glDrawElementsInstanced(GL_TRIANGLES, _meshes[static_cast<int>(mesh)][detailLevel].numIndices, GL_UNSIGNED_SHORT, (void*)0, instanceCount);
+}
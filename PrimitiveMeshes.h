@@ -0,0 +1,237 @@
+#ifndef PRIMITIVE_MESHES_H
+#define PRIMITIVE_MESHES_H
+
+#include <glad/gl.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "GpuResourceRegistry.h"
+
+// Cylinder, cone and sphere meshes whose vertex and index tables are built by
+// constexpr code, so the fixed scenery tessellations cost nothing at startup.
+// Shapes match CSCI441's drawSolid* (cylinders and cones stand on y = 0,
+// spheres are centered on the origin). Indices are ordered for the
+// post-transform vertex cache, see PrimitiveMeshGenerator::emitGridIndices.
+
+struct PrimitiveVertex {
+    float position[3];
+    float normal[3];
+};
+
+template<size_t NUM_VERTICES, size_t NUM_INDICES>
+struct PrimitiveMesh {
+    std::array<PrimitiveVertex, NUM_VERTICES> vertices;
+    std::array<uint16_t, NUM_INDICES> indices;
+};
+
+namespace PrimitiveMeshGenerator {
+    // smallest post-transform cache we plan for, FIFO
+    constexpr int VERTEX_CACHE_SIZE = 16;
+    // two rows of a band have to fit in the cache at once
+    constexpr int BAND_WIDTH = VERTEX_CACHE_SIZE / 2 - 1;
+
+    constexpr double PI = 3.14159265358979323846;
+
+    // Taylor series after reducing to [-pi, pi], exact to float precision
+    constexpr double sin(double x) {
+        long long turns = static_cast<long long>(x / (2.0 * PI) + (x >= 0.0 ? 0.5 : -0.5));
+        x -= static_cast<double>(turns) * 2.0 * PI;
+        double term = x;
+        double sum = x;
+        for(int n = 1; n < 12; ++n) {
+            term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double cos(double x) {
+        return sin(x + PI / 2.0);
+    }
+
+    constexpr double sqrt(double x) {
+        if(x <= 0.0) return 0.0;
+        double guess = x > 1.0 ? x : 1.0;
+        for(int i = 0; i < 64; ++i) {
+            guess = 0.5 * (guess + x / guess);
+        }
+        return guess;
+    }
+
+    constexpr PrimitiveVertex makeVertex(double x, double y, double z, double nx, double ny, double nz) {
+        double length = sqrt(nx * nx + ny * ny + nz * nz);
+        if(length > 0.0) {
+            nx /= length;
+            ny /= length;
+            nz /= length;
+        }
+        return {{static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)},
+                {static_cast<float>(nx), static_cast<float>(ny), static_cast<float>(nz)}};
+    }
+
+    // Triangulates a (STACKS + 1) x (SLICES + 1) vertex grid, row 0 at the bottom.
+    // Quads are visited in vertical bands of bandWidth columns so the two rows a
+    // band touches stay in the vertex cache; bandWidth = SLICES is plain row order.
+    // A row collapsed to a point (a pole or an apex) would make half of the quads
+    // next to it degenerate, those triangles are skipped.
+    template<int STACKS, int SLICES, size_t NUM_INDICES>
+    constexpr std::array<uint16_t, NUM_INDICES> emitGridIndices(bool bottomPole, bool topPole, int bandWidth) {
+        std::array<uint16_t, NUM_INDICES> indices{};
+        size_t count = 0;
+        for(int bandStart = 0; bandStart < SLICES; bandStart += bandWidth) {
+            int bandEnd = bandStart + bandWidth < SLICES ? bandStart + bandWidth : SLICES;
+            for(int stack = 0; stack < STACKS; ++stack) {
+                for(int slice = bandStart; slice < bandEnd; ++slice) {
+                    uint16_t bottomLeft = static_cast<uint16_t>(stack * (SLICES + 1) + slice);
+                    uint16_t bottomRight = static_cast<uint16_t>(bottomLeft + 1);
+                    uint16_t topLeft = static_cast<uint16_t>(bottomLeft + SLICES + 1);
+                    uint16_t topRight = static_cast<uint16_t>(topLeft + 1);
+                    // counter-clockwise seen from outside
+                    if(!(bottomPole && stack == 0)) {
+                        indices[count++] = bottomLeft;
+                        indices[count++] = bottomRight;
+                        indices[count++] = topRight;
+                    }
+                    if(!(topPole && stack == STACKS - 1)) {
+                        indices[count++] = bottomLeft;
+                        indices[count++] = topRight;
+                        indices[count++] = topLeft;
+                    }
+                }
+            }
+        }
+        return indices;
+    }
+
+    // average number of vertices transformed per triangle with a FIFO cache
+    template<size_t NUM_INDICES>
+    constexpr double simulateAcmr(const std::array<uint16_t, NUM_INDICES>& indices, int cacheSize) {
+        uint16_t cache[64] = {};
+        int cached = 0;
+        int next = 0;
+        int misses = 0;
+        for(size_t i = 0; i < NUM_INDICES; ++i) {
+            bool hit = false;
+            for(int j = 0; j < cached; ++j) {
+                if(cache[j] == indices[i]) hit = true;
+            }
+            if(hit) continue;
+            misses++;
+            cache[next] = indices[i];
+            next = (next + 1) % cacheSize;
+            if(cached < cacheSize) cached++;
+        }
+        return static_cast<double>(misses) / (NUM_INDICES / 3);
+    }
+
+    template<int STACKS, int SLICES>
+    using CylinderMesh = PrimitiveMesh<(STACKS + 1) * (SLICES + 1), STACKS * SLICES * 6>;
+
+    // side of a (truncated) cone from y = 0 to height
+    template<typename MeshType, int STACKS, int SLICES>
+    constexpr void fillTaperedSide(MeshType& mesh, double baseRadius, double topRadius, double height) {
+        // the side leans in by the radius change, tilt the normals up by the same slope
+        double normalY = (baseRadius - topRadius) / height;
+        for(int stack = 0; stack <= STACKS; ++stack) {
+            double t = static_cast<double>(stack) / STACKS;
+            double radius = baseRadius + (topRadius - baseRadius) * t;
+            for(int slice = 0; slice <= SLICES; ++slice) {
+                double theta = 2.0 * PI * slice / SLICES;
+                double s = sin(theta);
+                double c = cos(theta);
+                mesh.vertices[stack * (SLICES + 1) + slice] = makeVertex(radius * s, height * t, radius * c, s, normalY, c);
+            }
+        }
+    }
+
+    // open cylinder from y = 0 to height
+    template<int STACKS, int SLICES>
+    constexpr CylinderMesh<STACKS, SLICES> makeCylinder(double baseRadius, double topRadius, double height) {
+        CylinderMesh<STACKS, SLICES> mesh{};
+        fillTaperedSide<CylinderMesh<STACKS, SLICES>, STACKS, SLICES>(mesh, baseRadius, topRadius, height);
+        mesh.indices = emitGridIndices<STACKS, SLICES, STACKS * SLICES * 6>(false, false, BAND_WIDTH);
+        return mesh;
+    }
+
+    template<int STACKS, int SLICES>
+    using ConeMesh = PrimitiveMesh<(STACKS + 1) * (SLICES + 1), STACKS * SLICES * 6 - SLICES * 3>;
+
+    // open cone from y = 0 to its apex at height
+    template<int STACKS, int SLICES>
+    constexpr ConeMesh<STACKS, SLICES> makeCone(double baseRadius, double height) {
+        ConeMesh<STACKS, SLICES> mesh{};
+        fillTaperedSide<ConeMesh<STACKS, SLICES>, STACKS, SLICES>(mesh, baseRadius, 0.0, height);
+        mesh.indices = emitGridIndices<STACKS, SLICES, STACKS * SLICES * 6 - SLICES * 3>(false, true, BAND_WIDTH);
+        return mesh;
+    }
+
+    template<int STACKS, int SLICES>
+    using SphereMesh = PrimitiveMesh<(STACKS + 1) * (SLICES + 1), (STACKS - 1) * SLICES * 6>;
+
+    template<int STACKS, int SLICES>
+    constexpr SphereMesh<STACKS, SLICES> makeSphere(double radius) {
+        static_assert(STACKS >= 2, "a sphere needs at least two stacks");
+        SphereMesh<STACKS, SLICES> mesh{};
+        for(int stack = 0; stack <= STACKS; ++stack) {
+            double phi = PI * stack / STACKS;
+            double y = -cos(phi);
+            double ring = sin(phi);
+            for(int slice = 0; slice <= SLICES; ++slice) {
+                double theta = 2.0 * PI * slice / SLICES;
+                double x = ring * sin(theta);
+                double z = ring * cos(theta);
+                mesh.vertices[stack * (SLICES + 1) + slice] = makeVertex(radius * x, radius * y, radius * z, x, y, z);
+            }
+        }
+        mesh.indices = emitGridIndices<STACKS, SLICES, (STACKS - 1) * SLICES * 6>(true, true, BAND_WIDTH);
+        return mesh;
+    }
+}
+
+// Uploads the scenery meshes into registry owned buffers and draws them.
+// Every mesh is baked at each of the TESSELLATIONS, so switching detail at
+// runtime only binds another buffer. Bind a mesh once, then draw it for every
+// instance at the same detail level.
+class PrimitiveMeshes {
+public:
+    enum class Mesh {
+        TREE_TRUNK,
+        TREE_LEAVES,
+        LAMP_POST,
+        LAMP_BULB,
+        NUM_MESHES
+    };
+
+    // slices and stacks of each detail level, coarsest first
+    static constexpr int NUM_DETAIL_LEVELS = 3;
+    static constexpr GLuint TESSELLATIONS[NUM_DETAIL_LEVELS] = {8, 16, 32};
+    // detail level baked at exactly this tessellation, -1 if there is none
+    static int getDetailLevel(GLuint tessellation);
+
+    void upload(GpuResourceRegistry& registry, GLint positionLocation, GLint normalLocation);
+    void release();
+
+    void bind(Mesh mesh, int detailLevel) const;
+    void draw(Mesh mesh, int detailLevel) const;
+    void drawInstanced(Mesh mesh, int detailLevel, GLsizei instanceCount) const;
+
+private:
+    static constexpr int NUM_MESHES = static_cast<int>(Mesh::NUM_MESHES);
+
+    struct MeshBuffers {
+        GpuHandle vao;
+        GpuHandle vbo;
+        GpuHandle ibo;
+        GLsizei numIndices = 0;
+    };
+    MeshBuffers _meshes[NUM_MESHES][NUM_DETAIL_LEVELS];
+
+    template<typename MeshTable>
+    void _upload(Mesh mesh, int detailLevel, const MeshTable& table, GpuResourceRegistry& registry, GLint positionLocation, GLint normalLocation, const char* label);
+    template<int N>
+    void _uploadLevel(int detailLevel, GpuResourceRegistry& registry, GLint positionLocation, GLint normalLocation);
+};
+
+#endif // PRIMITIVE_MESHES_H
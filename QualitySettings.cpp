@@ -0,0 +1,181 @@
+#include "QualitySettings.h"
+
+#include "DynamicResolution.h"
+#include "PrimitiveMeshes.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    struct Preset {
+        const char* name;
+        GLfloat farPlane;
+        GLfloat lodBias;
+        GLuint lightLimit;
+        GLfloat renderScale;
+        GLuint tessellation;
+    };
+
+    // HIGH is what the engine drew before there were tiers
+    const Preset PRESETS[QualitySettings::NUM_TIERS] = {
+        {"low",     60.0f,  0.5f, 2,                                   0.5f,  8},
+        {"medium",  80.0f,  1.0f, 4,                                   0.75f, 16},
+        {"high",    100.0f, 2.0f, QualitySettings::MAX_POINT_LIGHTS,   1.0f,  16},
+        {"ultra",   150.0f, 4.0f, QualitySettings::MAX_POINT_LIGHTS,   1.0f,  32}
+    };
+
+    const char* SETTING_NAMES[QualitySettings::NUM_SETTINGS] = {
+        "window_width",
+        "window_height",
+        "far_plane",
+        "lod_bias",
+        "light_limit",
+        "render_scale",
+        "tessellation"
+    };
+
+    bool parseFloat(const char* value, GLfloat& result) {
+        char* end;
+        double parsed = strtod(value, &end);
+        if(end == value || *end != '\0') return false;
+        result = static_cast<GLfloat>(parsed);
+        return true;
+    }
+
+    bool parseInt(const char* value, long& result) {
+        char* end;
+        result = strtol(value, &end, 10);
+        return end != value && *end == '\0';
+    }
+
+    // trims in place, returns the first non blank character
+    char* trim(char* text) {
+        while(isspace(static_cast<unsigned char>(*text))) ++text;
+        char* end = text + strlen(text);
+        while(end > text && isspace(static_cast<unsigned char>(end[-1]))) --end;
+        *end = '\0';
+        return text;
+    }
+}
+
+void QualitySettings::setTier(Tier newTier) {
+    const Preset& preset = PRESETS[static_cast<int>(newTier)];
+    tier = newTier;
+    if(!isPinned(FAR_PLANE)) farPlane = preset.farPlane;
+    if(!isPinned(LOD_BIAS)) lodBias = preset.lodBias;
+    if(!isPinned(LIGHT_LIMIT)) lightLimit = preset.lightLimit;
+    if(!isPinned(RENDER_SCALE)) renderScale = preset.renderScale;
+    if(!isPinned(TESSELLATION)) tessellation = preset.tessellation;
+}
+
+bool QualitySettings::set(const char* key, const char* value) {
+    if(strcmp(key, "tier") == 0) {
+        Tier newTier;
+        if(!parseTier(value, newTier)) {
+            fprintf( stderr, "[ERROR]: unknown quality tier \"%s\", expected low, medium, high or ultra\n", value );
+            return false;
+        }
+        setTier(newTier);
+        return true;
+    }
+
+    int setting = 0;
+    while(setting < NUM_SETTINGS && strcmp(key, SETTING_NAMES[setting]) != 0) ++setting;
+    if(setting == NUM_SETTINGS) {
+        fprintf( stderr, "[ERROR]: unknown quality setting \"%s\"\n", key );
+        return false;
+    }
+
+    long integer = 0;
+    GLfloat real = 0.0f;
+    bool valid = false;
+    switch(setting) {
+        case WINDOW_WIDTH:
+        case WINDOW_HEIGHT:
+            valid = parseInt(value, integer) && integer > 0;
+            if(valid) (setting == WINDOW_WIDTH ? windowWidth : windowHeight) = static_cast<GLint>(integer);
+            break;
+        case FAR_PLANE:
+            // has to stay beyond the 0.1 near plane
+            valid = parseFloat(value, real) && real > 1.0f;
+            if(valid) farPlane = real;
+            break;
+        case LOD_BIAS:
+            valid = parseFloat(value, real) && real >= 0.0f;
+            if(valid) lodBias = real;
+            break;
+        case LIGHT_LIMIT:
+            valid = parseInt(value, integer) && integer >= 0 && integer <= static_cast<long>(MAX_POINT_LIGHTS);
+            if(valid) lightLimit = static_cast<GLuint>(integer);
+            break;
+        case RENDER_SCALE:
+            valid = parseFloat(value, real) && real >= DynamicResolution::MIN_SCALE && real <= DynamicResolution::MAX_SCALE;
+            if(valid) renderScale = real;
+            break;
+        case TESSELLATION:
+            valid = parseInt(value, integer) && integer > 0 && PrimitiveMeshes::getDetailLevel(static_cast<GLuint>(integer)) >= 0;
+            if(valid) tessellation = static_cast<GLuint>(integer);
+            break;
+    }
+    if(!valid) {
+        fprintf( stderr, "[ERROR]: invalid value \"%s\" for quality setting %s\n", value, key );
+        return false;
+    }
+
+    _pinned |= 1u << setting;
+    return true;
+}
+
+bool QualitySettings::loadConfig(const char* filename) {
+    FILE* fp = fopen(filename, "r");
+    if(!fp) {
+        fprintf( stderr, "[ERROR]: Could not open quality config \"%s\"\n", filename );
+        return false;
+    }
+
+    char line[256];
+    int lineNumber = 0;
+    bool valid = true;
+    while(valid && fgets(line, sizeof(line), fp) != nullptr) {
+        ++lineNumber;
+        char* comment = strchr(line, '#');
+        if(comment != nullptr) *comment = '\0';
+        char* text = trim(line);
+        if(*text == '\0') continue;
+
+        char* separator = strchr(text, '=');
+        if(separator == nullptr) {
+            fprintf( stderr, "[ERROR]: quality config \"%s\" line %d is not key = value\n", filename, lineNumber );
+            valid = false;
+            continue;
+        }
+        *separator = '\0';
+        valid = set(trim(text), trim(separator + 1));
+        if(!valid) {
+            fprintf( stderr, "[ERROR]: in quality config \"%s\" line %d\n", filename, lineNumber );
+        }
+    }
+
+    fclose(fp);
+    return valid;
+}
+
+const char* QualitySettings::getTierName(Tier tier) {
+    return PRESETS[static_cast<int>(tier)].name;
+}
+
+bool QualitySettings::parseTier(const char* name, Tier& tier) {
+    for(int i = 0; i < NUM_TIERS; ++i) {
+        if(strcmp(name, PRESETS[i].name) == 0) {
+            tier = static_cast<Tier>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* QualitySettings::getSettingName(Setting setting) {
+    return SETTING_NAMES[setting];
+}
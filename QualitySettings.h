@@ -0,0 +1,71 @@
+#ifndef QUALITY_SETTINGS_H
+#define QUALITY_SETTINGS_H
+
+#include <glad/gl.h>
+
+#include <cstdint>
+
+// What the engine trades between image quality and frame time. A tier fills
+// in every value but the window size; values set by name from a config file
+// or the command line are pinned and keep their value through later tier
+// changes, including the one the startup benchmark makes.
+//
+// Config files hold one "key = value" per line, # starts a comment. The keys
+// are the names in getSettingName(), plus "tier".
+struct QualitySettings {
+    enum class Tier {
+        LOW,
+        MEDIUM,
+        HIGH,
+        ULTRA
+    };
+    static constexpr int NUM_TIERS = 4;
+
+    enum Setting {
+        WINDOW_WIDTH = 0,
+        WINDOW_HEIGHT,
+        FAR_PLANE,
+        LOD_BIAS,
+        LIGHT_LIMIT,
+        RENDER_SCALE,
+        TESSELLATION,
+        NUM_SETTINGS
+    };
+
+    // size of the point light arrays in the lighting shaders
+    static constexpr GLuint MAX_POINT_LIGHTS = 10;
+    static constexpr GLint DEFAULT_WINDOW_WIDTH = 1280;
+    static constexpr GLint DEFAULT_WINDOW_HEIGHT = 720;
+
+    Tier tier = Tier::HIGH;
+    GLint windowWidth = DEFAULT_WINDOW_WIDTH;
+    GLint windowHeight = DEFAULT_WINDOW_HEIGHT;
+    // of the main and hero cam projections, nothing further away is drawn
+    GLfloat farPlane = 100.0f;
+    // multiplies the distance scenery drops to the next coarser tessellation at, 0 draws it all coarse
+    GLfloat lodBias = 2.0f;
+    // lamps lit by point lights, at most MAX_POINT_LIGHTS
+    GLuint lightLimit = MAX_POINT_LIGHTS;
+    // fraction of the window the main view renders at, an upper bound with a frame budget
+    GLfloat renderScale = 1.0f;
+    // slices and stacks of the nearby scenery, one of PrimitiveMeshes::TESSELLATIONS
+    GLuint tessellation = 16;
+
+    // resets every value that is not pinned to the tier's
+    void setTier(Tier newTier);
+    // parses and pins one value, prints what is wrong with it otherwise;
+    // "tier" goes to setTier() and pins nothing
+    bool set(const char* key, const char* value);
+    bool isPinned(Setting setting) const { return (_pinned & (1u << setting)) != 0; }
+
+    bool loadConfig(const char* filename);
+
+    static const char* getTierName(Tier tier);
+    static bool parseTier(const char* name, Tier& tier);
+    static const char* getSettingName(Setting setting);
+
+private:
+    uint32_t _pinned = 0;
+};
+
+#endif // QUALITY_SETTINGS_H
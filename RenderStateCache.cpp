@@ -0,0 +1,99 @@
+#include "RenderStateCache.h"
+
+RenderStateCache::RenderStateCache()
+    : _stats{0, 0}
+{
+    invalidate();
+}
+
+void RenderStateCache::invalidate() {
+    for(int& capability : _capabilities) capability = -1;
+    _depthFunc = UNKNOWN;
+    _depthMask = -1;
+    _cullFace = UNKNOWN;
+    _blendSourceFactor = UNKNOWN;
+    _blendDestinationFactor = UNKNOWN;
+    _program = UNKNOWN;
+    _activeTextureUnit = UNKNOWN;
+    for(GLuint unit = 0; unit < MAX_TEXTURE_UNITS; ++unit) {
+        _textureTargets[unit] = UNKNOWN;
+        _textures[unit] = UNKNOWN;
+    }
+}
+
+bool RenderStateCache::_changed(bool changed) {
+    if(changed) _stats.issued++;
+    else _stats.skipped++;
+    return changed;
+}
+
+void RenderStateCache::setEnabled(GLenum capability, bool enabled) {
+    int index;
+    switch(capability) {
+        case GL_DEPTH_TEST:   index = CAP_DEPTH_TEST; break;
+        case GL_CULL_FACE:    index = CAP_CULL_FACE; break;
+        case GL_BLEND:        index = CAP_BLEND; break;
+        case GL_SCISSOR_TEST: index = CAP_SCISSOR_TEST; break;
+        default:
+            // not shadowed, always forward
+            if(enabled) glEnable(capability);
+            else glDisable(capability);
+            _stats.issued++;
+            return;
+    }
+
+    if(!_changed(_capabilities[index] != (enabled ? 1 : 0))) return;
+    _capabilities[index] = enabled ? 1 : 0;
+    if(enabled) glEnable(capability);
+    else glDisable(capability);
+}
+
+void RenderStateCache::setDepthFunc(GLenum func) {
+    if(!_changed(_depthFunc != func)) return;
+    _depthFunc = func;
+    glDepthFunc(func);
+}
+
+void RenderStateCache::setDepthMask(GLboolean mask) {
+    if(!_changed(_depthMask != static_cast<GLint>(mask))) return;
+    _depthMask = mask;
+    glDepthMask(mask);
+}
+
+void RenderStateCache::setCullFace(GLenum face) {
+    if(!_changed(_cullFace != face)) return;
+    _cullFace = face;
+    glCullFace(face);
+}
+
+void RenderStateCache::setBlendFunc(GLenum sourceFactor, GLenum destinationFactor) {
+    if(!_changed(_blendSourceFactor != sourceFactor || _blendDestinationFactor != destinationFactor)) return;
+    _blendSourceFactor = sourceFactor;
+    _blendDestinationFactor = destinationFactor;
+    glBlendFunc(sourceFactor, destinationFactor);
+}
+
+void RenderStateCache::useProgram(GLuint program) {
+    if(!_changed(_program != program)) return;
+    _program = program;
+    glUseProgram(program);
+}
+
+void RenderStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    if(unit >= MAX_TEXTURE_UNITS) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        _activeTextureUnit = unit;
+        _stats.issued++;
+        return;
+    }
+
+    if(!_changed(_textureTargets[unit] != target || _textures[unit] != texture)) return;
+    if(_activeTextureUnit != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        _activeTextureUnit = unit;
+    }
+    glBindTexture(target, texture);
+    _textureTargets[unit] = target;
+    _textures[unit] = texture;
+}
@@ -0,0 +1,62 @@
+#ifndef RENDER_STATE_CACHE_H
+#define RENDER_STATE_CACHE_H
+
+#include <glad/gl.h>
+
+// Shadows the small amount of fixed function state the engine touches and
+// only forwards a call to GL when the value actually changes.
+// Anything that changes this state behind the cache's back (e.g. the
+// CSCI441 helpers binding their own VAOs) must be followed by invalidate().
+class RenderStateCache {
+public:
+    struct Stats {
+        unsigned int issued;
+        unsigned int skipped;
+    };
+
+    RenderStateCache();
+
+    // forget all shadowed state so the next call of each kind is always issued
+    void invalidate();
+
+    void setEnabled(GLenum capability, bool enabled);
+    void setDepthFunc(GLenum func);
+    void setDepthMask(GLboolean mask);
+    void setCullFace(GLenum face);
+    void setBlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+    void useProgram(GLuint program);
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    const Stats& getStats() const { return _stats; }
+    void resetStats() { _stats = {0, 0}; }
+
+    static constexpr GLuint MAX_TEXTURE_UNITS = 8;
+
+private:
+    enum Capability {
+        CAP_DEPTH_TEST = 0,
+        CAP_CULL_FACE,
+        CAP_BLEND,
+        CAP_SCISSOR_TEST,
+        NUM_CAPABILITIES
+    };
+    // -1 unknown, 0 disabled, 1 enabled
+    int _capabilities[NUM_CAPABILITIES];
+
+    static constexpr GLenum UNKNOWN = 0xFFFFFFFF;
+    GLenum _depthFunc;
+    GLint _depthMask;
+    GLenum _cullFace;
+    GLenum _blendSourceFactor;
+    GLenum _blendDestinationFactor;
+    GLuint _program;
+    GLuint _activeTextureUnit;
+    GLenum _textureTargets[MAX_TEXTURE_UNITS];
+    GLuint _textures[MAX_TEXTURE_UNITS];
+
+    Stats _stats;
+
+    bool _changed(bool changed);
+};
+
+#endif // RENDER_STATE_CACHE_H
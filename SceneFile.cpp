@@ -0,0 +1,208 @@
+#include "SceneFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char SCENE_MAGIC[4] = {'M', 'P', 'S', 'C'};
+
+static uint64_t alignOffset(uint64_t offset) {
+    return (offset + SceneFile::SECTION_ALIGNMENT - 1) & ~static_cast<uint64_t>(SceneFile::SECTION_ALIGNMENT - 1);
+}
+
+SceneFile::SceneFile()
+    : _pData(nullptr),
+      _size(0)
+#ifdef _WIN32
+      , _fileHandle(nullptr),
+      _mappingHandle(nullptr)
+#endif
+{}
+
+SceneFile::~SceneFile() {
+    close();
+}
+
+bool SceneFile::open(const char* filename) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        fprintf( stderr, "[ERROR]: Could not open scene file \"%s\"\n", filename );
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* pView = (mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr);
+    if(pView == nullptr) {
+        fprintf( stderr, "[ERROR]: Could not map scene file \"%s\"\n", filename );
+        if(mapping != nullptr) CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    _fileHandle = file;
+    _mappingHandle = mapping;
+    _pData = static_cast<const unsigned char*>(pView);
+    _size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(filename, O_RDONLY);
+    if(fd < 0) {
+        fprintf( stderr, "[ERROR]: Could not open scene file \"%s\"\n", filename );
+        return false;
+    }
+    struct stat fileInfo;
+    if(fstat(fd, &fileInfo) != 0 || fileInfo.st_size == 0) {
+        fprintf( stderr, "[ERROR]: Could not read scene file \"%s\"\n", filename );
+        ::close(fd);
+        return false;
+    }
+    void* pMapping = mmap(nullptr, fileInfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps its own reference to the file
+    ::close(fd);
+    if(pMapping == MAP_FAILED) {
+        fprintf( stderr, "[ERROR]: Could not map scene file \"%s\"\n", filename );
+        return false;
+    }
+    _pData = static_cast<const unsigned char*>(pMapping);
+    _size = static_cast<size_t>(fileInfo.st_size);
+#endif
+
+    if(!_validate(filename)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SceneFile::close() {
+    if(_pData == nullptr) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(_pData);
+    CloseHandle(_mappingHandle);
+    CloseHandle(_fileHandle);
+    _mappingHandle = nullptr;
+    _fileHandle = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(_pData), _size);
+#endif
+    _pData = nullptr;
+    _size = 0;
+}
+
+bool SceneFile::_validate(const char* filename) const {
+    if(_size < sizeof(SceneFileHeader)) {
+        fprintf( stderr, "[ERROR]: scene file \"%s\" is too small\n", filename );
+        return false;
+    }
+
+    const SceneFileHeader& header = getHeader();
+    if(memcmp(header.magic, SCENE_MAGIC, 4) != 0) {
+        fprintf( stderr, "[ERROR]: \"%s\" is not a scene file\n", filename );
+        return false;
+    }
+    if(header.byteOrderMark != BYTE_ORDER_MARK) {
+        fprintf( stderr, "[ERROR]: scene file \"%s\" was written with a different byte order\n", filename );
+        return false;
+    }
+    if(header.version != VERSION || header.headerSize != sizeof(SceneFileHeader)) {
+        fprintf( stderr, "[ERROR]: scene file \"%s\" has unsupported version %u\n", filename, header.version );
+        return false;
+    }
+    if(header.fileSize != _size) {
+        fprintf( stderr, "[ERROR]: scene file \"%s\" is truncated\n", filename );
+        return false;
+    }
+
+    // every section must be aligned and lie completely inside the file
+    const struct { uint64_t offset; uint64_t bytes; } SECTIONS[] = {
+        {header.treeOffset,     static_cast<uint64_t>(header.treeCount) * sizeof(SceneTreeRecord)},
+        {header.lampOffset,     static_cast<uint64_t>(header.lampCount) * sizeof(SceneLampRecord)},
+        {header.buildingOffset, static_cast<uint64_t>(header.buildingCount) * sizeof(SceneBuildingRecord)},
+        {header.heroOffset,     static_cast<uint64_t>(header.heroCount) * sizeof(SceneHeroRecord)}
+    };
+    for(const auto& section : SECTIONS) {
+        if(section.offset % SECTION_ALIGNMENT != 0 || section.offset < sizeof(SceneFileHeader) ||
+           section.offset > _size || section.bytes > _size - section.offset) {
+            fprintf( stderr, "[ERROR]: scene file \"%s\" has a corrupt section table\n", filename );
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SceneFile::write(const char* filename, uint32_t worldSeed, float environmentDensity,
+                      const std::vector<SceneTreeRecord>& trees,
+                      const std::vector<SceneLampRecord>& lamps,
+                      const std::vector<SceneBuildingRecord>& buildings,
+                      const std::vector<SceneHeroRecord>& heroes) {
+    SceneFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SCENE_MAGIC, 4);
+    header.version = VERSION;
+    header.byteOrderMark = BYTE_ORDER_MARK;
+    header.headerSize = sizeof(SceneFileHeader);
+    header.worldSeed = worldSeed;
+    header.environmentDensity = environmentDensity;
+    header.treeCount = static_cast<uint32_t>(trees.size());
+    header.lampCount = static_cast<uint32_t>(lamps.size());
+    header.buildingCount = static_cast<uint32_t>(buildings.size());
+    header.heroCount = static_cast<uint32_t>(heroes.size());
+
+    header.treeOffset = alignOffset(sizeof(SceneFileHeader));
+    header.lampOffset = alignOffset(header.treeOffset + trees.size() * sizeof(SceneTreeRecord));
+    header.buildingOffset = alignOffset(header.lampOffset + lamps.size() * sizeof(SceneLampRecord));
+    header.heroOffset = alignOffset(header.buildingOffset + buildings.size() * sizeof(SceneBuildingRecord));
+    header.fileSize = header.heroOffset + heroes.size() * sizeof(SceneHeroRecord);
+
+    FILE* fp = fopen(filename, "wb");
+    if(!fp) {
+        fprintf( stderr, "[ERROR]: Could not open scene file \"%s\" for writing\n", filename );
+        return false;
+    }
+
+    // write each section at its aligned offset, zero padding the gaps
+    uint64_t position = 0;
+    auto writeSection = [&](uint64_t offset, const void* pData, size_t bytes) {
+        static const unsigned char PADDING[SECTION_ALIGNMENT] = {0};
+        bool ok = true;
+        while(position < offset && ok) {
+            size_t padBytes = static_cast<size_t>(std::min<uint64_t>(offset - position, SECTION_ALIGNMENT));
+            ok = fwrite(PADDING, 1, padBytes, fp) == padBytes;
+            position += padBytes;
+        }
+        if(ok && bytes > 0) {
+            ok = fwrite(pData, 1, bytes, fp) == bytes;
+            position += bytes;
+        }
+        return ok;
+    };
+
+    bool ok = writeSection(0, &header, sizeof(header))
+           && writeSection(header.treeOffset, trees.data(), trees.size() * sizeof(SceneTreeRecord))
+           && writeSection(header.lampOffset, lamps.data(), lamps.size() * sizeof(SceneLampRecord))
+           && writeSection(header.buildingOffset, buildings.data(), buildings.size() * sizeof(SceneBuildingRecord))
+           && writeSection(header.heroOffset, heroes.data(), heroes.size() * sizeof(SceneHeroRecord));
+    fclose(fp);
+
+    if(!ok) {
+        fprintf( stderr, "[ERROR]: Could not write scene file \"%s\"\n", filename );
+        return false;
+    }
+    fprintf( stdout, "[INFO]: wrote scene with %u trees, %u lamps, %u buildings to %s (%llu bytes)\n",
+             header.treeCount, header.lampCount, header.buildingCount, filename,
+             static_cast<unsigned long long>(header.fileSize) );
+    return true;
+}
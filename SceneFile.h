@@ -0,0 +1,94 @@
+#ifndef SCENE_FILE_H
+#define SCENE_FILE_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "VertexFormats.h"
+
+// Flat, versioned binary scene format. Every section starts on a 16 byte
+// boundary and holds tightly packed 16 byte aligned records in the engine's
+// own layout, so loading a memory mapped file is a bulk copy. The records
+// are copied rather than uploaded from the mapping on purpose: scenery is
+// culled and sorted every frame and only the visible instances are streamed.
+
+// trees and lamps only translate, their part matrices are rebuilt on load
+typedef CompactInstance SceneTreeRecord;
+typedef CompactInstance SceneLampRecord;
+
+struct alignas(16) SceneBuildingRecord {
+    glm::mat4 modelMatrix;
+    glm::vec4 color;            // w unused
+    glm::vec4 positionRadius;   // xyz position, w bounding radius
+};
+
+struct alignas(16) SceneHeroRecord {
+    glm::vec4 positionHeading;  // xyz position, w heading in radians
+};
+
+struct SceneFileHeader {
+    char magic[4];              // "MPSC"
+    uint32_t version;
+    uint32_t byteOrderMark;     // 0x01020304 written in native order
+    uint32_t headerSize;
+    uint32_t worldSeed;
+    float environmentDensity;
+    uint32_t treeCount;
+    uint32_t lampCount;
+    uint32_t buildingCount;
+    uint32_t heroCount;
+    uint64_t treeOffset;
+    uint64_t lampOffset;
+    uint64_t buildingOffset;
+    uint64_t heroOffset;
+    uint64_t fileSize;
+};
+
+static_assert(sizeof(SceneBuildingRecord) == 96, "building records must stay tightly packed");
+static_assert(sizeof(SceneHeroRecord) == 16, "hero records must stay tightly packed");
+
+class SceneFile {
+public:
+    SceneFile();
+    ~SceneFile();
+    SceneFile(const SceneFile&) = delete;
+    SceneFile& operator=(const SceneFile&) = delete;
+
+    // memory maps the file read only and validates its header
+    bool open(const char* filename);
+    void close();
+    bool isOpen() const { return _pData != nullptr; }
+
+    const SceneFileHeader& getHeader() const { return *reinterpret_cast<const SceneFileHeader*>(_pData); }
+    const SceneTreeRecord* getTrees() const { return _section<SceneTreeRecord>(getHeader().treeOffset); }
+    const SceneLampRecord* getLamps() const { return _section<SceneLampRecord>(getHeader().lampOffset); }
+    const SceneBuildingRecord* getBuildings() const { return _section<SceneBuildingRecord>(getHeader().buildingOffset); }
+    const SceneHeroRecord* getHeroes() const { return _section<SceneHeroRecord>(getHeader().heroOffset); }
+
+    static bool write(const char* filename, uint32_t worldSeed, float environmentDensity,
+                      const std::vector<SceneTreeRecord>& trees,
+                      const std::vector<SceneLampRecord>& lamps,
+                      const std::vector<SceneBuildingRecord>& buildings,
+                      const std::vector<SceneHeroRecord>& heroes);
+
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    static constexpr size_t SECTION_ALIGNMENT = 16;
+
+private:
+    const unsigned char* _pData;
+    size_t _size;
+#ifdef _WIN32
+    void* _fileHandle;
+    void* _mappingHandle;
+#endif
+
+    template<typename T> const T* _section(uint64_t offset) const {
+        return reinterpret_cast<const T*>(_pData + offset);
+    }
+    bool _validate(const char* filename) const;
+};
+
+#endif // SCENE_FILE_H
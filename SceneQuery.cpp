@@ -0,0 +1,429 @@
+#include "SceneQuery.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SCENE_QUERY_SSE
+#endif
+
+namespace {
+    // relative costs of stepping into a node and of testing a box, for the surface area heuristic
+    constexpr float TRAVERSAL_COST = 1.0f;
+    constexpr float BOX_COST = 1.0f;
+    // keeps rays parallel to an axis away from infinities and the NaNs they breed
+    constexpr float MIN_DIRECTION = 1e-12f;
+
+    float halfArea(glm::vec3 boundsMin, glm::vec3 boundsMax) {
+        glm::vec3 extent = boundsMax - boundsMin;
+        return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+    }
+
+    glm::vec3 inverseDirection(glm::vec3 direction) {
+        glm::vec3 inverse;
+        for(int axis = 0; axis < 3; ++axis) {
+            float component = direction[axis];
+            inverse[axis] = 1.0f / (std::fabs(component) > MIN_DIRECTION ? component : std::copysign(MIN_DIRECTION, component));
+        }
+        return inverse;
+    }
+
+    // slab test, tNear is 0 when the origin is inside
+    bool intersectBox(glm::vec3 origin, glm::vec3 inverse, glm::vec3 boundsMin, glm::vec3 boundsMax, float maxDistance, float& tNear) {
+        glm::vec3 t0 = (boundsMin - origin) * inverse;
+        glm::vec3 t1 = (boundsMax - origin) * inverse;
+        glm::vec3 tMin = glm::min(t0, t1);
+        glm::vec3 tMax = glm::max(t0, t1);
+        tNear = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+        float tFar = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+        return tNear <= tFar;
+    }
+
+    // the face the ray enters the box through
+    glm::vec3 entryNormal(glm::vec3 origin, glm::vec3 direction, glm::vec3 boundsMin, glm::vec3 boundsMax, float distance) {
+        if(distance <= 0.0f) return -direction;
+        glm::vec3 inverse = inverseDirection(direction);
+        glm::vec3 tMin = glm::min((boundsMin - origin) * inverse, (boundsMax - origin) * inverse);
+        int axis = (tMin.x > tMin.y) ? (tMin.x > tMin.z ? 0 : 2) : (tMin.y > tMin.z ? 1 : 2);
+        glm::vec3 normal(0.0f);
+        normal[axis] = direction[axis] > 0.0f ? -1.0f : 1.0f;
+        return normal;
+    }
+}
+
+void SceneQuery::clear() {
+    _static = Tree();
+    _dynamic = Tree();
+}
+
+void SceneQuery::addStaticBox(ObjectType type, uint32_t index, glm::vec3 boundsMin, glm::vec3 boundsMax) {
+    _static.slots.push_back(static_cast<uint32_t>(_static.boxes.size()));
+    _static.boxes.push_back({boundsMin, boundsMax, type, index});
+}
+
+void SceneQuery::buildStatic() {
+    _build(_static);
+}
+
+uint32_t SceneQuery::addDynamicBox(ObjectType type, uint32_t index, glm::vec3 boundsMin, glm::vec3 boundsMax) {
+    uint32_t box = static_cast<uint32_t>(_dynamic.slots.size());
+    _dynamic.slots.push_back(static_cast<uint32_t>(_dynamic.boxes.size()));
+    _dynamic.boxes.push_back({boundsMin, boundsMax, type, index});
+    _build(_dynamic);
+    return box;
+}
+
+void SceneQuery::moveDynamicBox(uint32_t box, glm::vec3 boundsMin, glm::vec3 boundsMax) {
+    Box& moved = _dynamic.boxes[_dynamic.slots[box]];
+    moved.boundsMin = boundsMin;
+    moved.boundsMax = boundsMax;
+}
+
+void SceneQuery::refit() {
+    _refit(_dynamic);
+}
+
+void SceneQuery::_build(Tree& tree) {
+    tree.nodes.clear();
+    tree.types = 0;
+    const size_t numBoxes = tree.boxes.size();
+    if(numBoxes == 0) return;
+
+    std::vector<glm::vec3> centroids(numBoxes);
+    for(size_t i = 0; i < numBoxes; ++i) {
+        centroids[i] = (tree.boxes[i].boundsMin + tree.boxes[i].boundsMax) * 0.5f;
+        tree.types |= typeBit(tree.boxes[i].type);
+    }
+    std::vector<uint32_t> order(numBoxes);
+    std::iota(order.begin(), order.end(), 0);
+
+    // a binary tree over n leaves never needs more, so node references stay valid
+    tree.nodes.reserve(2 * numBoxes - 1);
+    tree.nodes.push_back({glm::vec3(0.0f), 0, glm::vec3(0.0f), static_cast<uint32_t>(numBoxes)});
+
+    struct Pending {
+        uint32_t node;
+        int depth;
+    };
+    std::vector<Pending> pending = {{0, 0}};
+    while(!pending.empty()) {
+        Pending current = pending.back();
+        pending.pop_back();
+        Node& node = tree.nodes[current.node];
+        const uint32_t first = node.first;
+        const uint32_t count = node.count;
+
+        glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+        glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+        for(uint32_t i = first; i < first + count; ++i) {
+            const Box& box = tree.boxes[order[i]];
+            boundsMin = glm::min(boundsMin, box.boundsMin);
+            boundsMax = glm::max(boundsMax, box.boundsMax);
+            centroidMin = glm::min(centroidMin, centroids[order[i]]);
+            centroidMax = glm::max(centroidMax, centroids[order[i]]);
+        }
+        node.boundsMin = boundsMin;
+        node.boundsMax = boundsMax;
+        if(count <= 1 || current.depth >= MAX_DEPTH) continue;
+
+        glm::vec3 extent = centroidMax - centroidMin;
+        const int axis = (extent.x > extent.y) ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        uint32_t middle;
+        if(extent[axis] <= 0.0f) {
+            if(count <= MAX_LEAF_BOXES) continue;
+            // every centroid in one spot, no plane separates them
+            middle = first + count / 2;
+        } else {
+            const float binScale = NUM_BINS / extent[axis];
+            const float binOrigin = centroidMin[axis];
+            auto binOf = [&](uint32_t box) {
+                return std::min(static_cast<int>((centroids[box][axis] - binOrigin) * binScale), NUM_BINS - 1);
+            };
+
+            uint32_t binCounts[NUM_BINS] = {};
+            glm::vec3 binMin[NUM_BINS], binMax[NUM_BINS];
+            std::fill(binMin, binMin + NUM_BINS, glm::vec3(FLT_MAX));
+            std::fill(binMax, binMax + NUM_BINS, glm::vec3(-FLT_MAX));
+            for(uint32_t i = first; i < first + count; ++i) {
+                int bin = binOf(order[i]);
+                ++binCounts[bin];
+                binMin[bin] = glm::min(binMin[bin], tree.boxes[order[i]].boundsMin);
+                binMax[bin] = glm::max(binMax[bin], tree.boxes[order[i]].boundsMax);
+            }
+
+            // split s puts bins below s on the left; sweep the right sides first
+            float rightCosts[NUM_BINS];
+            uint32_t rightCount = 0;
+            glm::vec3 rightMin(FLT_MAX), rightMax(-FLT_MAX);
+            for(int split = NUM_BINS - 1; split > 0; --split) {
+                rightCount += binCounts[split];
+                rightMin = glm::min(rightMin, binMin[split]);
+                rightMax = glm::max(rightMax, binMax[split]);
+                rightCosts[split] = rightCount > 0 ? rightCount * halfArea(rightMin, rightMax) : 0.0f;
+            }
+
+            int bestSplit = -1;
+            float bestCost = FLT_MAX;
+            uint32_t leftCount = 0;
+            glm::vec3 leftMin(FLT_MAX), leftMax(-FLT_MAX);
+            for(int split = 1; split < NUM_BINS; ++split) {
+                leftCount += binCounts[split - 1];
+                leftMin = glm::min(leftMin, binMin[split - 1]);
+                leftMax = glm::max(leftMax, binMax[split - 1]);
+                if(leftCount == 0 || leftCount == count) continue;
+                float cost = leftCount * halfArea(leftMin, leftMax) + rightCosts[split];
+                if(cost < bestCost) {
+                    bestCost = cost;
+                    bestSplit = split;
+                }
+            }
+
+            // the centroids span bins 0 and NUM_BINS - 1, so some split always separates them
+            float splitCost = TRAVERSAL_COST + BOX_COST * bestCost / halfArea(boundsMin, boundsMax);
+            if(count <= MAX_LEAF_BOXES && splitCost >= BOX_COST * count) continue;
+
+            middle = static_cast<uint32_t>(std::partition(order.begin() + first, order.begin() + first + count,
+                                                          [&](uint32_t box) { return binOf(box) < bestSplit; }) - order.begin());
+        }
+
+        const uint32_t left = static_cast<uint32_t>(tree.nodes.size());
+        node.first = left;
+        node.count = 0;
+        tree.nodes.push_back({glm::vec3(0.0f), first, glm::vec3(0.0f), middle - first});
+        tree.nodes.push_back({glm::vec3(0.0f), middle, glm::vec3(0.0f), first + count - middle});
+        pending.push_back({left, current.depth + 1});
+        pending.push_back({left + 1, current.depth + 1});
+    }
+
+    // store the boxes in leaf order and follow them with the slots
+    std::vector<Box> sorted(numBoxes);
+    std::vector<uint32_t> positions(numBoxes);
+    for(size_t i = 0; i < numBoxes; ++i) {
+        sorted[i] = tree.boxes[order[i]];
+        positions[order[i]] = static_cast<uint32_t>(i);
+    }
+    for(uint32_t& slot : tree.slots) {
+        slot = positions[slot];
+    }
+    tree.boxes.swap(sorted);
+}
+
+void SceneQuery::_refit(Tree& tree) {
+    // children always come after their parent
+    for(size_t i = tree.nodes.size(); i-- > 0;) {
+        Node& node = tree.nodes[i];
+        if(node.count > 0) {
+            node.boundsMin = glm::vec3(FLT_MAX);
+            node.boundsMax = glm::vec3(-FLT_MAX);
+            for(uint32_t box = node.first; box < node.first + node.count; ++box) {
+                node.boundsMin = glm::min(node.boundsMin, tree.boxes[box].boundsMin);
+                node.boundsMax = glm::max(node.boundsMax, tree.boxes[box].boundsMax);
+            }
+        } else {
+            const Node& left = tree.nodes[node.first];
+            const Node& right = tree.nodes[node.first + 1];
+            node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+            node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+        }
+    }
+}
+
+bool SceneQuery::_cast(const Tree& tree, glm::vec3 origin, glm::vec3 direction, float grow, unsigned int typeMask, Hit& hit) {
+    if(tree.nodes.empty() || (tree.types & typeMask) == 0) return false;
+
+    const glm::vec3 inverse = inverseDirection(direction);
+    const glm::vec3 margin(grow);
+    float closest = hit.distance;
+    const Box* pClosest = nullptr;
+
+    // nodes wait with the distance they were entered at, near child on top
+    struct Entry {
+        uint32_t node;
+        float tNear;
+    };
+    Entry stack[MAX_DEPTH + 2];
+    int stackSize = 0;
+    float tNear;
+    if(!intersectBox(origin, inverse, tree.nodes[0].boundsMin - margin, tree.nodes[0].boundsMax + margin, closest, tNear)) return false;
+    stack[stackSize++] = {0, tNear};
+
+    while(stackSize > 0) {
+        const Entry entry = stack[--stackSize];
+        if(entry.tNear > closest) continue;
+        const Node& node = tree.nodes[entry.node];
+
+        if(node.count > 0) {
+            for(uint32_t i = node.first; i < node.first + node.count; ++i) {
+                const Box& box = tree.boxes[i];
+                if((typeBit(box.type) & typeMask) == 0) continue;
+                if(intersectBox(origin, inverse, box.boundsMin - margin, box.boundsMax + margin, closest, tNear)) {
+                    closest = tNear;
+                    pClosest = &box;
+                }
+            }
+            continue;
+        }
+
+        const Node& left = tree.nodes[node.first];
+        const Node& right = tree.nodes[node.first + 1];
+        float tLeft, tRight;
+        bool hitLeft = intersectBox(origin, inverse, left.boundsMin - margin, left.boundsMax + margin, closest, tLeft);
+        bool hitRight = intersectBox(origin, inverse, right.boundsMin - margin, right.boundsMax + margin, closest, tRight);
+        if(hitLeft && hitRight) {
+            if(tLeft <= tRight) {
+                stack[stackSize++] = {node.first + 1, tRight};
+                stack[stackSize++] = {node.first, tLeft};
+            } else {
+                stack[stackSize++] = {node.first, tLeft};
+                stack[stackSize++] = {node.first + 1, tRight};
+            }
+        } else if(hitLeft) {
+            stack[stackSize++] = {node.first, tLeft};
+        } else if(hitRight) {
+            stack[stackSize++] = {node.first + 1, tRight};
+        }
+    }
+
+    if(pClosest == nullptr) return false;
+    hit.type = pClosest->type;
+    hit.index = pClosest->index;
+    hit.distance = closest;
+    hit.normal = entryNormal(origin, direction, pClosest->boundsMin - margin, pClosest->boundsMax + margin, closest);
+    return true;
+}
+
+bool SceneQuery::raycast(const Ray& ray, Hit& hit, unsigned int typeMask) const {
+    hit.index = NO_OBJECT;
+    hit.distance = ray.maxDistance;
+    bool hitStatic = _cast(_static, ray.origin, ray.direction, 0.0f, typeMask, hit);
+    bool hitDynamic = _cast(_dynamic, ray.origin, ray.direction, 0.0f, typeMask, hit);
+    return hitStatic || hitDynamic;
+}
+
+bool SceneQuery::segmentCast(glm::vec3 start, glm::vec3 end, Hit& hit, unsigned int typeMask) const {
+    return sphereCast(start, end, 0.0f, hit, typeMask);
+}
+
+bool SceneQuery::sphereCast(glm::vec3 start, glm::vec3 end, float radius, Hit& hit, unsigned int typeMask) const {
+    glm::vec3 motion = end - start;
+    float length = glm::length(motion);
+    // a zero length cast still reports the boxes the start is inside
+    glm::vec3 direction = length > 0.0f ? motion / length : glm::vec3(0.0f, 1.0f, 0.0f);
+
+    hit.index = NO_OBJECT;
+    hit.distance = length;
+    bool hitStatic = _cast(_static, start, direction, radius, typeMask, hit);
+    bool hitDynamic = _cast(_dynamic, start, direction, radius, typeMask, hit);
+    return hitStatic || hitDynamic;
+}
+
+#ifdef SCENE_QUERY_SSE
+void SceneQuery::_castPacket(const Tree& tree, const Ray* rays, unsigned int typeMask, float* closest, const Box** hitBoxes) {
+    if(tree.nodes.empty() || (tree.types & typeMask) == 0) return;
+
+    alignas(16) float origins[3][4];
+    alignas(16) float inverses[3][4];
+    for(int lane = 0; lane < 4; ++lane) {
+        glm::vec3 inverse = inverseDirection(rays[lane].direction);
+        for(int axis = 0; axis < 3; ++axis) {
+            origins[axis][lane] = rays[lane].origin[axis];
+            inverses[axis][lane] = inverse[axis];
+        }
+    }
+    const __m128 originX = _mm_load_ps(origins[0]), originY = _mm_load_ps(origins[1]), originZ = _mm_load_ps(origins[2]);
+    const __m128 inverseX = _mm_load_ps(inverses[0]), inverseY = _mm_load_ps(inverses[1]), inverseZ = _mm_load_ps(inverses[2]);
+    __m128 closestDistance = _mm_loadu_ps(closest);
+
+    // slab test of one box against all four rays, a lane's bits are set where it hits
+    auto testBox = [&](glm::vec3 boundsMin, glm::vec3 boundsMax, __m128& tNear) {
+        __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMin.x), originX), inverseX);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMax.x), originX), inverseX);
+        __m128 tMin = _mm_max_ps(_mm_min_ps(t0, t1), _mm_setzero_ps());
+        __m128 tMax = _mm_min_ps(_mm_max_ps(t0, t1), closestDistance);
+        t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMin.y), originY), inverseY);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMax.y), originY), inverseY);
+        tMin = _mm_max_ps(tMin, _mm_min_ps(t0, t1));
+        tMax = _mm_min_ps(tMax, _mm_max_ps(t0, t1));
+        t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMin.z), originZ), inverseZ);
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMax.z), originZ), inverseZ);
+        tMin = _mm_max_ps(tMin, _mm_min_ps(t0, t1));
+        tMax = _mm_min_ps(tMax, _mm_max_ps(t0, t1));
+        tNear = tMin;
+        return _mm_cmple_ps(tMin, tMax);
+    };
+
+    // a node is entered when any lane still hits it, the child nearer along the first ray first
+    const glm::vec3 leadDirection = rays[0].direction;
+    uint32_t stack[MAX_DEPTH + 2];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while(stackSize > 0) {
+        const Node& node = tree.nodes[stack[--stackSize]];
+        __m128 tNear;
+        if(_mm_movemask_ps(testBox(node.boundsMin, node.boundsMax, tNear)) == 0) continue;
+
+        if(node.count == 0) {
+            const Node& left = tree.nodes[node.first];
+            const Node& right = tree.nodes[node.first + 1];
+            glm::vec3 centerOffset = (right.boundsMin + right.boundsMax) - (left.boundsMin + left.boundsMax);
+            bool leftFirst = glm::dot(centerOffset, leadDirection) >= 0.0f;
+            stack[stackSize++] = leftFirst ? node.first + 1 : node.first;
+            stack[stackSize++] = leftFirst ? node.first : node.first + 1;
+            continue;
+        }
+
+        for(uint32_t i = node.first; i < node.first + node.count; ++i) {
+            const Box& box = tree.boxes[i];
+            if((typeBit(box.type) & typeMask) == 0) continue;
+            __m128 hitMask = testBox(box.boundsMin, box.boundsMax, tNear);
+            int lanes = _mm_movemask_ps(hitMask);
+            if(lanes == 0) continue;
+            closestDistance = _mm_or_ps(_mm_and_ps(hitMask, tNear), _mm_andnot_ps(hitMask, closestDistance));
+            for(int lane = 0; lane < 4; ++lane) {
+                if(lanes & (1 << lane)) hitBoxes[lane] = &box;
+            }
+        }
+    }
+    _mm_storeu_ps(closest, closestDistance);
+}
+#endif
+
+size_t SceneQuery::raycastBatch(const Ray* rays, size_t count, Hit* hits, unsigned int typeMask) const {
+    size_t numHits = 0;
+#ifdef SCENE_QUERY_SSE
+    for(size_t first = 0; first < count; first += 4) {
+        // a short last packet repeats its last ray in the spare lanes
+        Ray packet[4];
+        float closest[4];
+        const Box* hitBoxes[4] = {nullptr, nullptr, nullptr, nullptr};
+        for(size_t lane = 0; lane < 4; ++lane) {
+            packet[lane] = rays[std::min(first + lane, count - 1)];
+            closest[lane] = packet[lane].maxDistance;
+        }
+        _castPacket(_static, packet, typeMask, closest, hitBoxes);
+        _castPacket(_dynamic, packet, typeMask, closest, hitBoxes);
+
+        for(size_t lane = 0; lane < 4 && first + lane < count; ++lane) {
+            Hit& hit = hits[first + lane];
+            hit.distance = closest[lane];
+            const Box* pBox = hitBoxes[lane];
+            if(pBox == nullptr) {
+                hit.index = NO_OBJECT;
+                continue;
+            }
+            hit.type = pBox->type;
+            hit.index = pBox->index;
+            hit.normal = entryNormal(packet[lane].origin, packet[lane].direction, pBox->boundsMin, pBox->boundsMax, hit.distance);
+            ++numHits;
+        }
+    }
+#else
+    for(size_t i = 0; i < count; ++i) {
+        if(raycast(rays[i], hits[i], typeMask)) ++numHits;
+    }
+#endif
+    return numHits;
+}
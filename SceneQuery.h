@@ -0,0 +1,105 @@
+#ifndef SCENE_QUERY_H
+#define SCENE_QUERY_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Ray, segment and sphere casts against the scenery and the heroes, every
+// object being one or more axis aligned boxes. Static boxes go into a
+// bounding volume hierarchy built once with the binned surface area
+// heuristic. Moving boxes go into a second, small hierarchy that is built
+// when one is added and only refit after they move.
+// Sphere casts test the center against boxes grown by the radius, whose
+// corners are not rounded, so they hit a little early next to edges.
+// raycastBatch() walks both trees with four rays at a time, one per SSE lane.
+class SceneQuery {
+public:
+    enum class ObjectType : uint8_t {
+        TREE,
+        LAMP,
+        BUILDING,
+        HERO
+    };
+    static constexpr unsigned int typeBit(ObjectType type) { return 1u << static_cast<unsigned int>(type); }
+    static constexpr unsigned int ALL_TYPES = 0xF;
+    // the index a miss reports
+    static constexpr uint32_t NO_OBJECT = 0xFFFFFFFF;
+
+    struct Ray {
+        glm::vec3 origin;
+        glm::vec3 direction;    // unit length
+        float maxDistance;
+    };
+
+    struct Hit {
+        ObjectType type;
+        uint32_t index;         // into the engine's list of that type
+        float distance;         // along the ray, 0 when it starts inside a box
+        glm::vec3 normal;       // of the face hit, against the ray
+    };
+
+    // removes all static and moving boxes
+    void clear();
+
+    void addStaticBox(ObjectType type, uint32_t index, glm::vec3 boundsMin, glm::vec3 boundsMax);
+    // builds the static tree over every static box added since clear()
+    void buildStatic();
+
+    // rebuilds the moving tree, returns the handle to move the box by
+    uint32_t addDynamicBox(ObjectType type, uint32_t index, glm::vec3 boundsMin, glm::vec3 boundsMax);
+    void moveDynamicBox(uint32_t box, glm::vec3 boundsMin, glm::vec3 boundsMax);
+    // brings the moving tree's bounds up to date after moves
+    void refit();
+
+    // typeMask is a combination of typeBit()s, boxes of other types are passed through
+    bool raycast(const Ray& ray, Hit& hit, unsigned int typeMask = ALL_TYPES) const;
+    bool segmentCast(glm::vec3 start, glm::vec3 end, Hit& hit, unsigned int typeMask = ALL_TYPES) const;
+    // the distance is how far the center travels before the sphere touches a box
+    bool sphereCast(glm::vec3 start, glm::vec3 end, float radius, Hit& hit, unsigned int typeMask = ALL_TYPES) const;
+    // hits[i] is the result of rays[i], index NO_OBJECT on a miss; returns how many hit
+    size_t raycastBatch(const Ray* rays, size_t count, Hit* hits, unsigned int typeMask = ALL_TYPES) const;
+
+    size_t getNumStaticBoxes() const { return _static.boxes.size(); }
+    size_t getNumStaticNodes() const { return _static.nodes.size(); }
+
+    static constexpr int NUM_BINS = 12;
+    static constexpr uint32_t MAX_LEAF_BOXES = 4;
+    // deeper nodes become leaves, so traversal stacks can be fixed arrays
+    static constexpr int MAX_DEPTH = 40;
+
+private:
+    struct Box {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        ObjectType type;
+        uint32_t index;
+    };
+
+    // an interior node's children are nodes first and first + 1, a leaf holds boxes first to first + count - 1
+    struct Node {
+        glm::vec3 boundsMin;
+        uint32_t first;
+        glm::vec3 boundsMax;
+        uint32_t count;
+    };
+
+    struct Tree {
+        std::vector<Box> boxes;         // in leaf order once built
+        std::vector<uint32_t> slots;    // where each box, in the order added, ended up in boxes
+        std::vector<Node> nodes;
+        unsigned int types = 0;         // typeBit()s of every box in the tree
+    };
+
+    Tree _static;
+    Tree _dynamic;
+
+    static void _build(Tree& tree);
+    static void _refit(Tree& tree);
+    // closest box of the tree nearer than hit.distance along the ray, each box grown by grow
+    static bool _cast(const Tree& tree, glm::vec3 origin, glm::vec3 direction, float grow, unsigned int typeMask, Hit& hit);
+    static void _castPacket(const Tree& tree, const Ray* rays, unsigned int typeMask, float* closest, const Box** hitBoxes);
+};
+
+#endif // SCENE_QUERY_H
@@ -0,0 +1,222 @@
+#include "SphericalHarmonics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+    const char CACHE_MAGIC[4] = {'M', 'P', 'S', 'H'};
+
+    struct CacheFile {
+        char magic[4];
+        uint32_t version;
+        uint64_t hash;
+        float coefficients[SphericalHarmonics::NUM_COEFFICIENTS * 3];
+    };
+
+    // real spherical harmonics basis constants, bands 0, 1 and 2
+    const float BASIS_0 = 0.282095f;   // Y00
+    const float BASIS_1 = 0.488603f;   // Y1-1, Y10, Y11
+    const float BASIS_2 = 1.092548f;   // Y2-2, Y2-1, Y21
+    const float BASIS_20 = 0.315392f;  // Y20
+    const float BASIS_22 = 0.546274f;  // Y22
+
+    void evaluateBasis(glm::vec3 d, float basis[SphericalHarmonics::NUM_COEFFICIENTS]) {
+        basis[0] = BASIS_0;
+        basis[1] = BASIS_1 * d.y;
+        basis[2] = BASIS_1 * d.z;
+        basis[3] = BASIS_1 * d.x;
+        basis[4] = BASIS_2 * d.x * d.y;
+        basis[5] = BASIS_2 * d.y * d.z;
+        basis[6] = BASIS_20 * (3.0f * d.z * d.z - 1.0f);
+        basis[7] = BASIS_2 * d.x * d.z;
+        basis[8] = BASIS_22 * (d.x * d.x - d.y * d.y);
+    }
+
+    // direction through face coordinates s, t in [-1, 1], s to the right and t down the rows
+    glm::vec3 faceDirection(int face, float s, float t) {
+        switch(face) {
+            case 0:  return glm::vec3( 1.0f, -t, -s);
+            case 1:  return glm::vec3(-1.0f, -t,  s);
+            case 2:  return glm::vec3( s,  1.0f,  t);
+            case 3:  return glm::vec3( s, -1.0f, -t);
+            case 4:  return glm::vec3( s, -t,  1.0f);
+            default: return glm::vec3(-s, -t, -1.0f);
+        }
+    }
+}
+
+SphericalHarmonics::Coefficients SphericalHarmonics::project(const CubemapFace faces[NUM_FACES], unsigned int numThreads) {
+    // blocks of rows sum into their own slot and the slots are added in order,
+    // so the result does not depend on how the threads were scheduled
+    struct Block {
+        int face;
+        int firstRow;
+    };
+    std::vector<Block> blocks;
+    for(int face = 0; face < NUM_FACES; ++face) {
+        for(int row = 0; row < faces[face].height; row += ROWS_PER_BLOCK) blocks.push_back({face, row});
+    }
+    std::vector<double> sums(blocks.size() * NUM_COEFFICIENTS * 3, 0.0);
+
+    std::atomic<size_t> nextBlock(0);
+    auto worker = [&]() {
+        for(size_t b = nextBlock++; b < blocks.size(); b = nextBlock++) {
+            const CubemapFace& face = faces[blocks[b].face];
+            int lastRow = std::min(blocks[b].firstRow + ROWS_PER_BLOCK, face.height);
+            float texelSize = 2.0f / static_cast<float>(face.width);
+            float rowSize = 2.0f / static_cast<float>(face.height);
+            double* sum = &sums[b * NUM_COEFFICIENTS * 3];
+            float basis[NUM_COEFFICIENTS];
+
+            // a texel of area dA at distance r from the center subtends dA / r^3
+            float texelArea = texelSize * rowSize;
+
+            for(int row = blocks[b].firstRow; row < lastRow; ++row) {
+                float t = -1.0f + (row + 0.5f) * rowSize;
+                // row sums in float, a row is short enough not to lose precision
+                float rowSum[NUM_COEFFICIENTS * 3] = {0.0f};
+                const unsigned char* pixel = face.pixels + static_cast<size_t>(row) * face.width * face.channels;
+                for(int column = 0; column < face.width; ++column, pixel += face.channels) {
+                    float s = -1.0f + (column + 0.5f) * texelSize;
+                    float inverseDistance = 1.0f / std::sqrt(1.0f + s * s + t * t);
+                    float solidAngle = texelArea * inverseDistance * inverseDistance * inverseDistance;
+                    evaluateBasis(faceDirection(blocks[b].face, s, t) * inverseDistance, basis);
+
+                    // the lighting shaders work on stored colors as they are, so no sRGB decode
+                    glm::vec3 radiance = (face.channels >= 3
+                                          ? glm::vec3(pixel[0], pixel[1], pixel[2])
+                                          : glm::vec3(pixel[0])) * (solidAngle / 255.0f);
+                    for(int i = 0; i < NUM_COEFFICIENTS; ++i) {
+                        rowSum[3 * i + 0] += radiance.x * basis[i];
+                        rowSum[3 * i + 1] += radiance.y * basis[i];
+                        rowSum[3 * i + 2] += radiance.z * basis[i];
+                    }
+                }
+                for(int i = 0; i < NUM_COEFFICIENTS * 3; ++i) sum[i] += rowSum[i];
+            }
+        }
+    };
+
+    if(numThreads == 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = static_cast<unsigned int>(std::min<size_t>(numThreads, blocks.size()));
+    std::vector<std::thread> threads;
+    for(unsigned int i = 1; i < numThreads; ++i) threads.emplace_back(worker);
+    worker();
+    for(std::thread& thread : threads) thread.join();
+
+    double total[NUM_COEFFICIENTS * 3] = {0.0};
+    for(size_t b = 0; b < blocks.size(); ++b) {
+        for(int i = 0; i < NUM_COEFFICIENTS * 3; ++i) total[i] += sums[b * NUM_COEFFICIENTS * 3 + i];
+    }
+    Coefficients radiance;
+    for(int i = 0; i < NUM_COEFFICIENTS; ++i) {
+        radiance[i] = glm::vec3(static_cast<float>(total[3 * i]), static_cast<float>(total[3 * i + 1]), static_cast<float>(total[3 * i + 2]));
+    }
+    return radiance;
+}
+
+SphericalHarmonics::Coefficients SphericalHarmonics::toAmbient(const Coefficients& radiance) {
+    // clamped cosine convolution per band over the pi of a diffuse surface: pi, 2pi/3 and pi/4, over pi
+    const float BAND_0 = 1.0f, BAND_1 = 2.0f / 3.0f, BAND_2 = 0.25f;
+    const float SCALES[NUM_COEFFICIENTS] = {
+        BAND_0 * BASIS_0,
+        BAND_1 * BASIS_1, BAND_1 * BASIS_1, BAND_1 * BASIS_1,
+        BAND_2 * BASIS_2, BAND_2 * BASIS_2, BAND_2 * BASIS_20, BAND_2 * BASIS_2, BAND_2 * BASIS_22
+    };
+    Coefficients ambient;
+    for(int i = 0; i < NUM_COEFFICIENTS; ++i) ambient[i] = radiance[i] * SCALES[i];
+    return ambient;
+}
+
+SphericalHarmonics::Coefficients SphericalHarmonics::constantAmbient(glm::vec3 color) {
+    Coefficients ambient;
+    ambient.fill(glm::vec3(0.0f));
+    ambient[0] = color;
+    return ambient;
+}
+
+glm::vec3 SphericalHarmonics::evaluateAmbient(const Coefficients& ambient, glm::vec3 n) {
+    return ambient[0]
+         + ambient[1] * n.y + ambient[2] * n.z + ambient[3] * n.x
+         + ambient[4] * (n.x * n.y) + ambient[5] * (n.y * n.z) + ambient[6] * (3.0f * n.z * n.z - 1.0f)
+         + ambient[7] * (n.x * n.z) + ambient[8] * (n.x * n.x - n.y * n.y);
+}
+
+uint64_t SphericalHarmonics::hashFaces(const CubemapFace faces[NUM_FACES]) {
+    uint64_t hash = 14695981039346656037ull;
+    auto hashBytes = [&hash](const unsigned char* bytes, size_t count) {
+        for(size_t i = 0; i < count; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    for(int face = 0; face < NUM_FACES; ++face) {
+        int32_t size[3] = {faces[face].width, faces[face].height, faces[face].channels};
+        hashBytes(reinterpret_cast<const unsigned char*>(size), sizeof(size));
+        hashBytes(faces[face].pixels, static_cast<size_t>(faces[face].width) * faces[face].height * faces[face].channels);
+    }
+    return hash;
+}
+
+bool SphericalHarmonics::loadCache(const char* filename, uint64_t hash, Coefficients& ambient) {
+    FILE* fp = fopen(filename, "rb");
+    if(!fp) return false;
+
+    CacheFile cache;
+    bool valid = fread(&cache, sizeof(cache), 1, fp) == 1
+              && memcmp(cache.magic, CACHE_MAGIC, 4) == 0
+              && cache.version == CACHE_VERSION
+              && cache.hash == hash;
+    fclose(fp);
+    if(!valid) return false;
+
+    for(int i = 0; i < NUM_COEFFICIENTS; ++i) {
+        ambient[i] = glm::vec3(cache.coefficients[3 * i], cache.coefficients[3 * i + 1], cache.coefficients[3 * i + 2]);
+    }
+    return true;
+}
+
+bool SphericalHarmonics::saveCache(const char* filename, uint64_t hash, const Coefficients& ambient) {
+    CacheFile cache;
+    memset(&cache, 0, sizeof(cache));
+    memcpy(cache.magic, CACHE_MAGIC, 4);
+    cache.version = CACHE_VERSION;
+    cache.hash = hash;
+    for(int i = 0; i < NUM_COEFFICIENTS; ++i) {
+        cache.coefficients[3 * i + 0] = ambient[i].x;
+        cache.coefficients[3 * i + 1] = ambient[i].y;
+        cache.coefficients[3 * i + 2] = ambient[i].z;
+    }
+
+    FILE* fp = fopen(filename, "wb");
+    if(!fp) {
+        fprintf( stderr, "[ERROR]: Could not open spherical harmonics cache \"%s\" for writing\n", filename );
+        return false;
+    }
+    bool ok = fwrite(&cache, sizeof(cache), 1, fp) == 1;
+    fclose(fp);
+    if(!ok) fprintf( stderr, "[ERROR]: Could not write spherical harmonics cache \"%s\"\n", filename );
+    return ok;
+}
+
+SphericalHarmonics::Coefficients SphericalHarmonics::computeAmbient(const CubemapFace faces[NUM_FACES], const char* cacheFilename) {
+    uint64_t hash = hashFaces(faces);
+    Coefficients ambient;
+    if(loadCache(cacheFilename, hash, ambient)) {
+        fprintf( stdout, "[INFO]: sky ambient light read from %s\n", cacheFilename );
+        return ambient;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ambient = toAmbient(project(faces));
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    fprintf( stdout, "[INFO]: projected the sky into spherical harmonics in %.1f ms\n", ms );
+    saveCache(cacheFilename, hash, ambient);
+    return ambient;
+}
@@ -0,0 +1,52 @@
+#ifndef SPHERICAL_HARMONICS_H
+#define SPHERICAL_HARMONICS_H
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+
+// Ambient light from a cubemap as 2nd order spherical harmonics, the nine
+// coefficients the lighting shaders evaluate at a normal in a dozen
+// multiply-adds. Projecting a cubemap touches every texel, so it is done
+// once on worker threads and the result cached on disk, keyed by a hash of
+// the face pixels.
+//
+// Ambient coefficients have the clamped cosine convolution, the 1/pi of a
+// diffuse surface and the basis constants folded in; skyAmbient() in the
+// lighting shaders is evaluateAmbient() here.
+namespace SphericalHarmonics {
+    constexpr int NUM_COEFFICIENTS = 9;
+    using Coefficients = std::array<glm::vec3, NUM_COEFFICIENTS>;
+
+    // one face as stbi_load() returns it, rows top to bottom, in GL's +X, -X, +Y, -Y, +Z, -Z order
+    struct CubemapFace {
+        const unsigned char* pixels;
+        int width;
+        int height;
+        int channels;
+    };
+    constexpr int NUM_FACES = 6;
+
+    // radiance of the faces, weighted by each texel's solid angle, 0 threads is one per core
+    Coefficients project(const CubemapFace faces[NUM_FACES], unsigned int numThreads = 0);
+    // radiance to what a diffuse surface facing each way reflects
+    Coefficients toAmbient(const Coefficients& radiance);
+    // ambient coefficients that evaluate to color whichever way a surface faces
+    Coefficients constantAmbient(glm::vec3 color);
+    glm::vec3 evaluateAmbient(const Coefficients& ambient, glm::vec3 normal);
+
+    // FNV-1a over the size and pixels of every face
+    uint64_t hashFaces(const CubemapFace faces[NUM_FACES]);
+    bool loadCache(const char* filename, uint64_t hash, Coefficients& ambient);
+    bool saveCache(const char* filename, uint64_t hash, const Coefficients& ambient);
+
+    // the cached ambient coefficients of the faces, projected and cached when the cache misses
+    Coefficients computeAmbient(const CubemapFace faces[NUM_FACES], const char* cacheFilename);
+
+    constexpr uint32_t CACHE_VERSION = 1;
+    // rows of one face a worker projects at a time
+    constexpr int ROWS_PER_BLOCK = 16;
+}
+
+#endif // SPHERICAL_HARMONICS_H
@@ -0,0 +1,131 @@
+#include "StatsOverlay.h"
+
+#include <cstdint>
+#include <cstring>
+
+static const char GLYPH_CHARACTERS[] = " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ.:/-()%";
+// 5x7, one byte per row, bit 4 is the leftmost column
+static const uint8_t GLYPH_ROWS[][StatsOverlay::GLYPH_HEIGHT] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // '0'
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // '1'
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // '2'
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // '3'
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // '4'
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // '5'
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // '6'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // '7'
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // '8'
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // '9'
+    {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // 'A'
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, // 'B'
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, // 'C'
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, // 'D'
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // 'E'
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, // 'F'
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, // 'G'
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // 'H'
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 'I'
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, // 'J'
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // 'K'
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // 'L'
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, // 'M'
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // 'N'
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // 'O'
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // 'P'
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, // 'Q'
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, // 'R'
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, // 'S'
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // 'T'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // 'U'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, // 'V'
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, // 'W'
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // 'X'
+    {0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04}, // 'Y'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, // 'Z'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // '.'
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, // ':'
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // '/'
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // '-'
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}, // '('
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}, // ')'
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, // '%'
+};
+static constexpr GLuint NUM_GLYPHS = sizeof(GLYPH_ROWS) / sizeof(GLYPH_ROWS[0]);
+
+static GLuint getGlyph(char character) {
+    if (character >= 'a' && character <= 'z') character = static_cast<char>(character - 'a' + 'A');
+    const char* found = (character == '\0' ? nullptr : strchr(GLYPH_CHARACTERS, character));
+    return (found != nullptr ? static_cast<GLuint>(found - GLYPH_CHARACTERS) : 0);
+}
+
+void StatsOverlay::create(GpuResourceRegistry& registry) {
+    release();
+
+    // every glyph side by side, top row first
+    const GLuint atlasWidth = NUM_GLYPHS * GLYPH_WIDTH;
+    std::vector<GLubyte> pixels(atlasWidth * GLYPH_HEIGHT);
+    for (GLuint glyph = 0; glyph < NUM_GLYPHS; ++glyph) {
+        for (GLuint row = 0; row < GLYPH_HEIGHT; ++row) {
+            for (GLuint column = 0; column < GLYPH_WIDTH; ++column) {
+                bool set = (GLYPH_ROWS[glyph][row] >> (GLYPH_WIDTH - 1 - column)) & 1;
+                pixels[row * atlasWidth + glyph * GLYPH_WIDTH + column] = (set ? 255 : 0);
+            }
+        }
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, GLYPH_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    _fontTexture = registry.adopt(GpuResourceType::TEXTURE, texture, pixels.size(), "stats overlay font");
+
+    _vao = registry.createVertexArray("stats overlay VAO");
+    _instanceVBO = registry.createBuffer(GL_ARRAY_BUFFER, MAX_CHARACTERS * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW, "stats overlay instance VBO");
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glVertexAttribDivisor(0, 1);
+    glBindVertexArray(0);
+
+    _characters.reserve(MAX_CHARACTERS);
+}
+
+void StatsOverlay::release() {
+    _vao.reset();
+    _instanceVBO.reset();
+    _fontTexture.reset();
+    clear();
+}
+
+void StatsOverlay::clear() {
+    _characters.clear();
+    _numLines = 0;
+}
+
+void StatsOverlay::addLine(const char* text) {
+    for (GLuint column = 0; text[column] != '\0' && _characters.size() < MAX_CHARACTERS; ++column) {
+        _characters.push_back(glm::vec3(static_cast<GLfloat>(column), static_cast<GLfloat>(_numLines), static_cast<GLfloat>(getGlyph(text[column]))));
+    }
+    _numLines++;
+}
+
+void StatsOverlay::draw() {
+    if (_characters.empty()) return;
+
+    // orphan the previous contents so the upload does not wait on the last draw
+    glBindBuffer(GL_ARRAY_BUFFER, _instanceVBO.get());
+    glBufferData(GL_ARRAY_BUFFER, MAX_CHARACTERS * sizeof(glm::vec3), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, _characters.size() * sizeof(glm::vec3), _characters.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindVertexArray(_vao.get());
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(_characters.size()));
+    glBindVertexArray(0);
+}
@@ -0,0 +1,44 @@
+#ifndef STATS_OVERLAY_H
+#define STATS_OVERLAY_H
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "GpuResourceRegistry.h"
+
+// Lines of text in the top left corner of the window, drawn in one instanced call.
+// The font is a built in 5x7 pixel face covering digits, upper case letters
+// and a little punctuation, uploaded once as a single row texture. Every
+// character is an instance of a quad with its column, line and glyph; the
+// fragment shader fetches the glyph's pixels and fills the rest of the cell
+// with a translucent background so the text stays readable over the scene.
+class StatsOverlay {
+public:
+    static constexpr GLuint GLYPH_WIDTH = 5;
+    static constexpr GLuint GLYPH_HEIGHT = 7;
+    static constexpr GLuint MAX_CHARACTERS = 2048;
+
+    void create(GpuResourceRegistry& registry);
+    void release();
+
+    // text for the next draw, lower case is shown as upper case and anything else unknown as a space
+    void clear();
+    void addLine(const char* text);
+
+    // bind the overlay program and the font texture first
+    void draw();
+
+    GLuint getFontTexture() const { return _fontTexture.get(); }
+
+private:
+    GpuHandle _vao;
+    GpuHandle _instanceVBO;
+    GpuHandle _fontTexture;
+    // column, line and glyph of every character
+    std::vector<glm::vec3> _characters;
+    GLuint _numLines = 0;
+};
+
+#endif // STATS_OVERLAY_H
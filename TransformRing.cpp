@@ -0,0 +1,151 @@
+#include "TransformRing.h"
+
+#include "GLStats.h"
+
+#include <cstdio>
+#include <cstring>
+
+TransformRing::TransformRing()
+    : _bufferName(0),
+      _pMapped(nullptr),
+      _persistent(false),
+      _stride(0),
+      _chunkBytes(0),
+      _offset(0),
+      _chunk(0),
+      _stats{0, 0, 0}
+{}
+
+TransformRing::~TransformRing() {
+    release();
+}
+
+void TransformRing::create(GpuResourceRegistry& registry) {
+    release();
+
+    // every bound range has to start on the uniform buffer offset alignment
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    _stride = ((static_cast<GLsizeiptr>(sizeof(DrawTransform)) + alignment - 1) / alignment) * alignment;
+    _chunkBytes = _stride * DRAWS_PER_CHUNK;
+    GLsizeiptr bytes = _chunkBytes * NUM_CHUNKS;
+
+    GLuint name;
+    glGenBuffers(1, &name);
+    glBindBuffer(GL_UNIFORM_BUFFER, name);
+
+    _persistent = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+    if(_persistent) {
+        const GLbitfield FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, bytes, nullptr, FLAGS);
+        _pMapped = static_cast<uint8_t*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, bytes, FLAGS));
+        if(_pMapped == nullptr) {
+            // immutable storage cannot be respecified, start over with a mutable buffer
+            fprintf( stderr, "[ERROR]: could not map the transform ring persistently, falling back to orphaning\n" );
+            glDeleteBuffers(1, &name);
+            glGenBuffers(1, &name);
+            glBindBuffer(GL_UNIFORM_BUFFER, name);
+            _persistent = false;
+        }
+    }
+    if(!_persistent) {
+        glBufferData(GL_UNIFORM_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    }
+
+    _buffer = registry.adopt(GpuResourceType::BUFFER, name, static_cast<size_t>(bytes), "transform ring");
+    _bufferName = name;
+    _fences.assign(NUM_CHUNKS, nullptr);
+    _chunk = 0;
+    _offset = 0;
+
+    fprintf( stdout, "[INFO]: transform ring of %u x %u draws (%ld bytes), %s\n", NUM_CHUNKS, DRAWS_PER_CHUNK,
+             static_cast<long>(bytes), (_persistent ? "persistently mapped" : "orphaned on wrap") );
+}
+
+void TransformRing::release() {
+    for(GLsync& fence : _fences) {
+        if(fence != nullptr) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if(_pMapped != nullptr) {
+        glBindBuffer(GL_UNIFORM_BUFFER, _bufferName);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        _pMapped = nullptr;
+    }
+    _buffer.reset();
+    _bufferName = 0;
+}
+
+void TransformRing::bindBlock(GLuint programHandle, const char* blockName) {
+    GLuint blockIndex = glGetUniformBlockIndex(programHandle, blockName);
+    if(blockIndex == GL_INVALID_INDEX) {
+        fprintf( stderr, "[ERROR]: program %u has no uniform block \"%s\"\n", programHandle, blockName );
+        return;
+    }
+    glUniformBlockBinding(programHandle, blockIndex, BINDING_POINT);
+}
+
+void TransformRing::bindTransforms(const glm::mat4& modelMtx, const glm::mat4& viewProjMtx) {
+    if(_offset + _stride > static_cast<GLintptr>(_chunk + 1) * _chunkBytes) _advanceChunk();
+
+    DrawTransform transform;
+    transform.mvpMatrix = viewProjMtx * modelMtx;
+    transform.modelMatrix = modelMtx;
+    glm::mat3 normalMtx = glm::transpose(glm::inverse(glm::mat3(modelMtx)));
+    for(int i = 0; i < 3; ++i) transform.normalMatrix[i] = glm::vec4(normalMtx[i], 0.0f);
+
+    if(_persistent) {
+        memcpy(_pMapped + _offset, &transform, sizeof(transform));
+        GLStats::recordMappedUpload(sizeof(transform));
+    } else {
+        glBindBuffer(GL_UNIFORM_BUFFER, _bufferName);
+        glBufferSubData(GL_UNIFORM_BUFFER, _offset, sizeof(transform), &transform);
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, BINDING_POINT, _bufferName, _offset, sizeof(transform));
+
+    _offset += _stride;
+    _stats.draws++;
+}
+
+void TransformRing::endFrame() {
+    if(_offset > static_cast<GLintptr>(_chunk) * _chunkBytes) _advanceChunk();
+}
+
+void TransformRing::_advanceChunk() {
+    if(_persistent) {
+        // signals once every draw issued so far, including all that read this chunk, is done
+        _fences[_chunk] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    _chunk = (_chunk + 1) % NUM_CHUNKS;
+    _offset = static_cast<GLintptr>(_chunk) * _chunkBytes;
+
+    if(_persistent) {
+        _waitForChunk(_chunk);
+    } else if(_chunk == 0) {
+        // hand the old storage to the driver, it lives on until the draws reading it are done
+        glBindBuffer(GL_UNIFORM_BUFFER, _bufferName);
+        glBufferData(GL_UNIFORM_BUFFER, _chunkBytes * NUM_CHUNKS, nullptr, GL_STREAM_DRAW);
+        _stats.orphans++;
+    }
+}
+
+void TransformRing::_waitForChunk(GLuint chunk) {
+    GLsync fence = _fences[chunk];
+    if(fence == nullptr) return;
+
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if(result == GL_TIMEOUT_EXPIRED) {
+        _stats.fenceWaits++;
+        const GLuint64 ONE_SECOND = 1000000000;
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, ONE_SECOND);
+        } while(result == GL_TIMEOUT_EXPIRED);
+    }
+    if(result == GL_WAIT_FAILED) {
+        fprintf( stderr, "[ERROR]: waiting on a transform ring fence failed\n" );
+    }
+
+    glDeleteSync(fence);
+    _fences[chunk] = nullptr;
+}
@@ -0,0 +1,81 @@
+#ifndef TRANSFORM_RING_H
+#define TRANSFORM_RING_H
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "GpuResourceRegistry.h"
+
+// Streams the per-draw transforms of the lighting shader through one large
+// uniform buffer. Each draw writes its block linearly into the ring and binds
+// it with glBindBufferRange instead of three glUniform* calls.
+//
+// With GL_ARB_buffer_storage (core in 4.4) the buffer is mapped once,
+// persistently and coherently, and split into chunks guarded by fences; a
+// chunk is only rewritten after the GPU signalled it is done with it, which
+// with several frames worth of chunks never blocks in practice. On plain 4.1
+// the blocks are copied with glBufferSubData and the storage is orphaned every
+// time the ring wraps, so a region is never written while a draw may read it.
+class TransformRing {
+public:
+    // std140 layout of the DrawTransform block in lighting.vs.glsl
+    struct DrawTransform {
+        glm::mat4 mvpMatrix;
+        glm::mat4 modelMatrix;
+        // std140 pads each mat3 column to a vec4
+        glm::vec4 normalMatrix[3];
+    };
+
+    struct Stats {
+        unsigned int draws;
+        unsigned int fenceWaits;
+        unsigned int orphans;
+    };
+
+    static constexpr GLuint BINDING_POINT = 0;
+    static constexpr GLuint DRAWS_PER_CHUNK = 512;
+    static constexpr GLuint NUM_CHUNKS = 48;
+
+    TransformRing();
+    ~TransformRing();
+    TransformRing(const TransformRing&) = delete;
+    TransformRing& operator=(const TransformRing&) = delete;
+
+    void create(GpuResourceRegistry& registry);
+    void release();
+    bool isPersistent() const { return _persistent; }
+
+    // points the named uniform block of a program at the ring's binding point
+    static void bindBlock(GLuint programHandle, const char* blockName);
+
+    // writes the transforms of the next draw and binds them
+    void bindTransforms(const glm::mat4& modelMtx, const glm::mat4& viewProjMtx);
+    // fences what this frame wrote, the next frame starts on a fresh chunk
+    void endFrame();
+
+    const Stats& getStats() const { return _stats; }
+    void resetStats() { _stats = {0, 0, 0}; }
+
+private:
+    GpuHandle _buffer;
+    // cached so the per-draw path does not go through the registry
+    GLuint _bufferName;
+    uint8_t* _pMapped;
+    bool _persistent;
+
+    GLsizeiptr _stride;
+    GLsizeiptr _chunkBytes;
+    GLintptr _offset;
+    GLuint _chunk;
+    std::vector<GLsync> _fences;
+
+    Stats _stats;
+
+    void _advanceChunk();
+    void _waitForChunk(GLuint chunk);
+};
+
+#endif // TRANSFORM_RING_H
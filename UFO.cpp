@@ -1,18 +1,21 @@
 #include "UFO.h"
+
+#include "HeroMovement.h"
+
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-UFO::UFO(GLuint shaderProgramHandle, GLint mvpMatrixLocation, GLint normalMatrixLocation,
+UFO::UFO(GLuint shaderProgramHandle, TransformRing* pTransformRing,
          GLint materialAmbientLocation, GLint materialDiffuseLocation,
          GLint materialSpecularLocation, GLint materialShininessLocation)
     : _shaderProgramHandle(shaderProgramHandle),
-      _mvpMatrixLocation(mvpMatrixLocation),
-      _normalMatrixLocation(normalMatrixLocation),
+      _pTransformRing(pTransformRing),
       _materialAmbientLocation(materialAmbientLocation),
       _materialDiffuseLocation(materialDiffuseLocation),
       _materialSpecularLocation(materialSpecularLocation),
       _materialShininessLocation(materialShininessLocation),
       _position(-10.0f, 0.0f, -10.0f),
+      _boundingRadius(2.1f), // half the craft length
       _heading(0.0f)
 {}
 
@@ -27,40 +30,27 @@ void UFO::drawUFO(glm::mat4 viewMtx, glm::mat4 projMtx) const {
 }
 
 void UFO::flyForward() {
-    float speed = 0.2f;
-    _position += glm::vec3(sin(_heading), 0.0f, cos(_heading)) * speed;
-    float wheelRadius = 0.5f;
-    float rotationSpeed = (speed / (2.0f * M_PI * wheelRadius)) * 2.0f * M_PI;
+    _position = HeroMovement::step(_position, _heading, true);
 }
 
 void UFO::flyBackward() {
-    float speed = 0.2f;
-    _position -= glm::vec3(sin(_heading), 0.0f, cos(_heading)) * speed;
-    float wheelRadius = 0.5f;
-    float rotationSpeed = (speed / (2.0f * M_PI * wheelRadius)) * 2.0f * M_PI;
+    _position = HeroMovement::step(_position, _heading, false);
 }
 
 void UFO::turnLeft() {
-    float turnSpeed = glm::radians(2.0f);
-    _heading += turnSpeed;
-    if (_heading >= 2.0f * M_PI) _heading -= 2.0f * M_PI;
+    _heading = HeroMovement::turn(_heading, true);
 }
 
 void UFO::turnRight() {
-    float turnSpeed = glm::radians(2.0f);
-    _heading -= turnSpeed;
-    if (_heading < 0.0f) _heading += 2.0f * M_PI;
+    _heading = HeroMovement::turn(_heading, false);
 }
 
 
 void UFO::drawCraft(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx) const {
     glm::mat4 bodyMtx = modelMtx * glm::scale(glm::mat4(1.0f), glm::vec3(3.0f, 0.5f, 1.5f));
 
-    glm::mat4 mvpMtx = projMtx * viewMtx * bodyMtx;
-    glm::mat3 normalMtx = glm::transpose(glm::inverse(glm::mat3(bodyMtx)));
-
-    glUniformMatrix4fv(_mvpMatrixLocation, 1, GL_FALSE, glm::value_ptr(mvpMtx));
-    glUniformMatrix3fv(_normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMtx));
+    // Send matrices to shader
+    _pTransformRing->bindTransforms(bodyMtx, projMtx * viewMtx);
 
     glm::vec3 ambient(0.5f, 0.5f, 0.5f);
     glm::vec3 diffuse(0.6f, 0.6f, 0.6f);
@@ -79,11 +69,8 @@ void UFO::drawLookingPort(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projM
     glm::mat4 roofMtx = modelMtx * glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.5f, 0.0f));
     roofMtx = glm::scale(roofMtx, glm::vec3(1.0f, 0.5f, 1.0f)); // Adjust scale as needed
 
-    glm::mat4 mvpMtx = projMtx * viewMtx * roofMtx;
-    glm::mat3 normalMtx = glm::transpose(glm::inverse(glm::mat3(roofMtx)));
-
-    glUniformMatrix4fv(_mvpMatrixLocation, 1, GL_FALSE, glm::value_ptr(mvpMtx));
-    glUniformMatrix3fv(_normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMtx));
+    // Send matrices to shader
+    _pTransformRing->bindTransforms(roofMtx, projMtx * viewMtx);
     glm::vec3 ambient(0.2f, 0.2f, 0.5f);
     glm::vec3 diffuse(0.3f, 0.3f, 1.0f);
     glm::vec3 specular(1.0f, 1.0f, 1.0f);
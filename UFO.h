@@ -6,9 +6,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "TransformRing.h"
+
 class UFO {
 public:
-    UFO(GLuint shaderProgramHandle, GLint mvpMatrixLocation, GLint normalMatrixLocation,
+    UFO(GLuint shaderProgramHandle, TransformRing* pTransformRing,
         GLint materialAmbientLocation, GLint materialDiffuseLocation,
         GLint materialSpecularLocation, GLint materialShininessLocation);
 
@@ -27,10 +29,9 @@ public:
 
 private:
     GLuint _shaderProgramHandle;
-    GLint _mvpMatrixLocation;
+    TransformRing* _pTransformRing;
     GLint _materialSpecularLocation;
     GLint _materialShininessLocation;
-    GLint _normalMatrixLocation;
     GLint _materialAmbientLocation;
     GLint _materialDiffuseLocation;
     glm::vec3 _position;
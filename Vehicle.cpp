@@ -1,18 +1,21 @@
 #include "Vehicle.h"
+
+#include "HeroMovement.h"
+
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-Vehicle::Vehicle(GLuint shaderProgramHandle, GLint mvpMatrixLocation, GLint normalMatrixLocation,
+Vehicle::Vehicle(GLuint shaderProgramHandle, TransformRing* pTransformRing,
                  GLint materialAmbientLocation, GLint materialDiffuseLocation,
                  GLint materialSpecularLocation, GLint materialShininessLocation)
     : _shaderProgramHandle(shaderProgramHandle),
-      _mvpMatrixLocation(mvpMatrixLocation),
-      _normalMatrixLocation(normalMatrixLocation),
+      _pTransformRing(pTransformRing),
       _materialAmbientLocation(materialAmbientLocation),
       _materialDiffuseLocation(materialDiffuseLocation),
       _materialSpecularLocation(materialSpecularLocation),
       _materialShininessLocation(materialShininessLocation),
       _position(0.0f, 0.0f, 0.0f),
+      _boundingRadius(1.5f), // half the body length
       _heading(0.0f),
       _wheelRotation(0.0f)
 {}
@@ -29,9 +32,8 @@ void Vehicle::drawVehicle(glm::mat4 viewMtx, glm::mat4 projMtx) const {
 }
 
 void Vehicle::driveForward() {
-    float speed = 0.2f;
-    // Updated movement vector to align with +Z-axis front
-    _position += glm::vec3(sin(_heading), 0.0f, cos(_heading)) * speed;
+    float speed = HeroMovement::SPEED;
+    _position = HeroMovement::step(_position, _heading, true);
 
     // Calculate rotation based on movement and wheel radius
     float wheelRadius = 0.5f;
@@ -42,9 +44,8 @@ void Vehicle::driveForward() {
 }
 
 void Vehicle::driveBackward() {
-    float speed = 0.2f;
-    // Updated movement vector to align with +Z-axis front
-    _position -= glm::vec3(sin(_heading), 0.0f, cos(_heading)) * speed;
+    float speed = HeroMovement::SPEED;
+    _position = HeroMovement::step(_position, _heading, false);
 
     // Calculate rotation based on movement and wheel radius
     float wheelRadius = 0.5f; // Ensure this matches your wheel scaling
@@ -56,28 +57,19 @@ void Vehicle::driveBackward() {
 }
 
 void Vehicle::turnLeft() {
-    float turnSpeed = glm::radians(2.0f);
-    _heading += turnSpeed;
-
-    if (_heading >= 2.0f * M_PI) _heading -= 2.0f * M_PI;
+    _heading = HeroMovement::turn(_heading, true);
 }
 
 void Vehicle::turnRight() {
-    float turnSpeed = glm::radians(2.0f);
-    _heading -= turnSpeed;
-
-    if (_heading < 0.0f) _heading += 2.0f * M_PI;
+    _heading = HeroMovement::turn(_heading, false);
 }
 
 
 void Vehicle::_drawBody(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx) const {
     glm::mat4 bodyMtx = modelMtx * glm::scale(glm::mat4(1.0f), glm::vec3(3.0f, 0.5f, 1.5f));
 
-    glm::mat4 mvpMtx = projMtx * viewMtx * bodyMtx;
-    glm::mat3 normalMtx = glm::transpose(glm::inverse(glm::mat3(bodyMtx)));
-
-    glUniformMatrix4fv(_mvpMatrixLocation, 1, GL_FALSE, glm::value_ptr(mvpMtx));
-    glUniformMatrix3fv(_normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMtx));
+    // Send matrices to shader
+    _pTransformRing->bindTransforms(bodyMtx, projMtx * viewMtx);
 
     glm::vec3 ambient(0.6f, 0.0f, 0.6f);    // Increased ambient to match vibrant color
     glm::vec3 diffuse(1.0f, 0.0f, 1.0f);    // Hot Pink
@@ -97,13 +89,8 @@ void Vehicle::_drawRoof(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx
     glm::mat4 roofMtx = modelMtx * glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.5f, 0.0f));
     roofMtx = glm::scale(roofMtx, glm::vec3(1.0f, 0.5f, 1.0f)); // Adjust scale as needed
 
-    // Compute MVP and Normal matrices
-    glm::mat4 mvpMtx = projMtx * viewMtx * roofMtx;
-    glm::mat3 normalMtx = glm::transpose(glm::inverse(glm::mat3(roofMtx)));
-
     // Send matrices to shader
-    glUniformMatrix4fv(_mvpMatrixLocation, 1, GL_FALSE, glm::value_ptr(mvpMtx));
-    glUniformMatrix3fv(_normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMtx));
+    _pTransformRing->bindTransforms(roofMtx, projMtx * viewMtx);
 
     // Set material properties for roof (Light Pink)
     glm::vec3 ambient(0.4f, 0.3f, 0.3f);    // Increased ambient for lighter base
@@ -142,12 +129,8 @@ void Vehicle::_drawWheels(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projM
 
         wheelMtx = glm::scale(wheelMtx, glm::vec3(0.5f, 0.2f, 0.5f));
 
-        glm::mat4 mvpMtx = projMtx * viewMtx * wheelMtx;
-        glm::mat3 normalMtx = glm::transpose(glm::inverse(glm::mat3(wheelMtx)));
-
         // Send matrices to shader
-        glUniformMatrix4fv(_mvpMatrixLocation, 1, GL_FALSE, glm::value_ptr(mvpMtx));
-        glUniformMatrix3fv(_normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMtx));
+        _pTransformRing->bindTransforms(wheelMtx, projMtx * viewMtx);
 
         // Set material properties for wheels
         glm::vec3 ambient(0.2f, 0.2f, 0.2f);
@@ -0,0 +1,40 @@
+#include "VertexAttributes.h"
+
+#include <cstddef>
+
+void setVertexAttributes(VertexFormat format, GLint positionLocation, GLint normalLocation, GLint texCoordLocation) {
+    GLsizei stride = static_cast<GLsizei>(getVertexStride(format));
+    if(format == VertexFormat::FULL_FLOAT) {
+        if(positionLocation >= 0) {
+            glEnableVertexAttribArray(positionLocation);
+            glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(FullVertex, position));
+        }
+        if(normalLocation >= 0) {
+            glEnableVertexAttribArray(normalLocation);
+            glVertexAttribPointer(normalLocation, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(FullVertex, normal));
+        }
+        if(texCoordLocation >= 0) {
+            glEnableVertexAttribArray(texCoordLocation);
+            glVertexAttribPointer(texCoordLocation, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(FullVertex, texCoord));
+        }
+        return;
+    }
+
+    if(positionLocation >= 0) {
+        glEnableVertexAttribArray(positionLocation);
+        if(format == VertexFormat::COMPACT_SNORM16) {
+            glVertexAttribPointer(positionLocation, 3, GL_SHORT, GL_TRUE, stride, (void*)offsetof(CompactVertex, position));
+        } else {
+            glVertexAttribPointer(positionLocation, 3, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(CompactVertex, position));
+        }
+    }
+    // two components, the shader decodes the octahedral normal itself
+    if(normalLocation >= 0) {
+        glEnableVertexAttribArray(normalLocation);
+        glVertexAttribPointer(normalLocation, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(CompactVertex, normal));
+    }
+    if(texCoordLocation >= 0) {
+        glEnableVertexAttribArray(texCoordLocation);
+        glVertexAttribPointer(texCoordLocation, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(CompactVertex, texCoord));
+    }
+}
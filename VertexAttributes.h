@@ -0,0 +1,11 @@
+#ifndef VERTEX_ATTRIBUTES_H
+#define VERTEX_ATTRIBUTES_H
+
+#include <glad/gl.h>
+
+#include "VertexFormats.h"
+
+// points the attributes at the currently bound array buffer, a location of -1 is skipped
+void setVertexAttributes(VertexFormat format, GLint positionLocation, GLint normalLocation, GLint texCoordLocation);
+
+#endif // VERTEX_ATTRIBUTES_H
@@ -0,0 +1,155 @@
+#include "VertexFormats.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    uint32_t exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    // infinity and NaN keep a mantissa bit so NaN stays NaN
+    if(exponent == 0xFF) return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+
+    int halfExponent = static_cast<int>(exponent) - 127 + 15;
+    if(halfExponent >= 31) return sign | 0x7C00;
+    if(halfExponent <= 0) {
+        // denormal or zero, shift the implicit one in and round to nearest even
+        if(halfExponent < -10) return sign;
+        mantissa |= 0x800000;
+        uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t midpoint = 1u << (shift - 1);
+        if(remainder > midpoint || (remainder == midpoint && (half & 1))) half++;
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    // a carry out of the mantissa correctly bumps the exponent, up to infinity
+    if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) half++;
+    return sign | static_cast<uint16_t>(half);
+}
+
+float halfToFloat(uint16_t bits) {
+    uint32_t sign = static_cast<uint32_t>(bits & 0x8000) << 16;
+    uint32_t exponent = (bits >> 10) & 0x1F;
+    uint32_t mantissa = bits & 0x3FF;
+    uint32_t result;
+    if(exponent == 0x1F) {
+        result = sign | 0x7F800000 | (mantissa << 13);
+    } else if(exponent != 0) {
+        result = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    } else if(mantissa != 0) {
+        // renormalize the denormal
+        int shift = 0;
+        while(!(mantissa & 0x400)) {
+            mantissa <<= 1;
+            shift++;
+        }
+        result = sign | (static_cast<uint32_t>(127 - 15 + 1 - shift) << 23) | ((mantissa & 0x3FF) << 13);
+    } else {
+        result = sign;
+    }
+    float value;
+    memcpy(&value, &result, sizeof(value));
+    return value;
+}
+
+int16_t packSnorm16(float value) {
+    return static_cast<int16_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+}
+
+float unpackSnorm16(int16_t bits) {
+    // GL maps both -32768 and -32767 to -1
+    return std::max(bits / 32767.0f, -1.0f);
+}
+
+uint16_t packUnorm16(float value) {
+    return static_cast<uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+float unpackUnorm16(uint16_t bits) {
+    return bits / 65535.0f;
+}
+
+glm::vec2 octEncode(glm::vec3 normal) {
+    normal /= std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    glm::vec2 encoded(normal.x, normal.y);
+    if(normal.z < 0.0f) {
+        // fold the lower hemisphere over the diagonals
+        encoded.x = (1.0f - std::fabs(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f);
+        encoded.y = (1.0f - std::fabs(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return encoded;
+}
+
+glm::vec3 octDecode(glm::vec2 encoded) {
+    glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+    float fold = std::max(-normal.z, 0.0f);
+    normal.x += (normal.x >= 0.0f ? -fold : fold);
+    normal.y += (normal.y >= 0.0f ? -fold : fold);
+    return glm::normalize(normal);
+}
+
+CompactVertex packVertex(const FullVertex& vertex, VertexFormat format, float positionExtent) {
+    CompactVertex compact;
+    for(int i = 0; i < 3; ++i) {
+        if(format == VertexFormat::COMPACT_SNORM16) {
+            compact.position[i] = static_cast<uint16_t>(packSnorm16(vertex.position[i] / positionExtent));
+        } else {
+            compact.position[i] = floatToHalf(vertex.position[i]);
+        }
+    }
+    compact.position[3] = 0;
+
+    glm::vec2 normal = octEncode(vertex.normal);
+    compact.normal[0] = packSnorm16(normal.x);
+    compact.normal[1] = packSnorm16(normal.y);
+    compact.texCoord[0] = packUnorm16(vertex.texCoord.x);
+    compact.texCoord[1] = packUnorm16(vertex.texCoord.y);
+    return compact;
+}
+
+size_t getVertexStride(VertexFormat format) {
+    return format == VertexFormat::FULL_FLOAT ? sizeof(FullVertex) : sizeof(CompactVertex);
+}
+
+CompactInstance packInstance(glm::vec3 position, float yaw, float scale) {
+    const float TWO_PI = 6.28318530718f;
+    float turns = yaw / TWO_PI;
+    turns -= std::floor(turns);
+
+    CompactInstance instance;
+    instance.position = position;
+    // a full turn wraps back to 0
+    instance.yaw = static_cast<uint16_t>(std::lround(turns * 65536.0f) & 0xFFFF);
+    instance.scale = floatToHalf(scale);
+    return instance;
+}
+
+float getInstanceYaw(const CompactInstance& instance) {
+    return instance.yaw * (6.28318530718f / 65536.0f);
+}
+
+float getInstanceScale(const CompactInstance& instance) {
+    return halfToFloat(instance.scale);
+}
+
+glm::mat4 getInstanceMatrix(const CompactInstance& instance) {
+    glm::mat4 modelMtx = glm::translate(glm::mat4(1.0f), instance.position);
+    if(instance.yaw != 0) {
+        modelMtx = glm::rotate(modelMtx, getInstanceYaw(instance), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    float scale = getInstanceScale(instance);
+    if(scale != 1.0f) {
+        modelMtx = glm::scale(modelMtx, glm::vec3(scale));
+    }
+    return modelMtx;
+}
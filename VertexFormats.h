@@ -0,0 +1,65 @@
+#ifndef VERTEX_FORMATS_H
+#define VERTEX_FORMATS_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// Vertex layouts a mesh can be uploaded in.
+// FULL_FLOAT is the original 32 byte float position/normal/texcoord record.
+// The compact layouts are 16 bytes: half float or snorm16 positions,
+// an octahedral encoded normal in two snorm16 and unorm16 texture coordinates.
+// snorm16 positions are divided by the mesh extent when packed, fold that
+// extent back in with the model matrix.
+enum class VertexFormat {
+    FULL_FLOAT,
+    COMPACT_HALF,
+    COMPACT_SNORM16
+};
+
+struct FullVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+};
+
+struct CompactVertex {
+    uint16_t position[4];   // half float or snorm16 bits, the fourth is padding
+    int16_t normal[2];      // octahedral encoded, snorm16
+    uint16_t texCoord[2];   // unorm16
+};
+
+static_assert(sizeof(FullVertex) == 32, "full vertices must stay tightly packed");
+static_assert(sizeof(CompactVertex) == 16, "compact vertices must stay tightly packed");
+
+// Placement of an object that only translates, turns about +Y and scales
+// uniformly, 16 bytes instead of a model matrix per part.
+struct alignas(16) CompactInstance {
+    glm::vec3 position;
+    uint16_t yaw;           // unorm16 fraction of a full turn
+    uint16_t scale;         // half float
+};
+
+static_assert(sizeof(CompactInstance) == 16, "compact instances must stay tightly packed");
+
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t bits);
+int16_t packSnorm16(float value);
+float unpackSnorm16(int16_t bits);
+uint16_t packUnorm16(float value);
+float unpackUnorm16(uint16_t bits);
+
+// maps a unit vector onto the [-1,1] square, see octDecode
+glm::vec2 octEncode(glm::vec3 normal);
+glm::vec3 octDecode(glm::vec2 encoded);
+
+CompactVertex packVertex(const FullVertex& vertex, VertexFormat format, float positionExtent = 1.0f);
+size_t getVertexStride(VertexFormat format);
+
+CompactInstance packInstance(glm::vec3 position, float yaw = 0.0f, float scale = 1.0f);
+float getInstanceYaw(const CompactInstance& instance);
+float getInstanceScale(const CompactInstance& instance);
+glm::mat4 getInstanceMatrix(const CompactInstance& instance);
+
+#endif // VERTEX_FORMATS_H
@@ -0,0 +1,42 @@
+#include "WorldGenerator.h"
+
+#include <cstdlib>
+
+static float getRand() {
+    return static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+}
+
+void WorldGenerator::generate(float worldSize, float density, unsigned int seed,
+                              std::vector<CompactInstance>& trees, std::vector<CompactInstance>& lamps) {
+    srand(seed);
+
+    // Grid parameters
+    const float GRID_WIDTH = worldSize * 1.8f;
+    const float GRID_LENGTH = worldSize * 1.8f;
+    const float GRID_SPACING_WIDTH = 1.0f;
+    const float GRID_SPACING_LENGTH = 1.0f;
+
+    // Precomputed parameters based on above
+    const float LEFT_END_POINT = -GRID_WIDTH / 2.0f - 5.0f;
+    const float RIGHT_END_POINT = GRID_WIDTH / 2.0f + 5.0f;
+    const float BOTTOM_END_POINT = -GRID_LENGTH / 2.0f - 5.0f;
+    const float TOP_END_POINT = GRID_LENGTH / 2.0f + 5.0f;
+
+    // Generate Objects
+    for(int i = LEFT_END_POINT; i < RIGHT_END_POINT; i += GRID_SPACING_WIDTH) {
+        for(int j = BOTTOM_END_POINT; j < TOP_END_POINT; j += GRID_SPACING_LENGTH) {
+            // Don't just draw an object ANYWHERE.
+            if( i % 2 && j % 2 && getRand() < density ) {
+                // Place at spot
+                CompactInstance placement = packInstance(glm::vec3(i, 0.0f, j));
+
+                // Choose whether to make object a tree/lamppost
+                if (getRand() > 0.2) {
+                    trees.emplace_back(placement);
+                } else {
+                    lamps.emplace_back(placement);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef WORLD_GENERATOR_H
+#define WORLD_GENERATOR_H
+
+#include <vector>
+
+#include "VertexFormats.h"
+
+// Scatters trees and lamp posts over every other point of a one unit grid
+// a little wider than the island, each point taken with the given density.
+// Draws from rand() after srand(seed), as the engine always has, so the
+// seeds kept in journals and scene files still give the worlds they did.
+namespace WorldGenerator {
+    // appends to trees and lamps, four in five objects are trees
+    void generate(float worldSize, float density, unsigned int seed,
+                  std::vector<CompactInstance>& trees, std::vector<CompactInstance>& lamps);
+}
+
+#endif // WORLD_GENERATOR_H
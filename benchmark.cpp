@@ -0,0 +1,65 @@
+/*
+ *  Project: MP
+ *  File: benchmark.cpp
+ *
+ *  Description:
+ *      Replays scripted camera flythroughs across worlds of increasing
+ *      density and writes frame-time percentiles and histograms as JSON.
+ *      With --bandwidth it instead compares the compact vertex and
+ *      instance formats against the full float layouts, with --particles
+ *      it scales the particle count on the GPU and the CPU simulation,
+ *      with --flocking it scales the butterfly flock on one and all threads,
+ *      with --post it times the bloom and tone mapping passes at 1080p.
+ *
+ *  Usage: mp_bench [--bandwidth | --particles | --flocking | --post] [output.json]
+ *
+ */
+
+#include "MPEngine.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+int main(int argc, char* argv[]) {
+    bool bandwidth = false;
+    bool particles = false;
+    bool flocking = false;
+    bool postProcess = false;
+    const char* outputFilename = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--bandwidth") == 0) {
+            bandwidth = true;
+        } else if (strcmp(argv[i], "--particles") == 0) {
+            particles = true;
+        } else if (strcmp(argv[i], "--flocking") == 0) {
+            flocking = true;
+        } else if (strcmp(argv[i], "--post") == 0) {
+            postProcess = true;
+        } else {
+            outputFilename = argv[i];
+        }
+    }
+    if (outputFilename == nullptr) {
+        outputFilename = (bandwidth ? "bandwidth.json" : (particles ? "particles.json" : (flocking ? "flocking.json" : (postProcess ? "postprocess.json" : "benchmark.json"))));
+    }
+
+    auto mpEngine = new MPEngine();
+    mpEngine->initialize();
+    if (mpEngine->getError() == CSCI441::OpenGLEngine::OPENGL_ENGINE_ERROR_NO_ERROR) {
+        if (bandwidth) {
+            mpEngine->runBandwidthBenchmark(outputFilename);
+        } else if (particles) {
+            mpEngine->runParticleBenchmark(outputFilename);
+        } else if (flocking) {
+            mpEngine->runFlockBenchmark(outputFilename);
+        } else if (postProcess) {
+            mpEngine->runPostProcessBenchmark(outputFilename);
+        } else {
+            mpEngine->runBenchmark(outputFilename);
+        }
+    }
+    mpEngine->shutdown();
+    delete mpEngine;
+
+    return EXIT_SUCCESS;
+}
@@ -17,12 +17,176 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-int main() {
+int main(int argc, char* argv[]) {
+    // optional arguments:
+    //   --record <file>    journal all input of this session to file
+    //   --replay <file>    replay a recorded journal instead of live input
+    //   --headless         with --replay, simulate without opening a window
+    //   --load-scene <file> start from a saved scene instead of a random world
+    //   --save-scene <file> save the world and hero state on exit
+    //   --assert-no-alloc  fail on heap allocations in steady state frames
+    //                      (needs a build with MP_TRACK_ALLOCATIONS)
+    //   --vram-budget <MB> evict least recently used textures above this much GPU memory
+    //   --frame-budget <ms> scale the render resolution to hold this GPU frame time
+    //   --frame-pacing     sample input just before vsync instead of right after the swap
+    //   --agents <count>   number of autonomous vehicles and UFOs (default 200)
+    //   --cpu-particles    simulate particles on the CPU instead of with transform feedback
+    //   --no-post-process  draw the scene straight to the window, without bloom and tone mapping
+    //   --butterflies <count> number of ambient butterflies (default 2000)
+    //   --gl-stats <file>  count GL calls from the start and log them per frame to a CSV file
+    //   --quality <tier>   low, medium, high (default) or ultra
+    //   --quality-config <file> read quality settings from a file of key = value lines
+    //   --quality-set <key>=<value> set one quality setting, e.g. render_scale=0.75; it sticks
+    //                      through tier changes. The quality options apply in order.
+    //   --auto-quality <ms> at startup pick the highest tier whose frames take at most this long
+    const char* recordFilename = nullptr;
+    const char* replayFilename = nullptr;
+    const char* loadSceneFilename = nullptr;
+    const char* saveSceneFilename = nullptr;
+    const char* glStatsFilename = nullptr;
+    bool headless = false;
+    bool assertNoAlloc = false;
+    bool framePacing = false;
+    bool cpuParticles = false;
+    bool postProcess = true;
+    long vramBudgetMB = 0;
+    double frameBudgetMs = 0.0;
+    long agentCount = -1;
+    long swarmSize = -1;
+    QualitySettings quality;
+    double autoQualityMs = 0.0;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordFilename = argv[++i];
+        } else if(strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayFilename = argv[++i];
+        } else if(strcmp(argv[i], "--load-scene") == 0 && i + 1 < argc) {
+            loadSceneFilename = argv[++i];
+        } else if(strcmp(argv[i], "--save-scene") == 0 && i + 1 < argc) {
+            saveSceneFilename = argv[++i];
+        } else if(strcmp(argv[i], "--gl-stats") == 0 && i + 1 < argc) {
+            glStatsFilename = argv[++i];
+        } else if(strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if(strcmp(argv[i], "--vram-budget") == 0 && i + 1 < argc) {
+            vramBudgetMB = strtol(argv[++i], nullptr, 10);
+            if(vramBudgetMB <= 0) {
+                fprintf( stderr, "[ERROR]: --vram-budget expects a size in MB\n" );
+                return EXIT_FAILURE;
+            }
+        } else if(strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc) {
+            frameBudgetMs = strtod(argv[++i], nullptr);
+            if(frameBudgetMs <= 0.0) {
+                fprintf( stderr, "[ERROR]: --frame-budget expects a time in ms\n" );
+                return EXIT_FAILURE;
+            }
+        } else if(strcmp(argv[i], "--agents") == 0 && i + 1 < argc) {
+            agentCount = strtol(argv[++i], nullptr, 10);
+            if(agentCount < 0) {
+                fprintf( stderr, "[ERROR]: --agents expects a count\n" );
+                return EXIT_FAILURE;
+            }
+        } else if(strcmp(argv[i], "--butterflies") == 0 && i + 1 < argc) {
+            swarmSize = strtol(argv[++i], nullptr, 10);
+            if(swarmSize < 0) {
+                fprintf( stderr, "[ERROR]: --butterflies expects a count\n" );
+                return EXIT_FAILURE;
+            }
+        } else if(strcmp(argv[i], "--quality") == 0 && i + 1 < argc) {
+            if(!quality.set("tier", argv[++i])) return EXIT_FAILURE;
+        } else if(strcmp(argv[i], "--quality-config") == 0 && i + 1 < argc) {
+            if(!quality.loadConfig(argv[++i])) return EXIT_FAILURE;
+        } else if(strcmp(argv[i], "--quality-set") == 0 && i + 1 < argc) {
+            std::string option(argv[++i]);
+            size_t separator = option.find('=');
+            if(separator == std::string::npos) {
+                fprintf( stderr, "[ERROR]: --quality-set expects key=value\n" );
+                return EXIT_FAILURE;
+            }
+            if(!quality.set(option.substr(0, separator).c_str(), option.substr(separator + 1).c_str())) return EXIT_FAILURE;
+        } else if(strcmp(argv[i], "--auto-quality") == 0 && i + 1 < argc) {
+            autoQualityMs = strtod(argv[++i], nullptr);
+            if(autoQualityMs <= 0.0) {
+                fprintf( stderr, "[ERROR]: --auto-quality expects a time in ms\n" );
+                return EXIT_FAILURE;
+            }
+        } else if(strcmp(argv[i], "--cpu-particles") == 0) {
+            cpuParticles = true;
+        } else if(strcmp(argv[i], "--no-post-process") == 0) {
+            postProcess = false;
+        } else if(strcmp(argv[i], "--frame-pacing") == 0) {
+            framePacing = true;
+        } else if(strcmp(argv[i], "--assert-no-alloc") == 0) {
+            assertNoAlloc = true;
+        } else {
+            fprintf( stderr, "[ERROR]: unknown argument \"%s\"\n", argv[i] );
+            return EXIT_FAILURE;
+        }
+    }
+    if(headless && replayFilename == nullptr) {
+        fprintf( stderr, "[ERROR]: --headless needs --replay <file>\n" );
+        return EXIT_FAILURE;
+    }
 
     auto mpEngine = new MPEngine();
+    if(replayFilename != nullptr && !mpEngine->loadReplay(replayFilename)) {
+        delete mpEngine;
+        return EXIT_FAILURE;
+    }
+    if(loadSceneFilename != nullptr && !mpEngine->loadScene(loadSceneFilename)) {
+        delete mpEngine;
+        return EXIT_FAILURE;
+    }
+    if(recordFilename != nullptr) {
+        mpEngine->startRecording(recordFilename);
+    }
+    if(vramBudgetMB > 0) {
+        mpEngine->setVramBudget(static_cast<size_t>(vramBudgetMB) << 20);
+    }
+    if(frameBudgetMs > 0.0) {
+        mpEngine->setDynamicResolution(frameBudgetMs);
+    }
+    mpEngine->setQualitySettings(quality);
+    mpEngine->setFramePacing(framePacing);
+    mpEngine->setGpuParticles(!cpuParticles);
+    mpEngine->setPostProcessEnabled(postProcess);
+    if(agentCount >= 0) {
+        mpEngine->setAgentCount(static_cast<GLuint>(agentCount));
+    }
+    if(swarmSize >= 0) {
+        mpEngine->setSwarmSize(static_cast<GLuint>(swarmSize));
+    }
+    if(glStatsFilename != nullptr) {
+        mpEngine->setGLStatsLog(glStatsFilename);
+    }
+    if(assertNoAlloc) {
+        if(!AllocationTracker::isEnabled()) {
+            fprintf( stderr, "[ERROR]: --assert-no-alloc needs a build configured with -DMP_TRACK_ALLOCATIONS=ON\n" );
+            delete mpEngine;
+            return EXIT_FAILURE;
+        }
+        mpEngine->setAllocationAssert(true);
+    }
+
+    if(headless) {
+        bool replayed = mpEngine->runHeadless();
+        // the simulation state is all a scene holds, so it saves without a window too
+        if(replayed && saveSceneFilename != nullptr && !mpEngine->saveScene(saveSceneFilename)) {
+            replayed = false;
+        }
+        delete mpEngine;
+        return (replayed ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
     mpEngine->initialize();
     if (mpEngine->getError() == CSCI441::OpenGLEngine::OPENGL_ENGINE_ERROR_NO_ERROR) {
+        if(autoQualityMs > 0.0) {
+            mpEngine->selectQualityTier(autoQualityMs);
+        }
         mpEngine->run();
+        if(saveSceneFilename != nullptr) {
+            mpEngine->saveScene(saveSceneFilename);
+        }
     }
     mpEngine->shutdown();
     delete mpEngine;
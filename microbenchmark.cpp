@@ -0,0 +1,448 @@
+/*
+ *  Project: MP
+ *  File: microbenchmark.cpp
+ *
+ *  Description:
+ *      Times the core library on its own, without a window or GL context:
+ *      collision sweeps against growing obstacle counts, environment
+ *      generation for growing islands, hero updates in denser and denser
+ *      worlds, view/projection matrices for growing numbers of cameras and
+ *      scene query builds, raycasts and sphere casts for growing scenes, the
+ *      arcball camera's collision in denser and denser worlds, and sky
+ *      cubemaps of growing size projected into spherical harmonics.
+ *      Every case is run in batches sized to take about a millisecond and
+ *      reports nanoseconds per operation, to stdout and as JSON.
+ *
+ *  Usage: mp_microbench [--filter substring] [output.json]
+ *
+ */
+
+#include "ArcballCamera.h"
+#include "CameraCollision.h"
+#include "CollisionWorld.h"
+#include "FPCamera.h"
+#include "FrameStats.h"
+#include "HeroMovement.h"
+#include "SceneQuery.h"
+#include "SphericalHarmonics.h"
+#include "WorldGenerator.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+    typedef std::chrono::high_resolution_clock Clock;
+
+    // the island and obstacle radii the engine uses
+    constexpr float WORLD_SIZE = 55.0f;
+    constexpr float TREE_TRUNK_RADIUS = 1.0f;
+    constexpr float LAMP_POST_RADIUS = 0.2f;
+    constexpr float HERO_RADIUS = 1.0f;
+    constexpr unsigned int WORLD_SEED = 1;
+
+    // results land here so the timed work cannot be optimized away
+    volatile float sink;
+
+    class Runner {
+    public:
+        Runner(FILE* fp, const char* filter) : _fp(fp), _filter(filter), _firstRun(true) {}
+
+        bool wants(const char* name) const { return _filter == nullptr || strstr(name, _filter) != nullptr; }
+
+        // times op, which returns something to keep alive, as one operation at the given scale;
+        // an operation that handles several items, such as a batch of rays, also reports items per second
+        template<typename Op>
+        void run(const char* name, double scale, Op op, size_t itemsPerOp = 1) {
+            if(!wants(name)) return;
+
+            // double the batch until it is long enough to time
+            size_t iterations = 1;
+            while(_timeBatch(op, iterations) < TARGET_BATCH_MS && iterations < MAX_ITERATIONS) {
+                iterations *= 2;
+            }
+
+            for(int batch = 0; batch < WARMUP_BATCHES; ++batch) {
+                _timeBatch(op, iterations);
+            }
+            std::vector<double> nsPerOp;
+            for(int batch = 0; batch < BATCHES; ++batch) {
+                nsPerOp.push_back(_timeBatch(op, iterations) * 1e6 / static_cast<double>(iterations));
+            }
+
+            FrameStats::Summary summary = FrameStats::summarize(nsPerOp);
+            double itemsPerSecond = 1e9 * itemsPerOp / summary.p50;
+            if(itemsPerOp > 1) {
+                fprintf( stdout, "[INFO]: %-24s %10g %12.1f ns/op  (p95 %.1f, %zu x %d)  %.2f M items/s\n",
+                         name, scale, summary.p50, summary.p95, iterations, BATCHES, itemsPerSecond / 1e6 );
+            } else {
+                fprintf( stdout, "[INFO]: %-24s %10g %12.1f ns/op  (p95 %.1f, %zu x %d)\n",
+                         name, scale, summary.p50, summary.p95, iterations, BATCHES );
+            }
+
+            fprintf(_fp, "%s\n    {\n", (_firstRun ? "" : ","));
+            fprintf(_fp, "      \"name\": \"%s\",\n", name);
+            fprintf(_fp, "      \"scale\": %g,\n", scale);
+            fprintf(_fp, "      \"iterations\": %zu,\n", iterations);
+            fprintf(_fp, "      \"batches\": %d,\n", BATCHES);
+            fprintf(_fp, "      \"nsPerOp\": {\"mean\": %.2f, \"min\": %.2f, \"p50\": %.2f, \"p95\": %.2f, \"p99\": %.2f, \"max\": %.2f},\n",
+                    summary.mean, summary.min, summary.p50, summary.p95, summary.p99, summary.max);
+            fprintf(_fp, "      \"opsPerSecond\": %.1f,\n", 1e9 / summary.p50);
+            fprintf(_fp, "      \"itemsPerOp\": %zu,\n", itemsPerOp);
+            fprintf(_fp, "      \"itemsPerSecond\": %.1f\n", itemsPerSecond);
+            fprintf(_fp, "    }");
+            _firstRun = false;
+        }
+
+    private:
+        static constexpr double TARGET_BATCH_MS = 1.0;
+        static constexpr size_t MAX_ITERATIONS = 1 << 24;
+        static constexpr int WARMUP_BATCHES = 3;
+        static constexpr int BATCHES = 30;
+
+        FILE* _fp;
+        const char* _filter;
+        bool _firstRun;
+
+        template<typename Op>
+        static double _timeBatch(Op& op, size_t iterations) {
+            float result = 0.0f;
+            auto start = Clock::now();
+            for(size_t i = 0; i < iterations; ++i) {
+                result += op();
+            }
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            sink = result;
+            return ms;
+        }
+    };
+
+    // one sweep of a body against obstacles scattered at a constant density over a growing world
+    void benchmarkCollision(Runner& runner) {
+        const char* name = "collision/moveBody";
+        if(!runner.wants(name)) return;
+
+        const unsigned int OBSTACLE_COUNTS[] = {1000, 10000, 100000};
+        const size_t NUM_QUERIES = 4096;
+        for(unsigned int numObstacles : OBSTACLE_COUNTS) {
+            float worldSize = 1.5f * std::sqrt(static_cast<float>(numObstacles));
+            std::mt19937 generator(numObstacles);
+            std::uniform_real_distribution<float> coordinate(-worldSize, worldSize);
+            std::uniform_real_distribution<float> radius(LAMP_POST_RADIUS, TREE_TRUNK_RADIUS);
+            std::uniform_real_distribution<float> angle(0.0f, 6.28318530718f);
+
+            CollisionWorld world(worldSize);
+            for(unsigned int i = 0; i < numObstacles; ++i) {
+                world.addStaticCircle(glm::vec2(coordinate(generator), coordinate(generator)), radius(generator));
+            }
+            CollisionWorld::BodyId body = world.addBody(glm::vec2(0.0f), HERO_RADIUS);
+
+            // a random walk, so every query starts where a real move could have ended
+            std::vector<glm::vec2> starts, targets;
+            glm::vec2 position(0.0f);
+            for(size_t i = 0; i < NUM_QUERIES; ++i) {
+                float direction = angle(generator);
+                glm::vec2 target = position + glm::vec2(std::sin(direction), std::cos(direction));
+                target = glm::clamp(target, glm::vec2(-worldSize), glm::vec2(worldSize));
+                starts.push_back(position);
+                targets.push_back(target);
+                position = world.moveBody(body, target);
+            }
+
+            size_t query = 0;
+            runner.run(name, numObstacles, [&]() {
+                world.setBodyPosition(body, starts[query]);
+                glm::vec2 resolved = world.moveBody(body, targets[query]);
+                query = (query + 1) % NUM_QUERIES;
+                return resolved.x;
+            });
+        }
+    }
+
+    // the engine's environment density on growing islands
+    void benchmarkEnvironment(Runner& runner) {
+        const char* name = "environment/generate";
+        if(!runner.wants(name)) return;
+
+        const float WORLD_SIZES[] = {55.0f, 110.0f, 220.0f, 440.0f};
+        const float DENSITY = 0.02f;
+        std::vector<CompactInstance> trees, lamps;
+        for(float worldSize : WORLD_SIZES) {
+            runner.run(name, worldSize, [&]() {
+                trees.clear();
+                lamps.clear();
+                WorldGenerator::generate(worldSize, DENSITY, WORLD_SEED, trees, lamps);
+                return static_cast<float>(trees.size() + lamps.size());
+            });
+        }
+    }
+
+    // one step and turn of a hero, resolved against the island generated at each density
+    void benchmarkHeroUpdate(Runner& runner) {
+        const char* name = "hero/update";
+        if(!runner.wants(name)) return;
+
+        const float DENSITIES[] = {0.02f, 0.1f, 0.5f, 1.0f};
+        for(float density : DENSITIES) {
+            std::vector<CompactInstance> trees, lamps;
+            WorldGenerator::generate(WORLD_SIZE, density, WORLD_SEED, trees, lamps);
+
+            CollisionWorld world(WORLD_SIZE);
+            for(const CompactInstance& tree : trees) {
+                world.addStaticCircle(glm::vec2(tree.position.x, tree.position.z), TREE_TRUNK_RADIUS);
+            }
+            for(const CompactInstance& lamp : lamps) {
+                world.addStaticCircle(glm::vec2(lamp.position.x, lamp.position.z), LAMP_POST_RADIUS);
+            }
+            CollisionWorld::BodyId body = world.addBody(glm::vec2(0.0f), HERO_RADIUS);
+
+            glm::vec3 position(0.0f);
+            float heading = 0.0f;
+            unsigned int step = 0;
+            runner.run(name, density, [&]() {
+                // drive in wide circles, alternating direction
+                heading = HeroMovement::turn(heading, (step++ / 256) % 2 == 0);
+                glm::vec3 target = HeroMovement::step(position, heading, true);
+                position = HeroMovement::resolve(world, body, WORLD_SIZE, position, target);
+                return position.x;
+            });
+        }
+    }
+
+    // the boxes MPEngine::_rebuildSceneQuery() gives trees and lamps
+    void addSceneryBoxes(SceneQuery& sceneQuery, const std::vector<CompactInstance>& trees, const std::vector<CompactInstance>& lamps) {
+        for(uint32_t i = 0; i < trees.size(); ++i) {
+            glm::vec3 position = trees[i].position;
+            sceneQuery.addStaticBox(SceneQuery::ObjectType::TREE, i, position + glm::vec3(-1.0f, 0.0f, -1.0f), position + glm::vec3(1.0f, 5.0f, 1.0f));
+            sceneQuery.addStaticBox(SceneQuery::ObjectType::TREE, i, position + glm::vec3(-3.0f, 5.0f, -3.0f), position + glm::vec3(3.0f, 13.0f, 3.0f));
+        }
+        for(uint32_t i = 0; i < lamps.size(); ++i) {
+            glm::vec3 position = lamps[i].position;
+            sceneQuery.addStaticBox(SceneQuery::ObjectType::LAMP, i, position + glm::vec3(-0.5f, 0.0f, -0.5f), position + glm::vec3(0.5f, 7.5f, 0.5f));
+        }
+    }
+
+    // hierarchy builds and casts of batches of rays from eye height over growing islands,
+    // reported in rays per second
+    void benchmarkSceneQuery(Runner& runner) {
+        const char* NAMES[] = {"scenequery/build", "scenequery/raycast", "scenequery/raycastBatch", "scenequery/sphereCast"};
+        if(std::none_of(std::begin(NAMES), std::end(NAMES), [&](const char* name) { return runner.wants(name); })) return;
+
+        const float WORLD_SIZES[] = {55.0f, 110.0f, 220.0f, 440.0f};
+        const float DENSITY = 0.1f;
+        const size_t NUM_RAYS = 1024;
+        const float MAX_DISTANCE = 100.0f;
+        const float SPHERE_RADIUS = 0.5f;
+        for(float worldSize : WORLD_SIZES) {
+            std::vector<CompactInstance> trees, lamps;
+            WorldGenerator::generate(worldSize, DENSITY, WORLD_SEED, trees, lamps);
+
+            SceneQuery sceneQuery;
+            addSceneryBoxes(sceneQuery, trees, lamps);
+            sceneQuery.buildStatic();
+            double numBoxes = static_cast<double>(sceneQuery.getNumStaticBoxes());
+
+            runner.run(NAMES[0], numBoxes, [&]() {
+                sceneQuery.clear();
+                addSceneryBoxes(sceneQuery, trees, lamps);
+                sceneQuery.buildStatic();
+                return static_cast<float>(sceneQuery.getNumStaticNodes());
+            });
+
+            // pixels of a few 45 degree views from eye height, row by row, as picks and camera probes cast them
+            std::mt19937 generator(static_cast<unsigned int>(worldSize));
+            std::uniform_real_distribution<float> coordinate(-worldSize, worldSize);
+            std::uniform_real_distribution<float> height(1.0f, 10.0f);
+            std::uniform_real_distribution<float> angle(0.0f, 6.28318530718f);
+            const int VIEW_SIZE = 16;
+            const float HALF_FIELD = std::tan(glm::radians(22.5f));
+            std::vector<SceneQuery::Ray> rays;
+            while(rays.size() < NUM_RAYS) {
+                glm::vec3 eye(coordinate(generator), height(generator), coordinate(generator));
+                float yaw = angle(generator);
+                glm::vec3 forward(std::sin(yaw), 0.0f, std::cos(yaw));
+                glm::vec3 right(-std::cos(yaw), 0.0f, std::sin(yaw));
+                for(int y = 0; y < VIEW_SIZE; ++y) {
+                    for(int x = 0; x < VIEW_SIZE; ++x) {
+                        float u = HALF_FIELD * (2.0f * (x + 0.5f) / VIEW_SIZE - 1.0f);
+                        float v = HALF_FIELD * (1.0f - 2.0f * (y + 0.5f) / VIEW_SIZE);
+                        glm::vec3 direction = glm::normalize(forward + right * u + glm::vec3(0.0f, v, 0.0f));
+                        rays.push_back({eye, direction, MAX_DISTANCE});
+                    }
+                }
+            }
+            std::vector<SceneQuery::Hit> hits(NUM_RAYS);
+
+            runner.run(NAMES[1], numBoxes, [&]() {
+                float result = 0.0f;
+                for(size_t i = 0; i < NUM_RAYS; ++i) {
+                    sceneQuery.raycast(rays[i], hits[i]);
+                    result += hits[i].distance;
+                }
+                return result;
+            }, NUM_RAYS);
+
+            runner.run(NAMES[2], numBoxes, [&]() {
+                return static_cast<float>(sceneQuery.raycastBatch(rays.data(), NUM_RAYS, hits.data()));
+            }, NUM_RAYS);
+
+            runner.run(NAMES[3], numBoxes, [&]() {
+                float result = 0.0f;
+                for(const SceneQuery::Ray& ray : rays) {
+                    SceneQuery::Hit hit;
+                    sceneQuery.sphereCast(ray.origin, ray.origin + ray.direction * ray.maxDistance, SPHERE_RADIUS, hit);
+                    result += hit.distance;
+                }
+                return result;
+            }, NUM_RAYS);
+        }
+    }
+
+    // a tick of the arcball camera orbiting a hero that drives through the island generated at each density:
+    // the collision cast, the pulled in eye and its view matrix
+    void benchmarkCameraCollision(Runner& runner) {
+        const char* name = "camera/collision";
+        if(!runner.wants(name)) return;
+
+        const float DENSITIES[] = {0.02f, 0.1f, 0.5f, 1.0f};
+        for(float density : DENSITIES) {
+            std::vector<CompactInstance> trees, lamps;
+            WorldGenerator::generate(WORLD_SIZE, density, WORLD_SEED, trees, lamps);
+            SceneQuery sceneQuery;
+            addSceneryBoxes(sceneQuery, trees, lamps);
+            sceneQuery.buildStatic();
+
+            CollisionWorld world(WORLD_SIZE);
+            for(const CompactInstance& tree : trees) {
+                world.addStaticCircle(glm::vec2(tree.position.x, tree.position.z), TREE_TRUNK_RADIUS);
+            }
+            for(const CompactInstance& lamp : lamps) {
+                world.addStaticCircle(glm::vec2(lamp.position.x, lamp.position.z), LAMP_POST_RADIUS);
+            }
+            CollisionWorld::BodyId body = world.addBody(glm::vec2(0.0f), HERO_RADIUS);
+
+            ArcballCamera camera;
+            CameraCollision collision;
+            glm::vec3 position(0.0f);
+            float heading = 0.0f;
+            unsigned int step = 0;
+            runner.run(name, density, [&]() {
+                heading = HeroMovement::turn(heading, (step++ / 256) % 2 == 0);
+                position = HeroMovement::resolve(world, body, WORLD_SIZE, position, HeroMovement::step(position, heading, true));
+                camera.setTarget(position);
+                camera.rotate(0.01f, 0.0f);
+                camera.setDistanceLimit(collision.update(sceneQuery, camera.getTarget(), camera.getDesiredPosition()));
+                return camera.getViewMatrix()[3][2];
+            });
+        }
+    }
+
+    // projection of a sky cubemap into spherical harmonics on every core and on one, for growing faces
+    void benchmarkSkyProjection(Runner& runner) {
+        const char* NAMES[] = {"lighting/projectSky", "lighting/projectSkyOneThread"};
+        const unsigned int NUM_THREADS[] = {0, 1};
+        if(std::none_of(std::begin(NAMES), std::end(NAMES), [&](const char* name) { return runner.wants(name); })) return;
+
+        const int FACE_SIZES[] = {64, 128, 256, 512};
+        for(int faceSize : FACE_SIZES) {
+            std::mt19937 generator(faceSize);
+            std::uniform_int_distribution<int> channel(0, 255);
+            std::vector<unsigned char> pixels(static_cast<size_t>(faceSize) * faceSize * 3 * SphericalHarmonics::NUM_FACES);
+            for(unsigned char& value : pixels) value = static_cast<unsigned char>(channel(generator));
+            SphericalHarmonics::CubemapFace faces[SphericalHarmonics::NUM_FACES];
+            for(int face = 0; face < SphericalHarmonics::NUM_FACES; ++face) {
+                faces[face] = {pixels.data() + static_cast<size_t>(face) * faceSize * faceSize * 3, faceSize, faceSize, 3};
+            }
+
+            for(int i = 0; i < 2; ++i) {
+                runner.run(NAMES[i], faceSize, [&]() {
+                    return SphericalHarmonics::project(faces, NUM_THREADS[i])[0].x;
+                }, static_cast<size_t>(faceSize) * faceSize * SphericalHarmonics::NUM_FACES);
+            }
+        }
+    }
+
+    // view and projection matrices of a growing number of cameras, as recomputed every frame
+    void benchmarkCameras(Runner& runner) {
+        const unsigned int CAMERA_COUNTS[] = {1, 64, 4096};
+        const float ASPECT_RATIO = 16.0f / 9.0f;
+        const float FAR_PLANE = 100.0f;
+
+        if(runner.wants("camera/arcball")) {
+            for(unsigned int numCameras : CAMERA_COUNTS) {
+                std::vector<ArcballCamera> cameras(numCameras);
+                for(unsigned int i = 0; i < numCameras; ++i) {
+                    cameras[i].setTarget(glm::vec3(static_cast<float>(i % 64), 0.0f, static_cast<float>(i / 64)));
+                }
+                runner.run("camera/arcball", numCameras, [&]() {
+                    float result = 0.0f;
+                    for(ArcballCamera& camera : cameras) {
+                        camera.rotate(0.01f, 0.0f);
+                        glm::mat4 projectionMtx = glm::perspective(glm::radians(45.0f), ASPECT_RATIO, 0.1f, FAR_PLANE);
+                        glm::mat4 viewProjectionMtx = projectionMtx * camera.getViewMatrix();
+                        result += viewProjectionMtx[3][2];
+                    }
+                    return result;
+                });
+            }
+        }
+
+        if(runner.wants("camera/firstPerson")) {
+            for(unsigned int numCameras : CAMERA_COUNTS) {
+                std::vector<FPCamera> cameras(numCameras);
+                float heading = 0.0f;
+                runner.run("camera/firstPerson", numCameras, [&]() {
+                    float result = 0.0f;
+                    heading = HeroMovement::turn(heading, true);
+                    for(unsigned int i = 0; i < numCameras; ++i) {
+                        cameras[i].updatePositionAndOrientation(glm::vec3(static_cast<float>(i), 0.0f, 0.0f), heading);
+                        glm::mat4 projectionMtx = glm::perspective(glm::radians(45.0f), ASPECT_RATIO, 0.1f, FAR_PLANE);
+                        glm::mat4 viewProjectionMtx = projectionMtx * cameras[i].getViewMatrix();
+                        result += viewProjectionMtx[3][2];
+                    }
+                    return result;
+                });
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* filter = nullptr;
+    const char* outputFilename = "microbench.json";
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            outputFilename = argv[i];
+        }
+    }
+
+    FILE* fp = fopen(outputFilename, "w");
+    if (!fp) {
+        fprintf( stderr, "[ERROR]: Could not open benchmark output \"%s\"\n", outputFilename );
+        return EXIT_FAILURE;
+    }
+
+    fprintf(fp, "{\n  \"benchmark\": \"microbench\",\n  \"runs\": [");
+    Runner runner(fp, filter);
+    benchmarkCollision(runner);
+    benchmarkEnvironment(runner);
+    benchmarkHeroUpdate(runner);
+    benchmarkCameras(runner);
+    benchmarkSceneQuery(runner);
+    benchmarkCameraCollision(runner);
+    benchmarkSkyProjection(runner);
+    fprintf(fp, "\n  ]\n}\n");
+    fclose(fp);
+
+    fprintf( stdout, "[INFO]: benchmark results written to %s\n", outputFilename );
+    return EXIT_SUCCESS;
+}
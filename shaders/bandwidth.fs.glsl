@@ -0,0 +1,10 @@
+#version 410 core
+
+in vec3 Normal;
+in vec2 TexCoords;
+out vec4 fragColorOut;
+
+void main() {
+    // uses every attribute so none of them is optimized out of the fetch
+    fragColorOut = vec4(Normal * 0.5 + 0.5, 1.0) * vec4(TexCoords, 1.0, 1.0);
+}
@@ -0,0 +1,25 @@
+#version 410 core
+
+layout(location = 0) in vec3 vPos;          // Vertex position
+layout(location = 1) in vec3 vNormal;       // Vertex normal, xy octahedral encoded for the compact formats
+layout(location = 2) in vec2 textureCoords; // Vertex texture coordinates
+
+uniform mat4 mvpMatrix;
+uniform int octahedralNormals;
+
+// Outputs to Fragment Shader
+out vec3 Normal;
+out vec2 TexCoords;
+
+vec3 octDecode(vec2 encoded) {
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-normal.z, 0.0);
+    normal.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(normal.xy, vec2(0.0)));
+    return normalize(normal);
+}
+
+void main() {
+    Normal = (octahedralNormals != 0 ? octDecode(vNormal.xy) : vNormal);
+    TexCoords = textureCoords;
+    gl_Position = mvpMatrix * vec4(vPos, 1.0);
+}
@@ -0,0 +1,35 @@
+#version 410 core
+
+// One level down the bloom pyramid: four bilinear taps, each the average of
+// 2x2 source texels, cover the 4x4 texels under a destination texel.
+// The first level also keeps only what is brighter than the threshold.
+
+in vec2 texCoord;
+
+uniform sampler2D source;
+uniform vec2 sourceScale; // texCoord to the used corner of the source, see PostProcess.cpp
+uniform vec2 sourceMax;   // center of the last used texel
+uniform vec2 texelSize;   // of the source
+uniform float threshold;  // 0 keeps everything
+uniform float knee;       // below the threshold, colors fade in over this much
+
+out vec4 fragColorOut;
+
+vec3 tap(vec2 uv) {
+    return texture(source, min(uv, sourceMax)).rgb;
+}
+
+void main() {
+    vec2 uv = texCoord * sourceScale;
+    vec3 color = 0.25 * (tap(uv + vec2(-texelSize.x, -texelSize.y)) + tap(uv + vec2(texelSize.x, -texelSize.y))
+                       + tap(uv + vec2(-texelSize.x,  texelSize.y)) + tap(uv + vec2(texelSize.x,  texelSize.y)));
+
+    if(threshold > 0.0) {
+        // quadratic soft knee, so colors just under the threshold do not pop in
+        float brightness = max(color.r, max(color.g, color.b));
+        float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+        soft = soft * soft / (4.0 * knee + 0.0001);
+        color *= max(soft, brightness - threshold) / max(brightness, 0.0001);
+    }
+    fragColorOut = vec4(color, 1.0);
+}
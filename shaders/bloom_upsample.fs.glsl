@@ -0,0 +1,27 @@
+#version 410 core
+
+// One level up the bloom pyramid: a 3x3 tent filter over the smaller level,
+// added onto the larger one by blending.
+
+in vec2 texCoord;
+
+uniform sampler2D source;
+uniform vec2 sourceScale; // texCoord to the used corner of the source, see PostProcess.cpp
+uniform vec2 sourceMax;   // center of the last used texel
+uniform vec2 texelSize;   // of the source
+
+out vec4 fragColorOut;
+
+vec3 tap(vec2 uv) {
+    return texture(source, min(uv, sourceMax)).rgb;
+}
+
+void main() {
+    vec2 uv = texCoord * sourceScale;
+    vec2 dx = vec2(texelSize.x, 0.0);
+    vec2 dy = vec2(0.0, texelSize.y);
+    vec3 color = 4.0 * tap(uv)
+               + 2.0 * (tap(uv - dx) + tap(uv + dx) + tap(uv - dy) + tap(uv + dy))
+               + tap(uv - dx - dy) + tap(uv + dx - dy) + tap(uv - dx + dy) + tap(uv + dx + dy);
+    fragColorOut = vec4(color / 16.0, 1.0);
+}
@@ -0,0 +1,147 @@
+#version 410 core
+
+// lighting.vs.glsl for ButterflySwarm: the wings come out of the vertex animation
+// texture, the butterfly is placed by its instance and the diffuse color is per vertex
+
+layout(location = 0) in vec3 wingColor;              // Diffuse color of the wing
+layout(location = 1) in vec4 instancePositionHeading; // Butterfly position and heading
+layout(location = 2) in float instancePhase;          // Point in the flap cycle, 0 to 1
+
+// Rows 0 to NUM_FRAMES - 1 hold positions, the next NUM_FRAMES rows normals, one column per vertex
+#define NUM_FRAMES 40 // ButterflySwarm::NUM_FRAMES
+uniform sampler2D animationTexture;
+
+// Uniforms
+uniform mat4 viewProjection;
+uniform vec3 viewPos; // Camera position
+
+// Material properties
+struct Material {
+    vec3 ambient;
+    vec3 diffuse; // unused, the wings carry their own
+    vec3 specular;
+    float shininess;
+};
+uniform Material material;
+
+// Directional Light properties
+struct DirectionalLight {
+    vec3 direction;
+    vec3 color;
+};
+uniform DirectionalLight dirLight;
+
+// Point Light properties
+#define MAX_POINT_LIGHTS 10 // QualitySettings::MAX_POINT_LIGHTS
+uniform int numPointLights;
+uniform vec3 pointLightPositions[MAX_POINT_LIGHTS];
+uniform vec3 pointLightColors[MAX_POINT_LIGHTS];
+uniform float pointLightConstants[MAX_POINT_LIGHTS];
+uniform float pointLightLinears[MAX_POINT_LIGHTS];
+uniform float pointLightQuadratics[MAX_POINT_LIGHTS];
+
+// Spot Light properties
+uniform vec3 spotLightPosition;
+uniform vec3 spotLightDirection;
+uniform vec3 spotLightColor;
+uniform float spotLightWidth;
+
+// Sky ambient light, 2nd order spherical harmonics, see SphericalHarmonics.h
+uniform vec3 skyAmbient[9];
+
+vec3 skyAmbientAt(vec3 n) {
+    return skyAmbient[0]
+         + skyAmbient[1] * n.y + skyAmbient[2] * n.z + skyAmbient[3] * n.x
+         + skyAmbient[4] * (n.x * n.y) + skyAmbient[5] * (n.y * n.z) + skyAmbient[6] * (3.0 * n.z * n.z - 1.0)
+         + skyAmbient[7] * (n.x * n.z) + skyAmbient[8] * (n.x * n.x - n.y * n.y);
+}
+
+// Outputs to Fragment Shader
+out vec3 vertexColor;
+
+void main() {
+    // Blend the two baked frames around the phase
+    float frame = fract(instancePhase) * NUM_FRAMES;
+    int frame0 = int(frame) % NUM_FRAMES;
+    int frame1 = (frame0 + 1) % NUM_FRAMES;
+    float blend = fract(frame);
+    vec3 localPos = mix(texelFetch(animationTexture, ivec2(gl_VertexID, frame0), 0).xyz,
+                        texelFetch(animationTexture, ivec2(gl_VertexID, frame1), 0).xyz, blend);
+    vec3 localNormal = mix(texelFetch(animationTexture, ivec2(gl_VertexID, NUM_FRAMES + frame0), 0).xyz,
+                           texelFetch(animationTexture, ivec2(gl_VertexID, NUM_FRAMES + frame1), 0).xyz, blend);
+
+    // Turn about Y by the heading, then move to the instance's position
+    float c = cos(instancePositionHeading.w);
+    float s = sin(instancePositionHeading.w);
+    mat3 headingMatrix = mat3(c, 0.0, -s,  0.0, 1.0, 0.0,  s, 0.0, c);
+    vec3 worldPos = instancePositionHeading.xyz + headingMatrix * localPos;
+    vec3 normal = normalize(headingMatrix * localNormal);
+
+    // Transformations
+    gl_Position = viewProjection * vec4(worldPos, 1.0);
+    vec3 viewDir = normalize(viewPos - worldPos);
+
+    // Initialize color
+    vertexColor = vec3(0.0);
+
+    // Directional Light
+    {
+        vec3 lightDir = normalize(-dirLight.direction);
+        float diff = max(dot(normal, lightDir), 0.0);
+        vec3 reflectDir = reflect(-lightDir, normal);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+
+        // ambient light comes from the sky around, not the sun
+        vec3 ambient = material.ambient * skyAmbientAt(normal);
+        vec3 diffuse = wingColor * diff * dirLight.color;
+        vec3 specular = material.specular * spec * dirLight.color;
+
+        vertexColor += ambient + diffuse + specular;
+    }
+
+    // Point Lights
+    for(int i = 0; i < numPointLights; i++) {
+        vec3 lightPos = pointLightPositions[i];
+        vec3 lightColor = pointLightColors[i];
+
+        vec3 lightDir = normalize(lightPos - worldPos);
+        float diff = max(dot(normal, lightDir), 0.0);
+        vec3 reflectDir = reflect(-lightDir, normal);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+
+        float distance = length(lightPos - worldPos);
+        float attenuation = 1.0 / (pointLightConstants[i] + pointLightLinears[i] * distance + pointLightQuadratics[i] * (distance * distance));
+
+        vec3 ambient = material.ambient * lightColor;
+        vec3 diffuse = wingColor * diff * lightColor;
+        vec3 specular = material.specular * spec * lightColor;
+
+        ambient *= attenuation;
+        diffuse *= attenuation;
+        specular *= attenuation;
+
+        vertexColor += ambient + diffuse + specular;
+    }
+
+    // Spot Light
+    {
+        float linear = 0.09f;
+        float quadratic = 0.032f;
+
+        vec3 lightDir = normalize(spotLightPosition - worldPos);
+        float diff = max(dot(normal, lightDir), 0.0);
+
+        vec3 reflectDir = reflect(-lightDir, normal);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), 5);
+
+        if( dot(lightDir, normalize(-spotLightDirection)) > spotLightWidth ){
+            float dist = length(spotLightPosition - worldPos);
+            float attenuation = 1.0 / (1.0 + (linear * dist) + (quadratic * (dist * dist)));
+
+            vec3 ambient = material.ambient * spotLightColor * attenuation;
+            vec3 diffuse = wingColor * diff * spotLightColor * attenuation;
+            vec3 specular = material.specular * spec * spotLightColor * attenuation;
+            vertexColor += ambient + diffuse + specular;
+        }
+    }
+}
@@ -3,10 +3,14 @@
 layout(location = 0) in vec3 vPos;        // Vertex position
 layout(location = 1) in vec3 vNormal;     // Vertex normal
 
+// Per-draw transforms, streamed through TransformRing
+layout(std140) uniform DrawTransform {
+    mat4 mvpMatrix;
+    mat4 modelMatrix;
+    mat3 normalMatrix;
+};
+
 // Uniforms
-uniform mat4 mvpMatrix;
-uniform mat3 normalMatrix;
-uniform mat4 modelMatrix;
 uniform vec3 viewPos; // Camera position
 
 // Material properties
@@ -26,7 +30,7 @@ struct DirectionalLight {
 uniform DirectionalLight dirLight;
 
 // Point Light properties
-#define MAX_POINT_LIGHTS 10
+#define MAX_POINT_LIGHTS 10 // QualitySettings::MAX_POINT_LIGHTS
 uniform int numPointLights;
 uniform vec3 pointLightPositions[MAX_POINT_LIGHTS];
 uniform vec3 pointLightColors[MAX_POINT_LIGHTS];
@@ -40,6 +44,19 @@ uniform vec3 spotLightDirection;
 uniform vec3 spotLightColor;
 uniform float spotLightWidth;
 
+// Sky ambient light, 2nd order spherical harmonics, see SphericalHarmonics.h
+uniform vec3 skyAmbient[9];
+
+vec3 skyAmbientAt(vec3 n) {
+    return skyAmbient[0]
+         + skyAmbient[1] * n.y + skyAmbient[2] * n.z + skyAmbient[3] * n.x
+         + skyAmbient[4] * (n.x * n.y) + skyAmbient[5] * (n.y * n.z) + skyAmbient[6] * (3.0 * n.z * n.z - 1.0)
+         + skyAmbient[7] * (n.x * n.z) + skyAmbient[8] * (n.x * n.x - n.y * n.y);
+}
+
+// Light the surface gives off itself, above 1 it blooms
+uniform vec3 emission;
+
 // Outputs to Fragment Shader
 out vec3 vertexColor;
 
@@ -51,7 +68,7 @@ void main() {
     vec3 viewDir = normalize(viewPos - worldPos);
 
     // Initialize color
-    vertexColor = vec3(0.0);
+    vertexColor = emission;
 
     // Directional Light
     {
@@ -60,7 +77,8 @@ void main() {
         vec3 reflectDir = reflect(-lightDir, normal);
         float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
 
-        vec3 ambient = material.ambient * dirLight.color;
+        // ambient light comes from the sky around, not the sun
+        vec3 ambient = material.ambient * skyAmbientAt(normal);
         vec3 diffuse = material.diffuse * diff * dirLight.color;
         vec3 specular = material.specular * spec * dirLight.color;
 
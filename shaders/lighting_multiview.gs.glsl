@@ -0,0 +1,23 @@
+#version 410 core
+
+// Sends each triangle to the viewport of the view its instance was drawn for
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+in MultiviewData {
+    vec3 color;
+    flat int view;
+} gsIn[];
+
+// Outputs to Fragment Shader
+out vec3 vertexColor;
+
+void main() {
+    for(int i = 0; i < 3; i++) {
+        gl_ViewportIndex = gsIn[0].view;
+        gl_Position = gl_in[i].gl_Position;
+        vertexColor = gsIn[i].color;
+        EmitVertex();
+    }
+    EndPrimitive();
+}
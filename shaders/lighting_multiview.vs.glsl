@@ -0,0 +1,149 @@
+#version 410 core
+
+// lighting.vs.glsl for MultiView: one instance per view, lit from that view's eye
+
+layout(location = 0) in vec3 vPos;        // Vertex position
+layout(location = 1) in vec3 vNormal;     // Vertex normal
+
+// Uniforms
+uniform mat3 normalMatrix;
+uniform mat4 modelMatrix;
+
+// Views, see MultiView.h
+#define MAX_VIEWS 4
+uniform mat4 viewProjections[MAX_VIEWS];
+uniform vec3 viewPositions[MAX_VIEWS];
+// bit i set when the object is drawn into view i, instance n goes to the n-th set bit
+uniform int viewMask;
+
+// Material properties
+struct Material {
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float shininess;
+};
+uniform Material material;
+
+// Directional Light properties
+struct DirectionalLight {
+    vec3 direction;
+    vec3 color;
+};
+uniform DirectionalLight dirLight;
+
+// Point Light properties
+#define MAX_POINT_LIGHTS 10 // QualitySettings::MAX_POINT_LIGHTS
+uniform int numPointLights;
+uniform vec3 pointLightPositions[MAX_POINT_LIGHTS];
+uniform vec3 pointLightColors[MAX_POINT_LIGHTS];
+uniform float pointLightConstants[MAX_POINT_LIGHTS];
+uniform float pointLightLinears[MAX_POINT_LIGHTS];
+uniform float pointLightQuadratics[MAX_POINT_LIGHTS];
+
+// Spot Light properties
+uniform vec3 spotLightPosition;
+uniform vec3 spotLightDirection;
+uniform vec3 spotLightColor;
+uniform float spotLightWidth;
+
+// Sky ambient light, 2nd order spherical harmonics, see SphericalHarmonics.h
+uniform vec3 skyAmbient[9];
+
+vec3 skyAmbientAt(vec3 n) {
+    return skyAmbient[0]
+         + skyAmbient[1] * n.y + skyAmbient[2] * n.z + skyAmbient[3] * n.x
+         + skyAmbient[4] * (n.x * n.y) + skyAmbient[5] * (n.y * n.z) + skyAmbient[6] * (3.0 * n.z * n.z - 1.0)
+         + skyAmbient[7] * (n.x * n.z) + skyAmbient[8] * (n.x * n.x - n.y * n.y);
+}
+
+// Outputs to the multiview Geometry Shader
+out MultiviewData {
+    vec3 color;
+    flat int view;
+} vsOut;
+
+int instanceView() {
+    int remaining = gl_InstanceID;
+    for(int view = 0; view < MAX_VIEWS; view++) {
+        if((viewMask & (1 << view)) != 0) {
+            if(remaining == 0) return view;
+            remaining--;
+        }
+    }
+    return 0;
+}
+
+void main() {
+    // Transformations
+    int view = instanceView();
+    vec3 worldPos = vec3(modelMatrix * vec4(vPos, 1.0));
+    gl_Position = viewProjections[view] * vec4(worldPos, 1.0);
+    vec3 normal = normalize(normalMatrix * vNormal);
+    vec3 viewDir = normalize(viewPositions[view] - worldPos);
+    vsOut.view = view;
+
+    // Initialize color
+    vsOut.color = vec3(0.0);
+
+    // Directional Light
+    {
+        vec3 lightDir = normalize(-dirLight.direction);
+        float diff = max(dot(normal, lightDir), 0.0);
+        vec3 reflectDir = reflect(-lightDir, normal);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+
+        // ambient light comes from the sky around, not the sun
+        vec3 ambient = material.ambient * skyAmbientAt(normal);
+        vec3 diffuse = material.diffuse * diff * dirLight.color;
+        vec3 specular = material.specular * spec * dirLight.color;
+
+        vsOut.color += ambient + diffuse + specular;
+    }
+
+    // Point Lights
+    for(int i = 0; i < numPointLights; i++) {
+        vec3 lightPos = pointLightPositions[i];
+        vec3 lightColor = pointLightColors[i];
+
+        vec3 lightDir = normalize(lightPos - worldPos);
+        float diff = max(dot(normal, lightDir), 0.0);
+        vec3 reflectDir = reflect(-lightDir, normal);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+
+        float distance = length(lightPos - worldPos);
+        float attenuation = 1.0 / (pointLightConstants[i] + pointLightLinears[i] * distance + pointLightQuadratics[i] * (distance * distance));
+
+        vec3 ambient = material.ambient * lightColor;
+        vec3 diffuse = material.diffuse * diff * lightColor;
+        vec3 specular = material.specular * spec * lightColor;
+
+        ambient *= attenuation;
+        diffuse *= attenuation;
+        specular *= attenuation;
+
+        vsOut.color += ambient + diffuse + specular;
+    }
+
+    // Spot Light
+    {
+        float linear = 0.09f;
+        float quadratic = 0.032f;
+
+        vec3 lightDir = normalize(spotLightPosition - worldPos);
+        float diff = max(dot(normal, lightDir), 0.0);
+
+        vec3 reflectDir = reflect(-lightDir, normal);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), 5);
+
+        if( dot(lightDir, normalize(-spotLightDirection)) > spotLightWidth ){
+            float dist = length(spotLightPosition - worldPos);
+            float attenuation = 1.0 / (1.0 + (linear * dist) + (quadratic * (dist * dist)));
+
+            vec3 ambient = material.ambient * spotLightColor * attenuation;
+            vec3 diffuse = material.diffuse * diff * spotLightColor * attenuation;
+            vec3 specular = material.specular * spec * spotLightColor * attenuation;
+            vsOut.color += ambient + diffuse + specular;
+        }
+    }
+}
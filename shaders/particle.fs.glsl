@@ -0,0 +1,13 @@
+#version 410 core
+
+in vec2 corner;
+in vec4 particleColor;
+
+out vec4 fragColorOut;
+
+void main() {
+    // round soft sprite, fading out toward the edge
+    float falloff = 1.0 - dot(corner, corner);
+    if(falloff <= 0.0) discard;
+    fragColorOut = vec4(particleColor.rgb, particleColor.a * falloff * falloff);
+}
@@ -0,0 +1,39 @@
+#version 410 core
+
+// One camera facing quad per instance, a triangle strip over gl_VertexID 0..3
+#define MAX_EMITTERS 16 // ParticleSystem::MAX_EMITTERS
+
+layout(location = 0) in vec4 positionAge;      // xyz position, w age in seconds
+layout(location = 1) in vec4 velocityLifetime; // xyz velocity, w lifetime in seconds
+
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+// one past the last particle of each emitter
+uniform int emitterEnds[MAX_EMITTERS];
+uniform vec4 emitterStartColors[MAX_EMITTERS];
+uniform vec4 emitterEndColors[MAX_EMITTERS];
+uniform float emitterSizes[MAX_EMITTERS];
+
+out vec2 corner;
+out vec4 particleColor;
+
+void main() {
+    corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    particleColor = vec4(0.0);
+
+    // unborn or dead: all four corners collapse onto one point and nothing is rasterized
+    float life = positionAge.w / max(velocityLifetime.w, 1e-6);
+    if(positionAge.w < 0.0 || life >= 1.0) {
+        gl_Position = vec4(0.0);
+        return;
+    }
+
+    int emitter = 0;
+    while(emitter < MAX_EMITTERS - 1 && gl_InstanceID >= emitterEnds[emitter]) emitter++;
+
+    // offset in view space so the quad always faces the camera, shrinking as it ages
+    vec4 viewPosition = viewMatrix * vec4(positionAge.xyz, 1.0);
+    viewPosition.xy += corner * emitterSizes[emitter] * (1.0 - 0.5 * life);
+    gl_Position = projectionMatrix * viewPosition;
+    particleColor = mix(emitterStartColors[emitter], emitterEndColors[emitter], life);
+}
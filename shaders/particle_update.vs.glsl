@@ -0,0 +1,60 @@
+#version 410 core
+
+// Advances one particle per instance, the result is captured with transform feedback
+#define MAX_EMITTERS 16 // ParticleSystem::MAX_EMITTERS
+
+layout(location = 0) in vec4 positionAge;      // xyz position, w age in seconds
+layout(location = 1) in vec4 velocityLifetime; // xyz velocity, w lifetime in seconds
+
+uniform float deltaTime;
+uniform uint frameSeed;
+// one past the last particle of each emitter
+uniform int emitterEnds[MAX_EMITTERS];
+uniform vec4 emitterPositionRadius[MAX_EMITTERS];
+uniform vec4 emitterVelocitySpread[MAX_EMITTERS];
+// w is zero for inactive emitters
+uniform vec4 emitterAccelerationLifetime[MAX_EMITTERS];
+
+out vec4 outPositionAge;
+out vec4 outVelocityLifetime;
+
+// PCG hash, the CPU fallback in ParticleSystem.cpp uses the same one
+uint hashParticle(uint x) {
+    uint state = x * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float randomParticle(uint k) {
+    return float(hashParticle(uint(gl_InstanceID) ^ hashParticle(frameSeed * 8u + k))) / 4294967295.0;
+}
+
+void main() {
+    int emitter = 0;
+    while(emitter < MAX_EMITTERS - 1 && gl_InstanceID >= emitterEnds[emitter]) emitter++;
+
+    vec3 position = positionAge.xyz;
+    vec3 velocity = velocityLifetime.xyz;
+    float lifetime = velocityLifetime.w;
+    float age = positionAge.w + deltaTime;
+
+    if(age >= lifetime) {
+        float emitterLifetime = emitterAccelerationLifetime[emitter].w;
+        if(emitterLifetime > 0.0) {
+            // somewhere on the emitter's disc, launched with a random kick
+            float angle = randomParticle(0u) * 6.28318531;
+            float radius = emitterPositionRadius[emitter].w * sqrt(randomParticle(1u));
+            position = emitterPositionRadius[emitter].xyz + vec3(cos(angle) * radius, 0.0, sin(angle) * radius);
+            vec3 kick = vec3(randomParticle(2u), randomParticle(3u), randomParticle(4u)) * 2.0 - 1.0;
+            velocity = emitterVelocitySpread[emitter].xyz + kick * emitterVelocitySpread[emitter].w;
+            lifetime = emitterLifetime * (0.75 + 0.5 * randomParticle(5u));
+            age = 0.0;
+        }
+    } else if(age >= 0.0) {
+        velocity += emitterAccelerationLifetime[emitter].xyz * deltaTime;
+        position += velocity * deltaTime;
+    }
+
+    outPositionAge = vec4(position, age);
+    outVelocityLifetime = vec4(velocity, lifetime);
+}
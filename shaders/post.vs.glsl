@@ -0,0 +1,11 @@
+#version 410 core
+
+// One triangle over the whole viewport, made from gl_VertexID without any vertex buffer
+
+out vec2 texCoord; // 0 to 1 across the viewport
+
+void main() {
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    texCoord = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
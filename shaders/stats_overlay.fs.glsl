@@ -0,0 +1,21 @@
+#version 410 core
+
+#define GLYPH_WIDTH 5  // StatsOverlay::GLYPH_WIDTH
+#define GLYPH_HEIGHT 7 // StatsOverlay::GLYPH_HEIGHT
+
+in vec2 cellPosition;
+flat in int glyph;
+
+// every glyph side by side, top row first
+uniform sampler2D font;
+
+out vec4 fragColorOut;
+
+void main() {
+    ivec2 pixel = ivec2(floor(cellPosition)) - ivec2(0, 1);
+    float set = 0.0;
+    if(pixel.x >= 0 && pixel.x < GLYPH_WIDTH && pixel.y >= 0 && pixel.y < GLYPH_HEIGHT) {
+        set = texelFetch(font, ivec2(glyph * GLYPH_WIDTH + pixel.x, pixel.y), 0).r;
+    }
+    fragColorOut = mix(vec4(0.0, 0.0, 0.0, 0.6), vec4(1.0, 1.0, 0.7, 1.0), set);
+}
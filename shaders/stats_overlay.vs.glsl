@@ -0,0 +1,29 @@
+#version 410 core
+
+// One character cell per instance, a triangle strip over gl_VertexID 0..3
+#define GLYPH_WIDTH 5  // StatsOverlay::GLYPH_WIDTH
+#define GLYPH_HEIGHT 7 // StatsOverlay::GLYPH_HEIGHT
+// a pixel of spacing right of each glyph and above and below it
+#define CELL_SIZE vec2(GLYPH_WIDTH + 1, GLYPH_HEIGHT + 2)
+#define MARGIN 8.0
+
+layout(location = 0) in vec3 character; // x column, y line, z glyph
+
+// framebuffer size in pixels
+uniform vec2 screenSize;
+// screen pixels per font pixel
+uniform float pixelScale;
+
+// position inside the cell in font pixels, y down
+out vec2 cellPosition;
+flat out int glyph;
+
+void main() {
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    cellPosition = corner * CELL_SIZE;
+    glyph = int(character.z);
+
+    // lines run down from the top left corner
+    vec2 pixel = vec2(MARGIN) + (character.xy * CELL_SIZE + cellPosition) * pixelScale;
+    gl_Position = vec4(pixel.x / screenSize.x * 2.0 - 1.0, 1.0 - pixel.y / screenSize.y * 2.0, 0.0, 1.0);
+}
@@ -0,0 +1,37 @@
+#version 410 core
+
+// The HDR scene plus its bloom, exposed and tone mapped into the displayed image
+
+in vec2 texCoord;
+
+uniform sampler2D scene;
+uniform vec2 sceneScale;    // texCoord to the used corner of the scene, see PostProcess.cpp
+uniform vec2 sceneMax;
+uniform sampler2D bloom;    // the half level of the bloom pyramid
+uniform vec2 bloomScale;
+uniform vec2 bloomMax;
+uniform float bloomIntensity; // 0 without bloom
+uniform float exposure;
+uniform int toneMapping;      // 0 clamps like the LDR back buffer did
+
+out vec4 fragColorOut;
+
+// colors up to the shoulder stay as the lighting made them, brighter ones roll off toward 1
+const float SHOULDER = 0.8;
+
+vec3 toneMap(vec3 color) {
+    vec3 over = max(color - SHOULDER, 0.0);
+    return min(color, SHOULDER) + (1.0 - SHOULDER) * (1.0 - exp(-over / (1.0 - SHOULDER)));
+}
+
+void main() {
+    vec3 color = texture(scene, min(texCoord * sceneScale, sceneMax)).rgb;
+    if(bloomIntensity > 0.0) {
+        color += bloomIntensity * texture(bloom, min(texCoord * bloomScale, bloomMax)).rgb;
+    }
+    color *= exposure;
+    if(toneMapping != 0) {
+        color = toneMap(color);
+    }
+    fragColorOut = vec4(clamp(color, 0.0, 1.0), 1.0);
+}